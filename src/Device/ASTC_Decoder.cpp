@@ -15,16 +15,27 @@
 #include "ASTC_Decoder.hpp"
 
 #include "System/Math.hpp"
+#include "System/Parallel.hpp"
 
 #ifdef SWIFTSHADER_ENABLE_ASTC
 #	include "astc_codec_internals.h"
 #endif
 
+#include <algorithm>
+#include <cstring>
 #include <memory>
 #include <unordered_map>
 
+#if defined(__i386__) || defined(__x86_64__)
+#	include <xmmintrin.h>
+#	include <emmintrin.h>
+#endif
+
 namespace {
 
+// Rows of blocks are decoded concurrently, in ranges of at least this many blocks.
+constexpr int MinParallelBlocks = 256;
+
 #ifdef SWIFTSHADER_ENABLE_ASTC
 void write_imageblock(unsigned char *img,
                       // picture-block to initialize with image data. We assume that orig_data is valid
@@ -96,6 +107,81 @@ void write_imageblock(unsigned char *img,
 		}
 	}
 }
+
+// Converts a row of decoded texels to 8-bit unsigned normalized RGBA. The
+// number of texels is a compile time constant, so that the loops get unrolled.
+template<int width>
+void writeUnormRow(unsigned char *dest, const float *fptr)
+{
+#if defined(__i386__) || defined(__x86_64__)
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 scale = _mm_set1_ps(255.0f);
+	const __m128 half = _mm_set1_ps(0.5f);
+
+	auto toUnorm = [&](const float *texel) {
+		__m128 c = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(texel), zero), one);
+		return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(c, scale), half));
+	};
+
+	int x = 0;
+	for(; x + 4 <= width; x += 4)
+	{
+		__m128i c01 = _mm_packs_epi32(toUnorm(fptr + 4 * x), toUnorm(fptr + 4 * x + 4));
+		__m128i c23 = _mm_packs_epi32(toUnorm(fptr + 4 * x + 8), toUnorm(fptr + 4 * x + 12));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dest + 4 * x), _mm_packus_epi16(c01, c23));
+	}
+
+	for(; x < width; x++)
+	{
+		__m128i c = _mm_packs_epi32(toUnorm(fptr + 4 * x), _mm_setzero_si128());
+		int32_t texel = _mm_cvtsi128_si32(_mm_packus_epi16(c, c));
+		memcpy(dest + 4 * x, &texel, sizeof(texel));
+	}
+#else
+	for(int i = 0; i < 4 * width; i++)
+	{
+		dest[i] = static_cast<unsigned char>(sw::clamp(fptr[i], 0.0f, 1.0f) * 255.0f + 0.5f);
+	}
+#endif
+}
+
+// Specialization of write_imageblock() for 2D blocks lying entirely within the
+// image, decoded to 8-bit unsigned normalized RGBA.
+template<int xdim, int ydim>
+void writeUnormBlock(unsigned char *dest, int destPitchB, const imageblock *pb)
+{
+	for(int y = 0; y < ydim; y++)
+	{
+		writeUnormRow<xdim>(dest + y * destPitchB, pb->orig_data + 4 * xdim * y);
+	}
+
+	for(int i = 0; i < xdim * ydim; i++)
+	{
+		if(pb->nan_texel[i])
+		{
+			// NaN-pixel, but we can't display it. Display purple instead.
+			unsigned char *pix = dest + (i / xdim) * destPitchB + (i % xdim) * 4;
+			pix[0] = 0xFF;
+			pix[1] = 0x00;
+			pix[2] = 0xFF;
+			pix[3] = 0xFF;
+		}
+	}
+}
+
+using WriteBlockFunction = void (*)(unsigned char *dest, int destPitchB, const imageblock *pb);
+
+// Returns the specialized writer for the most common LDR block footprints,
+// or nullptr for the others.
+WriteBlockFunction getUnormBlockWriter(int xdim, int ydim)
+{
+	if(xdim == 4 && ydim == 4) return writeUnormBlock<4, 4>;
+	if(xdim == 6 && ydim == 6) return writeUnormBlock<6, 6>;
+	if(xdim == 8 && ydim == 8) return writeUnormBlock<8, 8>;
+
+	return nullptr;
+}
 #endif
 
 }  // namespace
@@ -114,21 +200,47 @@ void ASTC_Decoder::Decode(const unsigned char *source, unsigned char *dest,
 	std::unique_ptr<block_size_descriptor> bsd(new block_size_descriptor);
 	init_block_size_descriptor(xBlockSize, yBlockSize, zBlockSize, bsd.get());
 
-	std::unique_ptr<imageblock> ib(new imageblock);
-	std::unique_ptr<symbolic_compressed_block> scb(new symbolic_compressed_block);
-	for(int z = 0; z < zblocks; z++)
+	WriteBlockFunction writeBlock = nullptr;
+	if(isUnsignedByte && (bytes == 4) && (zBlockSize == 1))
 	{
-		for(int y = 0; y < yblocks; y++)
+		writeBlock = getUnormBlockWriter(xBlockSize, yBlockSize);
+	}
+
+	// The block size descriptor is only read while decoding, so it's shared by
+	// all ranges of block rows. Each range decodes into its own block storage.
+	const block_size_descriptor *descriptor = bsd.get();
+	uint32_t rowCount = static_cast<uint32_t>(yblocks * zblocks);
+	uint32_t minRows = static_cast<uint32_t>(std::max(MinParallelBlocks / xblocks, 1));
+
+	sw::parallelFor(rowCount, minRows, [&](uint32_t firstRow, uint32_t lastRow) {
+		std::unique_ptr<imageblock> ib(new imageblock);
+		std::unique_ptr<symbolic_compressed_block> scb(new symbolic_compressed_block);
+		const unsigned char *block = source + static_cast<size_t>(firstRow) * xblocks * 16;
+
+		for(uint32_t row = firstRow; row < lastRow; row++)
 		{
-			for(int x = 0; x < xblocks; x++, source += 16)
+			int y = row % yblocks;
+			int z = row / yblocks;
+			bool interiorRow = (y + 1) * yBlockSize <= destHeight;
+
+			for(int x = 0; x < xblocks; x++, block += 16)
 			{
-				physical_to_symbolic(bsd.get(), *(physical_compressed_block *)source, scb.get());
-				decompress_symbolic_block(decode_mode, bsd.get(), x * xBlockSize, y * yBlockSize, z * zBlockSize, scb.get(), ib.get());
-				write_imageblock(dest, ib.get(), destWidth, destHeight, destDepth, bytes, destPitchB, destSliceB, isUnsignedByte,
-				                 xBlockSize, yBlockSize, zBlockSize, x * xBlockSize, y * yBlockSize, z * zBlockSize);
+				physical_to_symbolic(descriptor, *(const physical_compressed_block *)block, scb.get());
+				decompress_symbolic_block(decode_mode, descriptor, x * xBlockSize, y * yBlockSize, z * zBlockSize, scb.get(), ib.get());
+
+				if(writeBlock && interiorRow && ((x + 1) * xBlockSize <= destWidth))
+				{
+					// Blocks are 2D on this path, so each slice of blocks is a slice of the image.
+					writeBlock(dest + z * destSliceB + y * yBlockSize * destPitchB + x * xBlockSize * bytes, destPitchB, ib.get());
+				}
+				else
+				{
+					write_imageblock(dest, ib.get(), destWidth, destHeight, destDepth, bytes, destPitchB, destSliceB, isUnsignedByte,
+					                 xBlockSize, yBlockSize, zBlockSize, x * xBlockSize, y * yBlockSize, z * zBlockSize);
+				}
 			}
 		}
-	}
+	});
 
 	term_block_size_descriptor(bsd.get());
 #endif
@@ -20,9 +20,11 @@
 #include "System/Debug.hpp"
 #include "System/Half.hpp"
 #include "System/Memory.hpp"
+#include "System/Parallel.hpp"
 #include "Vulkan/VkImage.hpp"
 #include "Vulkan/VkImageView.hpp"
 
+#include <algorithm>
 #include <utility>
 
 #if defined(__i386__) || defined(__x86_64__)
@@ -30,6 +32,19 @@
 #	include <emmintrin.h>
 #endif
 
+namespace {
+
+// Transfers are split into row ranges of at least this many bytes, which are
+// processed concurrently by the scheduler's workers.
+constexpr uint32_t MinParallelBytes = 64 * 1024;
+
+uint32_t minParallelRows(size_t rowBytes)
+{
+	return static_cast<uint32_t>(std::max<size_t>(MinParallelBytes / std::max<size_t>(rowBytes, 1), 1));
+}
+
+}  // anonymous namespace
+
 namespace sw {
 
 static rr::RValue<rr::Int> PackFields(const rr::Int4 &ints, const sw::int4 shifts)
@@ -45,6 +60,8 @@ Blitter::Blitter()
     , blitCache(1024)
     , cornerUpdateMutex()
     , cornerUpdateCache(64)  // We only need one of these per format
+    , edgeCopyMutex()
+    , edgeCopyCache(64)
 {
 }
 
@@ -62,28 +79,7 @@ void Blitter::clear(const void *pixel, vk::Format format, vk::Image *dest, const
 	}
 
 	VkClearValue clampedPixel;
-	if(viewFormat.isSignedNormalized() || viewFormat.isUnsignedNormalized())
-	{
-		const float minValue = viewFormat.isSignedNormalized() ? -1.0f : 0.0f;
-
-		if(aspect & VK_IMAGE_ASPECT_COLOR_BIT)
-		{
-			memcpy(clampedPixel.color.float32, pixel, sizeof(VkClearColorValue));
-			clampedPixel.color.float32[0] = sw::clamp(clampedPixel.color.float32[0], minValue, 1.0f);
-			clampedPixel.color.float32[1] = sw::clamp(clampedPixel.color.float32[1], minValue, 1.0f);
-			clampedPixel.color.float32[2] = sw::clamp(clampedPixel.color.float32[2], minValue, 1.0f);
-			clampedPixel.color.float32[3] = sw::clamp(clampedPixel.color.float32[3], minValue, 1.0f);
-			pixel = clampedPixel.color.float32;
-		}
-
-		// Stencil never requires clamping, so we can check for Depth only
-		if(aspect & VK_IMAGE_ASPECT_DEPTH_BIT)
-		{
-			memcpy(&(clampedPixel.depthStencil), pixel, sizeof(VkClearDepthStencilValue));
-			clampedPixel.depthStencil.depth = sw::clamp(clampedPixel.depthStencil.depth, minValue, 1.0f);
-			pixel = &(clampedPixel.depthStencil);
-		}
-	}
+	pixel = ClampClearValue(pixel, viewFormat, aspect, clampedPixel);
 
 	if(fastClear(pixel, format, dest, dstFormat, subresourceRange, renderArea))
 	{
@@ -148,7 +144,7 @@ void Blitter::clear(const void *pixel, vk::Format format, vk::Image *dest, const
 			for(uint32_t depth = subresourceRange.baseArrayLayer; depth <= lastLayer; depth++)
 			{
 				data.dest = dest->getTexelPointer({ 0, 0, static_cast<int32_t>(depth) }, subres);
-				blitRoutine(&data);
+				runBlitRoutine(blitRoutine, data, state);
 			}
 		}
 		else
@@ -159,7 +155,7 @@ void Blitter::clear(const void *pixel, vk::Format format, vk::Image *dest, const
 				{
 					data.dest = dest->getTexelPointer({ 0, 0, static_cast<int32_t>(depth) }, subres);
 
-					blitRoutine(&data);
+					runBlitRoutine(blitRoutine, data, state);
 				}
 			}
 		}
@@ -167,7 +163,35 @@ void Blitter::clear(const void *pixel, vk::Format format, vk::Image *dest, const
 	dest->contentsChanged(subresourceRange);
 }
 
-bool Blitter::fastClear(const void *clearValue, vk::Format clearFormat, vk::Image *dest, const vk::Format &viewFormat, const VkImageSubresourceRange &subresourceRange, const VkRect2D *renderArea)
+const void *Blitter::ClampClearValue(const void *pixel, const vk::Format &viewFormat, VkImageAspectFlagBits aspect, VkClearValue &clampedPixel)
+{
+	if(viewFormat.isSignedNormalized() || viewFormat.isUnsignedNormalized())
+	{
+		const float minValue = viewFormat.isSignedNormalized() ? -1.0f : 0.0f;
+
+		if(aspect & VK_IMAGE_ASPECT_COLOR_BIT)
+		{
+			memcpy(clampedPixel.color.float32, pixel, sizeof(VkClearColorValue));
+			clampedPixel.color.float32[0] = sw::clamp(clampedPixel.color.float32[0], minValue, 1.0f);
+			clampedPixel.color.float32[1] = sw::clamp(clampedPixel.color.float32[1], minValue, 1.0f);
+			clampedPixel.color.float32[2] = sw::clamp(clampedPixel.color.float32[2], minValue, 1.0f);
+			clampedPixel.color.float32[3] = sw::clamp(clampedPixel.color.float32[3], minValue, 1.0f);
+			pixel = clampedPixel.color.float32;
+		}
+
+		// Stencil never requires clamping, so we can check for Depth only
+		if(aspect & VK_IMAGE_ASPECT_DEPTH_BIT)
+		{
+			memcpy(&(clampedPixel.depthStencil), pixel, sizeof(VkClearDepthStencilValue));
+			clampedPixel.depthStencil.depth = sw::clamp(clampedPixel.depthStencil.depth, minValue, 1.0f);
+			pixel = &(clampedPixel.depthStencil);
+		}
+	}
+
+	return pixel;
+}
+
+bool Blitter::PackClearValue(const void *clearValue, vk::Format clearFormat, const vk::Format &viewFormat, uint32_t &packed)
 {
 	if(clearFormat != VK_FORMAT_R32G32B32A32_SFLOAT &&
 	   clearFormat != VK_FORMAT_D32_SFLOAT &&
@@ -196,9 +220,6 @@ bool Blitter::fastClear(const void *clearValue, vk::Format clearFormat, vk::Imag
 
 	const ClearValue &c = *reinterpret_cast<const ClearValue *>(clearValue);
 
-	uint32_t packed = 0;
-
-	VkImageAspectFlagBits aspect = static_cast<VkImageAspectFlagBits>(subresourceRange.aspectMask);
 	switch(viewFormat)
 	{
 	case VK_FORMAT_R5G6B5_UNORM_PACK16:
@@ -243,6 +264,65 @@ bool Blitter::fastClear(const void *clearValue, vk::Format clearFormat, vk::Imag
 		return false;
 	}
 
+	return true;
+}
+
+bool Blitter::GetClearTexel(const void *clearValue, vk::Format clearFormat, const vk::Format &viewFormat, VkImageAspectFlagBits aspect, uint32_t &texel)
+{
+	vk::Format dstFormat = viewFormat.getAspectFormat(aspect);
+	if(dstFormat == VK_FORMAT_UNDEFINED)
+	{
+		return false;
+	}
+
+	VkClearValue clampedPixel;
+	clearValue = ClampClearValue(clearValue, viewFormat, aspect, clampedPixel);
+
+	return PackClearValue(clearValue, clearFormat, dstFormat, texel);
+}
+
+void Blitter::ClearRows(void *rows, int texelBytes, uint32_t texel, uint32_t width, uint32_t height, size_t pitchB)
+{
+	uint8_t *d = static_cast<uint8_t *>(rows);
+
+	switch(texelBytes)
+	{
+	case 4:
+		for(uint32_t i = 0; i < height; i++)
+		{
+			sw::clear((uint32_t *)d, texel, width);
+			d += pitchB;
+		}
+		break;
+	case 2:
+		for(uint32_t i = 0; i < height; i++)
+		{
+			sw::clear((uint16_t *)d, static_cast<uint16_t>(texel), width);
+			d += pitchB;
+		}
+		break;
+	case 1:
+		for(uint32_t i = 0; i < height; i++)
+		{
+			memset(d, texel, width);
+			d += pitchB;
+		}
+		break;
+	default:
+		assert(false);
+	}
+}
+
+bool Blitter::fastClear(const void *clearValue, vk::Format clearFormat, vk::Image *dest, const vk::Format &viewFormat, const VkImageSubresourceRange &subresourceRange, const VkRect2D *renderArea)
+{
+	uint32_t packed = 0;
+	if(!PackClearValue(clearValue, clearFormat, viewFormat, packed))
+	{
+		return false;
+	}
+
+	VkImageAspectFlagBits aspect = static_cast<VkImageAspectFlagBits>(subresourceRange.aspectMask);
+
 	VkImageSubresource subres = {
 		subresourceRange.aspectMask,
 		subresourceRange.baseMipLevel,
@@ -273,6 +353,8 @@ bool Blitter::fastClear(const void *clearValue, vk::Format clearFormat, vk::Imag
 			extent.depth = 1;  // The 3D image is instead interpreted as a 2D image with layers
 		}
 
+		uint32_t minRows = minParallelRows(area.extent.width * viewFormat.bytes());
+
 		for(subres.arrayLayer = subresourceRange.baseArrayLayer; subres.arrayLayer <= lastLayer; subres.arrayLayer++)
 		{
 			for(uint32_t depth = 0; depth < extent.depth; depth++)
@@ -282,37 +364,12 @@ bool Blitter::fastClear(const void *clearValue, vk::Format clearFormat, vk::Imag
 
 				for(int j = 0; j < dest->getSampleCount(); j++)
 				{
-					uint8_t *d = slice;
+					parallelFor(area.extent.height, minRows, [&](uint32_t begin, uint32_t end) {
+						uint8_t *d = slice + begin * rowPitchBytes;
+						ASSERT(d + (end - begin - 1) * rowPitchBytes < dest->end());
 
-					switch(viewFormat.bytes())
-					{
-					case 4:
-						for(uint32_t i = 0; i < area.extent.height; i++)
-						{
-							ASSERT(d < dest->end());
-							sw::clear((uint32_t *)d, packed, area.extent.width);
-							d += rowPitchBytes;
-						}
-						break;
-					case 2:
-						for(uint32_t i = 0; i < area.extent.height; i++)
-						{
-							ASSERT(d < dest->end());
-							sw::clear((uint16_t *)d, static_cast<uint16_t>(packed), area.extent.width);
-							d += rowPitchBytes;
-						}
-						break;
-					case 1:
-						for(uint32_t i = 0; i < area.extent.height; i++)
-						{
-							ASSERT(d < dest->end());
-							memset(d, packed, area.extent.width);
-							d += rowPitchBytes;
-						}
-						break;
-					default:
-						assert(false);
-					}
+						ClearRows(d, viewFormat.bytes(), packed, area.extent.width, end - begin, rowPitchBytes);
+					});
 
 					slice += slicePitchBytes;
 				}
@@ -1803,6 +1860,22 @@ Blitter::BlitRoutineType Blitter::getBlitRoutine(const State &state)
 	return blitRoutine;
 }
 
+void Blitter::runBlitRoutine(const BlitRoutineType &blitRoutine, const BlitData &data, const State &state)
+{
+	// Each row range is processed by its own call to the routine, across all
+	// destination slices.
+	size_t rowBytes = static_cast<size_t>(data.x1d - data.x0d) * (data.z1d - data.z0d) *
+	                  state.destFormat.bytes() * state.destSamples;
+	uint32_t rows = static_cast<uint32_t>(data.y1d - data.y0d);
+
+	parallelFor(rows, minParallelRows(rowBytes), [&](uint32_t begin, uint32_t end) {
+		BlitData rangeData = data;
+		rangeData.y0d = data.y0d + static_cast<int>(begin);
+		rangeData.y1d = data.y0d + static_cast<int>(end);
+		blitRoutine(&rangeData);
+	});
+}
+
 Blitter::CornerUpdateRoutineType Blitter::getCornerUpdateRoutine(const State &state)
 {
 	marl::lock lock(cornerUpdateMutex);
@@ -1817,6 +1890,20 @@ Blitter::CornerUpdateRoutineType Blitter::getCornerUpdateRoutine(const State &st
 	return cornerUpdateRoutine;
 }
 
+Blitter::EdgeCopyRoutineType Blitter::getEdgeCopyRoutine(const State &state)
+{
+	marl::lock lock(edgeCopyMutex);
+	auto edgeCopyRoutine = edgeCopyCache.lookup(state);
+
+	if(!edgeCopyRoutine)
+	{
+		edgeCopyRoutine = generateEdgeCopy(state);
+		edgeCopyCache.add(state, edgeCopyRoutine);
+	}
+
+	return edgeCopyRoutine;
+}
+
 void Blitter::blit(const vk::Image *src, vk::Image *dst, VkImageBlit2KHR region, VkFilter filter)
 {
 	ASSERT(src->getFormat() != VK_FORMAT_UNDEFINED);
@@ -1944,12 +2031,151 @@ void Blitter::blit(const vk::Image *src, vk::Image *dst, VkImageBlit2KHR region,
 		ASSERT(data.source < src->end());
 		ASSERT(data.dest < dst->end());
 
-		blitRoutine(&data);
+		runBlitRoutine(blitRoutine, data, state);
 	}
 
 	dst->contentsChanged(dstSubresRange);
 }
 
+// Generates the levels written by a chain of blits, each of which halves the
+// previous level of the same image, in a single pass. The first levels are
+// generated tile by tile, so that each tile's source texels are still cached
+// when reading them back to produce the next level. Only linear filtering of
+// 8-bit unsigned normalized formats with even level extents is handled, for
+// which the blit reduces to averaging 2x2 texels.
+bool Blitter::fastMipChain(vk::Image *image, const VkImageBlit2KHR *regions, uint32_t levelCount, VkFilter filter)
+{
+	if(filter != VK_FILTER_LINEAR ||
+	   image->getImageType() != VK_IMAGE_TYPE_2D ||
+	   image->getSampleCount() != 1)
+	{
+		return false;
+	}
+
+	const vk::Format format = image->getFormat(VK_IMAGE_ASPECT_COLOR_BIT);
+	switch(format)
+	{
+	case VK_FORMAT_R8_UNORM:
+	case VK_FORMAT_R8G8_UNORM:
+	case VK_FORMAT_R8G8B8A8_UNORM:
+	case VK_FORMAT_B8G8R8A8_UNORM:
+	case VK_FORMAT_A8B8G8R8_UNORM_PACK32:
+		break;
+	default:
+		return false;
+	}
+
+	const VkImageSubresourceLayers &subresource = regions[0].srcSubresource;
+	if(subresource.aspectMask != VK_IMAGE_ASPECT_COLOR_BIT)
+	{
+		return false;
+	}
+
+	for(uint32_t i = 0; i < levelCount; i++)
+	{
+		const VkImageBlit2KHR &region = regions[i];
+		VkExtent3D srcExtent = image->getMipLevelExtent(VK_IMAGE_ASPECT_COLOR_BIT, subresource.mipLevel + i);
+
+		if(region.srcSubresource.mipLevel != subresource.mipLevel + i ||
+		   region.dstSubresource.mipLevel != subresource.mipLevel + i + 1 ||
+		   region.srcSubresource.baseArrayLayer != subresource.baseArrayLayer ||
+		   region.dstSubresource.baseArrayLayer != subresource.baseArrayLayer ||
+		   region.srcSubresource.layerCount != subresource.layerCount ||
+		   region.dstSubresource.layerCount != subresource.layerCount ||
+		   (srcExtent.width % 2) != 0 || (srcExtent.height % 2) != 0 ||
+		   region.srcOffsets[0] != VkOffset3D{ 0, 0, 0 } ||
+		   region.srcOffsets[1] != VkOffset3D{ static_cast<int32_t>(srcExtent.width), static_cast<int32_t>(srcExtent.height), 1 } ||
+		   region.dstOffsets[0] != VkOffset3D{ 0, 0, 0 } ||
+		   region.dstOffsets[1] != VkOffset3D{ static_cast<int32_t>(srcExtent.width / 2), static_cast<int32_t>(srcExtent.height / 2), 1 })
+		{
+			return false;
+		}
+	}
+
+	VkImageSubresourceRange dstSubresRange = {
+		VK_IMAGE_ASPECT_COLOR_BIT,
+		subresource.mipLevel + 1,
+		levelCount,
+		subresource.baseArrayLayer,
+		subresource.layerCount
+	};
+
+	const uint32_t layerCount = image->getLastLayerIndex(dstSubresRange) - subresource.baseArrayLayer + 1;
+	const int bytes = format.bytes();
+
+	// Halves the [x0, x1) x [y0, y1) rectangle of a level into the next one.
+	auto downsample = [&](uint32_t layer, uint32_t level, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1) {
+		const uint8_t *src = static_cast<const uint8_t *>(image->getTexelPointer({ 0, 0, 0 }, { VK_IMAGE_ASPECT_COLOR_BIT, level, layer }));
+		uint8_t *dst = static_cast<uint8_t *>(image->getTexelPointer({ 0, 0, 0 }, { VK_IMAGE_ASPECT_COLOR_BIT, level + 1, layer }));
+		size_t srcPitch = image->rowPitchBytes(VK_IMAGE_ASPECT_COLOR_BIT, level);
+		size_t dstPitch = image->rowPitchBytes(VK_IMAGE_ASPECT_COLOR_BIT, level + 1);
+
+		for(uint32_t y = y0; y < y1; y += 2)
+		{
+			const uint8_t *s0 = src + y * srcPitch + x0 * bytes;
+			const uint8_t *s1 = s0 + srcPitch;
+			uint8_t *d = dst + (y / 2) * dstPitch + (x0 / 2) * bytes;
+
+			for(uint32_t x = x0; x < x1; x += 2)
+			{
+				for(int c = 0; c < bytes; c++)
+				{
+					d[c] = static_cast<uint8_t>((s0[c] + s0[c + bytes] + s1[c] + s1[c + bytes] + 2) >> 2);
+				}
+
+				s0 += 2 * bytes;
+				s1 += 2 * bytes;
+				d += bytes;
+			}
+		}
+	};
+
+	// Tiles of the base level are reduced down to a single texel each. Levels
+	// smaller than a tile are generated afterwards.
+	constexpr uint32_t TileSize = 64;
+	constexpr uint32_t TileLevels = 6;  // log2(TileSize)
+	static_assert((1u << TileLevels) == TileSize, "TileLevels must match TileSize");
+
+	const uint32_t tiledLevels = std::min(levelCount, TileLevels);
+	const VkExtent3D baseExtent = image->getMipLevelExtent(VK_IMAGE_ASPECT_COLOR_BIT, subresource.mipLevel);
+	const uint32_t tilesX = (baseExtent.width + TileSize - 1) / TileSize;
+	const uint32_t tilesY = (baseExtent.height + TileSize - 1) / TileSize;
+	const uint32_t tilesPerLayer = tilesX * tilesY;
+
+	parallelFor(layerCount * tilesPerLayer, 4, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t tile = begin; tile < end; tile++)
+		{
+			uint32_t layer = subresource.baseArrayLayer + tile / tilesPerLayer;
+			uint32_t tx = (tile % tilesPerLayer) % tilesX;
+			uint32_t ty = (tile % tilesPerLayer) / tilesX;
+
+			for(uint32_t i = 0; i < tiledLevels; i++)
+			{
+				uint32_t size = TileSize >> i;
+				VkExtent3D extent = image->getMipLevelExtent(VK_IMAGE_ASPECT_COLOR_BIT, subresource.mipLevel + i);
+
+				downsample(layer, subresource.mipLevel + i,
+				           tx * size, ty * size,
+				           std::min((tx + 1) * size, extent.width), std::min((ty + 1) * size, extent.height));
+			}
+		}
+	});
+
+	for(uint32_t i = tiledLevels; i < levelCount; i++)
+	{
+		VkExtent3D extent = image->getMipLevelExtent(VK_IMAGE_ASPECT_COLOR_BIT, subresource.mipLevel + i);
+
+		for(uint32_t layer = 0; layer < layerCount; layer++)
+		{
+			downsample(subresource.baseArrayLayer + layer, subresource.mipLevel + i, 0, 0, extent.width, extent.height);
+		}
+	}
+
+	image->contentsChanged(dstSubresRange);
+
+	return true;
+}
+
 static void resolveDepth(const vk::ImageView *src, vk::ImageView *dst, const VkResolveModeFlagBits depthResolveMode)
 {
 	if(depthResolveMode == VK_RESOLVE_MODE_NONE)
@@ -2143,53 +2369,55 @@ bool Blitter::fastResolve(const vk::Image *src, vk::Image *dst, VkImageResolve2K
 	{
 		if(samples == 4)
 		{
-			for(int y = 0; y < height; y++)
-			{
-				int x = 0;
+			parallelFor(height, minParallelRows(4 * samples * width), [&](uint32_t begin, uint32_t end) {
+				for(uint32_t y = begin; y < end; y++)
+				{
+					const uint8_t *s0 = source0 + y * pitch;
+					const uint8_t *s1 = source1 + y * pitch;
+					const uint8_t *s2 = source2 + y * pitch;
+					const uint8_t *s3 = source3 + y * pitch;
+					uint8_t *d = dest + y * pitch;
+
+					ASSERT(s0 < src->end());
+					ASSERT(s3 < src->end());
+					ASSERT(d < dst->end());
+
+					int x = 0;
 
 #if defined(__i386__) || defined(__x86_64__)
-				if(SSE2)
-				{
-					for(; (x + 3) < width; x += 4)
+					if(SSE2)
 					{
-						__m128i c0 = _mm_loadu_si128((__m128i *)(source0 + 4 * x));
-						__m128i c1 = _mm_loadu_si128((__m128i *)(source1 + 4 * x));
-						__m128i c2 = _mm_loadu_si128((__m128i *)(source2 + 4 * x));
-						__m128i c3 = _mm_loadu_si128((__m128i *)(source3 + 4 * x));
+						for(; (x + 3) < width; x += 4)
+						{
+							__m128i c0 = _mm_loadu_si128((__m128i *)(s0 + 4 * x));
+							__m128i c1 = _mm_loadu_si128((__m128i *)(s1 + 4 * x));
+							__m128i c2 = _mm_loadu_si128((__m128i *)(s2 + 4 * x));
+							__m128i c3 = _mm_loadu_si128((__m128i *)(s3 + 4 * x));
 
-						c0 = _mm_avg_epu8(c0, c1);
-						c2 = _mm_avg_epu8(c2, c3);
-						c0 = _mm_avg_epu8(c0, c2);
+							c0 = _mm_avg_epu8(c0, c1);
+							c2 = _mm_avg_epu8(c2, c3);
+							c0 = _mm_avg_epu8(c0, c2);
 
-						_mm_storeu_si128((__m128i *)(dest + 4 * x), c0);
+							_mm_storeu_si128((__m128i *)(d + 4 * x), c0);
+						}
 					}
-				}
 #endif
 
-				for(; x < width; x++)
-				{
-					uint32_t c0 = *(uint32_t *)(source0 + 4 * x);
-					uint32_t c1 = *(uint32_t *)(source1 + 4 * x);
-					uint32_t c2 = *(uint32_t *)(source2 + 4 * x);
-					uint32_t c3 = *(uint32_t *)(source3 + 4 * x);
+					for(; x < width; x++)
+					{
+						uint32_t c0 = *(uint32_t *)(s0 + 4 * x);
+						uint32_t c1 = *(uint32_t *)(s1 + 4 * x);
+						uint32_t c2 = *(uint32_t *)(s2 + 4 * x);
+						uint32_t c3 = *(uint32_t *)(s3 + 4 * x);
 
-					uint32_t c01 = averageByte4(c0, c1);
-					uint32_t c23 = averageByte4(c2, c3);
-					uint32_t c03 = averageByte4(c01, c23);
+						uint32_t c01 = averageByte4(c0, c1);
+						uint32_t c23 = averageByte4(c2, c3);
+						uint32_t c03 = averageByte4(c01, c23);
 
-					*(uint32_t *)(dest + 4 * x) = c03;
+						*(uint32_t *)(d + 4 * x) = c03;
+					}
 				}
-
-				source0 += pitch;
-				source1 += pitch;
-				source2 += pitch;
-				source3 += pitch;
-				dest += pitch;
-
-				ASSERT(source0 < src->end());
-				ASSERT(source3 < src->end());
-				ASSERT(dest < dst->end());
-			}
+			});
 		}
 		else
 			UNSUPPORTED("Samples: %d", samples);
@@ -2211,16 +2439,20 @@ void Blitter::copy(const vk::Image *src, uint8_t *dst, unsigned int dstPitch)
 	unsigned int srcPitch = src->rowPitchBytes(VK_IMAGE_ASPECT_COLOR_BIT, 0);
 	ASSERT(dstPitch >= rowBytes && srcPitch >= rowBytes && src->getMipLevelExtent(VK_IMAGE_ASPECT_COLOR_BIT, 0).height >= extent.height);
 
-	const uint8_t *s = (uint8_t *)src->getTexelPointer({ 0, 0, 0 }, { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0 });
-	uint8_t *d = dst;
+	const uint8_t *source = (uint8_t *)src->getTexelPointer({ 0, 0, 0 }, { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0 });
 
-	for(uint32_t y = 0; y < extent.height; y++)
-	{
-		memcpy(d, s, rowBytes);
+	parallelFor(extent.height, minParallelRows(rowBytes), [&](uint32_t begin, uint32_t end) {
+		const uint8_t *s = source + size_t(begin) * srcPitch;
+		uint8_t *d = dst + size_t(begin) * dstPitch;
 
-		s += srcPitch;
-		d += dstPitch;
-	}
+		for(uint32_t y = begin; y < end; y++)
+		{
+			memcpy(d, s, rowBytes);
+
+			s += srcPitch;
+			d += dstPitch;
+		}
+	});
 }
 
 void Blitter::computeCubeCorner(Pointer<Byte> &layer, Int &x0, Int &x1, Int &y0, Int &y1, Int &pitchB, const State &state)
@@ -2254,16 +2486,20 @@ Blitter::CornerUpdateRoutineType Blitter::generateCornerUpdate(const State &stat
 		Int pitchB = *Pointer<Int>(blit + OFFSET(CubeBorderData, pitchB));
 		UInt layerSize = *Pointer<Int>(blit + OFFSET(CubeBorderData, layerSize));
 		UInt dim = *Pointer<Int>(blit + OFFSET(CubeBorderData, dim));
+		UInt faceMask = *Pointer<UInt>(blit + OFFSET(CubeBorderData, faceMask));
 
 		// Low Border, Low Pixel, High Border, High Pixel
 		Int LB(-1), LP(0), HB(dim), HP(dim - 1);
 
 		for(int face = 0; face < 6; face++)
 		{
-			computeCubeCorner(layers, LB, LP, LB, LP, pitchB, state);
-			computeCubeCorner(layers, LB, LP, HB, HP, pitchB, state);
-			computeCubeCorner(layers, HB, HP, LB, LP, pitchB, state);
-			computeCubeCorner(layers, HB, HP, HB, HP, pitchB, state);
+			If((faceMask & UInt(1 << face)) != UInt(0))
+			{
+				computeCubeCorner(layers, LB, LP, LB, LP, pitchB, state);
+				computeCubeCorner(layers, LB, LP, HB, HP, pitchB, state);
+				computeCubeCorner(layers, HB, HP, LB, LP, pitchB, state);
+				computeCubeCorner(layers, HB, HP, HB, HP, pitchB, state);
+			}
 			layers = layers + layerSize;
 		}
 	}
@@ -2271,56 +2507,143 @@ Blitter::CornerUpdateRoutineType Blitter::generateCornerUpdate(const State &stat
 	return function("BlitRoutine");
 }
 
-void Blitter::updateBorders(const vk::Image *image, const VkImageSubresource &subresource)
+void Blitter::CopyTexel(Pointer<Byte> &dest, Pointer<Byte> &source, int bytes)
+{
+	// Copy in the widest pieces the texel size allows.
+	for(int offset = 0; offset < bytes;)
+	{
+		int remaining = bytes - offset;
+		if(remaining >= 16)
+		{
+			*Pointer<Int4>(dest + offset, 1) = *Pointer<Int4>(source + offset, 1);
+			offset += 16;
+		}
+		else if(remaining >= 8)
+		{
+			*Pointer<Int2>(dest + offset, 1) = *Pointer<Int2>(source + offset, 1);
+			offset += 8;
+		}
+		else if(remaining >= 4)
+		{
+			*Pointer<Int>(dest + offset, 1) = *Pointer<Int>(source + offset, 1);
+			offset += 4;
+		}
+		else if(remaining >= 2)
+		{
+			*Pointer<Short>(dest + offset, 1) = *Pointer<Short>(source + offset, 1);
+			offset += 2;
+		}
+		else
+		{
+			*Pointer<Byte>(dest + offset) = *Pointer<Byte>(source + offset);
+			offset += 1;
+		}
+	}
+}
+
+Blitter::EdgeCopyRoutineType Blitter::generateEdgeCopy(const State &state)
+{
+	int bytes = state.sourceFormat.bytes();
+
+	EdgeCopyFunction function;
+	{
+		Pointer<Byte> edge(function.Arg<0>());
+
+		Pointer<Byte> source = *Pointer<Pointer<Byte>>(edge + OFFSET(CubeEdgeData, source));
+		Pointer<Byte> dest = *Pointer<Pointer<Byte>>(edge + OFFSET(CubeEdgeData, dest));
+		Int sDelta = *Pointer<Int>(edge + OFFSET(CubeEdgeData, sDelta));
+		Int dDelta = *Pointer<Int>(edge + OFFSET(CubeEdgeData, dDelta));
+		Int count = *Pointer<Int>(edge + OFFSET(CubeEdgeData, count));
+
+		If((sDelta == Int(bytes)) && (dDelta == Int(bytes)))
+		{
+			// Rows traversed in the same direction are contiguous.
+			Int size = count * bytes;
+			Int i = 0;
+
+			While(i + 16 <= size)
+			{
+				*Pointer<Int4>(dest + i, 1) = *Pointer<Int4>(source + i, 1);
+				i += 16;
+			}
+
+			While(i < size)
+			{
+				*Pointer<Byte>(dest + i) = *Pointer<Byte>(source + i);
+				i++;
+			}
+		}
+		Else
+		{
+			For(Int i = 0, i < count, i++)
+			{
+				CopyTexel(dest, source, bytes);
+				source += sDelta;
+				dest += dDelta;
+			}
+		}
+	}
+
+	return function("EdgeCopyRoutine");
+}
+
+void Blitter::updateBorders(const vk::Image *image, const VkImageSubresource &subresource, uint32_t dirtyFaces)
 {
 	ASSERT(image->getArrayLayers() >= (subresource.arrayLayer + 6));
 
 	// From Vulkan 1.1 spec, section 11.5. Image Views:
 	// "For cube and cube array image views, the layers of the image view starting
 	//  at baseArrayLayer correspond to faces in the order +X, -X, +Y, -Y, +Z, -Z."
-	VkImageSubresource posX = subresource;
-	VkImageSubresource negX = posX;
-	negX.arrayLayer++;
-	VkImageSubresource posY = negX;
-	posY.arrayLayer++;
-	VkImageSubresource negY = posY;
-	negY.arrayLayer++;
-	VkImageSubresource posZ = negY;
-	posZ.arrayLayer++;
-	VkImageSubresource negZ = posZ;
-	negZ.arrayLayer++;
-
-	// Copy top / bottom
-	copyCubeEdge(image, posX, BOTTOM, negY, RIGHT);
-	copyCubeEdge(image, posY, BOTTOM, posZ, TOP);
-	copyCubeEdge(image, posZ, BOTTOM, negY, TOP);
-	copyCubeEdge(image, negX, BOTTOM, negY, LEFT);
-	copyCubeEdge(image, negY, BOTTOM, negZ, BOTTOM);
-	copyCubeEdge(image, negZ, BOTTOM, negY, BOTTOM);
-
-	copyCubeEdge(image, posX, TOP, posY, RIGHT);
-	copyCubeEdge(image, posY, TOP, negZ, TOP);
-	copyCubeEdge(image, posZ, TOP, posY, BOTTOM);
-	copyCubeEdge(image, negX, TOP, posY, LEFT);
-	copyCubeEdge(image, negY, TOP, posZ, BOTTOM);
-	copyCubeEdge(image, negZ, TOP, posY, TOP);
-
-	// Copy left / right
-	copyCubeEdge(image, posX, RIGHT, negZ, LEFT);
-	copyCubeEdge(image, posY, RIGHT, posX, TOP);
-	copyCubeEdge(image, posZ, RIGHT, posX, LEFT);
-	copyCubeEdge(image, negX, RIGHT, posZ, LEFT);
-	copyCubeEdge(image, negY, RIGHT, posX, BOTTOM);
-	copyCubeEdge(image, negZ, RIGHT, negX, LEFT);
-
-	copyCubeEdge(image, posX, LEFT, posZ, RIGHT);
-	copyCubeEdge(image, posY, LEFT, negX, TOP);
-	copyCubeEdge(image, posZ, LEFT, negX, RIGHT);
-	copyCubeEdge(image, negX, LEFT, negZ, RIGHT);
-	copyCubeEdge(image, negY, LEFT, negX, BOTTOM);
-	copyCubeEdge(image, negZ, LEFT, posX, RIGHT);
-
-	// Compute corner colors
+	enum Face
+	{
+		posX,
+		negX,
+		posY,
+		negY,
+		posZ,
+		negZ
+	};
+
+	struct CubeEdge
+	{
+		Face dstFace;
+		Edge dstEdge;
+		Face srcFace;
+		Edge srcEdge;
+	};
+
+	static constexpr CubeEdge edges[] = {
+		// Copy top / bottom
+		{ posX, BOTTOM, negY, RIGHT },
+		{ posY, BOTTOM, posZ, TOP },
+		{ posZ, BOTTOM, negY, TOP },
+		{ negX, BOTTOM, negY, LEFT },
+		{ negY, BOTTOM, negZ, BOTTOM },
+		{ negZ, BOTTOM, negY, BOTTOM },
+
+		{ posX, TOP, posY, RIGHT },
+		{ posY, TOP, negZ, TOP },
+		{ posZ, TOP, posY, BOTTOM },
+		{ negX, TOP, posY, LEFT },
+		{ negY, TOP, posZ, BOTTOM },
+		{ negZ, TOP, posY, TOP },
+
+		// Copy left / right
+		{ posX, RIGHT, negZ, LEFT },
+		{ posY, RIGHT, posX, TOP },
+		{ posZ, RIGHT, posX, LEFT },
+		{ negX, RIGHT, posZ, LEFT },
+		{ negY, RIGHT, posX, BOTTOM },
+		{ negZ, RIGHT, negX, LEFT },
+
+		{ posX, LEFT, posZ, RIGHT },
+		{ posY, LEFT, negX, TOP },
+		{ posZ, LEFT, negX, RIGHT },
+		{ negX, LEFT, negZ, RIGHT },
+		{ negY, LEFT, negX, BOTTOM },
+		{ negZ, LEFT, posX, RIGHT },
+	};
+
 	VkImageAspectFlagBits aspect = static_cast<VkImageAspectFlagBits>(subresource.aspectMask);
 	vk::Format format = image->getFormat(aspect);
 	VkSampleCountFlagBits samples = image->getSampleCount();
@@ -2330,23 +2653,43 @@ void Blitter::updateBorders(const vk::Image *image, const VkImageSubresource &su
 	// VK_IMAGE_TYPE_2D, flags must not contain VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT"
 	ASSERT(samples == VK_SAMPLE_COUNT_1_BIT);
 
+	auto edgeCopyRoutine = getEdgeCopyRoutine(state);
 	auto cornerUpdateRoutine = getCornerUpdateRoutine(state);
-	if(!cornerUpdateRoutine)
+	if(!edgeCopyRoutine || !cornerUpdateRoutine)
 	{
 		return;
 	}
 
+	// An edge is stale when its source face changed, or when its destination
+	// face changed, since writes to a face may have overwritten its borders.
+	uint32_t updatedFaces = 0;
+	for(const CubeEdge &edge : edges)
+	{
+		if((dirtyFaces & ((1u << edge.dstFace) | (1u << edge.srcFace))) != 0)
+		{
+			VkImageSubresource dstSubresource = subresource;
+			dstSubresource.arrayLayer += edge.dstFace;
+			VkImageSubresource srcSubresource = subresource;
+			srcSubresource.arrayLayer += edge.srcFace;
+
+			copyCubeEdge(image, edgeCopyRoutine, dstSubresource, edge.dstEdge, srcSubresource, edge.srcEdge);
+			updatedFaces |= 1u << edge.dstFace;
+		}
+	}
+
+	// Compute corner colors of the faces whose borders changed
 	VkExtent3D extent = image->getMipLevelExtent(aspect, subresource.mipLevel);
 	CubeBorderData data = {
-		image->getTexelPointer({ 0, 0, 0 }, posX),
+		image->getTexelPointer({ 0, 0, 0 }, subresource),
 		assert_cast<uint32_t>(image->rowPitchBytes(aspect, subresource.mipLevel)),
 		assert_cast<uint32_t>(image->getLayerSize(aspect)),
-		extent.width
+		extent.width,
+		updatedFaces
 	};
 	cornerUpdateRoutine(&data);
 }
 
-void Blitter::copyCubeEdge(const vk::Image *image,
+void Blitter::copyCubeEdge(const vk::Image *image, const EdgeCopyRoutineType &edgeCopyRoutine,
                            const VkImageSubresource &dstSubresource, Edge dstEdge,
                            const VkImageSubresource &srcSubresource, Edge srcEdge)
 {
@@ -2405,10 +2748,14 @@ void Blitter::copyCubeEdge(const vk::Image *image,
 	ASSERT((src < image->end()) && ((src + (w * srcDelta)) < image->end()));
 	ASSERT((dst < image->end()) && ((dst + (w * dstDelta)) < image->end()));
 
-	for(int i = 0; i < w; ++i, dst += dstDelta, src += srcDelta)
-	{
-		memcpy(dst, src, bytes);
-	}
+	CubeEdgeData data = {
+		src,
+		dst,
+		srcDelta,
+		dstDelta,
+		static_cast<uint32_t>(w)
+	};
+	edgeCopyRoutine(&data);
 }
 
 }  // namespace sw
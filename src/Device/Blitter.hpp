@@ -135,6 +135,16 @@ class Blitter
 		uint32_t pitchB;
 		uint32_t layerSize;
 		uint32_t dim;
+		uint32_t faceMask;  // Faces whose corners are updated
+	};
+
+	struct CubeEdgeData
+	{
+		const void *source;
+		void *dest;
+		int32_t sDelta;  // Distance in bytes between consecutive texels
+		int32_t dDelta;
+		uint32_t count;
 	};
 
 public:
@@ -143,12 +153,23 @@ public:
 
 	void clear(const void *clearValue, vk::Format clearFormat, vk::Image *dest, const vk::Format &viewFormat, const VkImageSubresourceRange &subresourceRange, const VkRect2D *renderArea = nullptr);
 
+	// Computes the texel value clear() writes to an aspect of the given format,
+	// for the formats which clearing can fill with a single texel value.
+	static bool GetClearTexel(const void *clearValue, vk::Format clearFormat, const vk::Format &viewFormat, VkImageAspectFlagBits aspect, uint32_t &texel);
+	// Fills rows of texels with a value obtained from GetClearTexel().
+	static void ClearRows(void *rows, int texelBytes, uint32_t texel, uint32_t width, uint32_t height, size_t pitchB);
+
 	void blit(const vk::Image *src, vk::Image *dst, VkImageBlit2KHR region, VkFilter filter);
+	bool fastMipChain(vk::Image *image, const VkImageBlit2KHR *regions, uint32_t levelCount, VkFilter filter);
 	void resolve(const vk::Image *src, vk::Image *dst, VkImageResolve2KHR region);
 	void resolveDepthStencil(const vk::ImageView *src, vk::ImageView *dst, VkResolveModeFlagBits depthResolveMode, VkResolveModeFlagBits stencilResolveMode);
 	void copy(const vk::Image *src, uint8_t *dst, unsigned int dstPitch);
 
-	void updateBorders(const vk::Image *image, const VkImageSubresource &subresource);
+	// Updates the borders of the cube whose +X face is the given subresource,
+	// for faces whose contents changed. Bit i of dirtyFaces stands for layer
+	// arrayLayer + i. Only edges and corners reading from or written over by
+	// those faces are recomputed.
+	void updateBorders(const vk::Image *image, const VkImageSubresource &subresource, uint32_t dirtyFaces = 0x3F);
 
 private:
 	enum Edge
@@ -159,6 +180,8 @@ private:
 		LEFT
 	};
 
+	static const void *ClampClearValue(const void *pixel, const vk::Format &viewFormat, VkImageAspectFlagBits aspect, VkClearValue &clampedPixel);
+	static bool PackClearValue(const void *clearValue, vk::Format clearFormat, const vk::Format &viewFormat, uint32_t &packed);
 	bool fastClear(const void *clearValue, vk::Format clearFormat, vk::Image *dest, const vk::Format &viewFormat, const VkImageSubresourceRange &subresourceRange, const VkRect2D *renderArea);
 	bool fastResolve(const vk::Image *src, vk::Image *dst, VkImageResolve2KHR region);
 
@@ -174,6 +197,7 @@ private:
 	using BlitRoutineType = BlitFunction::RoutineType;
 	BlitRoutineType getBlitRoutine(const State &state);
 	BlitRoutineType generate(const State &state);
+	void runBlitRoutine(const BlitRoutineType &blitRoutine, const BlitData &data, const State &state);
 	Float4 sample(Pointer<Byte> &source, Float &x, Float &y, Float &z,
 	              Int &sWidth, Int &sHeight, Int &sDepth,
 	              Int &sSliceB, Int &sPitchB, const State &state);
@@ -184,7 +208,13 @@ private:
 	CornerUpdateRoutineType generateCornerUpdate(const State &state);
 	void computeCubeCorner(Pointer<Byte> &layer, Int &x0, Int &x1, Int &y0, Int &y1, Int &pitchB, const State &state);
 
-	void copyCubeEdge(const vk::Image *image,
+	using EdgeCopyFunction = FunctionT<void(const CubeEdgeData *)>;
+	using EdgeCopyRoutineType = EdgeCopyFunction::RoutineType;
+	EdgeCopyRoutineType getEdgeCopyRoutine(const State &state);
+	EdgeCopyRoutineType generateEdgeCopy(const State &state);
+	static void CopyTexel(Pointer<Byte> &dest, Pointer<Byte> &source, int bytes);
+
+	void copyCubeEdge(const vk::Image *image, const EdgeCopyRoutineType &edgeCopyRoutine,
 	                  const VkImageSubresource &dstSubresource, Edge dstEdge,
 	                  const VkImageSubresource &srcSubresource, Edge srcEdge);
 
@@ -193,6 +223,9 @@ private:
 
 	marl::mutex cornerUpdateMutex;
 	RoutineCache<State, CornerUpdateFunction::CFunctionType> cornerUpdateCache GUARDED_BY(cornerUpdateMutex);
+
+	marl::mutex edgeCopyMutex;
+	RoutineCache<State, EdgeCopyFunction::CFunctionType> edgeCopyCache GUARDED_BY(edgeCopyMutex);
 };
 
 }  // namespace sw
@@ -263,7 +263,7 @@ void IndexBuffer::getIndexBuffers(VkPrimitiveTopology topology, uint32_t count,
 		}
 
 		void *indexBuffer = binding.buffer->getOffsetPointer(binding.offset + first * bytesPerIndex());
-		if(hasPrimitiveRestartEnable)
+		if(hasPrimitiveRestartEnable && !SupportsBatchPrimitiveRestart(topology))
 		{
 			switch(indexType)
 			{
@@ -291,6 +291,23 @@ void IndexBuffer::getIndexBuffers(VkPrimitiveTopology topology, uint32_t count,
 	}
 }
 
+bool IndexBuffer::SupportsBatchPrimitiveRestart(VkPrimitiveTopology topology)
+{
+	// Primitives which include a restart index are dropped from batches. Triangle
+	// strips and fans also depend on where their strip started, for the winding
+	// and the hub vertex, which the renderer records for each batch.
+	switch(topology)
+	{
+	case VK_PRIMITIVE_TOPOLOGY_POINT_LIST:
+	case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP:
+	case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP:
+	case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_FAN:
+		return true;
+	default:
+		return false;
+	}
+}
+
 VkFormat Attachments::colorFormat(int location) const
 {
 	ASSERT((location >= 0) && (location < sw::MAX_COLOR_BUFFERS));
@@ -482,6 +499,19 @@ VkDeviceSize Inputs::getInstanceStride(uint32_t i) const
 	return 0;
 }
 
+bool Inputs::hasInstanceAttributes() const
+{
+	for(uint32_t i = 0; i < sw::MAX_INTERFACE_COMPONENTS / 4; i++)
+	{
+		if(getInstanceStride(i) != 0)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
 void MultisampleState::set(const VkPipelineMultisampleStateCreateInfo *multisampleState)
 {
 	if(multisampleState->flags != 0)
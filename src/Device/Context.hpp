@@ -102,6 +102,10 @@ struct IndexBuffer
 	void setIndexBufferBinding(const VertexInputBinding &indexBufferBinding, VkIndexType type);
 	void getIndexBuffers(VkPrimitiveTopology topology, uint32_t count, uint32_t first, bool indexed, bool hasPrimitiveRestartEnable, std::vector<std::pair<uint32_t, void *>> *indexBuffers) const;
 
+	// Returns true if primitive restart is handled by the renderer's batch assembly
+	// for this topology, so the index buffer doesn't get split at restart indices.
+	static bool SupportsBatchPrimitiveRestart(VkPrimitiveTopology topology);
+
 private:
 	uint32_t bytesPerIndex() const;
 
@@ -109,6 +113,15 @@ private:
 	VkIndexType indexType;
 };
 
+// A record of a draw merged from consecutive indirect draw records. It applies
+// to the primitives from firstPrimitive up to the next record's.
+struct DrawRecord
+{
+	uint32_t firstPrimitive;
+	int32_t baseVertex;
+	int32_t instanceOffset;  // Added to the instance index of the merged draw
+};
+
 struct Attachments
 {
 	ImageView *colorBuffer[sw::MAX_COLOR_BUFFERS] = {};
@@ -146,6 +159,7 @@ struct Inputs
 	void advanceInstanceAttributes();
 	VkDeviceSize getVertexStride(uint32_t i) const;
 	VkDeviceSize getInstanceStride(uint32_t i) const;
+	bool hasInstanceAttributes() const;
 
 private:
 	InputsDynamicStateFlags dynamicStateFlags = {};
@@ -14,7 +14,24 @@
 
 #include "ETC_Decoder.hpp"
 
+#include "System/CPUID.hpp"
+#include "System/Parallel.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__aarch64__)
+#	include <arm_neon.h>
+#elif defined(__i386__) || defined(__x86_64__)
+#	include <tmmintrin.h>
+#endif
+
 namespace {
+
+// Rows of blocks are decoded concurrently, in ranges of at least this many blocks.
+constexpr int MinParallelBlocks = 1024;
+
 inline unsigned char clampByte(int value)
 {
 	return static_cast<unsigned char>((value < 0) ? 0 : ((value > 255) ? 255 : value));
@@ -39,9 +56,7 @@ struct bgra8
 	unsigned char r;
 	unsigned char a;
 
-	inline bgra8()
-	{
-	}
+	bgra8() = default;
 
 	inline void set(int red, int green, int blue)
 	{
@@ -85,11 +100,122 @@ inline int extend_7to8bits(int x)
 	return (x << 1) | (x >> 6);
 }
 
+// Writes the texels of a 4x4 block within the image bounds. Each texel is the
+// palette color selected by indices[], which is in row-major order. If
+// alphaValues isn't null, it replaces the alpha of the palette colors.
+void writePaletteTexels(unsigned char *dest, int x, int y, int w, int h, int pitch, const bgra8 palette[8], const uint8_t indices[16], const unsigned char (*alphaValues)[4])
+{
+	for(int j = 0; j < 4 && (y + j) < h; j++)
+	{
+		bgra8 *color = (bgra8 *)dest;
+		for(int i = 0; i < 4 && (x + i) < w; i++)
+		{
+			color[i] = palette[indices[j * 4 + i]];
+			if(alphaValues)
+			{
+				color[i].a = alphaValues[j][i];
+			}
+		}
+		dest += pitch;
+	}
+}
+
+// Vectorized writePaletteTexels() for blocks lying entirely within the image.
+// The palette is used as a 32-byte lookup table, and each row of four texels
+// is gathered from it by a single table lookup.
+#if defined(__aarch64__)
+void writePaletteBlock(unsigned char *dest, int pitch, const bgra8 palette[8], const uint8_t indices[16], const unsigned char (*alphaValues)[4])
+{
+	const uint8x16x2_t table = { { vld1q_u8(&palette[0].b), vld1q_u8(&palette[4].b) } };
+	const uint8x16_t index = vld1q_u8(indices);
+	const uint8x16_t spread = { 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3 };
+	const uint8x16_t channel = { 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3 };
+	const uint8x16_t alphaSpread = { 16, 16, 16, 0, 16, 16, 16, 1, 16, 16, 16, 2, 16, 16, 16, 3 };
+	const uint8x16_t alphaMask = vreinterpretq_u8_u32(vdupq_n_u32(0xFF000000));
+
+	for(int j = 0; j < 4; j++)
+	{
+		uint8x16_t texelIndex = vqtbl1q_u8(index, vaddq_u8(spread, vdupq_n_u8(4 * j)));
+		uint8x16_t texels = vqtbl2q_u8(table, vaddq_u8(vshlq_n_u8(texelIndex, 2), channel));
+
+		if(alphaValues)
+		{
+			uint32_t alphaRow;
+			memcpy(&alphaRow, alphaValues[j], sizeof(alphaRow));
+			uint8x16_t alpha = vqtbl1q_u8(vreinterpretq_u8_u32(vdupq_n_u32(alphaRow)), alphaSpread);
+			texels = vbslq_u8(alphaMask, alpha, texels);
+		}
+
+		vst1q_u8(dest + j * pitch, texels);
+	}
+}
+#elif(defined(__i386__) || defined(__x86_64__)) && defined(__GNUC__)
+__attribute__((target("ssse3"))) void writePaletteBlockSSSE3(unsigned char *dest, int pitch, const bgra8 palette[8], const uint8_t indices[16], const unsigned char (*alphaValues)[4])
+{
+	const __m128i tableLo = _mm_loadu_si128((const __m128i *)&palette[0]);
+	const __m128i tableHi = _mm_loadu_si128((const __m128i *)&palette[4]);
+	const __m128i index = _mm_loadu_si128((const __m128i *)indices);
+	const __m128i spread = _mm_setr_epi8(0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3);
+	const __m128i channel = _mm_setr_epi8(0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3);
+	const __m128i alphaSpread = _mm_setr_epi8(-1, -1, -1, 0, -1, -1, -1, 1, -1, -1, -1, 2, -1, -1, -1, 3);
+	const __m128i alphaMask = _mm_set1_epi32(0xFF000000);
+
+	for(int j = 0; j < 4; j++)
+	{
+		__m128i texelIndex = _mm_shuffle_epi8(index, _mm_add_epi8(spread, _mm_set1_epi8(4 * j)));
+		__m128i byteIndex = _mm_add_epi8(_mm_slli_epi16(texelIndex, 2), channel);
+
+		// _mm_shuffle_epi8 only addresses 16 bytes, and produces zero for control
+		// bytes with the top bit set. Look up both halves of the palette, each with
+		// the bytes addressing the other half turned into zeroes.
+		__m128i isHi = _mm_cmpgt_epi8(byteIndex, _mm_set1_epi8(15));
+		__m128i lo = _mm_shuffle_epi8(tableLo, _mm_or_si128(byteIndex, isHi));
+		__m128i hi = _mm_shuffle_epi8(tableHi, _mm_sub_epi8(byteIndex, _mm_set1_epi8(16)));
+		__m128i texels = _mm_or_si128(lo, hi);
+
+		if(alphaValues)
+		{
+			int32_t alphaRow;
+			memcpy(&alphaRow, alphaValues[j], sizeof(alphaRow));
+			__m128i alpha = _mm_shuffle_epi8(_mm_cvtsi32_si128(alphaRow), alphaSpread);
+			texels = _mm_or_si128(_mm_andnot_si128(alphaMask, texels), alpha);
+		}
+
+		_mm_storeu_si128((__m128i *)(dest + j * pitch), texels);
+	}
+}
+
+void writePaletteBlock(unsigned char *dest, int pitch, const bgra8 palette[8], const uint8_t indices[16], const unsigned char (*alphaValues)[4])
+{
+	static const bool SSSE3 = sw::CPUID::supportsSSSE3();
+
+	if(SSSE3)
+	{
+		writePaletteBlockSSSE3(dest, pitch, palette, indices, alphaValues);
+	}
+	else
+	{
+		writePaletteTexels(dest, 0, 0, 4, 4, pitch, palette, indices, alphaValues);
+	}
+}
+#else
+void writePaletteBlock(unsigned char *dest, int pitch, const bgra8 palette[8], const uint8_t indices[16], const unsigned char (*alphaValues)[4])
+{
+	writePaletteTexels(dest, 0, 0, 4, 4, pitch, palette, indices, alphaValues);
+}
+#endif
+
 struct ETC2
 {
 	// Decodes unsigned single or dual channel block to bytes
 	static void DecodeBlock(const ETC2 **sources, unsigned char *dest, int nbChannels, int x, int y, int w, int h, int pitch, bool isSigned, bool isEAC)
 	{
+		int values[2][16];
+		for(int c = 0; c < nbChannels; c++)
+		{
+			sources[c]->getSingleChannel(values[c], isSigned, isEAC);
+		}
+
 		if(isEAC)
 		{
 			for(int j = 0; j < 4 && (y + j) < h; j++)
@@ -99,7 +225,7 @@ struct ETC2
 				{
 					for(int c = nbChannels - 1; c >= 0; c--)
 					{
-						sDst[i * nbChannels + c] = clampEAC(sources[c]->getSingleChannel(i, j, isSigned, true), isSigned);
+						sDst[i * nbChannels + c] = clampEAC(values[c][j * 4 + i], isSigned);
 					}
 				}
 				dest += pitch;
@@ -116,7 +242,7 @@ struct ETC2
 					{
 						for(int c = nbChannels - 1; c >= 0; c--)
 						{
-							sDst[i * nbChannels + c] = clampSByte(sources[c]->getSingleChannel(i, j, isSigned, false));
+							sDst[i * nbChannels + c] = clampSByte(values[c][j * 4 + i]);
 						}
 					}
 					sDst += pitch;
@@ -130,7 +256,7 @@ struct ETC2
 					{
 						for(int c = nbChannels - 1; c >= 0; c--)
 						{
-							dest[i * nbChannels + c] = clampByte(sources[c]->getSingleChannel(i, j, isSigned, false));
+							dest[i * nbChannels + c] = clampByte(values[c][j * 4 + i]);
 						}
 					}
 					dest += pitch;
@@ -139,12 +265,20 @@ struct ETC2
 		}
 	}
 
-	// Decodes RGB block to bgra8
-	void decodeBlock(unsigned char *dest, int x, int y, int w, int h, int pitch, unsigned char alphaValues[4][4], bool punchThroughAlpha) const
+	// Decodes RGB block to bgra8. If alphaValues is null, the block is opaque,
+	// except for punch-through alpha.
+	void decodeBlock(unsigned char *dest, int x, int y, int w, int h, int pitch, const unsigned char (*alphaValues)[4], bool punchThroughAlpha) const
 	{
 		bool opaqueBit = diffbit;
 		bool nonOpaquePunchThroughAlpha = punchThroughAlpha && !opaqueBit;
 
+		// Individual, differential, H and T modes select each texel's color from
+		// a palette. The individual and differential modes use the upper half of
+		// the palette for the second subblock.
+		bgra8 palette[8] = {};
+		uint8_t indices[16];
+		getIndices(indices);
+
 		// Select mode
 		if(diffbit || punchThroughAlpha)
 		{
@@ -153,24 +287,46 @@ struct ETC2
 			int b = (B + dB);
 			if(r < 0 || r > 31)
 			{
-				decodeTBlock(dest, x, y, w, h, pitch, alphaValues, nonOpaquePunchThroughAlpha);
+				getTPalette(palette);
 			}
 			else if(g < 0 || g > 31)
 			{
-				decodeHBlock(dest, x, y, w, h, pitch, alphaValues, nonOpaquePunchThroughAlpha);
+				getHPalette(palette);
 			}
 			else if(b < 0 || b > 31)
 			{
 				decodePlanarBlock(dest, x, y, w, h, pitch, alphaValues);
+				return;
 			}
 			else
 			{
-				decodeDifferentialBlock(dest, x, y, w, h, pitch, alphaValues, nonOpaquePunchThroughAlpha);
+				getDifferentialPalette(palette, indices, nonOpaquePunchThroughAlpha);
 			}
 		}
 		else
 		{
-			decodeIndividualBlock(dest, x, y, w, h, pitch, alphaValues, nonOpaquePunchThroughAlpha);
+			getIndividualPalette(palette, indices, nonOpaquePunchThroughAlpha);
+		}
+
+		for(bgra8 &color : palette)
+		{
+			color.a = 255;
+		}
+
+		if(nonOpaquePunchThroughAlpha)
+		{
+			// Texels with index 2 are transparent black
+			palette[2].set(0, 0, 0, 0);
+			palette[6].set(0, 0, 0, 0);
+		}
+
+		if((x + 4 <= w) && (y + 4 <= h))
+		{
+			writePaletteBlock(dest, pitch, palette, indices, alphaValues);
+		}
+		else
+		{
+			writePaletteTexels(dest, x, y, w, h, pitch, palette, indices, alphaValues);
 		}
 	}
 
@@ -356,7 +512,7 @@ private:
 		};
 	};
 
-	void decodeIndividualBlock(unsigned char *dest, int x, int y, int w, int h, int pitch, unsigned char alphaValues[4][4], bool nonOpaquePunchThroughAlpha) const
+	void getIndividualPalette(bgra8 palette[8], uint8_t indices[16], bool nonOpaquePunchThroughAlpha) const
 	{
 		int r1 = extend_4to8bits(R1);
 		int g1 = extend_4to8bits(G1);
@@ -366,10 +522,10 @@ private:
 		int g2 = extend_4to8bits(G2);
 		int b2 = extend_4to8bits(B2);
 
-		decodeIndividualOrDifferentialBlock(dest, x, y, w, h, pitch, r1, g1, b1, r2, g2, b2, alphaValues, nonOpaquePunchThroughAlpha);
+		getIndividualOrDifferentialPalette(palette, indices, r1, g1, b1, r2, g2, b2, nonOpaquePunchThroughAlpha);
 	}
 
-	void decodeDifferentialBlock(unsigned char *dest, int x, int y, int w, int h, int pitch, unsigned char alphaValues[4][4], bool nonOpaquePunchThroughAlpha) const
+	void getDifferentialPalette(bgra8 palette[8], uint8_t indices[16], bool nonOpaquePunchThroughAlpha) const
 	{
 		int b1 = extend_5to8bits(B);
 		int g1 = extend_5to8bits(G);
@@ -379,10 +535,10 @@ private:
 		int g2 = extend_5to8bits(G + dG);
 		int b2 = extend_5to8bits(B + dB);
 
-		decodeIndividualOrDifferentialBlock(dest, x, y, w, h, pitch, r1, g1, b1, r2, g2, b2, alphaValues, nonOpaquePunchThroughAlpha);
+		getIndividualOrDifferentialPalette(palette, indices, r1, g1, b1, r2, g2, b2, nonOpaquePunchThroughAlpha);
 	}
 
-	void decodeIndividualOrDifferentialBlock(unsigned char *dest, int x, int y, int w, int h, int pitch, int r1, int g1, int b1, int r2, int g2, int b2, unsigned char alphaValues[4][4], bool nonOpaquePunchThroughAlpha) const
+	void getIndividualOrDifferentialPalette(bgra8 palette[8], uint8_t indices[16], int r1, int g1, int b1, int r2, int g2, int b2, bool nonOpaquePunchThroughAlpha) const
 	{
 		// Table 3.17.2 sorted according to table 3.17.3
 		static const int intensityModifierDefault[8][4] = {
@@ -410,79 +566,33 @@ private:
 
 		const int(&intensityModifier)[8][4] = nonOpaquePunchThroughAlpha ? intensityModifierNonOpaque : intensityModifierDefault;
 
-		bgra8 subblockColors0[4];
-		bgra8 subblockColors1[4];
-
-		const int i10 = intensityModifier[cw1][0];
-		const int i11 = intensityModifier[cw1][1];
-		const int i12 = intensityModifier[cw1][2];
-		const int i13 = intensityModifier[cw1][3];
-
-		subblockColors0[0].set(r1 + i10, g1 + i10, b1 + i10);
-		subblockColors0[1].set(r1 + i11, g1 + i11, b1 + i11);
-		subblockColors0[2].set(r1 + i12, g1 + i12, b1 + i12);
-		subblockColors0[3].set(r1 + i13, g1 + i13, b1 + i13);
-
-		const int i20 = intensityModifier[cw2][0];
-		const int i21 = intensityModifier[cw2][1];
-		const int i22 = intensityModifier[cw2][2];
-		const int i23 = intensityModifier[cw2][3];
-
-		subblockColors1[0].set(r2 + i20, g2 + i20, b2 + i20);
-		subblockColors1[1].set(r2 + i21, g2 + i21, b2 + i21);
-		subblockColors1[2].set(r2 + i22, g2 + i22, b2 + i22);
-		subblockColors1[3].set(r2 + i23, g2 + i23, b2 + i23);
-
-		unsigned char *destStart = dest;
-
-		if(flipbit)
+		for(int k = 0; k < 4; k++)
 		{
-			for(int j = 0; j < 2 && (y + j) < h; j++)
-			{
-				bgra8 *color = (bgra8 *)dest;
-				if((x + 0) < w) color[0] = subblockColors0[getIndex(0, j)].addA(alphaValues[j][0]);
-				if((x + 1) < w) color[1] = subblockColors0[getIndex(1, j)].addA(alphaValues[j][1]);
-				if((x + 2) < w) color[2] = subblockColors0[getIndex(2, j)].addA(alphaValues[j][2]);
-				if((x + 3) < w) color[3] = subblockColors0[getIndex(3, j)].addA(alphaValues[j][3]);
-				dest += pitch;
-			}
+			const int i1 = intensityModifier[cw1][k];
+			const int i2 = intensityModifier[cw2][k];
 
-			for(int j = 2; j < 4 && (y + j) < h; j++)
-			{
-				bgra8 *color = (bgra8 *)dest;
-				if((x + 0) < w) color[0] = subblockColors1[getIndex(0, j)].addA(alphaValues[j][0]);
-				if((x + 1) < w) color[1] = subblockColors1[getIndex(1, j)].addA(alphaValues[j][1]);
-				if((x + 2) < w) color[2] = subblockColors1[getIndex(2, j)].addA(alphaValues[j][2]);
-				if((x + 3) < w) color[3] = subblockColors1[getIndex(3, j)].addA(alphaValues[j][3]);
-				dest += pitch;
-			}
+			palette[k].set(r1 + i1, g1 + i1, b1 + i1);
+			palette[4 + k].set(r2 + i2, g2 + i2, b2 + i2);
 		}
-		else
+
+		// The flip bit selects whether the subblocks are 2x4 (side by side) or 4x2 (on top of each other)
+		for(int j = 0; j < 4; j++)
 		{
-			for(int j = 0; j < 4 && (y + j) < h; j++)
+			for(int i = 0; i < 4; i++)
 			{
-				bgra8 *color = (bgra8 *)dest;
-				if((x + 0) < w) color[0] = subblockColors0[getIndex(0, j)].addA(alphaValues[j][0]);
-				if((x + 1) < w) color[1] = subblockColors0[getIndex(1, j)].addA(alphaValues[j][1]);
-				if((x + 2) < w) color[2] = subblockColors1[getIndex(2, j)].addA(alphaValues[j][2]);
-				if((x + 3) < w) color[3] = subblockColors1[getIndex(3, j)].addA(alphaValues[j][3]);
-				dest += pitch;
+				if(flipbit ? (j >= 2) : (i >= 2))
+				{
+					indices[j * 4 + i] += 4;
+				}
 			}
 		}
-
-		if(nonOpaquePunchThroughAlpha)
-		{
-			decodePunchThroughAlphaBlock(destStart, x, y, w, h, pitch);
-		}
 	}
 
-	void decodeTBlock(unsigned char *dest, int x, int y, int w, int h, int pitch, unsigned char alphaValues[4][4], bool nonOpaquePunchThroughAlpha) const
+	void getTPalette(bgra8 palette[8]) const
 	{
 		// Table C.8, distance index fot T and H modes
 		static const int distance[8] = { 3, 6, 11, 16, 23, 32, 41, 64 };
 
-		bgra8 paintColors[4];
-
 		int r1 = extend_4to8bits(TR1a << 2 | TR1b);
 		int g1 = extend_4to8bits(TG1);
 		int b1 = extend_4to8bits(TB1);
@@ -493,36 +603,17 @@ private:
 
 		const int d = distance[Tda << 1 | Tdb];
 
-		paintColors[0].set(r1, g1, b1);
-		paintColors[1].set(r2 + d, g2 + d, b2 + d);
-		paintColors[2].set(r2, g2, b2);
-		paintColors[3].set(r2 - d, g2 - d, b2 - d);
-
-		unsigned char *destStart = dest;
-
-		for(int j = 0; j < 4 && (y + j) < h; j++)
-		{
-			bgra8 *color = (bgra8 *)dest;
-			if((x + 0) < w) color[0] = paintColors[getIndex(0, j)].addA(alphaValues[j][0]);
-			if((x + 1) < w) color[1] = paintColors[getIndex(1, j)].addA(alphaValues[j][1]);
-			if((x + 2) < w) color[2] = paintColors[getIndex(2, j)].addA(alphaValues[j][2]);
-			if((x + 3) < w) color[3] = paintColors[getIndex(3, j)].addA(alphaValues[j][3]);
-			dest += pitch;
-		}
-
-		if(nonOpaquePunchThroughAlpha)
-		{
-			decodePunchThroughAlphaBlock(destStart, x, y, w, h, pitch);
-		}
+		palette[0].set(r1, g1, b1);
+		palette[1].set(r2 + d, g2 + d, b2 + d);
+		palette[2].set(r2, g2, b2);
+		palette[3].set(r2 - d, g2 - d, b2 - d);
 	}
 
-	void decodeHBlock(unsigned char *dest, int x, int y, int w, int h, int pitch, unsigned char alphaValues[4][4], bool nonOpaquePunchThroughAlpha) const
+	void getHPalette(bgra8 palette[8]) const
 	{
 		// Table C.8, distance index fot T and H modes
 		static const int distance[8] = { 3, 6, 11, 16, 23, 32, 41, 64 };
 
-		bgra8 paintColors[4];
-
 		int r1 = extend_4to8bits(HR1);
 		int g1 = extend_4to8bits(HG1a << 1 | HG1b);
 		int b1 = extend_4to8bits(HB1a << 3 | HB1b << 1 | HB1c);
@@ -533,30 +624,13 @@ private:
 
 		const int d = distance[(Hda << 2) | (Hdb << 1) | ((r1 << 16 | g1 << 8 | b1) >= (r2 << 16 | g2 << 8 | b2) ? 1 : 0)];
 
-		paintColors[0].set(r1 + d, g1 + d, b1 + d);
-		paintColors[1].set(r1 - d, g1 - d, b1 - d);
-		paintColors[2].set(r2 + d, g2 + d, b2 + d);
-		paintColors[3].set(r2 - d, g2 - d, b2 - d);
-
-		unsigned char *destStart = dest;
-
-		for(int j = 0; j < 4 && (y + j) < h; j++)
-		{
-			bgra8 *color = (bgra8 *)dest;
-			if((x + 0) < w) color[0] = paintColors[getIndex(0, j)].addA(alphaValues[j][0]);
-			if((x + 1) < w) color[1] = paintColors[getIndex(1, j)].addA(alphaValues[j][1]);
-			if((x + 2) < w) color[2] = paintColors[getIndex(2, j)].addA(alphaValues[j][2]);
-			if((x + 3) < w) color[3] = paintColors[getIndex(3, j)].addA(alphaValues[j][3]);
-			dest += pitch;
-		}
-
-		if(nonOpaquePunchThroughAlpha)
-		{
-			decodePunchThroughAlphaBlock(destStart, x, y, w, h, pitch);
-		}
+		palette[0].set(r1 + d, g1 + d, b1 + d);
+		palette[1].set(r1 - d, g1 - d, b1 - d);
+		palette[2].set(r2 + d, g2 + d, b2 + d);
+		palette[3].set(r2 - d, g2 - d, b2 - d);
 	}
 
-	void decodePlanarBlock(unsigned char *dest, int x, int y, int w, int h, int pitch, unsigned char alphaValues[4][4]) const
+	void decodePlanarBlock(unsigned char *dest, int x, int y, int w, int h, int pitch, const unsigned char (*alphaValues)[4]) const
 	{
 		int ro = extend_6to8bits(RO);
 		int go = extend_7to8bits(GO1 << 6 | GO2);
@@ -580,69 +654,31 @@ private:
 				((bgra8 *)(dest))[i].set(((i * (rh - ro) + ry) >> 2) + ro,
 				                         ((i * (gh - go) + gy) >> 2) + go,
 				                         ((i * (bh - bo) + by) >> 2) + bo,
-				                         alphaValues[j][i]);
+				                         alphaValues ? alphaValues[j][i] : 255);
 			}
 			dest += pitch;
 		}
 	}
 
-	// Index for individual, differential, H and T modes
-	inline int getIndex(int x, int y) const
+	// Palette index of each texel for individual, differential, H and T modes, in row-major order
+	void getIndices(uint8_t indices[16]) const
 	{
-		int bitIndex = x * 4 + y;
-		int bitOffset = bitIndex & 7;
-		int lsb = (pixelIndexLSB[1 - (bitIndex >> 3)] >> bitOffset) & 1;
-		int msb = (pixelIndexMSB[1 - (bitIndex >> 3)] >> bitOffset) & 1;
-
-		return (msb << 1) | lsb;
-	}
+		// The index bits are stored in column-major order
+		int msb = pixelIndexMSB[0] << 8 | pixelIndexMSB[1];
+		int lsb = pixelIndexLSB[0] << 8 | pixelIndexLSB[1];
 
-	void decodePunchThroughAlphaBlock(unsigned char *dest, int x, int y, int w, int h, int pitch) const
-	{
-		for(int j = 0; j < 4 && (y + j) < h; j++)
+		for(int j = 0; j < 4; j++)
 		{
-			for(int i = 0; i < 4 && (x + i) < w; i++)
+			for(int i = 0; i < 4; i++)
 			{
-				if(getIndex(i, j) == 2)  //  msb == 1 && lsb == 0
-				{
-					((bgra8 *)dest)[i].set(0, 0, 0, 0);
-				}
+				int bit = i * 4 + j;
+				indices[j * 4 + i] = static_cast<uint8_t>(((msb >> bit) & 1) << 1 | ((lsb >> bit) & 1));
 			}
-			dest += pitch;
 		}
 	}
 
-	// Single channel utility functions
-	inline int getSingleChannel(int x, int y, bool isSigned, bool isEAC) const
-	{
-		int codeword = isSigned ? signed_base_codeword : base_codeword;
-		return isEAC ? ((multiplier == 0) ? (codeword * 8 + 4 + getSingleChannelModifier(x, y)) : (codeword * 8 + 4 + getSingleChannelModifier(x, y) * multiplier * 8)) : codeword + getSingleChannelModifier(x, y) * multiplier;
-	}
-
-	inline int getSingleChannelIndex(int x, int y) const
-	{
-		switch(x * 4 + y)
-		{
-		case 0: return ma;
-		case 1: return mb;
-		case 2: return mc1 << 1 | mc2;
-		case 3: return md;
-		case 4: return me;
-		case 5: return mf1 << 2 | mf2;
-		case 6: return mg;
-		case 7: return mh;
-		case 8: return mi;
-		case 9: return mj;
-		case 10: return mk1 << 1 | mk2;
-		case 11: return ml;
-		case 12: return mm;
-		case 13: return mn1 << 2 | mn2;
-		case 14: return mo;
-		default: return mp;  // 15
-		}
-	}
-
-	inline int getSingleChannelModifier(int x, int y) const
+	// Single channel values of each texel, in row-major order
+	void getSingleChannel(int values[16], bool isSigned, bool isEAC) const
 	{
 		static const int modifierTable[16][8] = { { -3, -6, -9, -15, 2, 5, 8, 14 },
 			                                      { -3, -7, -10, -13, 2, 6, 9, 12 },
@@ -661,74 +697,105 @@ private:
 			                                      { -4, -6, -8, -9, 3, 5, 7, 8 },
 			                                      { -3, -5, -7, -9, 2, 4, 6, 8 } };
 
-		return modifierTable[table_index][getSingleChannelIndex(x, y)];
+		const int *modifiers = modifierTable[table_index];
+
+		// The 3-bit modifier indices of each texel are stored as a big-endian
+		// 48-bit value, in column-major order.
+		const unsigned char *bytes = reinterpret_cast<const unsigned char *>(this);
+		uint64_t modifierIndices = 0;
+		for(int i = 2; i < 8; i++)
+		{
+			modifierIndices = (modifierIndices << 8) | bytes[i];
+		}
+
+		int codeword = isSigned ? signed_base_codeword : base_codeword;
+		int base = isEAC ? (codeword * 8 + 4) : codeword;
+		int scale = isEAC ? ((multiplier == 0) ? 1 : (multiplier * 8)) : multiplier;
+
+		for(int j = 0; j < 4; j++)
+		{
+			for(int i = 0; i < 4; i++)
+			{
+				int texel = i * 4 + j;
+				values[j * 4 + i] = base + modifiers[(modifierIndices >> (45 - 3 * texel)) & 7] * scale;
+			}
+		}
 	}
 };
-}  // namespace
 
-// Decodes 1 to 4 channel images to 8 bit output
-bool ETC_Decoder::Decode(const unsigned char *src, unsigned char *dst, int w, int h, int dstPitch, int dstBpp, InputType inputType)
+void decodeBlock(const ETC2 *block, unsigned char *dest, int x, int y, int w, int h, int dstPitch, ETC_Decoder::InputType inputType)
 {
-	const ETC2 *sources[2];
-	sources[0] = (const ETC2 *)src;
-
-	unsigned char alphaValues[4][4] = { { 255, 255, 255, 255 }, { 255, 255, 255, 255 }, { 255, 255, 255, 255 }, { 255, 255, 255, 255 } };
-
 	switch(inputType)
 	{
-	case ETC_R_SIGNED:
-	case ETC_R_UNSIGNED:
-		for(int y = 0; y < h; y += 4)
+	case ETC_Decoder::ETC_R_SIGNED:
+	case ETC_Decoder::ETC_R_UNSIGNED:
+		ETC2::DecodeBlock(&block, dest, 1, x, y, w, h, dstPitch, inputType == ETC_Decoder::ETC_R_SIGNED, true);
+		break;
+	case ETC_Decoder::ETC_RG_SIGNED:
+	case ETC_Decoder::ETC_RG_UNSIGNED:
 		{
-			unsigned char *dstRow = dst + (y * dstPitch);
-			for(int x = 0; x < w; x += 4, sources[0]++)
-			{
-				ETC2::DecodeBlock(sources, dstRow + (x * dstBpp), 1, x, y, w, h, dstPitch, inputType == ETC_R_SIGNED, true);
-			}
+			const ETC2 *sources[2] = { block, block + 1 };
+			ETC2::DecodeBlock(sources, dest, 2, x, y, w, h, dstPitch, inputType == ETC_Decoder::ETC_RG_SIGNED, true);
 		}
 		break;
-	case ETC_RG_SIGNED:
-	case ETC_RG_UNSIGNED:
-		sources[1] = sources[0] + 1;
-		for(int y = 0; y < h; y += 4)
+	case ETC_Decoder::ETC_RGB:
+	case ETC_Decoder::ETC_RGB_PUNCHTHROUGH_ALPHA:
+		block->decodeBlock(dest, x, y, w, h, dstPitch, nullptr, inputType == ETC_Decoder::ETC_RGB_PUNCHTHROUGH_ALPHA);
+		break;
+	case ETC_Decoder::ETC_RGBA:
 		{
-			unsigned char *dstRow = dst + (y * dstPitch);
-			for(int x = 0; x < w; x += 4, sources[0] += 2, sources[1] += 2)
-			{
-				ETC2::DecodeBlock(sources, dstRow + (x * dstBpp), 2, x, y, w, h, dstPitch, inputType == ETC_RG_SIGNED, true);
-			}
+			// RGBA packets are 128 bits, with the alpha in the first 64 bit packet and the RGB color in the second
+			// Texels beyond the edge of the image aren't decoded, so keep them defined.
+			unsigned char alphaValues[4][4] = { { 255, 255, 255, 255 }, { 255, 255, 255, 255 }, { 255, 255, 255, 255 }, { 255, 255, 255, 255 } };
+			ETC2::DecodeBlock(&block, &(alphaValues[0][0]), 1, x, y, w, h, 4, false, false);
+			block[1].decodeBlock(dest, x, y, w, h, dstPitch, alphaValues, false);
 		}
 		break;
+	}
+}
+
+}  // namespace
+
+// Decodes 1 to 4 channel images to 8 bit output
+bool ETC_Decoder::Decode(const unsigned char *src, unsigned char *dst, int w, int h, int dstPitch, int dstBpp, InputType inputType)
+{
+	int blockSize = 0;  // In 64 bit packets
+
+	switch(inputType)
+	{
+	case ETC_R_SIGNED:
+	case ETC_R_UNSIGNED:
 	case ETC_RGB:
 	case ETC_RGB_PUNCHTHROUGH_ALPHA:
-		for(int y = 0; y < h; y += 4)
-		{
-			unsigned char *dstRow = dst + (y * dstPitch);
-			for(int x = 0; x < w; x += 4, sources[0]++)
-			{
-				sources[0]->decodeBlock(dstRow + (x * dstBpp), x, y, w, h, dstPitch, alphaValues, inputType == ETC_RGB_PUNCHTHROUGH_ALPHA);
-			}
-		}
+		blockSize = 1;
 		break;
+	case ETC_RG_SIGNED:
+	case ETC_RG_UNSIGNED:
 	case ETC_RGBA:
-		for(int y = 0; y < h; y += 4)
+		blockSize = 2;
+		break;
+	default:
+		return false;
+	}
+
+	// Rows of blocks are decoded concurrently
+	int blocksPerRow = (w + 3) / 4;
+	uint32_t rowCount = static_cast<uint32_t>((h + 3) / 4);
+	uint32_t minRows = static_cast<uint32_t>(std::max(MinParallelBlocks / std::max(blocksPerRow, 1), 1));
+
+	sw::parallelFor(rowCount, minRows, [&](uint32_t firstRow, uint32_t lastRow) {
+		const ETC2 *block = reinterpret_cast<const ETC2 *>(src) + static_cast<size_t>(firstRow) * blocksPerRow * blockSize;
+
+		for(uint32_t row = firstRow; row < lastRow; row++)
 		{
+			int y = row * 4;
 			unsigned char *dstRow = dst + (y * dstPitch);
-			for(int x = 0; x < w; x += 4)
+			for(int x = 0; x < w; x += 4, block += blockSize)
 			{
-				// Decode Alpha
-				ETC2::DecodeBlock(&sources[0], &(alphaValues[0][0]), 1, x, y, w, h, 4, false, false);
-				sources[0]++;  // RGBA packets are 128 bits, so move on to the next 64 bit packet to decode the RGB color
-
-				// Decode RGB
-				sources[0]->decodeBlock(dstRow + (x * dstBpp), x, y, w, h, dstPitch, alphaValues, false);
-				sources[0]++;
+				decodeBlock(block, dstRow + (x * dstBpp), x, y, w, h, dstPitch, inputType);
 			}
 		}
-		break;
-	default:
-		return false;
-	}
+	});
 
 	return true;
 }
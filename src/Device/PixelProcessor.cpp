@@ -18,6 +18,7 @@
 #include "Pipeline/Constants.hpp"
 #include "Pipeline/PixelProgram.hpp"
 #include "System/Debug.hpp"
+#include "System/Trace.hpp"
 #include "Vulkan/VkImageView.hpp"
 #include "Vulkan/VkPipelineLayout.hpp"
 
@@ -196,6 +197,8 @@ PixelProcessor::RoutineType PixelProcessor::routine(const State &state,
 
 	if(!routine)
 	{
+		SW_TRACE_SCOPE("compile", "PixelRoutine", { "shader", static_cast<int64_t>(state.shaderID) });
+		rr::ScopedPragma optimizationProfile(rr::OptimizationProfile, pixelShader ? pixelShader->getOptimizationProfile() : rr::FastCompileProfile);
 		QuadRasterizer *generator = new PixelProgram(state, pipelineLayout, pixelShader, attachments, descriptorSets);
 		generator->generate();
 		routine = (*generator)("PixelRoutine_%0.8X", state.shaderID);
@@ -165,12 +165,6 @@ void QuadRasterizer::rasterize(Int &yMin, Int &yMax)
 					}
 				}
 
-				for(unsigned int i = 0; i < state.numClipDistances; i++)
-				{
-					DclipDistance[i] = SIMD::Float(*Pointer<Float>(primitive + OFFSET(Primitive, clipDistance[i].C))) +
-					                   yFragment * SIMD::Float(*Pointer<Float>(primitive + OFFSET(Primitive, clipDistance[i].B)));
-				}
-
 				for(unsigned int i = 0; i < state.numCullDistances; i++)
 				{
 					DcullDistance[i] = SIMD::Float(*Pointer<Float>(primitive + OFFSET(Primitive, cullDistance[i].C))) +
@@ -178,6 +172,13 @@ void QuadRasterizer::rasterize(Int &yMin, Int &yMax)
 				}
 			}
 
+			// Clip distances also apply to draws without a fragment shader.
+			for(unsigned int i = 0; i < state.numClipDistances; i++)
+			{
+				DclipDistance[i] = SIMD::Float(*Pointer<Float>(primitive + OFFSET(Primitive, clipDistance[i].C))) +
+				                   yFragment * SIMD::Float(*Pointer<Float>(primitive + OFFSET(Primitive, clipDistance[i].B)));
+			}
+
 			Short4 xLeft[4];
 			Short4 xRight[4];
 
@@ -258,7 +259,7 @@ bool QuadRasterizer::interpolateW() const
 {
 	// Note: could optimize cases where there is a fragment shader but it has no
 	// perspective-correct inputs, but that's vanishingly rare.
-	return spirvShader != nullptr;
+	return (spirvShader != nullptr) || (state.numClipDistances > 0);
 }
 
 }  // namespace sw
@@ -26,6 +26,7 @@
 #include "System/Math.hpp"
 #include "System/Memory.hpp"
 #include "System/Timer.hpp"
+#include "System/Trace.hpp"
 #include "Vulkan/VkConfig.hpp"
 #include "Vulkan/VkDescriptorSet.hpp"
 #include "Vulkan/VkDevice.hpp"
@@ -38,6 +39,8 @@
 #include "marl/defer.h"
 #include "marl/trace.h"
 
+#include <bitset>
+
 #undef max
 
 #ifndef NDEBUG
@@ -144,14 +147,190 @@ inline bool setBatchIndices(unsigned int batch[128][3], VkPrimitiveTopology topo
 	return true;
 }
 
+// Assembles a batch of primitives which may include the primitive restart index.
+// Primitives which include it are dropped, which splits strips in place instead
+// of drawing each range separately. Triangle strips alternate their winding
+// from the start of each strip, and fans share its first vertex, so stripStart
+// is the index of the first vertex of the strip containing the first primitive.
+// Only topologies for which vk::IndexBuffer::SupportsBatchPrimitiveRestart()
+// is true are handled. Returns the number of primitives written to the batch.
+template<typename T>
+inline unsigned int setBatchIndicesWithRestart(unsigned int batch[128][3], VkPrimitiveTopology topology, VkProvokingVertexModeEXT provokingVertexMode, const T *indices, unsigned int start, unsigned int primitiveCount, unsigned int stripStart)
+{
+	const T restartIndex = static_cast<T>(-1);
+	bool provokeFirst = (provokingVertexMode == VK_PROVOKING_VERTEX_MODE_FIRST_VERTEX_EXT);
+	unsigned int count = 0;
+
+	switch(topology)
+	{
+	case VK_PRIMITIVE_TOPOLOGY_POINT_LIST:
+		{
+			auto pointBatch = &(batch[0][0]);
+			for(unsigned int i = start; i < start + primitiveCount; i++)
+			{
+				if(indices[i] != restartIndex)
+				{
+					*pointBatch++ = indices[i];
+					count++;
+				}
+			}
+
+			// Repeat the last index to allow for SIMD width overrun.
+			if(count > 0)
+			{
+				unsigned int last = *(pointBatch - 1);
+				for(unsigned int i = 0; i < 3; i++)
+				{
+					*pointBatch++ = last;
+				}
+			}
+		}
+		break;
+	case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP:
+		{
+			for(unsigned int i = start; i < start + primitiveCount; i++)
+			{
+				if(indices[i] != restartIndex && indices[i + 1] != restartIndex)
+				{
+					batch[count][0] = indices[i + (provokeFirst ? 0 : 1)];
+					batch[count][1] = indices[i + (provokeFirst ? 1 : 0)];
+					batch[count][2] = indices[i + 1];
+					count++;
+				}
+			}
+		}
+		break;
+	case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP:
+		{
+			for(unsigned int i = start; i < start + primitiveCount; i++)
+			{
+				if(indices[i] == restartIndex)
+				{
+					stripStart = i + 1;
+				}
+				else if(indices[i + 1] != restartIndex && indices[i + 2] != restartIndex)
+				{
+					unsigned int parity = (i - stripStart) & 1;
+					batch[count][0] = indices[i + (provokeFirst ? 0 : 2)];
+					batch[count][1] = indices[i + parity + (provokeFirst ? 1 : 0)];
+					batch[count][2] = indices[i + (~parity & 1) + (provokeFirst ? 1 : 0)];
+					count++;
+				}
+			}
+		}
+		break;
+	case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_FAN:
+		{
+			// Fan primitive i consists of the hub and vertices i + 1 and i + 2.
+			for(unsigned int i = start; i < start + primitiveCount; i++)
+			{
+				if(indices[i] == restartIndex)
+				{
+					stripStart = i + 1;
+				}
+
+				if(i + 1 > stripStart && indices[i + 1] != restartIndex && indices[i + 2] != restartIndex)
+				{
+					batch[count][provokeFirst ? 0 : 2] = indices[i + 1];
+					batch[count][provokeFirst ? 1 : 0] = indices[i + 2];
+					batch[count][provokeFirst ? 2 : 1] = indices[stripStart];
+					count++;
+				}
+			}
+		}
+		break;
+	default:
+		ASSERT(false);
+		break;
+	}
+
+	return count;
+}
+
+// Records the start of the strip containing the first primitive of each batch,
+// so that batches of strips and fans with primitive restart can be assembled
+// independently. Only the indices before the last batch need to be scanned.
+template<typename T>
+static void setBatchStripStarts(std::vector<unsigned int> &stripStarts, const T *indices, unsigned int numBatches, unsigned int numPrimitivesPerBatch)
+{
+	const T restartIndex = static_cast<T>(-1);
+	unsigned int stripStart = 0;
+	unsigned int i = 0;
+
+	stripStarts.resize(numBatches);
+	for(unsigned int batch = 0; batch < numBatches; batch++)
+	{
+		for(; i < batch * numPrimitivesPerBatch; i++)
+		{
+			if(indices[i] == restartIndex)
+			{
+				stripStart = i + 1;
+			}
+		}
+
+		stripStarts[batch] = stripStart;
+	}
+}
+
+// Returns true if running the fragment shader has no observable effect, which is
+// common for shadow map and depth pre-pass pipelines. Dropping it leaves only
+// the depth and stencil operations, which use the depth-only pixel routine.
+// That routine still applies the vertex shader's clip distances.
+static bool isFragmentShaderRedundant(const sw::SpirvShader *fragmentShader, const vk::FragmentOutputInterfaceState &fragmentOutputInterfaceState, const vk::Attachments &attachments)
+{
+	if(!fragmentShader)
+	{
+		return true;
+	}
+
+	const auto &analysis = fragmentShader->getAnalysis();
+	if(analysis.ContainsDiscard || analysis.ContainsImageWrite || analysis.ContainsMemoryWrite)
+	{
+		return false;
+	}
+
+	const auto &modes = fragmentShader->getExecutionModes();
+	if(modes.DepthReplacing || modes.StencilRefReplacing ||
+	   fragmentShader->hasBuiltinOutput(spv::BuiltInFragDepth) ||
+	   fragmentShader->hasBuiltinOutput(spv::BuiltInFragStencilRefEXT) ||
+	   fragmentShader->hasBuiltinOutput(spv::BuiltInSampleMask))
+	{
+		return false;
+	}
+
+	// Alpha-to-coverage depends on the shader's output even without color writes.
+	if(fragmentOutputInterfaceState.hasAlphaToCoverage())
+	{
+		return false;
+	}
+
+	for(uint32_t location = 0; location < MAX_COLOR_BUFFERS; location++)
+	{
+		if(fragmentOutputInterfaceState.colorWriteActive(location, attachments))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+DrawCall::BatchData::~BatchData()
+{
+	sw::freeMemory(viewPrimitives);
+}
+
 DrawCall::DrawCall()
 {
 	// TODO(b/140991626): Use allocateUninitialized() instead of allocateZeroOrPoison() to improve startup peformance.
 	data = (DrawData *)sw::allocateZeroOrPoison(sizeof(DrawData));
+	viewData = nullptr;
+	viewCount = 1;
 }
 
 DrawCall::~DrawCall()
 {
+	sw::freeMemory(viewData);
 	sw::freeMemory(data);
 }
 
@@ -181,13 +360,16 @@ void Renderer::operator delete(void *mem)
 }
 
 void Renderer::draw(const vk::GraphicsPipeline *pipeline, const vk::DynamicState &dynamicState, unsigned int count, int baseVertex,
-                    CountedEvent *events, int instanceID, int layer, void *indexBuffer, const VkRect2D &renderArea,
-                    const vk::Pipeline::PushConstantStorage &pushConstants, bool update)
+                    CountedEvent *events, int instanceID, uint32_t viewMask, void *indexBuffer, const VkRect2D &renderArea,
+                    const vk::Pipeline::PushConstantStorage &pushConstants, const std::vector<vk::DrawRecord> *records, bool update)
 {
 	if(count == 0) { return; }
 
+	ASSERT(viewMask != 0 && viewMask < (1u << vk::MAX_MULTIVIEW_VIEW_COUNT));
+
 	auto id = nextDrawID++;
 	MARL_SCOPED_EVENT("draw %d", id);
+	SW_TRACE_SCOPE("renderer", "draw", { "draw", id }, { "count", count });
 
 	marl::Pool<sw::DrawCall>::Loan draw;
 	{
@@ -234,8 +416,20 @@ void Renderer::draw(const vk::GraphicsPipeline *pipeline, const vk::DynamicState
 		vertexState = vertexProcessor.update(pipelineState, vertexShader, inputs);
 		vertexRoutine = vertexProcessor.routine(vertexState, preRasterizationState.getPipelineLayout(), vertexShader, inputs.getDescriptorSets());
 
+		positionRoutine = {};
+		if(const sw::SpirvShader *positionShader = pipeline->getPositionShader())
+		{
+			positionState = vertexProcessor.update(pipelineState, positionShader, inputs);
+			positionRoutine = vertexProcessor.routine(positionState, preRasterizationState.getPipelineLayout(), positionShader, inputs.getDescriptorSets());
+		}
+
 		if(!hasRasterizerDiscard)
 		{
+			if(isFragmentShaderRedundant(fragmentShader, *fragmentOutputInterfaceState, attachments))
+			{
+				fragmentShader = nullptr;
+			}
+
 			setupState = setupProcessor.update(pipelineState, fragmentShader, vertexShader, attachments);
 			setupRoutine = setupProcessor.routine(setupState);
 
@@ -282,12 +476,44 @@ void Renderer::draw(const vk::GraphicsPipeline *pipeline, const vk::DynamicState
 	}
 
 	data->indices = indexBuffer;
-	data->layer = layer;
+	data->layer = sw::log2i(viewMask & (~viewMask + 1));  // Lowest view
+	draw->viewCount = hasRasterizerDiscard ? 1 : static_cast<int>(std::bitset<32>(viewMask).count());
 	data->instanceID = instanceID;
 	data->baseVertex = baseVertex;
+
+	draw->records.clear();
+	draw->batchRanges.clear();
+	if(records && records->size() > 1)
+	{
+		draw->setBatchRanges(*records);
+		data->baseVertex = 0;  // Added to the indices of each record instead
+	}
 	draw->indexType = indexBuffer ? pipeline->getIndexBuffer().getIndexType() : VK_INDEX_TYPE_UINT16;
+	draw->primitiveRestart = indexBuffer && vertexInputInterfaceState.hasPrimitiveRestartEnable() &&
+	                         vk::IndexBuffer::SupportsBatchPrimitiveRestart(draw->topology);
+
+	draw->batchStripStarts.clear();
+	if(draw->primitiveRestart &&
+	   (draw->topology == VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP || draw->topology == VK_PRIMITIVE_TOPOLOGY_TRIANGLE_FAN))
+	{
+		switch(draw->indexType)
+		{
+		case VK_INDEX_TYPE_UINT8_EXT:
+			setBatchStripStarts(draw->batchStripStarts, static_cast<const uint8_t *>(indexBuffer), draw->numBatches, numPrimitivesPerBatch);
+			break;
+		case VK_INDEX_TYPE_UINT16:
+			setBatchStripStarts(draw->batchStripStarts, static_cast<const uint16_t *>(indexBuffer), draw->numBatches, numPrimitivesPerBatch);
+			break;
+		case VK_INDEX_TYPE_UINT32:
+			setBatchStripStarts(draw->batchStripStarts, static_cast<const uint32_t *>(indexBuffer), draw->numBatches, numPrimitivesPerBatch);
+			break;
+		default:
+			ASSERT(false);
+		}
+	}
 
 	draw->vertexRoutine = vertexRoutine;
+	draw->positionRoutine = (draw->viewCount > 1) ? positionRoutine : VertexProcessor::RoutineType();
 
 	vk::DescriptorSet::PrepareForSampling(draw->descriptorSetObjects, draw->preRasterizationPipelineLayout, device);
 
@@ -447,7 +673,6 @@ void Renderer::draw(const vk::GraphicsPipeline *pipeline, const vk::DynamicState
 
 				if(draw->colorBuffer[index])
 				{
-					data->colorBuffer[index] = (unsigned int *)attachments.colorBuffer[index]->getOffsetPointer({ 0, 0, 0 }, VK_IMAGE_ASPECT_COLOR_BIT, 0, data->layer);
 					data->colorPitchB[index] = attachments.colorBuffer[index]->rowPitchBytes(VK_IMAGE_ASPECT_COLOR_BIT, 0);
 					data->colorSliceB[index] = attachments.colorBuffer[index]->slicePitchBytes(VK_IMAGE_ASPECT_COLOR_BIT, 0);
 				}
@@ -458,17 +683,27 @@ void Renderer::draw(const vk::GraphicsPipeline *pipeline, const vk::DynamicState
 
 			if(draw->depthBuffer)
 			{
-				data->depthBuffer = (float *)attachments.depthBuffer->getOffsetPointer({ 0, 0, 0 }, VK_IMAGE_ASPECT_DEPTH_BIT, 0, data->layer);
 				data->depthPitchB = attachments.depthBuffer->rowPitchBytes(VK_IMAGE_ASPECT_DEPTH_BIT, 0);
 				data->depthSliceB = attachments.depthBuffer->slicePitchBytes(VK_IMAGE_ASPECT_DEPTH_BIT, 0);
 			}
 
 			if(draw->stencilBuffer)
 			{
-				data->stencilBuffer = (unsigned char *)attachments.stencilBuffer->getOffsetPointer({ 0, 0, 0 }, VK_IMAGE_ASPECT_STENCIL_BIT, 0, data->layer);
 				data->stencilPitchB = attachments.stencilBuffer->rowPitchBytes(VK_IMAGE_ASPECT_STENCIL_BIT, 0);
 				data->stencilSliceB = attachments.stencilBuffer->slicePitchBytes(VK_IMAGE_ASPECT_STENCIL_BIT, 0);
 			}
+
+			// Clears of the attachments recorded at the start of the render pass may still be
+			// pending. Each pixel cluster performs them before it first writes to the rows.
+			draw->hasDeferredClears = (draw->depthBuffer && draw->depthBuffer->hasDeferredClears()) ||
+			                          (draw->stencilBuffer && draw->stencilBuffer->hasDeferredClears());
+			for(int index = 0; index < MAX_COLOR_BUFFERS; index++)
+			{
+				if(draw->colorBuffer[index] && draw->colorBuffer[index]->hasDeferredClears())
+				{
+					draw->hasDeferredClears = true;
+				}
+			}
 		}
 
 		if(draw->fragmentPipelineLayout != draw->preRasterizationPipelineLayout)
@@ -482,11 +717,126 @@ void Renderer::draw(const vk::GraphicsPipeline *pipeline, const vk::DynamicState
 		data->pushConstants = pushConstants;
 	}
 
+	if(!hasRasterizerDiscard)
+	{
+		draw->setTargetLayer(data, data->layer);
+
+		if(draw->viewCount > 1)
+		{
+			if(!draw->viewData)
+			{
+				draw->viewData = (DrawData *)sw::allocateZeroOrPoison(sizeof(DrawData) * (vk::MAX_MULTIVIEW_VIEW_COUNT - 1));
+			}
+
+			// The other views only differ in the layer they render to.
+			uint32_t remainingViews = viewMask & (viewMask - 1);
+			for(int view = 1; view < draw->viewCount; view++)
+			{
+				DrawData *viewData = draw->getViewData(view);
+				*viewData = *data;
+				draw->setTargetLayer(viewData, sw::log2i(remainingViews & (~remainingViews + 1)));
+				remainingViews &= remainingViews - 1;
+			}
+		}
+	}
+
 	draw->events = events;
 
 	DrawCall::run(device, draw, &drawTickets, clusterQueues);
 }
 
+void DrawCall::setTargetLayer(DrawData *data, int layer) const
+{
+	data->layer = layer;
+
+	for(int index = 0; index < MAX_COLOR_BUFFERS; index++)
+	{
+		if(colorBuffer[index])
+		{
+			data->colorBuffer[index] = (unsigned int *)colorBuffer[index]->getOffsetPointer({ 0, 0, 0 }, VK_IMAGE_ASPECT_COLOR_BIT, 0, layer);
+		}
+	}
+
+	if(depthBuffer)
+	{
+		data->depthBuffer = (float *)depthBuffer->getOffsetPointer({ 0, 0, 0 }, VK_IMAGE_ASPECT_DEPTH_BIT, 0, layer);
+	}
+
+	if(stencilBuffer)
+	{
+		data->stencilBuffer = (unsigned char *)stencilBuffer->getOffsetPointer({ 0, 0, 0 }, VK_IMAGE_ASPECT_STENCIL_BIT, 0, layer);
+	}
+}
+
+void DrawCall::setBatchRanges(const std::vector<vk::DrawRecord> &drawRecords)
+{
+	records = drawRecords;
+
+	unsigned int record = 0;
+	unsigned int first = 0;
+	while(first < numPrimitives)
+	{
+		while(record + 1 < records.size() && records[record + 1].firstPrimitive <= first)
+		{
+			record++;
+		}
+
+		// End the batch early where the instance offset changes, since all of
+		// its vertices are processed with the same instance ID.
+		unsigned int end = std::min(first + numPrimitivesPerBatch, numPrimitives);
+		for(unsigned int next = record + 1; next < records.size() && records[next].firstPrimitive < end; next++)
+		{
+			if(records[next].instanceOffset != records[record].instanceOffset)
+			{
+				end = records[next].firstPrimitive;
+				break;
+			}
+		}
+
+		batchRanges.push_back({ first, end - first, record });
+		first = end;
+	}
+
+	numBatches = static_cast<unsigned int>(batchRanges.size());
+}
+
+void DrawCall::addBaseVertices(BatchData *batch) const
+{
+	const bool isPoint = (topology == VK_PRIMITIVE_TOPOLOGY_POINT_LIST);
+	unsigned int *pointIndices = &batch->triangleIndices[0][0];
+	unsigned int record = batchRanges[batch->id].record;
+
+	for(unsigned int i = 0; i < batch->numPrimitives; i++)
+	{
+		const unsigned int primitive = batch->firstPrimitive + i;
+		while(record + 1 < records.size() && records[record + 1].firstPrimitive <= primitive)
+		{
+			record++;
+		}
+
+		const unsigned int baseVertex = static_cast<unsigned int>(records[record].baseVertex);
+		if(isPoint)
+		{
+			pointIndices[i] += baseVertex;
+		}
+		else
+		{
+			batch->triangleIndices[i][0] += baseVertex;
+			batch->triangleIndices[i][1] += baseVertex;
+			batch->triangleIndices[i][2] += baseVertex;
+		}
+	}
+
+	if(isPoint && batch->numPrimitives > 0)
+	{
+		// Repeat the last index to allow for SIMD width overrun.
+		for(unsigned int i = 0; i < 3; i++)
+		{
+			pointIndices[batch->numPrimitives + i] = pointIndices[batch->numPrimitives - 1];
+		}
+	}
+}
+
 void DrawCall::setup()
 {
 	if(occlusionQuery != nullptr)
@@ -509,6 +859,7 @@ void DrawCall::teardown(vk::Device *device)
 	}
 
 	vertexRoutine = {};
+	positionRoutine = {};
 	setupRoutine = {};
 	pixelRoutine = {};
 
@@ -521,9 +872,12 @@ void DrawCall::teardown(vk::Device *device)
 	{
 		if(occlusionQuery != nullptr)
 		{
-			for(int cluster = 0; cluster < MaxClusterCount; cluster++)
+			for(int view = 0; view < viewCount; view++)
 			{
-				occlusionQuery->add(data->occlusion[cluster]);
+				for(int cluster = 0; cluster < MaxClusterCount; cluster++)
+				{
+					occlusionQuery->add(getViewData(view)->occlusion[cluster]);
+				}
 			}
 			occlusionQuery->finish();
 		}
@@ -557,6 +911,7 @@ void DrawCall::run(vk::Device *device, const marl::Loan<DrawCall> &draw, marl::T
 	auto ticket = tickets->take();
 	auto finally = marl::make_shared_finally([device, draw, ticket] {
 		MARL_SCOPED_EVENT("FINISH draw %d", draw->id);
+		SW_TRACE_SCOPE("renderer", "finish", { "draw", draw->id });
 		draw->teardown(device);
 		ticket.done();
 	});
@@ -565,8 +920,16 @@ void DrawCall::run(vk::Device *device, const marl::Loan<DrawCall> &draw, marl::T
 	{
 		auto batch = draw->batchDataPool->borrow();
 		batch->id = batchId;
-		batch->firstPrimitive = batch->id * numPrimitivesPerBatch;
-		batch->numPrimitives = std::min(batch->firstPrimitive + numPrimitivesPerBatch, numPrimitives) - batch->firstPrimitive;
+		if(!draw->batchRanges.empty())
+		{
+			batch->firstPrimitive = draw->batchRanges[batchId].firstPrimitive;
+			batch->numPrimitives = draw->batchRanges[batchId].numPrimitives;
+		}
+		else
+		{
+			batch->firstPrimitive = batch->id * numPrimitivesPerBatch;
+			batch->numPrimitives = std::min(batch->firstPrimitive + numPrimitivesPerBatch, numPrimitives) - batch->firstPrimitive;
+		}
 
 		for(int cluster = 0; cluster < MaxClusterCount; cluster++)
 		{
@@ -580,7 +943,16 @@ void DrawCall::run(vk::Device *device, const marl::Loan<DrawCall> &draw, marl::T
 			{
 				processPrimitives(device, draw.get(), batch.get());
 
-				if(batch->numVisible > 0)
+				bool visible = (batch->numVisible > 0);
+				if(draw->positionRoutine)
+				{
+					for(int view = 1; view < draw->viewCount; view++)
+					{
+						visible = visible || (batch->getNumVisible(view) > 0);
+					}
+				}
+
+				if(visible)
 				{
 					processPixels(device, draw, batch, finally);
 					return;
@@ -598,39 +970,86 @@ void DrawCall::run(vk::Device *device, const marl::Loan<DrawCall> &draw, marl::T
 void DrawCall::processVertices(vk::Device *device, DrawCall *draw, BatchData *batch)
 {
 	MARL_SCOPED_EVENT("VERTEX draw %d, batch %d", draw->id, batch->id);
+	SW_TRACE_SCOPE("renderer", "vertex", { "draw", draw->id }, { "batch", batch->id });
 
-	unsigned int triangleIndices[MaxBatchSize + 1][3];  // One extra for SIMD width overrun. TODO: Adjust to dynamic batch size.
+	auto &triangleIndices = batch->triangleIndices;
 	{
 		MARL_SCOPED_EVENT("processPrimitiveVertices");
-		processPrimitiveVertices(
+		batch->numPrimitives = processPrimitiveVertices(
 		    triangleIndices,
 		    draw->data->indices,
 		    draw->indexType,
 		    batch->firstPrimitive,
 		    batch->numPrimitives,
 		    draw->topology,
-		    draw->provokingVertexMode);
+		    draw->provokingVertexMode,
+		    draw->primitiveRestart,
+		    draw->batchStripStarts.empty() ? 0 : draw->batchStripStarts[batch->id]);
+	}
+
+	int instanceOffset = 0;
+	if(!draw->batchRanges.empty())
+	{
+		draw->addBaseVertices(batch);
+		instanceOffset = draw->records[draw->batchRanges[batch->id].record].instanceOffset;
 	}
 
 	auto &vertexTask = batch->vertexTask;
 	vertexTask.primitiveStart = batch->firstPrimitive;
 	// We're only using batch compaction for points, not lines
 	vertexTask.vertexCount = batch->numPrimitives * ((draw->topology == VK_PRIMITIVE_TOPOLOGY_POINT_LIST) ? 1 : 3);
-	if(vertexTask.vertexCache.drawCall != draw->id)
+	// The position routine leaves the cache holding the last view's positions.
+	bool sameInstance = (vertexTask.instanceOffset == instanceOffset);
+	vertexTask.instanceOffset = instanceOffset;
+	if(vertexTask.vertexCache.drawCall != draw->id || !sameInstance || draw->positionRoutine)
 	{
 		vertexTask.vertexCache.clear();
 		vertexTask.vertexCache.drawCall = draw->id;
 	}
 
+	if(vertexTask.vertexCount == 0)
+	{
+		return;  // All primitives of the batch were dropped by primitive restart.
+	}
+
 	draw->vertexRoutine(device, &batch->triangles.front().v0, &triangleIndices[0][0], &vertexTask, draw->data);
 }
 
 void DrawCall::processPrimitives(vk::Device *device, DrawCall *draw, BatchData *batch)
 {
 	MARL_SCOPED_EVENT("PRIMITIVES draw %d batch %d", draw->id, batch->id);
+	SW_TRACE_SCOPE("renderer", "primitives", { "draw", draw->id }, { "batch", batch->id });
 	auto triangles = &batch->triangles[0];
 	auto primitives = &batch->primitives[0];
 	batch->numVisible = draw->setupPrimitives(device, triangles, primitives, draw, batch->numPrimitives);
+
+	if(!draw->positionRoutine)
+	{
+		return;
+	}
+
+	if(!batch->viewPrimitives)
+	{
+		batch->viewPrimitives = (Primitive *)sw::allocate(sizeof(Primitive) * MaxBatchSize * (vk::MAX_MULTIVIEW_VIEW_COUNT - 1));
+	}
+
+	// The other views only recompute the position outputs, which overwrite the
+	// first view's in the triangles, and keep all other outputs.
+	for(int view = 1; view < draw->viewCount; view++)
+	{
+		int &numVisible = batch->viewNumVisible[view - 1];
+		numVisible = 0;
+
+		auto &vertexTask = batch->vertexTask;
+		if(vertexTask.vertexCount == 0)
+		{
+			continue;  // All primitives of the batch were dropped by primitive restart.
+		}
+
+		vertexTask.vertexCache.clear();
+		draw->positionRoutine(device, &batch->triangles.front().v0, &batch->triangleIndices[0][0], &vertexTask, draw->getViewData(view));
+		numVisible = draw->setupPrimitives(device, triangles, batch->getPrimitives(view), draw, batch->numPrimitives);
+	}
 }
 
 void DrawCall::processPixels(vk::Device *device, const marl::Loan<DrawCall> &draw, const marl::Loan<BatchData> &batch, const std::shared_ptr<marl::Finally> &finally)
@@ -653,31 +1072,104 @@ void DrawCall::processPixels(vk::Device *device, const marl::Loan<DrawCall> &dra
 			auto &draw = data->draw;
 			auto &batch = data->batch;
 			MARL_SCOPED_EVENT("PIXEL draw %d, batch %d, cluster %d", draw->id, batch->id, cluster);
-			draw->pixelRoutine(device, &batch->primitives.front(), batch->numVisible, cluster, MaxClusterCount, draw->data);
+			SW_TRACE_SCOPE("renderer", "pixel", { "draw", draw->id }, { "batch", batch->id }, { "cluster", cluster });
+			for(int view = 0; view < draw->viewCount; view++)
+			{
+				DrawData *viewData = draw->getViewData(view);
+				// Without a position routine, all views share the first view's primitives.
+				const int primitivesView = draw->positionRoutine ? view : 0;
+				Primitive *primitives = batch->getPrimitives(primitivesView);
+				int numVisible = batch->getNumVisible(primitivesView);
+				if(draw->hasDeferredClears)
+				{
+					draw->clearDeferredRows(primitives, numVisible, cluster, viewData->layer);
+				}
+				draw->pixelRoutine(device, primitives, numVisible, cluster, MaxClusterCount, viewData);
+			}
 			batch->clusterTickets[cluster].done();
 		});
 	}
 }
 
+void DrawCall::clearDeferredRows(const Primitive *primitives, int count, int cluster, int layer) const
+{
+	if(count == 0)
+	{
+		return;
+	}
+
+	int yMin = primitives[0].yMin;
+	int yMax = primitives[0].yMax;
+	for(int i = 1; i < count; i++)
+	{
+		yMin = std::min(yMin, primitives[i].yMin);
+		yMax = std::max(yMax, primitives[i].yMax);
+	}
+
+	for(int index = 0; index < MAX_COLOR_BUFFERS; index++)
+	{
+		if(colorBuffer[index])
+		{
+			colorBuffer[index]->clearDeferredRows(VK_IMAGE_ASPECT_COLOR_BIT, layer, yMin, yMax, cluster, MaxClusterCount);
+		}
+	}
+
+	if(depthBuffer)
+	{
+		depthBuffer->clearDeferredRows(VK_IMAGE_ASPECT_DEPTH_BIT, layer, yMin, yMax, cluster, MaxClusterCount);
+	}
+
+	if(stencilBuffer)
+	{
+		stencilBuffer->clearDeferredRows(VK_IMAGE_ASPECT_STENCIL_BIT, layer, yMin, yMax, cluster, MaxClusterCount);
+	}
+}
+
 void Renderer::synchronize()
 {
 	MARL_SCOPED_EVENT("synchronize");
+	SW_TRACE_SCOPE("renderer", "synchronize");
 	auto ticket = drawTickets.take();
 	ticket.wait();
 	device->updateSamplingRoutineSnapshotCache();
 	ticket.done();
 }
 
-void DrawCall::processPrimitiveVertices(
+unsigned int DrawCall::processPrimitiveVertices(
     unsigned int triangleIndicesOut[MaxBatchSize + 1][3],
     const void *primitiveIndices,
     VkIndexType indexType,
     unsigned int start,
     unsigned int triangleCount,
     VkPrimitiveTopology topology,
-    VkProvokingVertexModeEXT provokingVertexMode)
+    VkProvokingVertexModeEXT provokingVertexMode,
+    bool primitiveRestart,
+    unsigned int stripStart)
 {
-	if(!primitiveIndices)
+	if(primitiveRestart)
+	{
+		switch(indexType)
+		{
+		case VK_INDEX_TYPE_UINT8_EXT:
+			triangleCount = setBatchIndicesWithRestart(triangleIndicesOut, topology, provokingVertexMode, static_cast<const uint8_t *>(primitiveIndices), start, triangleCount, stripStart);
+			break;
+		case VK_INDEX_TYPE_UINT16:
+			triangleCount = setBatchIndicesWithRestart(triangleIndicesOut, topology, provokingVertexMode, static_cast<const uint16_t *>(primitiveIndices), start, triangleCount, stripStart);
+			break;
+		case VK_INDEX_TYPE_UINT32:
+			triangleCount = setBatchIndicesWithRestart(triangleIndicesOut, topology, provokingVertexMode, static_cast<const uint32_t *>(primitiveIndices), start, triangleCount, stripStart);
+			break;
+		default:
+			ASSERT(false);
+			return 0;
+		}
+
+		if(triangleCount == 0)
+		{
+			return 0;
+		}
+	}
+	else if(!primitiveIndices)
 	{
 		struct LinearIndex
 		{
@@ -686,7 +1178,7 @@ void DrawCall::processPrimitiveVertices(
 
 		if(!setBatchIndices(triangleIndicesOut, topology, provokingVertexMode, LinearIndex(), start, triangleCount))
 		{
-			return;
+			return 0;
 		}
 	}
 	else
@@ -696,29 +1188,29 @@ void DrawCall::processPrimitiveVertices(
 		case VK_INDEX_TYPE_UINT8_EXT:
 			if(!setBatchIndices(triangleIndicesOut, topology, provokingVertexMode, static_cast<const uint8_t *>(primitiveIndices), start, triangleCount))
 			{
-				return;
+				return 0;
 			}
 			break;
 		case VK_INDEX_TYPE_UINT16:
 			if(!setBatchIndices(triangleIndicesOut, topology, provokingVertexMode, static_cast<const uint16_t *>(primitiveIndices), start, triangleCount))
 			{
-				return;
+				return 0;
 			}
 			break;
 		case VK_INDEX_TYPE_UINT32:
 			if(!setBatchIndices(triangleIndicesOut, topology, provokingVertexMode, static_cast<const uint32_t *>(primitiveIndices), start, triangleCount))
 			{
-				return;
+				return 0;
 			}
 			break;
 			break;
 		default:
 			ASSERT(false);
-			return;
+			return 0;
 		}
 	}
 
-	// setBatchIndices() takes care of the point case, since it's different due to the compaction
+	// setBatchIndices() and setBatchIndicesWithRestart() take care of the point case, since it's different due to the compaction
 	if(topology != VK_PRIMITIVE_TOPOLOGY_POINT_LIST)
 	{
 		// Repeat the last index to allow for SIMD width overrun.
@@ -726,6 +1218,8 @@ void DrawCall::processPrimitiveVertices(
 		triangleIndicesOut[triangleCount][1] = triangleIndicesOut[triangleCount - 1][2];
 		triangleIndicesOut[triangleCount][2] = triangleIndicesOut[triangleCount - 1][2];
 	}
+
+	return triangleCount;
 }
 
 int DrawCall::setupSolidTriangles(vk::Device *device, Triangle *triangles, Primitive *primitives, const DrawCall *drawCall, int count)
@@ -27,6 +27,7 @@
 #include "marl/ticket.h"
 
 #include <atomic>
+#include <vector>
 
 namespace vk {
 
@@ -121,11 +122,22 @@ struct DrawCall
 		TriangleBatch triangles;
 		PrimitiveBatch primitives;
 		VertexTask vertexTask;
+		unsigned int triangleIndices[MaxBatchSize + 1][3];  // One extra for SIMD width overrun. TODO: Adjust to dynamic batch size.
 		unsigned int id;
 		unsigned int firstPrimitive;
 		unsigned int numPrimitives;
 		int numVisible;
 		marl::Ticket clusterTickets[MaxClusterCount];
+
+		// Multiview draws whose positions differ between views set up primitives
+		// for each view. The first view uses primitives and numVisible.
+		Primitive *viewPrimitives = nullptr;  // Views other than the first. Allocated on first use.
+		int viewNumVisible[vk::MAX_MULTIVIEW_VIEW_COUNT - 1];
+
+		~BatchData();
+
+		Primitive *getPrimitives(int view) { return (view == 0) ? primitives.data() : &viewPrimitives[(view - 1) * MaxBatchSize]; }
+		int getNumVisible(int view) const { return (view == 0) ? numVisible : viewNumVisible[view - 1]; }
 	};
 
 	using Pool = marl::BoundedPool<DrawCall, MaxDrawCount, marl::PoolPolicy::Preserve>;
@@ -138,6 +150,10 @@ struct DrawCall
 	static void processVertices(vk::Device *device, DrawCall *draw, BatchData *batch);
 	static void processPrimitives(vk::Device *device, DrawCall *draw, BatchData *batch);
 	static void processPixels(vk::Device *device, const marl::Loan<DrawCall> &draw, const marl::Loan<BatchData> &batch, const std::shared_ptr<marl::Finally> &finally);
+	void clearDeferredRows(const Primitive *primitives, int count, int cluster, int layer) const;
+	void setTargetLayer(DrawData *data, int layer) const;
+	void setBatchRanges(const std::vector<vk::DrawRecord> &drawRecords);
+	void addBaseVertices(BatchData *batch) const;
 	void setup();
 	void teardown(vk::Device *device);
 
@@ -151,12 +167,29 @@ struct DrawCall
 	VkPrimitiveTopology topology;
 	VkProvokingVertexModeEXT provokingVertexMode;
 	VkIndexType indexType;
+	bool primitiveRestart;  // Batches drop primitives which include the restart index
+	// For triangle strips and fans with primitive restart, the index of the first
+	// vertex of the strip containing each batch's first primitive. Empty otherwise.
+	std::vector<unsigned int> batchStripStarts;
+
+	// Draws merged from several records add each record's base vertex to the
+	// indices of its primitives, so batches can span records, but split batches
+	// where the instance offset changes. Both are empty for other draws.
+	struct BatchRange
+	{
+		unsigned int firstPrimitive;
+		unsigned int numPrimitives;
+		unsigned int record;  // Record of the first primitive
+	};
+	std::vector<vk::DrawRecord> records;
+	std::vector<BatchRange> batchRanges;
 	VkLineRasterizationModeEXT lineRasterizationMode;
 
 	bool depthClipEnable;
 	bool depthClipNegativeOneToOne;
 
 	VertexProcessor::RoutineType vertexRoutine;
+	VertexProcessor::RoutineType positionRoutine;  // Null unless views have different positions
 	SetupProcessor::RoutineType setupRoutine;
 	PixelProcessor::RoutineType pixelRoutine;
 	bool preRasterizationContainsImageWrite;
@@ -168,6 +201,7 @@ struct DrawCall
 	vk::ImageView *colorBuffer[MAX_COLOR_BUFFERS];
 	vk::ImageView *depthBuffer;
 	vk::ImageView *stencilBuffer;
+	bool hasDeferredClears;
 	vk::DescriptorSet::Array descriptorSetObjects;
 	const vk::PipelineLayout *preRasterizationPipelineLayout;
 	const vk::PipelineLayout *fragmentPipelineLayout;
@@ -177,14 +211,25 @@ struct DrawCall
 
 	DrawData *data;
 
-	static void processPrimitiveVertices(
+	// Multiview draws share vertex processing and primitive setup between
+	// views, and run the pixel routine once per view, each with its own data.
+	// When the positions differ between views, the positionRoutine computes
+	// them for the other views, and primitives are set up for each view.
+	int viewCount;
+	DrawData *viewData;  // Views other than the first. Allocated on first use.
+
+	DrawData *getViewData(int view) const { return (view == 0) ? data : &viewData[view - 1]; }
+
+	static unsigned int processPrimitiveVertices(
 	    unsigned int triangleIndicesOut[MaxBatchSize + 1][3],
 	    const void *primitiveIndices,
 	    VkIndexType indexType,
 	    unsigned int start,
 	    unsigned int triangleCount,
 	    VkPrimitiveTopology topology,
-	    VkProvokingVertexModeEXT provokingVertexMode);
+	    VkProvokingVertexModeEXT provokingVertexMode,
+	    bool primitiveRestart,
+	    unsigned int stripStart);
 
 	static int setupSolidTriangles(vk::Device *device, Triangle *triangles, Primitive *primitives, const DrawCall *drawCall, int count);
 	static int setupWireframeTriangles(vk::Device *device, Triangle *triangles, Primitive *primitives, const DrawCall *drawCall, int count);
@@ -209,8 +254,8 @@ public:
 	bool hasOcclusionQuery() const { return occlusionQuery != nullptr; }
 
 	void draw(const vk::GraphicsPipeline *pipeline, const vk::DynamicState &dynamicState, unsigned int count, int baseVertex,
-	          CountedEvent *events, int instanceID, int layer, void *indexBuffer, const VkRect2D &renderArea,
-	          const vk::Pipeline::PushConstantStorage &pushConstants, bool update = true);
+	          CountedEvent *events, int instanceID, uint32_t viewMask, void *indexBuffer, const VkRect2D &renderArea,
+	          const vk::Pipeline::PushConstantStorage &pushConstants, const std::vector<vk::DrawRecord> *records = nullptr, bool update = true);
 
 	void addQuery(vk::Query *query);
 	void removeQuery(vk::Query *query);
@@ -232,10 +277,12 @@ private:
 	SetupProcessor setupProcessor;
 
 	VertexProcessor::State vertexState;
+	VertexProcessor::State positionState;
 	SetupProcessor::State setupState;
 	PixelProcessor::State pixelState;
 
 	VertexProcessor::RoutineType vertexRoutine;
+	VertexProcessor::RoutineType positionRoutine;
 	SetupProcessor::RoutineType setupRoutine;
 	PixelProcessor::RoutineType pixelRoutine;
 
@@ -88,6 +88,7 @@ struct Sampler
 {
 	VkImageViewType textureType;
 	vk::Format textureFormat;
+	vk::Format compressedFormat;  // Block format decoded into textureFormat, if any
 	FilterType textureFilter;
 	AddressingMode addressingModeU;
 	AddressingMode addressingModeV;
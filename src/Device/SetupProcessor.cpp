@@ -21,6 +21,7 @@
 #include "Pipeline/SetupRoutine.hpp"
 #include "Pipeline/SpirvShader.hpp"
 #include "System/Debug.hpp"
+#include "System/Trace.hpp"
 #include "Vulkan/VkImageView.hpp"
 
 #include <cstring>
@@ -76,7 +77,8 @@ SetupProcessor::State SetupProcessor::update(const vk::GraphicsState &pipelineSt
 	state.applySlopeDepthBias = vertexInputInterfaceState.isDrawTriangle(false, polygonMode) && (preRasterizationState.getSlopeDepthBias() != 0.0f);
 	state.applyDepthBiasClamp = vertexInputInterfaceState.isDrawTriangle(false, polygonMode) && (preRasterizationState.getDepthBiasClamp() != 0.0f);
 	state.interpolateZ = fragmentState.depthTestActive(attachments) || vPosZW;
-	state.interpolateW = fragmentShader != nullptr;
+	// Clip distances are interpolated perspective-correctly even without a fragment shader.
+	state.interpolateW = (fragmentShader != nullptr) || (vertexShader->getNumOutputClipDistances() > 0);
 	state.frontFace = preRasterizationState.getFrontFace();
 	state.cullMode = preRasterizationState.getCullMode();
 
@@ -108,6 +110,7 @@ SetupProcessor::RoutineType SetupProcessor::routine(const State &state)
 
 	if(!routine)
 	{
+		SW_TRACE_SCOPE("compile", "SetupRoutine");
 		SetupRoutine *generator = new SetupRoutine(state);
 		generator->generate();
 		routine = generator->getRoutine();
@@ -18,6 +18,7 @@
 #include "Pipeline/VertexProgram.hpp"
 #include "System/Debug.hpp"
 #include "System/Math.hpp"
+#include "System/Trace.hpp"
 #include "Vulkan/VkPipelineLayout.hpp"
 
 #include <cstring>
@@ -82,6 +83,8 @@ const VertexProcessor::State VertexProcessor::update(const vk::GraphicsState &pi
 	for(size_t i = 0; i < MAX_INTERFACE_COMPONENTS / 4; i++)
 	{
 		state.input[i].format = inputs.getStream(i).format;
+		state.input[i].binding = inputs.getStream(i).binding;
+		state.input[i].offset = inputs.getStream(i).offset;
 		// TODO: get rid of attribType -- just keep the VK format all the way through, this fully determines
 		// how to handle the attribute.
 		state.input[i].attribType = vertexShader->inputs[i * 4].Type;
@@ -101,6 +104,8 @@ VertexProcessor::RoutineType VertexProcessor::routine(const State &state,
 
 	if(!routine)  // Create one
 	{
+		SW_TRACE_SCOPE("compile", "VertexRoutine", { "shader", static_cast<int64_t>(state.shaderID) });
+		rr::ScopedPragma optimizationProfile(rr::OptimizationProfile, vertexShader->getOptimizationProfile());
 		VertexRoutine *generator = new VertexProgram(state, pipelineLayout, vertexShader, descriptorSets);
 		generator->generate();
 		routine = (*generator)("VertexRoutine_%0.8X", state.shaderID);
@@ -48,6 +48,7 @@ struct VertexTask
 {
 	unsigned int vertexCount;
 	unsigned int primitiveStart;
+	int instanceOffset = 0;  // Added to the draw's instance ID, for merged draws
 	VertexCache vertexCache;
 };
 
@@ -76,6 +77,8 @@ public:
 
 			VkFormat format;  // TODO(b/148016460): Could be restricted to VK_FORMAT_END_RANGE
 			unsigned int attribType : BITS(SpirvShader::ATTRIBTYPE_LAST);
+			unsigned int binding : BITS(vk::MAX_VERTEX_INPUT_BINDINGS - 1);
+			unsigned int offset : 16;  // Offset of the attribute within its binding's vertices
 		};
 
 		Input input[MAX_INTERFACE_COMPONENTS / 4];
@@ -16,15 +16,127 @@
 
 #include "Constants.hpp"
 #include "System/Debug.hpp"
+#include "System/SwiftConfig.hpp"
+#include "System/Trace.hpp"
 #include "Vulkan/VkDevice.hpp"
 #include "Vulkan/VkPipelineLayout.hpp"
 
 #include "marl/defer.h"
+#include "marl/scheduler.h"
 #include "marl/trace.h"
 #include "marl/waitgroup.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <queue>
 
+namespace {
+
+// Number of chunks each task starts with. More chunks give finer grained
+// load balancing at the cost of more contention on the chunk ranges.
+constexpr uint32_t chunksPerTask = 8;
+
+// Partitions the workgroup grid into chunks of neighbouring workgroups.
+// By default a chunk is a contiguous run of workgroups in X-major order,
+// rounded to whole rows or slices when it spans more than one. With tiling
+// enabled, multi-dimensional grids are instead cut into roughly square 2D or
+// cubic 3D tiles, which keeps workgroups that share rows of an image or
+// matrix together.
+struct WorkgroupTiling
+{
+	WorkgroupTiling(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ, uint32_t targetChunkCount, bool tile)
+	    : groupCountX(groupCountX)
+	    , groupCountY(groupCountY)
+	    , groupCountZ(groupCountZ)
+	{
+		uint32_t groupCount = groupCountX * groupCountY * groupCountZ;
+		uint32_t chunkSize = std::max(groupCount / std::max(targetChunkCount, 1u), 1u);
+
+		if(tile && (groupCountY > 1 || groupCountZ > 1))
+		{
+			float edge = (groupCountZ > 1) ? std::cbrt((float)chunkSize) : std::sqrt((float)chunkSize);
+			tileX = std::min(groupCountX, std::max((uint32_t)edge, 1u));
+			tileY = std::min(groupCountY, std::max(chunkSize / tileX, 1u));
+			tileZ = std::min(groupCountZ, std::max(chunkSize / (tileX * tileY), 1u));
+		}
+		else
+		{
+			tileX = std::min(groupCountX, chunkSize);
+			tileY = (tileX == groupCountX) ? std::min(groupCountY, std::max(chunkSize / tileX, 1u)) : 1;
+			tileZ = (tileY == groupCountY) ? std::min(groupCountZ, std::max(chunkSize / (tileX * tileY), 1u)) : 1;
+		}
+
+		tilesX = (groupCountX + tileX - 1) / tileX;
+		tilesY = (groupCountY + tileY - 1) / tileY;
+		tilesZ = (groupCountZ + tileZ - 1) / tileZ;
+		chunkCount = tilesX * tilesY * tilesZ;
+	}
+
+	// Returns the [begin, end) workgroup offsets covered by the given chunk.
+	void getChunkBounds(uint32_t chunk, uint32_t &beginX, uint32_t &beginY, uint32_t &beginZ, uint32_t &endX, uint32_t &endY, uint32_t &endZ) const
+	{
+		uint32_t chunkX = chunk % tilesX;
+		uint32_t chunkY = (chunk / tilesX) % tilesY;
+		uint32_t chunkZ = chunk / (tilesX * tilesY);
+
+		beginX = chunkX * tileX;
+		beginY = chunkY * tileY;
+		beginZ = chunkZ * tileZ;
+		endX = std::min(beginX + tileX, groupCountX);
+		endY = std::min(beginY + tileY, groupCountY);
+		endZ = std::min(beginZ + tileZ, groupCountZ);
+	}
+
+	uint32_t groupCountX;
+	uint32_t groupCountY;
+	uint32_t groupCountZ;
+	uint32_t tileX;
+	uint32_t tileY;
+	uint32_t tileZ;
+	uint32_t tilesX;
+	uint32_t tilesY;
+	uint32_t tilesZ;
+	uint32_t chunkCount;
+};
+
+// Claims a chunk from a packed [begin, end) range. The owner of the range
+// takes chunks from the front, thieves take them from the back.
+bool claimChunk(std::atomic<uint64_t> &range, bool steal, uint32_t &chunk)
+{
+	uint64_t current = range.load(std::memory_order_relaxed);
+
+	while(true)
+	{
+		uint32_t begin = (uint32_t)current;
+		uint32_t end = (uint32_t)(current >> 32);
+
+		if(begin >= end)
+		{
+			return false;
+		}
+
+		if(steal)
+		{
+			end--;
+			chunk = end;
+		}
+		else
+		{
+			chunk = begin;
+			begin++;
+		}
+
+		uint64_t claimed = (uint64_t)begin | ((uint64_t)end << 32);
+		if(range.compare_exchange_weak(current, claimed, std::memory_order_relaxed))
+		{
+			return true;
+		}
+	}
+}
+
+}  // namespace
+
 namespace sw {
 
 ComputeProgram::ComputeProgram(vk::Device *device, std::shared_ptr<SpirvShader> shader, const vk::PipelineLayout *pipelineLayout, const vk::DescriptorSet::Bindings &descriptorSets)
@@ -42,11 +154,36 @@ ComputeProgram::~ComputeProgram()
 void ComputeProgram::generate()
 {
 	MARL_SCOPED_EVENT("ComputeProgram::generate");
+	SW_TRACE_SCOPE("compile", "ComputeProgram");
+	rr::ScopedPragma optimizationProfile(rr::OptimizationProfile, shader->getOptimizationProfile());
 
-	SpirvRoutine routine(pipelineLayout);
-	shader->emitProlog(&routine);
-	emit(&routine);
-	shader->emitEpilog(&routine);
+	bool containsControlBarriers = shader->getAnalysis().ContainsControlBarriers;
+	bool splitBarriers = containsControlBarriers && shader->getBarrierPhases().splittable;
+
+	if(!containsControlBarriers || splitBarriers)
+	{
+		WorkgroupFunction function;
+		{
+			SpirvRoutine routine(pipelineLayout);
+			shader->emitProlog(&routine);
+			emit(function, &routine, splitBarriers);
+			shader->emitEpilog(&routine);
+		}
+
+		workgroupFunction = function("ComputeProgram");
+	}
+	else
+	{
+		workgroupCoroutine = std::make_unique<WorkgroupCoroutine>();
+		{
+			SpirvRoutine routine(pipelineLayout);
+			shader->emitProlog(&routine);
+			emit(*workgroupCoroutine, &routine, false);
+			shader->emitEpilog(&routine);
+		}
+
+		workgroupCoroutine->finalize("ComputeProgram");
+	}
 }
 
 void ComputeProgram::setWorkgroupBuiltins(Pointer<Byte> data, SpirvRoutine *routine, Int workgroupID[3])
@@ -148,16 +285,18 @@ void ComputeProgram::setSubgroupBuiltins(Pointer<Byte> data, SpirvRoutine *routi
 	});
 }
 
-void ComputeProgram::emit(SpirvRoutine *routine)
+template<typename F>
+void ComputeProgram::emit(F &function, SpirvRoutine *routine, bool splitBarriers)
 {
-	Pointer<Byte> device = Arg<0>();
-	Pointer<Byte> data = Arg<1>();
-	Int workgroupX = Arg<2>();
-	Int workgroupY = Arg<3>();
-	Int workgroupZ = Arg<4>();
-	Pointer<Byte> workgroupMemory = Arg<5>();
-	Int firstSubgroup = Arg<6>();
-	Int subgroupCount = Arg<7>();
+	Pointer<Byte> device = function.template Arg<0>();
+	Pointer<Byte> data = function.template Arg<1>();
+	Int workgroupX = function.template Arg<2>();
+	Int workgroupY = function.template Arg<3>();
+	Int workgroupZ = function.template Arg<4>();
+	Pointer<Byte> workgroupMemory = function.template Arg<5>();
+	Pointer<Byte> barrierPhaseSpill = function.template Arg<6>();
+	Int firstSubgroup = function.template Arg<7>();
+	Int subgroupCount = function.template Arg<8>();
 
 	routine->device = device;
 	routine->descriptorSets = data + OFFSET(Data, descriptorSets);
@@ -171,20 +310,74 @@ void ComputeProgram::emit(SpirvRoutine *routine)
 	Int workgroupID[3] = { workgroupX, workgroupY, workgroupZ };
 	setWorkgroupBuiltins(data, routine, workgroupID);
 
-	For(Int i = 0, i < subgroupCount, i++)
-	{
-		auto subgroupIndex = firstSubgroup + i;
-
+	// Sets the builtins of the given subgroup, and returns its active lane mask.
+	auto beginSubgroup = [&](Int subgroupIndex) -> RValue<SIMD::Int> {
 		// TODO: Replace SIMD::Int(0, 1, 2, 3) with SIMD-width equivalent
 		auto localInvocationIndex = SIMD::Int(subgroupIndex * SIMD::Width) + SIMD::Int(0, 1, 2, 3);
 
+		setSubgroupBuiltins(data, routine, workgroupID, localInvocationIndex, subgroupIndex);
+
 		// Disable lanes where (invocationIDs >= invocationsPerWorkgroup)
-		auto activeLaneMask = CmpLT(localInvocationIndex, SIMD::Int(invocationsPerWorkgroup));
+		return CmpLT(localInvocationIndex, SIMD::Int(invocationsPerWorkgroup));
+	};
 
-		setSubgroupBuiltins(data, routine, workgroupID, localInvocationIndex, subgroupIndex);
+	if(!splitBarriers)
+	{
+		For(Int i = 0, i < subgroupCount, i++)
+		{
+			auto activeLaneMask = beginSubgroup(firstSubgroup + i);
 
-		shader->emit(routine, activeLaneMask, activeLaneMask, descriptorSets);
+			shader->emit(routine, activeLaneMask, activeLaneMask, descriptorSets);
+		}
+
+		return;
 	}
+
+	// Each phase between workgroup barriers is run for all the subgroups
+	// before the next phase starts. At each barrier the emitter spills the
+	// state of the current subgroup, and calls nextBarrierPhase() to close the
+	// loop over the subgroups and open the next one.
+	int spillStride = shader->getBarrierPhases().spillSlots * SIMD::Width * sizeof(float);
+
+	Int i = 0;
+	BasicBlock *phaseHeader = nullptr;
+	BasicBlock *phaseEnd = nullptr;
+
+	auto beginPhase = [&]() {
+		i = 0;
+
+		phaseHeader = Nucleus::createBasicBlock();
+		phaseEnd = Nucleus::createBasicBlock();
+		auto phaseBody = Nucleus::createBasicBlock();
+
+		Nucleus::createBr(phaseHeader);
+		Nucleus::setInsertBlock(phaseHeader);
+		Nucleus::createCondBr((i < subgroupCount).value(), phaseBody, phaseEnd);
+		Nucleus::setInsertBlock(phaseBody);
+
+		routine->barrierPhaseSpill = barrierPhaseSpill + i * spillStride;
+	};
+
+	auto endPhase = [&]() {
+		i++;
+
+		Nucleus::createBr(phaseHeader);
+		Nucleus::setInsertBlock(phaseEnd);
+	};
+
+	routine->nextBarrierPhase = [&]() {
+		endPhase();
+		beginPhase();
+		beginSubgroup(firstSubgroup + i);  // The emitter reloads the active lane mask.
+	};
+
+	beginPhase();
+	auto activeLaneMask = beginSubgroup(firstSubgroup + i);
+
+	shader->emit(routine, activeLaneMask, activeLaneMask, descriptorSets);
+
+	endPhase();
+	routine->nextBarrierPhase = nullptr;
 }
 
 void ComputeProgram::run(
@@ -195,6 +388,8 @@ void ComputeProgram::run(
     uint32_t baseGroupX, uint32_t baseGroupY, uint32_t baseGroupZ,
     uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
 {
+	SW_TRACE_SCOPE("compute", "dispatch", { "groupCountX", groupCountX }, { "groupCountY", groupCountY }, { "groupCountZ", groupCountZ });
+
 	uint32_t workgroupSizeX = shader->getWorkgroupSizeX();
 	uint32_t workgroupSizeY = shader->getWorkgroupSizeY();
 	uint32_t workgroupSizeZ = shader->getWorkgroupSizeZ();
@@ -217,53 +412,73 @@ void ComputeProgram::run(
 	data.subgroupsPerWorkgroup = subgroupsPerWorkgroup;
 	data.pushConstants = pushConstants;
 
-	marl::WaitGroup wg;
-	constexpr uint32_t batchCount = 16;
+	// Phases of workgroups with split barriers spill their per-subgroup state
+	// between barriers.
+	size_t barrierPhaseSpillSize = 0;
+	if(workgroupFunction && shader->getAnalysis().ContainsControlBarriers)
+	{
+		barrierPhaseSpillSize = shader->getBarrierPhases().spillSlots * subgroupsPerWorkgroup * SIMD::Width * sizeof(float);
+	}
 
 	auto groupCount = groupCountX * groupCountY * groupCountZ;
+	if(groupCount == 0)
+	{
+		return;
+	}
+
+	// Workgroups are handed out in contiguous chunks so that neighbouring
+	// workgroups, which tend to touch neighbouring memory, run back to back on
+	// the same worker. Each task starts on its own range of chunks and steals
+	// from the back of other tasks' ranges once it runs dry, which keeps
+	// workers busy when workgroup costs are uneven.
+	uint32_t workerCount = 1;
+	if(auto *scheduler = marl::Scheduler::get())
+	{
+		workerCount = std::max(scheduler->config().workerThread.count, 1);
+	}
+
+	uint32_t taskCount = std::min(workerCount, groupCount);
+	WorkgroupTiling tiling(groupCountX, groupCountY, groupCountZ, taskCount * chunksPerTask,
+	                       getConfiguration().enableComputeWorkgroupTiling);
+
+	// Each range packs the [begin, end) chunk indices of a task into 64 bits,
+	// so that the owner and thieves can claim chunks with a single CAS.
+	std::vector<std::atomic<uint64_t>> chunkRanges(taskCount);
+	for(uint32_t taskID = 0; taskID < taskCount; taskID++)
+	{
+		uint64_t begin = (uint64_t)tiling.chunkCount * taskID / taskCount;
+		uint64_t end = (uint64_t)tiling.chunkCount * (taskID + 1) / taskCount;
+		chunkRanges[taskID].store(begin | (end << 32), std::memory_order_relaxed);
+	}
+
+	marl::WaitGroup wg(taskCount);
 
-	for(uint32_t batchID = 0; batchID < batchCount && batchID < groupCount; batchID++)
+	for(uint32_t taskID = 0; taskID < taskCount; taskID++)
 	{
-		wg.add(1);
-		marl::schedule([this, batchID, groupCount, groupCountX, groupCountY,
+		marl::schedule([this, taskID, taskCount, tiling, &chunkRanges,
 		                baseGroupZ, baseGroupY, baseGroupX, wg, subgroupsPerWorkgroup,
-		                &data] {
-			// Workaround for the fact that some compilers don't allow batchCount to be captured.
-			constexpr uint32_t batchCount = 16;
+		                barrierPhaseSpillSize, &data] {
 			defer(wg.done());
 			std::vector<uint8_t> workgroupMemory(shader->workgroupMemory.size());
+			std::vector<uint8_t> barrierPhaseSpill(barrierPhaseSpillSize);
 
-			for(uint32_t groupIndex = batchID; groupIndex < groupCount; groupIndex += batchCount)
-			{
-				auto modulo = groupIndex;
-				auto groupOffsetZ = modulo / (groupCountX * groupCountY);
-				modulo -= groupOffsetZ * (groupCountX * groupCountY);
-				auto groupOffsetY = modulo / groupCountX;
-				modulo -= groupOffsetY * groupCountX;
-				auto groupOffsetX = modulo;
-
-				auto groupZ = baseGroupZ + groupOffsetZ;
-				auto groupY = baseGroupY + groupOffsetY;
-				auto groupX = baseGroupX + groupOffsetX;
+			auto runWorkgroup = [&](uint32_t groupX, uint32_t groupY, uint32_t groupZ) {
 				MARL_SCOPED_EVENT("groupX: %d, groupY: %d, groupZ: %d", groupX, groupY, groupZ);
 
+				if(workgroupFunction)
+				{
+					workgroupFunction(device, &data, groupX, groupY, groupZ, workgroupMemory.data(), barrierPhaseSpill.data(), 0, subgroupsPerWorkgroup);
+					return;
+				}
+
+				// Make a coroutine call per subgroup so each subgroup can
+				// yield, bringing all subgroups to the barrier together.
 				using Coroutine = std::unique_ptr<rr::Stream<SpirvEmitter::YieldResult>>;
 				std::queue<Coroutine> coroutines;
 
-				if(shader->getAnalysis().ContainsControlBarriers)
+				for(uint32_t subgroupIndex = 0; subgroupIndex < subgroupsPerWorkgroup; subgroupIndex++)
 				{
-					// Make a function call per subgroup so each subgroup
-					// can yield, bringing all subgroups to the barrier
-					// together.
-					for(uint32_t subgroupIndex = 0; subgroupIndex < subgroupsPerWorkgroup; subgroupIndex++)
-					{
-						auto coroutine = (*this)(device, &data, groupX, groupY, groupZ, workgroupMemory.data(), subgroupIndex, 1);
-						coroutines.push(std::move(coroutine));
-					}
-				}
-				else
-				{
-					auto coroutine = (*this)(device, &data, groupX, groupY, groupZ, workgroupMemory.data(), 0, subgroupsPerWorkgroup);
+					auto coroutine = (*workgroupCoroutine)(device, &data, groupX, groupY, groupZ, workgroupMemory.data(), nullptr, subgroupIndex, 1);
 					coroutines.push(std::move(coroutine));
 				}
 
@@ -279,6 +494,42 @@ void ComputeProgram::run(
 						coroutines.push(std::move(coroutine));
 					}
 				}
+			};
+
+			auto runChunk = [&](uint32_t chunk) {
+				SW_TRACE_SCOPE("compute", "workgroups", { "task", taskID }, { "chunk", chunk });
+
+				uint32_t beginX, beginY, beginZ, endX, endY, endZ;
+				tiling.getChunkBounds(chunk, beginX, beginY, beginZ, endX, endY, endZ);
+
+				for(uint32_t groupOffsetZ = beginZ; groupOffsetZ < endZ; groupOffsetZ++)
+				{
+					for(uint32_t groupOffsetY = beginY; groupOffsetY < endY; groupOffsetY++)
+					{
+						for(uint32_t groupOffsetX = beginX; groupOffsetX < endX; groupOffsetX++)
+						{
+							runWorkgroup(baseGroupX + groupOffsetX, baseGroupY + groupOffsetY, baseGroupZ + groupOffsetZ);
+						}
+					}
+				}
+			};
+
+			// Work through our own range front to back.
+			uint32_t chunk;
+			while(claimChunk(chunkRanges[taskID], false, chunk))
+			{
+				runChunk(chunk);
+			}
+
+			// Then steal from the back of the other tasks' ranges, furthest
+			// from where their owners are working.
+			for(uint32_t i = 1; i < taskCount; i++)
+			{
+				auto &victim = chunkRanges[(taskID + i) % taskCount];
+				while(claimChunk(victim, true, chunk))
+				{
+					runChunk(chunk);
+				}
 			}
 		});
 	}
@@ -22,6 +22,7 @@
 #include "Vulkan/VkPipeline.hpp"
 
 #include <functional>
+#include <memory>
 
 namespace vk {
 class Device;
@@ -36,22 +37,14 @@ class DescriptorSetsLayout;
 struct Constants;
 
 // ComputeProgram builds a SPIR-V compute shader.
-class ComputeProgram : public Coroutine<SpirvEmitter::YieldResult(
-                           const vk::Device *device,
-                           void *data,
-                           int32_t workgroupX,
-                           int32_t workgroupY,
-                           int32_t workgroupZ,
-                           void *workgroupMemory,
-                           int32_t firstSubgroup,
-                           int32_t subgroupCount)>
+class ComputeProgram
 {
 public:
 	ComputeProgram(vk::Device *device, std::shared_ptr<SpirvShader> spirvShader, const vk::PipelineLayout *pipelineLayout, const vk::DescriptorSet::Bindings &descriptorSets);
 
 	virtual ~ComputeProgram();
 
-	// generate builds the shader program.
+	// generate builds and finalizes the shader program.
 	void generate();
 
 	// run executes the compute shader routine for all workgroups.
@@ -64,7 +57,33 @@ public:
 	    uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ);
 
 protected:
-	void emit(SpirvRoutine *routine);
+	// Shaders without workgroup control barriers, or whose barriers can be
+	// split into phases (see Spirv::BarrierPhases), are built as a plain
+	// function which processes a range of subgroups of a workgroup. Other
+	// shaders are built as a coroutine which yields at each barrier, and
+	// one is started for each subgroup.
+	using WorkgroupFunction = FunctionT<void(const vk::Device *device,
+	                                         void *data,
+	                                         int32_t workgroupX,
+	                                         int32_t workgroupY,
+	                                         int32_t workgroupZ,
+	                                         void *workgroupMemory,
+	                                         void *barrierPhaseSpill,
+	                                         int32_t firstSubgroup,
+	                                         int32_t subgroupCount)>;
+	using WorkgroupCoroutine = Coroutine<SpirvEmitter::YieldResult(
+	    const vk::Device *device,
+	    void *data,
+	    int32_t workgroupX,
+	    int32_t workgroupY,
+	    int32_t workgroupZ,
+	    void *workgroupMemory,
+	    void *barrierPhaseSpill,
+	    int32_t firstSubgroup,
+	    int32_t subgroupCount)>;
+
+	template<typename F>
+	void emit(F &function, SpirvRoutine *routine, bool splitBarriers);
 	void setWorkgroupBuiltins(Pointer<Byte> data, SpirvRoutine *routine, Int workgroupID[3]);
 	void setSubgroupBuiltins(Pointer<Byte> data, SpirvRoutine *routine, Int workgroupID[3], SIMD::Int localInvocationIndex, Int subgroupIndex);
 
@@ -84,6 +103,9 @@ protected:
 	const std::shared_ptr<SpirvShader> shader;
 	const vk::PipelineLayout *const pipelineLayout;  // Reference held by vk::Pipeline
 	const vk::DescriptorSet::Bindings &descriptorSets;
+
+	WorkgroupFunction::RoutineType workgroupFunction;
+	std::unique_ptr<WorkgroupCoroutine> workgroupCoroutine;
 };
 
 }  // namespace sw
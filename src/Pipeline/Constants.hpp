@@ -131,6 +131,39 @@ struct Constants
 		sw::SampleLocationsY[3],
 	};
 
+	// ETC2 intensity modifiers, T and H mode distances, and alpha/EAC modifiers
+	const int etc2IntensityModifiers[8][4] = {
+		{ 2, 8, -2, -8 },
+		{ 5, 17, -5, -17 },
+		{ 9, 29, -9, -29 },
+		{ 13, 42, -13, -42 },
+		{ 18, 60, -18, -60 },
+		{ 24, 80, -24, -80 },
+		{ 33, 106, -33, -106 },
+		{ 47, 183, -47, -183 },
+	};
+
+	const int etc2Distances[8] = { 3, 6, 11, 16, 23, 32, 41, 64 };
+
+	const int etc2AlphaModifiers[16][8] = {
+		{ -3, -6, -9, -15, 2, 5, 8, 14 },
+		{ -3, -7, -10, -13, 2, 6, 9, 12 },
+		{ -2, -5, -8, -13, 1, 4, 7, 12 },
+		{ -2, -4, -6, -13, 1, 3, 5, 12 },
+		{ -3, -6, -8, -12, 2, 5, 7, 11 },
+		{ -3, -7, -9, -11, 2, 6, 8, 10 },
+		{ -4, -7, -8, -11, 3, 6, 7, 10 },
+		{ -3, -5, -8, -11, 2, 4, 7, 10 },
+		{ -2, -6, -8, -10, 1, 5, 7, 9 },
+		{ -2, -5, -8, -10, 1, 4, 7, 9 },
+		{ -2, -4, -8, -10, 1, 3, 7, 9 },
+		{ -2, -5, -7, -10, 1, 4, 6, 9 },
+		{ -3, -4, -7, -10, 2, 3, 6, 9 },
+		{ -1, -2, -3, -10, 0, 1, 2, 9 },
+		{ -4, -6, -8, -9, 3, 5, 7, 8 },
+		{ -3, -5, -7, -9, 2, 4, 6, 8 },
+	};
+
 	float half2float[65536];
 };
 
@@ -50,6 +50,47 @@ bool shouldUsePerSampleShading(const PixelProcessor::State &state, const SpirvSh
 	return false;
 }
 
+bool shouldUseEarlyFragmentTests(const PixelProcessor::State &state, const SpirvShader *spirvShader)
+{
+	if(!spirvShader || spirvShader->getExecutionModes().EarlyFragmentTests)
+	{
+		return true;
+	}
+
+	// Clip distances are only applied after the early tests, so promoting them
+	// would write depth and stencil for clipped fragments (b/148105887).
+	if(state.numClipDistances > 0)
+	{
+		return false;
+	}
+
+	// Depth and stencil tests can be promoted ahead of shading when the shader can't
+	// affect their outcome, and skipping it for failing fragments is unobservable.
+	const auto &modes = spirvShader->getExecutionModes();
+	if(modes.DepthReplacing || modes.StencilRefReplacing ||
+	   spirvShader->hasBuiltinOutput(spv::BuiltInFragDepth) ||
+	   spirvShader->hasBuiltinOutput(spv::BuiltInFragStencilRefEXT) ||
+	   spirvShader->coverageModified() || state.alphaToCoverage)
+	{
+		return false;
+	}
+
+	const auto &analysis = spirvShader->getAnalysis();
+	if(analysis.ContainsImageWrite || analysis.ContainsMemoryWrite)
+	{
+		return false;
+	}
+
+	// Input attachments may alias the depth/stencil attachment, in which case the
+	// shader must observe the values from before this fragment's writes.
+	if(spirvShader->getUsedCapabilities().InputAttachment && (state.depthWriteEnable || state.stencilActive))
+	{
+		return false;
+	}
+
+	return true;
+}
+
 }  // namespace
 
 PixelRoutine::PixelRoutine(
@@ -65,6 +106,7 @@ PixelRoutine::PixelRoutine(
     , shaderContainsInterpolation(spirvShader && spirvShader->getUsedCapabilities().InterpolationFunction)
     , perSampleShading(shouldUsePerSampleShading(state, spirvShader))
     , invocationCount(perSampleShading ? state.multiSampleCount : 1)
+    , earlyFragmentTests(shouldUseEarlyFragmentTests(state, spirvShader))
 {
 	if(spirvShader)
 	{
@@ -94,9 +136,18 @@ PixelRoutine::SampleSet PixelRoutine::getSampleSet(int invocation) const
 	return samples;
 }
 
+bool PixelRoutine::isDepthOnly() const
+{
+	return !spirvShader && (state.colorWriteMask == 0) && !state.alphaToCoverage;
+}
+
 void PixelRoutine::quad(Pointer<Byte> cBuffer[MAX_COLOR_BUFFERS], Pointer<Byte> &zBuffer, Pointer<Byte> &sBuffer, Int cMask[4], Int &x, Int &y)
 {
-	const bool earlyFragmentTests = !spirvShader || spirvShader->getExecutionModes().EarlyFragmentTests;
+	if(isDepthOnly())
+	{
+		depthOnlyQuad(zBuffer, sBuffer, cMask, x);
+		return;
+	}
 
 	Int zMask[4];  // Depth mask
 	Int sMask[4];  // Stencil mask
@@ -513,6 +564,7 @@ Bool PixelRoutine::depthTest(const Pointer<Byte> &zBuffer, int q, const Int &x,
 		case VK_FORMAT_D32_SFLOAT_S8_UINT:
 			Z = z;
 			zValue = readDepth32F(zBuffer, q, x);
+			depthValue[q] = zValue;  // Reused by writeDepth32F()
 			break;
 		default:
 			UNSUPPORTED("Depth format: %d", int(state.depthFormat));
@@ -657,7 +709,7 @@ void PixelRoutine::alphaToCoverage(Int cMask[4], const SIMD::Float &alpha, const
 	}
 }
 
-void PixelRoutine::writeDepth32F(Pointer<Byte> &zBuffer, int q, const Int &x, const Float4 &z, const Int &zMask)
+void PixelRoutine::writeDepth32F(Pointer<Byte> &zBuffer, int q, const Int &x, const Float4 &z, const Float4 &zValue, const Int &zMask)
 {
 	Float4 Z = z;
 
@@ -669,16 +721,9 @@ void PixelRoutine::writeDepth32F(Pointer<Byte> &zBuffer, int q, const Int &x, co
 		buffer += q * *Pointer<Int>(data + OFFSET(DrawData, depthSliceB));
 	}
 
-	Float4 zValue;
-
-	if(state.depthCompareMode != VK_COMPARE_OP_NEVER || (state.depthCompareMode != VK_COMPARE_OP_ALWAYS && !state.depthWriteEnable))
-	{
-		zValue = Float4(*Pointer<Float2>(buffer), *Pointer<Float2>(buffer + pitch));
-	}
-
 	Z = As<Float4>(As<Int4>(Z) & *Pointer<Int4>(constants + OFFSET(Constants, maskD4X) + zMask * 16, 16));
-	zValue = As<Float4>(As<Int4>(zValue) & *Pointer<Int4>(constants + OFFSET(Constants, invMaskD4X) + zMask * 16, 16));
-	Z = As<Float4>(As<Int4>(Z) | As<Int4>(zValue));
+	Float4 oldZ = As<Float4>(As<Int4>(zValue) & *Pointer<Int4>(constants + OFFSET(Constants, invMaskD4X) + zMask * 16, 16));
+	Z = As<Float4>(As<Int4>(Z) | As<Int4>(oldZ));
 
 	*Pointer<Float2>(buffer) = Float2(Z.xy);
 	*Pointer<Float2>(buffer + pitch) = Float2(Z.zw);
@@ -729,7 +774,8 @@ void PixelRoutine::writeDepth(Pointer<Byte> &zBuffer, const Int &x, const Int zM
 			break;
 		case VK_FORMAT_D32_SFLOAT:
 		case VK_FORMAT_D32_SFLOAT_S8_UINT:
-			writeDepth32F(zBuffer, q, x, Extract128(z[q], 0), zMask[q]);
+			// Depth writes imply an active depth test, which already read the buffer.
+			writeDepth32F(zBuffer, q, x, Extract128(z[q], 0), Extract128(depthValue[q], 0), zMask[q]);
 			break;
 		default:
 			UNSUPPORTED("Depth format: %d", int(state.depthFormat));
@@ -841,6 +887,102 @@ Byte8 PixelRoutine::stencilOperation(const Byte8 &bufferValue, const PixelProces
 	return pass;
 }
 
+// Processes a quad for draws which only affect the depth and stencil buffers,
+// like shadow map and depth pre-pass rendering. Without a fragment shader all
+// samples are tested and written at once, and only Z, and W for clip distances,
+// are interpolated.
+void PixelRoutine::depthOnlyQuad(Pointer<Byte> &zBuffer, Pointer<Byte> &sBuffer, Int cMask[4], Int &x)
+{
+	Int zMask[4];  // Depth mask
+	Int sMask[4];  // Stencil mask
+
+	// Sample shading has no observable effect without a shader, so all samples
+	// are processed together.
+	SampleSet samples;
+
+	for(unsigned int q = 0; q < state.multiSampleCount; q++)
+	{
+		if(state.multiSampleMask & (1 << q))
+		{
+			samples.push_back(q);
+		}
+	}
+
+	if(samples.empty())
+	{
+		return;
+	}
+
+	const auto xMorton = SIMD::Float([](int i) { return float(compactEvenBits(i)); });  // 0, 1, 0, 1, 2, 3, 2, 3, 0, 1, 0, 1, 2, 3, 2, 3, ...
+	xFragment = SIMD::Float(Float(x)) + xMorton - SIMD::Float(*Pointer<Float>(primitive + OFFSET(Primitive, x0)));
+
+	// Fragments with a negative clip distance don't exist, so they are removed
+	// before any depth or stencil operation, and aren't counted by queries.
+	if(state.numClipDistances > 0)
+	{
+		w = interpolate(xFragment, Dw, rhw, primitive + OFFSET(Primitive, w), false, false);
+		rhw = reciprocal(w, false, true);
+
+		for(uint32_t i = 0; i < state.numClipDistances; i++)
+		{
+			auto distance = interpolate(xFragment, DclipDistance[i], rhw,
+			                            primitive + OFFSET(Primitive, clipDistance[i]),
+			                            false, true);
+
+			auto clipMask = SignMask(CmpGE(distance, SIMD::Float(0)));
+			for(unsigned int q : samples)
+			{
+				cMask[q] &= clipMask;
+			}
+		}
+	}
+
+	for(unsigned int q : samples)
+	{
+		zMask[q] = cMask[q];
+		sMask[q] = cMask[q];
+	}
+
+	stencilTest(sBuffer, x, sMask, samples);
+
+	if(interpolateZ())
+	{
+		for(unsigned int q : samples)
+		{
+			SIMD::Float x = xFragment;
+
+			if(state.enableMultiSampling)
+			{
+				x -= SIMD::Float(*Pointer<Float>(constants + OFFSET(Constants, SampleLocationsX) + q * sizeof(float)));
+			}
+
+			z[q] = interpolate(x, Dz[q], z[q], primitive + OFFSET(Primitive, z), false, false);
+
+			if(state.depthBias)
+			{
+				z[q] += SIMD::Float(*Pointer<Float>(primitive + OFFSET(Primitive, zBias)));
+			}
+		}
+	}
+
+	Bool depthPass = false;
+
+	for(unsigned int q : samples)
+	{
+		z[q] = clampDepth(z[q]);
+		depthPass = depthPass || depthTest(zBuffer, q, x, z[q], sMask[q], zMask[q], cMask[q]);
+		depthBoundsTest(zBuffer, q, x, zMask[q], cMask[q]);
+	}
+
+	writeStencil(sBuffer, x, sMask, zMask, cMask, samples);
+
+	If(depthPass)
+	{
+		writeDepth(zBuffer, x, zMask, samples);
+		occlusionSampleCount(zMask, sMask, samples);
+	}
+}
+
 bool PixelRoutine::hasStencilReplaceRef() const
 {
 	return spirvShader &&
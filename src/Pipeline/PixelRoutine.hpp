@@ -62,6 +62,9 @@ protected:
 	bool isSRGB(int index) const;
 
 private:
+	bool isDepthOnly() const;
+	void depthOnlyQuad(Pointer<Byte> &zBuffer, Pointer<Byte> &sBuffer, Int cMask[4], Int &x);
+
 	bool hasStencilReplaceRef() const;
 	Byte8 stencilReplaceRef();
 	void stencilTest(const Pointer<Byte> &sBuffer, const Int &x, Int sMask[4], const SampleSet &samples);
@@ -104,7 +107,7 @@ private:
 	SIMD::Float readDepth32F(const Pointer<Byte> &zBuffer, int q, const Int &x) const;
 	SIMD::Float readDepth16(const Pointer<Byte> &zBuffer, int q, const Int &x) const;
 
-	void writeDepth32F(Pointer<Byte> &zBuffer, int q, const Int &x, const Float4 &z, const Int &zMask);
+	void writeDepth32F(Pointer<Byte> &zBuffer, int q, const Int &x, const Float4 &z, const Float4 &zValue, const Int &zMask);
 	void writeDepth16(Pointer<Byte> &zBuffer, int q, const Int &x, const Float4 &z, const Int &zMask);
 
 	Int4 depthBoundsTest32F(const Pointer<Byte> &zBuffer, int q, const Int &x);
@@ -114,6 +117,9 @@ private:
 	const bool shaderContainsInterpolation;  // TODO(b/194714095)
 	const bool perSampleShading;
 	const int invocationCount;
+	const bool earlyFragmentTests;  // Depth and stencil tests precede shading
+
+	SIMD::Float depthValue[4];  // Depth buffer contents read by depthTest()
 
 	SampleSet getSampleSet(int invocation) const;
 };
@@ -875,6 +875,9 @@ Vector4s SamplerCore::sampleQuad2D(Pointer<Byte> &texture, Float4 &u, Float4 &v,
 			Short4 uuuu1 = offsetSample(uuuu, mipmap, OFFSET(Mipmap, uHalf), state.addressingModeU == ADDRESSING_WRAP, +1, lod);
 			Short4 vvvv1 = offsetSample(vvvv, mipmap, OFFSET(Mipmap, vHalf), state.addressingModeV == ADDRESSING_WRAP, +1, lod);
 
+			// The four taps share the ETC2 blocks they fall in.
+			ETC2BlockScope etc2BlockScope(*this);
+
 			Vector4s c00 = sampleTexel(uuuu0, vvvv0, wwww, layerIndex, sample, mipmap, buffer);
 			Vector4s c10 = sampleTexel(uuuu1, vvvv0, wwww, layerIndex, sample, mipmap, buffer);
 			Vector4s c01 = sampleTexel(uuuu0, vvvv1, wwww, layerIndex, sample, mipmap, buffer);
@@ -1169,9 +1172,6 @@ Vector4f SamplerCore::sampleFloat2D(Pointer<Byte> &texture, Float4 &u, Float4 &v
 	address(u, x0, x1, fu, mipmap, filter, OFFSET(Mipmap, width), state.addressingModeU);
 	address(v, y0, y1, fv, mipmap, filter, OFFSET(Mipmap, height), state.addressingModeV);
 
-	Int4 pitchP = As<Int4>(*Pointer<UInt4>(mipmap + OFFSET(Mipmap, pitchP), 16));
-	y0 *= pitchP;
-
 	Int4 z;
 	if(state.isCube() || state.isArrayed())
 	{
@@ -1200,7 +1200,8 @@ Vector4f SamplerCore::sampleFloat2D(Pointer<Byte> &texture, Float4 &u, Float4 &v
 	}
 	else
 	{
-		y1 *= pitchP;
+		// The four taps share the ETC2 blocks they fall in.
+		ETC2BlockScope etc2BlockScope(*this);
 
 		Vector4f c00 = sampleTexel(x0, y0, z, dRef, sample, mipmap, buffer);
 		Vector4f c10 = sampleTexel(x1, y0, z, dRef, sample, mipmap, buffer);
@@ -1264,9 +1265,7 @@ Vector4f SamplerCore::sampleFloat3D(Pointer<Byte> &texture, Float4 &u, Float4 &v
 	address(v, y0, y1, fv, mipmap, filter, OFFSET(Mipmap, height), state.addressingModeV);
 	address(w, z0, z1, fw, mipmap, filter, OFFSET(Mipmap, depth), state.addressingModeW);
 
-	Int4 pitchP = As<Int4>(*Pointer<UInt4>(mipmap + OFFSET(Mipmap, pitchP), 16));
 	Int4 sliceP = As<Int4>(*Pointer<UInt4>(mipmap + OFFSET(Mipmap, sliceP), 16));
-	y0 *= pitchP;
 	z0 *= sliceP;
 
 	if(state.textureFilter == FILTER_POINT || (function == Fetch))
@@ -1275,7 +1274,6 @@ Vector4f SamplerCore::sampleFloat3D(Pointer<Byte> &texture, Float4 &u, Float4 &v
 	}
 	else
 	{
-		y1 *= pitchP;
 		z1 *= sliceP;
 
 		Vector4f c000 = sampleTexel(x0, y0, z0, dRef, sample, mipmap, buffer);
@@ -1594,11 +1592,19 @@ void SamplerCore::computeIndices(UInt index[4], Short4 uuuu, Short4 vvvv, Short4
 	uuuu = MulHigh(As<UShort4>(uuuu), UShort4(*Pointer<UInt4>(mipmap + OFFSET(Mipmap, width))));
 
 	UInt4 indices = Int4(uuuu);
+	Short4 texel;
 
 	if(state.is2D() || state.is3D() || state.isCube())
 	{
 		vvvv = MulHigh(As<UShort4>(vvvv), UShort4(*Pointer<UInt4>(mipmap + OFFSET(Mipmap, height))));
 
+		if(isCompressedFormat())
+		{
+			texel = ((vvvv & Short4(3)) << 2) | (uuuu & Short4(3));
+			uuuu = As<Short4>(As<UShort4>(uuuu) >> 2);
+			vvvv = As<Short4>(As<UShort4>(vvvv) >> 2);
+		}
+
 		Short4 uv0uv1 = As<Short4>(UnpackLow(uuuu, vvvv));
 		Short4 uv2uv3 = As<Short4>(UnpackHigh(uuuu, vvvv));
 		Int2 i01 = MulAdd(uv0uv1, *Pointer<Short4>(mipmap + OFFSET(Mipmap, onePitchP)));
@@ -1635,6 +1641,11 @@ void SamplerCore::computeIndices(UInt index[4], Short4 uuuu, Short4 vvvv, Short4
 		indices += sampleOffset;
 	}
 
+	if(isCompressedFormat())
+	{
+		indices = (indices << 4) | As<UInt4>(Int4(texel));
+	}
+
 	index[0] = Extract(indices, 0);
 	index[1] = Extract(indices, 1);
 	index[2] = Extract(indices, 2);
@@ -1643,11 +1654,20 @@ void SamplerCore::computeIndices(UInt index[4], Short4 uuuu, Short4 vvvv, Short4
 
 void SamplerCore::computeIndices(UInt index[4], Int4 uuuu, Int4 vvvv, Int4 wwww, const Int4 &sample, Int4 valid, const Pointer<Byte> &mipmap)
 {
+	Int4 texel;
+
+	if(isCompressedFormat())
+	{
+		texel = ((vvvv & Int4(3)) << 2) | (uuuu & Int4(3));
+		uuuu >>= 2;
+		vvvv >>= 2;
+	}
+
 	UInt4 indices = uuuu;
 
 	if(state.is2D() || state.is3D() || state.isCube())
 	{
-		indices += As<UInt4>(vvvv);
+		indices += As<UInt4>(vvvv * As<Int4>(*Pointer<UInt4>(mipmap + OFFSET(Mipmap, pitchP), 16)));
 	}
 
 	if(state.is3D() || state.isCube() || state.isArrayed())
@@ -1661,6 +1681,11 @@ void SamplerCore::computeIndices(UInt index[4], Int4 uuuu, Int4 vvvv, Int4 wwww,
 		           *Pointer<UInt4>(mipmap + OFFSET(Mipmap, samplePitchP), 16);
 	}
 
+	if(isCompressedFormat())
+	{
+		indices = (indices << 4) | As<UInt4>(texel);
+	}
+
 	if(borderModeActive())
 	{
 		// Texels out of range are still sampled before being replaced
@@ -1678,7 +1703,11 @@ Vector4s SamplerCore::sampleTexel(UInt index[4], Pointer<Byte> buffer)
 {
 	Vector4s c;
 
-	if(has16bitPackedTextureFormat())
+	if(isCompressedFormat())
+	{
+		c = sampleCompressedTexel(index, buffer);
+	}
+	else if(has16bitPackedTextureFormat())
 	{
 		c.x = Insert(c.x, Pointer<Short>(buffer)[index[0]], 0);
 		c.x = Insert(c.x, Pointer<Short>(buffer)[index[1]], 1);
@@ -1979,6 +2008,540 @@ Vector4s SamplerCore::sampleTexel(UInt index[4], Pointer<Byte> buffer)
 	return c;
 }
 
+// Divides by 5 or 7 through the given 16-bit fixed-point reciprocal, rounding
+// towards zero like the reference BC decoder.
+static Int4 divideBC(const Int4 &n, int reciprocal)
+{
+	Int4 sign = n >> 31;
+	Int4 quotient = (((n ^ sign) - sign) * Int4(reciprocal)) >> 16;
+	return (quotient ^ sign) - sign;
+}
+
+// Expands a 5 or 6 bit RGB565 field to 8 bits.
+static Int4 expand565(const Int4 &color, int shift, int bits)
+{
+	Int4 c = (color >> shift) & Int4((1 << bits) - 1);
+	return (c << (8 - bits)) | (c >> (2 * bits - 8));
+}
+
+// Selects the color channel of a BC1 texel from its block's endpoints.
+static Int4 decodeBCColorChannel(const Int4 &e0, const Int4 &e1, const Int4 &selector, const Int4 &fourColors)
+{
+	// (2 * e0 + e1) / 3, with values up to 765.
+	Int4 c2 = (fourColors & ((((e0 << 1) + e1) * Int4(0xAAAB)) >> 17)) | (~fourColors & ((e0 + e1) >> 1));
+	Int4 c3 = fourColors & ((((e1 << 1) + e0) * Int4(0xAAAB)) >> 17);
+
+	return (CmpEQ(selector, Int4(0)) & e0) |
+	       (CmpEQ(selector, Int4(1)) & e1) |
+	       (CmpEQ(selector, Int4(2)) & c2) |
+	       (CmpEQ(selector, Int4(3)) & c3);
+}
+
+// Decodes a BC3 alpha, BC4 or BC5 channel from the 8 byte blocks at offset.
+static Int4 decodeBCChannel(Pointer<Byte> block[4], const Int texel[4], int offset, bool isSigned)
+{
+	Int4 endpoints;
+	Int4 indexBits;
+	Int4 shift;
+
+	for(int i = 0; i < 4; i++)
+	{
+		// The 3-bit index of each texel is read from a 16-bit window of the
+		// 48 index bits which follow the two endpoints.
+		Int bit = texel[i] * 3;
+		Int window = Min(bit >> 3, Int(4));
+
+		endpoints = Insert(endpoints, Int(*Pointer<UShort>(block[i] + offset)), i);
+		indexBits = Insert(indexBits, Int(*Pointer<UShort>(block[i] + offset + 2 + window)), i);
+		shift = Insert(shift, bit - (window << 3), i);
+	}
+
+	Int4 selector = As<Int4>(As<UInt4>(indexBits) >> As<UInt4>(shift)) & Int4(7);
+
+	Int4 e0 = isSigned ? ((endpoints << 24) >> 24) : (endpoints & Int4(0xFF));
+	Int4 e1 = isSigned ? ((endpoints << 16) >> 24) : (endpoints >> 8);
+
+	// Weight of e1 in the interpolated value. Selectors 0 and 1 are the endpoints.
+	Int4 isEndpoint0 = CmpEQ(selector, Int4(0));
+	Int4 isEndpoint1 = CmpEQ(selector, Int4(1));
+	Int4 isInterpolated = ~(isEndpoint0 | isEndpoint1);
+	Int4 w7 = (isEndpoint1 & Int4(7)) | (isInterpolated & (selector - Int4(1)));
+	Int4 w5 = (isEndpoint1 & Int4(5)) | (isInterpolated & (selector - Int4(1)));
+
+	Int4 c7 = divideBC((Int4(7) - w7) * e0 + w7 * e1, 9363);
+	Int4 c5 = divideBC((Int4(5) - w5) * e0 + w5 * e1, 13108);
+
+	Int4 isMin = CmpEQ(selector, Int4(6));
+	Int4 isMax = CmpEQ(selector, Int4(7));
+	c5 = (~(isMin | isMax) & c5) |
+	     (isMin & Int4(isSigned ? -128 : 0)) |
+	     (isMax & Int4(isSigned ? 127 : 255));
+
+	Int4 eightValues = CmpGT(e0, e1);
+
+	return (eightValues & c7) | (~eightValues & c5);
+}
+
+Vector4s SamplerCore::sampleCompressedTexel(UInt index[4], Pointer<Byte> buffer)
+{
+	ASSERT(state.compressedFormat.isDecodedBySampler());
+
+	// The index holds the block index times 16, plus the texel's position within its 4x4 block.
+	int blockBytes = state.compressedFormat.bytesPerBlock();
+
+	Pointer<Byte> block[4];
+	Int texel[4];
+	Int4 texels;
+
+	for(int i = 0; i < 4; i++)
+	{
+		block[i] = buffer + (index[i] >> 4) * UInt(blockBytes);
+		texel[i] = As<Int>(index[i] & UInt(15));
+		texels = Insert(texels, texel[i], i);
+	}
+
+	Vector4s c;
+
+	switch(state.compressedFormat)
+	{
+	case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+	case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+	case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+	case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+	case VK_FORMAT_BC2_UNORM_BLOCK:
+	case VK_FORMAT_BC2_SRGB_BLOCK:
+	case VK_FORMAT_BC3_UNORM_BLOCK:
+	case VK_FORMAT_BC3_SRGB_BLOCK:
+		{
+			// BC2 and BC3 store the alpha block first, followed by a BC1 color block.
+			bool isBC1 = (blockBytes == 8);
+			int colorOffset = isBC1 ? 0 : 8;
+
+			Int4 endpoints;
+			Int4 indexBits;
+
+			for(int i = 0; i < 4; i++)
+			{
+				endpoints = Insert(endpoints, *Pointer<Int>(block[i] + colorOffset), i);
+				indexBits = Insert(indexBits, *Pointer<Int>(block[i] + colorOffset + 4), i);
+			}
+
+			Int4 selector = As<Int4>(As<UInt4>(indexBits) >> As<UInt4>(texels << 1)) & Int4(3);
+			Int4 color0 = endpoints & Int4(0xFFFF);
+			Int4 color1 = As<Int4>(As<UInt4>(endpoints) >> 16);
+
+			// BC1 blocks with color0 <= color1 hold three colors plus black, or transparent black.
+			Int4 fourColors = Int4(-1);
+			if(isBC1)
+			{
+				fourColors = CmpGT(color0, color1);
+			}
+
+			Int4 r = decodeBCColorChannel(expand565(color0, 11, 5), expand565(color1, 11, 5), selector, fourColors);
+			Int4 g = decodeBCColorChannel(expand565(color0, 5, 6), expand565(color1, 5, 6), selector, fourColors);
+			Int4 b = decodeBCColorChannel(expand565(color0, 0, 5), expand565(color1, 0, 5), selector, fourColors);
+			Int4 a = Int4(0xFF);
+
+			switch(state.compressedFormat)
+			{
+			case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+			case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+				a &= fourColors | ~CmpEQ(selector, Int4(3));
+				break;
+			case VK_FORMAT_BC2_UNORM_BLOCK:
+			case VK_FORMAT_BC2_SRGB_BLOCK:
+				{
+					// 4-bit explicit alpha.
+					Int4 alphaBits;
+					for(int i = 0; i < 4; i++)
+					{
+						alphaBits = Insert(alphaBits, *Pointer<Int>(block[i] + ((texel[i] >> 3) << 2)), i);
+					}
+
+					a = As<Int4>(As<UInt4>(alphaBits) >> As<UInt4>((texels & Int4(7)) << 2)) & Int4(0xF);
+					a |= a << 4;
+				}
+				break;
+			case VK_FORMAT_BC3_UNORM_BLOCK:
+			case VK_FORMAT_BC3_SRGB_BLOCK:
+				a = decodeBCChannel(block, texel, 0, false);
+				break;
+			default:
+				break;
+			}
+
+			c.x = Short4(r << 8);
+			c.y = Short4(g << 8);
+			c.z = Short4(b << 8);
+			c.w = Short4(a << 8);
+		}
+		break;
+	case VK_FORMAT_BC4_UNORM_BLOCK:
+	case VK_FORMAT_BC4_SNORM_BLOCK:
+		c.x = Short4(decodeBCChannel(block, texel, 0, state.compressedFormat == VK_FORMAT_BC4_SNORM_BLOCK) << 8);
+		break;
+	case VK_FORMAT_BC5_UNORM_BLOCK:
+	case VK_FORMAT_BC5_SNORM_BLOCK:
+		c.x = Short4(decodeBCChannel(block, texel, 0, state.compressedFormat == VK_FORMAT_BC5_SNORM_BLOCK) << 8);
+		c.y = Short4(decodeBCChannel(block, texel, 8, state.compressedFormat == VK_FORMAT_BC5_SNORM_BLOCK) << 8);
+		break;
+	case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK:
+	case VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK:
+	case VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK:
+	case VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK:
+	case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK:
+	case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK:
+		{
+			// ETC2 RGBA8 stores the alpha block first, followed by an ETC2 RGB8 color block.
+			bool punchThrough = (state.compressedFormat == VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK) ||
+			                    (state.compressedFormat == VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK);
+			int colorOffset = (blockBytes == 16) ? 8 : 0;
+
+			UInt4 blockIndex;
+			for(int i = 0; i < 4; i++)
+			{
+				blockIndex = Insert(blockIndex, index[i] >> 4, i);
+			}
+
+			if(etc2Blocks)
+			{
+				if(!etc2BlocksDecoded)
+				{
+					decodeETC2Blocks(block, blockIndex, colorOffset, punchThrough);
+					etc2BlocksDecoded = true;
+				}
+				else
+				{
+					If(SignMask(As<Int4>(CmpNEQ(etc2Blocks->blockIndex, blockIndex))) != 0)
+					{
+						decodeETC2Blocks(block, blockIndex, colorOffset, punchThrough);
+					}
+				}
+
+				c = sampleETC2(block, texels, colorOffset);
+			}
+			else
+			{
+				ETC2Blocks blocks;
+				etc2Blocks = &blocks;
+				decodeETC2Blocks(block, blockIndex, colorOffset, punchThrough);
+				c = sampleETC2(block, texels, colorOffset);
+				etc2Blocks = nullptr;
+			}
+		}
+		break;
+	case VK_FORMAT_EAC_R11_UNORM_BLOCK:
+	case VK_FORMAT_EAC_R11_SNORM_BLOCK:
+		c.x = Short4(decodeETC2Channel(block, texels, 0, state.compressedFormat == VK_FORMAT_EAC_R11_SNORM_BLOCK, true));
+		break;
+	case VK_FORMAT_EAC_R11G11_UNORM_BLOCK:
+	case VK_FORMAT_EAC_R11G11_SNORM_BLOCK:
+		c.x = Short4(decodeETC2Channel(block, texels, 0, state.compressedFormat == VK_FORMAT_EAC_R11G11_SNORM_BLOCK, true));
+		c.y = Short4(decodeETC2Channel(block, texels, 8, state.compressedFormat == VK_FORMAT_EAC_R11G11_SNORM_BLOCK, true));
+		break;
+	default:
+		UNSUPPORTED("state.compressedFormat %d", (int)state.compressedFormat);
+	}
+
+	return c;
+}
+
+SamplerCore::ETC2BlockScope::ETC2BlockScope(SamplerCore &core)
+    : core(core)
+{
+	// Only the outermost footprint shares its blocks.
+	if(!core.etc2Blocks)
+	{
+		core.etc2Blocks = &blocks;
+		core.etc2BlocksDecoded = false;
+	}
+}
+
+SamplerCore::ETC2BlockScope::~ETC2BlockScope()
+{
+	if(core.etc2Blocks == &blocks)
+	{
+		core.etc2Blocks = nullptr;
+		core.etc2BlocksDecoded = false;
+	}
+}
+
+// Extracts byte n of each lane.
+static Int4 extractByte(const Int4 &word, int n)
+{
+	return As<Int4>(As<UInt4>(word) >> (8 * n)) & Int4(0xFF);
+}
+
+// Extends 4, 5, 6 or 7 bit ETC2 color fields to 8 bits.
+static Int4 extendETC2(const Int4 &c, int bits)
+{
+	return (c << (8 - bits)) | (c >> (2 * bits - 8));
+}
+
+// Packs clamped color channels into R8G8B8A8, with opaque alpha.
+static Int4 packETC2(const Int4 &r, const Int4 &g, const Int4 &b)
+{
+	auto clamp = [](const Int4 &x) { return Min(Max(x, Int4(0)), Int4(0xFF)); };
+
+	return clamp(r) | (clamp(g) << 8) | (clamp(b) << 16) | As<Int4>(UInt4(0xFF000000u));
+}
+
+// Decodes the palettes of the ETC2 color blocks at colorOffset into etc2Blocks.
+// Lanes in individual or differential mode get two 4-entry subblock palettes,
+// T and H mode lanes get one 4-entry palette, and planar lanes are evaluated
+// per texel by sampleETC2().
+void SamplerCore::decodeETC2Blocks(Pointer<Byte> block[4], const UInt4 &blockIndex, int colorOffset, bool punchThrough)
+{
+	ETC2Blocks &blocks = *etc2Blocks;
+
+	Int4 w0;
+	Int4 w1;
+
+	for(int i = 0; i < 4; i++)
+	{
+		w0 = Insert(w0, *Pointer<Int>(block[i] + colorOffset), i);
+		w1 = Insert(w1, *Pointer<Int>(block[i] + colorOffset + 4), i);
+	}
+
+	blocks.blockIndex = blockIndex;
+	blocks.colorBits0 = w0;
+	blocks.colorBits1 = w1;
+
+	Int4 b0 = extractByte(w0, 0);
+	Int4 b1 = extractByte(w0, 1);
+	Int4 b2 = extractByte(w0, 2);
+	Int4 b3 = extractByte(w0, 3);
+
+	Int4 diffBit = CmpNEQ(b3 & Int4(2), Int4(0));
+	blocks.flip = CmpNEQ(b3 & Int4(1), Int4(0));
+
+	// Punch-through blocks are always in differential mode, and use the
+	// differential bit to tell opaque blocks from those with transparent texels.
+	Int4 differential = punchThrough ? Int4(-1) : diffBit;
+	Int4 nonOpaque = punchThrough ? Int4(~diffBit) : Int4(0);
+
+	// Differential mode's second base colors overflowing select the T, H and planar modes.
+	Int4 r = b0 >> 3;
+	Int4 g = b1 >> 3;
+	Int4 b = b2 >> 3;
+	Int4 r2 = r + ((b0 & Int4(7)) ^ Int4(4)) - Int4(4);
+	Int4 g2 = g + ((b1 & Int4(7)) ^ Int4(4)) - Int4(4);
+	Int4 b2nd = b + ((b2 & Int4(7)) ^ Int4(4)) - Int4(4);
+
+	auto overflows = [](const Int4 &x) { return CmpLT(x, Int4(0)) | CmpGT(x, Int4(31)); };
+	Int4 tMode = differential & overflows(r2);
+	Int4 hMode = differential & ~tMode & overflows(g2);
+	blocks.planar = differential & ~(tMode | hMode) & overflows(b2nd);
+	blocks.hasSubblocks = ~(tMode | hMode | blocks.planar);
+
+	// Individual and differential mode base colors.
+	Int4 individual = ~differential;
+	Int4 r1 = (individual & extendETC2(b0 >> 4, 4)) | (differential & extendETC2(r, 5));
+	Int4 g1 = (individual & extendETC2(b1 >> 4, 4)) | (differential & extendETC2(g, 5));
+	Int4 b1st = (individual & extendETC2(b2 >> 4, 4)) | (differential & extendETC2(b, 5));
+	r2 = (individual & extendETC2(b0 & Int4(0xF), 4)) | (differential & extendETC2(r2 & Int4(0x1F), 5));
+	g2 = (individual & extendETC2(b1 & Int4(0xF), 4)) | (differential & extendETC2(g2 & Int4(0x1F), 5));
+	b2nd = (individual & extendETC2(b2 & Int4(0xF), 4)) | (differential & extendETC2(b2nd & Int4(0x1F), 5));
+
+	// Intensity modifiers of both subblocks, transposed from their table rows.
+	Int4 codeword1 = b3 >> 5;
+	Int4 codeword2 = (b3 >> 2) & Int4(7);
+	Float4 modifiers1[4];
+	Float4 modifiers2[4];
+
+	for(int i = 0; i < 4; i++)
+	{
+		modifiers1[i] = *Pointer<Float4>(constants + OFFSET(Constants, etc2IntensityModifiers) + Extract(codeword1, i) * 16, 4);
+		modifiers2[i] = *Pointer<Float4>(constants + OFFSET(Constants, etc2IntensityModifiers) + Extract(codeword2, i) * 16, 4);
+	}
+
+	transpose4x4(modifiers1[0], modifiers1[1], modifiers1[2], modifiers1[3]);
+	transpose4x4(modifiers2[0], modifiers2[1], modifiers2[2], modifiers2[3]);
+
+	// T mode base colors.
+	Int4 tr1 = extendETC2((((b0 >> 3) & Int4(3)) << 2) | (b0 & Int4(3)), 4);
+	Int4 tg1 = extendETC2(b1 >> 4, 4);
+	Int4 tb1 = extendETC2(b1 & Int4(0xF), 4);
+	Int4 tr2 = extendETC2(b2 >> 4, 4);
+	Int4 tg2 = extendETC2(b2 & Int4(0xF), 4);
+	Int4 tb2 = extendETC2(b3 >> 4, 4);
+	Int4 tDistance = (((b3 >> 2) & Int4(3)) << 1) | (b3 & Int4(1));
+
+	// H mode base colors. The order of the base colors holds the distance's lowest bit.
+	Int4 hr1 = extendETC2((b0 >> 3) & Int4(0xF), 4);
+	Int4 hg1 = extendETC2(((b0 & Int4(7)) << 1) | ((b1 >> 4) & Int4(1)), 4);
+	Int4 hb1 = extendETC2((((b1 >> 3) & Int4(1)) << 3) | ((b1 & Int4(3)) << 1) | (b2 >> 7), 4);
+	Int4 hr2 = extendETC2((b2 >> 3) & Int4(0xF), 4);
+	Int4 hg2 = extendETC2(((b2 & Int4(7)) << 1) | (b3 >> 7), 4);
+	Int4 hb2 = extendETC2((b3 >> 3) & Int4(0xF), 4);
+	Int4 hOrder = CmpNLT((hr1 << 16) | (hg1 << 8) | hb1, (hr2 << 16) | (hg2 << 8) | hb2);
+	Int4 hDistance = (((b3 >> 2) & Int4(1)) << 2) | ((b3 & Int4(1)) << 1) | (hOrder & Int4(1));
+
+	Int4 distanceIndex = (tMode & tDistance) | (~tMode & hDistance);
+	Int4 d;
+	for(int i = 0; i < 4; i++)
+	{
+		d = Insert(d, *Pointer<Int>(constants + OFFSET(Constants, etc2Distances) + Extract(distanceIndex, i) * 4), i);
+	}
+
+	// T mode's palette is { c1, c2 + d, c2, c2 - d }, H mode's is { c1 + d, c1 - d, c2 + d, c2 - d }.
+	Int4 cr1 = (tMode & tr1) | (~tMode & hr1);
+	Int4 cg1 = (tMode & tg1) | (~tMode & hg1);
+	Int4 cb1 = (tMode & tb1) | (~tMode & hb1);
+	Int4 cr2 = (tMode & tr2) | (~tMode & hr2);
+	Int4 cg2 = (tMode & tg2) | (~tMode & hg2);
+	Int4 cb2 = (tMode & tb2) | (~tMode & hb2);
+	Int4 hd = ~tMode & d;
+
+	Int4 thPalette[4];
+	thPalette[0] = packETC2(cr1 + hd, cg1 + hd, cb1 + hd);
+	thPalette[1] = (tMode & packETC2(cr2 + d, cg2 + d, cb2 + d)) | (~tMode & packETC2(cr1 - d, cg1 - d, cb1 - d));
+	thPalette[2] = packETC2(cr2 + hd, cg2 + hd, cb2 + hd);
+	thPalette[3] = packETC2(cr2 - d, cg2 - d, cb2 - d);
+
+	for(int k = 0; k < 4; k++)
+	{
+		Int4 m1 = As<Int4>(modifiers1[k]);
+		Int4 m2 = As<Int4>(modifiers2[k]);
+
+		// Non-opaque punch-through blocks replace the modifiers of index 2 with
+		// transparent black, and those of index 0 with zero.
+		if(punchThrough && ((k == 0) || (k == 2)))
+		{
+			m1 &= ~nonOpaque;
+			m2 &= ~nonOpaque;
+		}
+
+		Int4 subblock1 = packETC2(r1 + m1, g1 + m1, b1st + m1);
+		blocks.palette[k] = (blocks.hasSubblocks & subblock1) | (~blocks.hasSubblocks & thPalette[k]);
+		blocks.palette[k + 4] = packETC2(r2 + m2, g2 + m2, b2nd + m2);
+	}
+
+	if(punchThrough)
+	{
+		blocks.palette[2] &= ~nonOpaque;
+		blocks.palette[6] &= ~nonOpaque;
+	}
+}
+
+// Selects the color of each lane's texel from the blocks decoded by decodeETC2Blocks(),
+// and decodes the alpha block of ETC2 RGBA8.
+Vector4s SamplerCore::sampleETC2(Pointer<Byte> block[4], const Int4 &texels, int colorOffset)
+{
+	const ETC2Blocks &blocks = *etc2Blocks;
+
+	// Texel indices are stored in column-major order, with the first byte holding the highest bits.
+	Int4 x = texels & Int4(3);
+	Int4 y = texels >> 2;
+	UInt4 bit = As<UInt4>(((x << 2) | y) ^ Int4(8));
+	Int4 msb = As<Int4>(As<UInt4>(blocks.colorBits1) >> bit) & Int4(1);
+	Int4 lsb = As<Int4>(As<UInt4>(blocks.colorBits1) >> (bit + UInt4(16))) & Int4(1);
+
+	Int4 secondSubblock = (blocks.flip & CmpNLT(y, Int4(2))) | (~blocks.flip & CmpNLT(x, Int4(2)));
+	Int4 selector = ((msb << 1) | lsb) + (blocks.hasSubblocks & secondSubblock & Int4(4));
+
+	Int4 color = Int4(0);
+	for(int e = 0; e < 8; e++)
+	{
+		color |= CmpEQ(selector, Int4(e)) & blocks.palette[e];
+	}
+
+	If(SignMask(blocks.planar) != 0)
+	{
+		Int4 b0 = extractByte(blocks.colorBits0, 0);
+		Int4 b1 = extractByte(blocks.colorBits0, 1);
+		Int4 b2 = extractByte(blocks.colorBits0, 2);
+		Int4 b3 = extractByte(blocks.colorBits0, 3);
+		Int4 b4 = extractByte(blocks.colorBits1, 0);
+		Int4 b5 = extractByte(blocks.colorBits1, 1);
+		Int4 b6 = extractByte(blocks.colorBits1, 2);
+		Int4 b7 = extractByte(blocks.colorBits1, 3);
+
+		// Origin, horizontal and vertical colors.
+		Int4 ro = extendETC2((b0 >> 1) & Int4(0x3F), 6);
+		Int4 go = extendETC2(((b0 & Int4(1)) << 6) | ((b1 >> 1) & Int4(0x3F)), 7);
+		Int4 bo = extendETC2(((b1 & Int4(1)) << 5) | (((b2 >> 3) & Int4(3)) << 3) | ((b2 & Int4(3)) << 1) | (b3 >> 7), 6);
+		Int4 rh = extendETC2((((b3 >> 2) & Int4(0x1F)) << 1) | (b3 & Int4(1)), 6);
+		Int4 gh = extendETC2(b4 >> 1, 7);
+		Int4 bh = extendETC2(((b4 & Int4(1)) << 5) | (b5 >> 3), 6);
+		Int4 rv = extendETC2(((b5 & Int4(7)) << 3) | (b6 >> 5), 6);
+		Int4 gv = extendETC2(((b6 & Int4(0x1F)) << 2) | (b7 >> 6), 7);
+		Int4 bv = extendETC2(b7 & Int4(0x3F), 6);
+
+		auto interpolate = [&](const Int4 &o, const Int4 &h, const Int4 &v) {
+			return ((x * (h - o) + y * (v - o) + Int4(2)) >> 2) + o;
+		};
+
+		Int4 planarColor = packETC2(interpolate(ro, rh, rv), interpolate(go, gh, gv), interpolate(bo, bh, bv));
+		color = (blocks.planar & planarColor) | (~blocks.planar & color);
+	}
+
+	Vector4s c;
+	c.x = Short4(extractByte(color, 0) << 8);
+	c.y = Short4(extractByte(color, 1) << 8);
+	c.z = Short4(extractByte(color, 2) << 8);
+	c.w = Short4(extractByte(color, 3) << 8);
+
+	if(colorOffset != 0)
+	{
+		c.w = Short4(decodeETC2Channel(block, texels, 0, false, false) << 8);
+	}
+
+	return c;
+}
+
+// Decodes the 8 byte ETC2 alpha or EAC blocks at offset. EAC values are
+// returned as 16-bit normalized values, and alpha as 8-bit values.
+Int4 SamplerCore::decodeETC2Channel(Pointer<Byte> block[4], const Int4 &texels, int offset, bool isSigned, bool isEAC)
+{
+	Int4 w0;
+	Int4 w1;
+
+	for(int i = 0; i < 4; i++)
+	{
+		w0 = Insert(w0, *Pointer<Int>(block[i] + offset), i);
+		w1 = Insert(w1, *Pointer<Int>(block[i] + offset + 4), i);
+	}
+
+	Int4 b0 = extractByte(w0, 0);
+	Int4 b1 = extractByte(w0, 1);
+
+	// The 48 index bits are stored big-endian, 3 bits per texel in column-major order.
+	UInt4 high = As<UInt4>((extractByte(w0, 2) << 24) | (extractByte(w0, 3) << 16) | (extractByte(w1, 0) << 8) | extractByte(w1, 1));
+	UInt4 low = As<UInt4>((extractByte(w1, 0) << 24) | (extractByte(w1, 1) << 16) | (extractByte(w1, 2) << 8) | extractByte(w1, 3));
+	Int4 position = Int4(45) - Int4(3) * (((texels & Int4(3)) << 2) | (texels >> 2));
+	Int4 inHigh = CmpNLT(position, Int4(16));
+	UInt4 highBits = high >> As<UInt4>(Max(position - Int4(16), Int4(0)));
+	UInt4 lowBits = low >> As<UInt4>(Min(position, Int4(31)));
+	Int4 selector = ((inHigh & As<Int4>(highBits)) | (~inHigh & As<Int4>(lowBits))) & Int4(7);
+
+	Int4 table = b1 & Int4(0xF);
+	Int4 multiplier = b1 >> 4;
+
+	Int4 modifier;
+	for(int i = 0; i < 4; i++)
+	{
+		Int entry = Extract(table, i) * 8 + Extract(selector, i);
+		modifier = Insert(modifier, *Pointer<Int>(constants + OFFSET(Constants, etc2AlphaModifiers) + entry * 4), i);
+	}
+
+	Int4 codeword = isSigned ? Int4((b0 << 24) >> 24) : b0;
+
+	if(!isEAC)
+	{
+		return Min(Max(codeword + modifier * multiplier, Int4(0)), Int4(0xFF));
+	}
+
+	// EAC's 11-bit values, expanded to 16 bits.
+	Int4 isZero = CmpEQ(multiplier, Int4(0));
+	Int4 scale = (isZero & Int4(1)) | (~isZero & (multiplier << 3));
+	Int4 value = (codeword << 3) + Int4(4) + modifier * scale;
+
+	value = isSigned ? Min(Max(value, Int4(-1023)), Int4(1023)) : Min(Max(value, Int4(0)), Int4(2047));
+
+	return value << 5;
+}
+
 void SamplerCore::sampleLumaTexel(Vector4f &output, Short4 &uuuu, Short4 &vvvv, Short4 &wwww, const Short4 &layerIndex, const Int4 &sample, Pointer<Byte> &lumaMipmap, Pointer<Byte> lumaBuffer)
 {
 	ASSERT(isYcbcrFormat());
@@ -2726,6 +3289,11 @@ bool SamplerCore::isYcbcrFormat() const
 	return state.textureFormat.isYcbcrFormat();
 }
 
+bool SamplerCore::isCompressedFormat() const
+{
+	return state.compressedFormat != VK_FORMAT_UNDEFINED;
+}
+
 bool SamplerCore::isRGBComponent(int component) const
 {
 	return state.textureFormat.isRGBComponent(component);
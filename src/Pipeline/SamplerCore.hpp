@@ -92,6 +92,10 @@ private:
 	void sampleChromaTexel(Vector4f& output, Short4 &u, Short4 &v, Short4 &w, const Short4 &cubeArrayLayer, const Int4 &sample, Pointer<Byte> &mipmapU, Pointer<Byte> bufferU, Pointer<Byte> &mipmapV, Pointer<Byte> bufferV);
 	Vector4s sampleTexel(Short4 &u, Short4 &v, Short4 &w, const Short4 &cubeArrayLayer, const Int4 &sample, Pointer<Byte> &mipmap, Pointer<Byte> buffer);
 	Vector4s sampleTexel(UInt index[4], Pointer<Byte> buffer);
+	Vector4s sampleCompressedTexel(UInt index[4], Pointer<Byte> buffer);
+	void decodeETC2Blocks(Pointer<Byte> block[4], const UInt4 &blockIndex, int colorOffset, bool punchThrough);
+	Vector4s sampleETC2(Pointer<Byte> block[4], const Int4 &texels, int colorOffset);
+	Int4 decodeETC2Channel(Pointer<Byte> block[4], const Int4 &texels, int offset, bool isSigned, bool isEAC);
 	Vector4f sampleTexel(Int4 &u, Int4 &v, Int4 &w, const Float4 &dRef, const Int4 &sample, Pointer<Byte> &mipmap, Pointer<Byte> buffer);
 	Vector4f replaceBorderTexel(const Vector4f &c, Int4 valid);
 	Pointer<Byte> selectMipmap(const Pointer<Byte> &texture, const Float &lod, bool secondLOD);
@@ -112,6 +116,7 @@ private:
 	bool has16bitTextureComponents() const;
 	bool has32bitIntegerTextureComponents() const;
 	bool isYcbcrFormat() const;
+	bool isCompressedFormat() const;
 	bool isRGBComponent(int component) const;
 	bool borderModeActive() const;
 	VkComponentSwizzle gatherSwizzle() const;
@@ -121,6 +126,35 @@ private:
 	Pointer<Byte> &constants;
 	const Sampler &state;
 	const SamplerFunction function;
+
+	// ETC2 color blocks decoded for the four lanes. The taps of a bilinear
+	// footprint mostly fall in the same blocks, so their palettes are only
+	// decoded again when a lane's block changes.
+	struct ETC2Blocks
+	{
+		UInt4 blockIndex;
+		Int4 colorBits0;
+		Int4 colorBits1;
+		Int4 flip;
+		Int4 hasSubblocks;
+		Int4 planar;
+		Int4 palette[8];  // Packed R8G8B8A8
+	};
+
+	// Shares the decoded ETC2 blocks between the taps of a footprint while in scope.
+	class ETC2BlockScope
+	{
+	public:
+		ETC2BlockScope(SamplerCore &core);
+		~ETC2BlockScope();
+
+	private:
+		SamplerCore &core;
+		ETC2Blocks blocks;
+	};
+
+	ETC2Blocks *etc2Blocks = nullptr;
+	bool etc2BlocksDecoded = false;
 };
 
 }  // namespace sw
@@ -19,6 +19,7 @@
 #include "spirv-tools/libspirv.h"
 
 #include <string.h>
+#include <algorithm>
 #include <atomic>
 #include <fstream>
 
@@ -34,21 +35,122 @@ std::string ConcatPath(const std::string &base, const std::string &file)
 	{
 		return file;
 	}
-	char lastChar = *base.rend();
+	char lastChar = base.back();
 	if(lastChar == '\\' || lastChar == '/')
 	{
 		return base + file;
 	}
 	return base + "/" + file;
 }
+
+// Slots in the per-thread counter slabs. A slot is released when its thread
+// exits, so that thread churn doesn't make running threads share slabs.
+class ThreadSlots
+{
+public:
+	uint32_t acquire()
+	{
+		marl::lock lock(mutex);
+		if(freeSlots.empty())
+		{
+			return nextSlot++;
+		}
+
+		uint32_t slot = freeSlots.back();
+		freeSlots.pop_back();
+		return slot;
+	}
+
+	void release(uint32_t slot)
+	{
+		marl::lock lock(mutex);
+		freeSlots.push_back(slot);
+	}
+
+private:
+	marl::mutex mutex;
+	uint32_t nextSlot GUARDED_BY(mutex) = 0;
+	std::vector<uint32_t> freeSlots GUARDED_BY(mutex);
+};
+
+// Never destroyed, as threads may exit during process exit.
+ThreadSlots &getThreadSlots()
+{
+	static ThreadSlots *slots = new ThreadSlots();
+	return *slots;
+}
+
+// Returns the slot of the calling thread in the per-thread counter slabs.
+uint32_t GetThreadSlot()
+{
+	struct Slot
+	{
+		Slot()
+		    : index(getThreadSlots().acquire())
+		{}
+
+		~Slot() { getThreadSlots().release(index); }
+
+		const uint32_t index;
+	};
+
+	thread_local Slot slot;
+	return slot.index;
+}
 }  // namespace
 
 namespace sw {
 
+SpirvProfileData::SpirvProfileData(std::vector<Block> blocks, std::vector<Line> lines)
+    : blocks(std::move(blocks))
+    , lines(std::move(lines))
+{
+	for(uint32_t i = 0; i < this->blocks.size(); i++)
+	{
+		blockIndices.emplace(this->blocks[i].labelId, i);
+	}
+
+	constexpr size_t countersPerCacheLine = 64 / sizeof(Counters) + 1;
+	slabSize = (this->blocks.size() + countersPerCacheLine - 1) / countersPerCacheLine * countersPerCacheLine;
+	counters.reset(new Counters[slabSize * MaxSlabs]());
+}
+
+uint32_t SpirvProfileData::getBlockIndex(uint32_t labelId) const
+{
+	auto it = blockIndices.find(labelId);
+	ASSERT(it != blockIndices.end());
+	return it->second;
+}
+
+SpirvProfileData::Counters *SpirvProfileData::GetThreadCounters(SpirvProfileData *data)
+{
+	return &data->counters[(GetThreadSlot() % MaxSlabs) * data->slabSize];
+}
+
+std::vector<SpirvProfileData::Totals> SpirvProfileData::Aggregate() const
+{
+	std::vector<Totals> total(blocks.size());
+
+	for(uint32_t slab = 0; slab < MaxSlabs; slab++)
+	{
+		const Counters *slabCounters = &counters[slab * slabSize];
+		for(size_t i = 0; i < blocks.size(); i++)
+		{
+			total[i].executions += slabCounters[i].executions.load(std::memory_order_relaxed);
+			total[i].invocations += slabCounters[i].invocations.load(std::memory_order_relaxed);
+			total[i].cycles += slabCounters[i].cycles.load(std::memory_order_relaxed);
+		}
+	}
+
+	return total;
+}
+
 SpirvProfiler::SpirvProfiler(const Configuration &config)
     : cfg(config)
 {
 	reportFilePath = ConcatPath(cfg.spvProfilingReportDir, "spirv_profile.txt");
+	instructionsFoldedFilePath = ConcatPath(cfg.spvProfilingReportDir, "spirv_profile_instructions.folded");
+	cyclesFoldedFilePath = ConcatPath(cfg.spvProfilingReportDir, "spirv_profile_cycles.folded");
 
 	reportThreadStop = false;
 	reportThread = std::thread{ [this] {
@@ -64,9 +166,21 @@ SpirvProfiler::~SpirvProfiler()
 {
 	reportThreadStop.store(true, std::memory_order_release);
 	reportThread.join();
+
+	// Write out what was collected since the last periodic report.
+	ReportSnapshot();
 }
 
 void SpirvProfiler::ReportSnapshot()
+{
+	auto profiles = GetRegisteredProfilesSnapshot();
+
+	WriteTextReport(profiles);
+	WriteFoldedReport(profiles, false);
+	WriteFoldedReport(profiles, true);
+}
+
+void SpirvProfiler::WriteTextReport(const std::unordered_map<std::string, SpirvProfileData *> &profiles)
 {
 	std::ofstream f{ reportFilePath };
 
@@ -76,27 +190,131 @@ void SpirvProfiler::ReportSnapshot()
 		return;
 	}
 
-	auto profiles = GetRegisteredProfilesSnapshot();
 	for(const auto &[shaderId, profileData] : profiles)
 	{
+		auto counters = profileData->Aggregate();
+
+		std::unordered_map<spv::Op, int64_t> spvOpExecutionCount;
+		for(size_t i = 0; i < profileData->blocks.size(); i++)
+		{
+			for(const auto &insn : profileData->blocks[i].instructions)
+			{
+				spvOpExecutionCount[insn.opcode] += counters[i].executions;
+			}
+		}
+
 		f << "[Shader " << shaderId << "]" << std::endl;
 
 		f << "[SPIR-V operand execution count]" << std::endl;
-		for(const auto &[spvOp, execCount] : profileData->spvOpExecutionCount)
+		for(const auto &[spvOp, execCount] : spvOpExecutionCount)
 		{
 			f << GetSpvOpName(spvOp) << ": " << execCount << std::endl;
 		}
 
+		// List the blocks from hottest to coldest.
+		std::vector<size_t> order(profileData->blocks.size());
+		for(size_t i = 0; i < order.size(); i++)
+		{
+			order[i] = i;
+		}
+		std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+			if(counters[a].cycles != counters[b].cycles)
+			{
+				return counters[a].cycles > counters[b].cycles;
+			}
+			return counters[a].invocations * profileData->blocks[a].instructions.size() >
+			       counters[b].invocations * profileData->blocks[b].instructions.size();
+		});
+
+		f << "[SPIR-V block profile]" << std::endl;
+		for(size_t i : order)
+		{
+			const auto &block = profileData->blocks[i];
+			f << "%" << block.labelId << ": executions " << counters[i].executions
+			  << ", invocations " << counters[i].invocations
+			  << ", instructions " << block.instructions.size()
+			  << ", cycles " << counters[i].cycles << std::endl;
+		}
+
 		f << std::endl;
 	}
 
 	f.close();
 }
 
-void SpirvProfiler::RegisterShaderForProfiling(std::string shaderId, std::unique_ptr<SpirvProfileData> profData)
+// Writes the profile in the folded stack format used by flame graph tools,
+// with one line per instruction of the form:
+//   shader;%block;file:line;OpName %result <count>
+// The count is the number of invocations which executed the instruction, or
+// its share of the cycles spent in the block.
+void SpirvProfiler::WriteFoldedReport(const std::unordered_map<std::string, SpirvProfileData *> &profiles, bool cycles)
+{
+	const std::string &path = cycles ? cyclesFoldedFilePath : instructionsFoldedFilePath;
+	std::ofstream f{ path };
+
+	if(!f)
+	{
+		warn("Error writing SPIR-V profile to file %s: %s\n", path.c_str(), strerror(errno));
+		return;
+	}
+
+	for(const auto &[shaderId, profileData] : profiles)
+	{
+		auto counters = profileData->Aggregate();
+
+		for(size_t i = 0; i < profileData->blocks.size(); i++)
+		{
+			const auto &block = profileData->blocks[i];
+			size_t instructionCount = block.instructions.size();
+
+			if(counters[i].executions == 0 || instructionCount == 0)
+			{
+				continue;
+			}
+
+			for(size_t j = 0; j < instructionCount; j++)
+			{
+				const auto &insn = block.instructions[j];
+
+				uint64_t count = counters[i].invocations;
+				if(cycles)
+				{
+					// Cycles are only known per block, so split them evenly.
+					count = counters[i].cycles / instructionCount + (j < counters[i].cycles % instructionCount ? 1 : 0);
+				}
+
+				if(count == 0)
+				{
+					continue;
+				}
+
+				f << shaderId << ";%" << block.labelId << ";";
+
+				if(insn.lineIndex != 0)
+				{
+					const auto &line = profileData->lines[insn.lineIndex];
+					f << line.file << ":" << line.line << ";";
+				}
+
+				f << GetSpvOpName(insn.opcode);
+				if(insn.resultId != 0)
+				{
+					f << " %" << insn.resultId;
+				}
+
+				f << " " << count << std::endl;
+			}
+		}
+	}
+
+	f.close();
+}
+
+SpirvProfileData *SpirvProfiler::RegisterShaderForProfiling(std::string shaderId, std::unique_ptr<SpirvProfileData> profData)
 {
 	marl::lock lock{ profileMux };
-	shaderProfiles[shaderId] = std::move(profData);
+	auto it = shaderProfiles.emplace(shaderId, std::move(profData)).first;
+	return it->second.get();
 }
 
 std::unordered_map<std::string, SpirvProfileData *> SpirvProfiler::GetRegisteredProfilesSnapshot()
@@ -24,24 +24,95 @@
 
 #include <atomic>
 #include <cstdint>
+#include <memory>
+#include <string>
 #include <thread>
 #include <unordered_map>
+#include <vector>
 
 namespace sw {
 
 // SpirvProfileData contains bookkeeping data structures for SPIR-V
 // instrumentation.
+//
+// The JIT-compiled shader counts how often each basic block is entered, by
+// how many invocations, and how many cycles are spent in it. Instruction
+// counts per opcode, result ID and source line are derived from these and
+// the static block contents when a report is written.
 class SpirvProfileData
 {
 public:
-	SpirvProfileData() = default;
+	// Static description of a basic block.
+	struct Block
+	{
+		uint32_t labelId = 0;
+
+		// Instructions executed each time the block runs, in order, with the
+		// source location they were attributed to by OpLine, if any.
+		struct Instruction
+		{
+			spv::Op opcode;
+			uint32_t resultId;  // Zero if the instruction has no result
+			uint32_t lineIndex;
+		};
+		std::vector<Instruction> instructions;
+	};
+
+	// Source location attributed by an OpLine instruction.
+	struct Line
+	{
+		std::string file;
+		uint32_t line = 0;
+	};
+
+	// Dynamic counters of a basic block. Each running thread is assigned a
+	// slab of counters, so the relaxed atomic increments of the JIT-compiled
+	// code rarely contend, and the slabs are summed when a report is written.
+	struct Counters
+	{
+		std::atomic<uint64_t> executions;   // Number of times the block was entered
+		std::atomic<uint64_t> invocations;  // Sum of active lanes when entering the block
+		std::atomic<uint64_t> cycles;       // Cycles spent in the block, if supported
+	};
+
+	static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t), "JIT code updates counters as 64-bit integers");
+
+	// Counters of a basic block, summed over all threads.
+	struct Totals
+	{
+		uint64_t executions = 0;
+		uint64_t invocations = 0;
+		uint64_t cycles = 0;
+	};
+
+	SpirvProfileData(std::vector<Block> blocks, std::vector<Line> lines);
 	SpirvProfileData(const SpirvProfileData &) = delete;
 	SpirvProfileData(SpirvProfileData &&) = delete;
 	SpirvProfileData &operator=(const SpirvProfileData &) = delete;
 	SpirvProfileData &operator=(SpirvProfileData &&) = delete;
 
-	// SPIR-V instruction execution count, by opcode.
-	std::unordered_map<spv::Op, int64_t> spvOpExecutionCount;
+	// Returns the index of the block with the given label in the counters.
+	uint32_t getBlockIndex(uint32_t labelId) const;
+
+	// Returns the counter slab of the calling thread. Called from JIT code.
+	static Counters *GetThreadCounters(SpirvProfileData *data);
+
+	// Returns the counters of all blocks, summed over all threads.
+	std::vector<Totals> Aggregate() const;
+
+	const std::vector<Block> blocks;
+
+	// Source locations. Index 0 is used for instructions without an OpLine.
+	const std::vector<Line> lines;
+
+private:
+	// Slots of exited threads are reused. Beyond this many concurrently
+	// running threads, slabs are shared, which only adds contention.
+	static constexpr uint32_t MaxSlabs = 64;
+
+	std::unordered_map<uint32_t, uint32_t> blockIndices;
+	size_t slabSize;  // In Counters, padded to a whole number of cache lines
+	std::unique_ptr<Counters[]> counters;
 };
 
 class SpirvProfiler
@@ -50,14 +121,21 @@ public:
 	SpirvProfiler(const Configuration &config);
 	~SpirvProfiler();
 
-	void RegisterShaderForProfiling(std::string shaderId, std::unique_ptr<SpirvProfileData> profData);
+	// Registers the profile data of a shader, unless data for the same shader
+	// ID was registered before, and returns the registered data. Shaders with
+	// the same ID share JIT routines, so they also share profile data.
+	SpirvProfileData *RegisterShaderForProfiling(std::string shaderId, std::unique_ptr<SpirvProfileData> profData);
 
 private:
 	void ReportSnapshot();
+	void WriteTextReport(const std::unordered_map<std::string, SpirvProfileData *> &profiles);
+	void WriteFoldedReport(const std::unordered_map<std::string, SpirvProfileData *> &profiles, bool cycles);
 	std::unordered_map<std::string, SpirvProfileData *> GetRegisteredProfilesSnapshot();
 
 	const Configuration &cfg;
 	std::string reportFilePath;
+	std::string instructionsFoldedFilePath;
+	std::string cyclesFoldedFilePath;
 
 	std::thread reportThread;
 	std::atomic<bool> reportThreadStop;
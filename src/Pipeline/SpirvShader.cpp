@@ -19,13 +19,19 @@
 
 #include "Device/Context.hpp"
 #include "System/Debug.hpp"
+#include "System/SwiftConfig.hpp"
 #include "Vulkan/VkPipelineLayout.hpp"
 #include "Vulkan/VkRenderPass.hpp"
 
 #include "marl/defer.h"
 
+#include <spirv/unified1/GLSL.std.450.h>
 #include <spirv/unified1/spirv.hpp>
 
+#include <algorithm>
+#include <cstdio>
+#include <map>
+
 namespace sw {
 
 Spirv::Spirv(
@@ -235,6 +241,9 @@ Spirv::Spirv(
 			break;
 
 		case spv::OpLoopMerge:
+			analysis.ContainsLoops = true;
+			break;
+
 		case spv::OpSelectionMerge:
 			break;  // Nothing to do in analysis pass.
 
@@ -677,19 +686,6 @@ Spirv::Spirv(
 		case spv::OpDPdyFine:
 		case spv::OpFwidthFine:
 		case spv::OpAtomicLoad:
-		case spv::OpAtomicIAdd:
-		case spv::OpAtomicISub:
-		case spv::OpAtomicSMin:
-		case spv::OpAtomicSMax:
-		case spv::OpAtomicUMin:
-		case spv::OpAtomicUMax:
-		case spv::OpAtomicAnd:
-		case spv::OpAtomicOr:
-		case spv::OpAtomicXor:
-		case spv::OpAtomicIIncrement:
-		case spv::OpAtomicIDecrement:
-		case spv::OpAtomicExchange:
-		case spv::OpAtomicCompareExchange:
 		case spv::OpPhi:
 		case spv::OpImageSampleImplicitLod:
 		case spv::OpImageSampleExplicitLod:
@@ -749,6 +745,23 @@ Spirv::Spirv(
 			DefineResult(insn);
 			break;
 
+		case spv::OpAtomicIAdd:
+		case spv::OpAtomicISub:
+		case spv::OpAtomicSMin:
+		case spv::OpAtomicSMax:
+		case spv::OpAtomicUMin:
+		case spv::OpAtomicUMax:
+		case spv::OpAtomicAnd:
+		case spv::OpAtomicOr:
+		case spv::OpAtomicXor:
+		case spv::OpAtomicIIncrement:
+		case spv::OpAtomicIDecrement:
+		case spv::OpAtomicExchange:
+		case spv::OpAtomicCompareExchange:
+			analysis.ContainsMemoryWrite = true;
+			DefineResult(insn);
+			break;
+
 		case spv::OpExtInst:
 			switch(getExtension(insn.word(3)).name)
 			{
@@ -769,6 +782,17 @@ Spirv::Spirv(
 		case spv::OpStore:
 		case spv::OpAtomicStore:
 		case spv::OpCopyMemory:
+			{
+				// Stores through pointers whose definition has not been seen yet are
+				// conservatively assumed to write memory which outlives the invocation.
+				auto it = defs.find(insn.word(1));
+				if(it == defs.end() || StoresInHelperInvocationsHaveNoEffect(getType(it->second).storageClass))
+				{
+					analysis.ContainsMemoryWrite = true;
+				}
+			}
+			break;
+
 		case spv::OpMemoryBarrier:
 			// Don't need to do anything during analysis pass
 			break;
@@ -819,6 +843,11 @@ Spirv::Spirv(
 		it.second.AssignBlockFields();
 	}
 
+	AnalyzeBarrierPhases();
+	AnalyzeSkippableBlocks();
+	AnalyzeUniformity();
+	AnalyzeInductionVariables();
+
 #ifdef SPIRV_SHADER_CFG_GRAPHVIZ_DOT_FILEPATH
 	{
 		char path[1024];
@@ -1308,7 +1337,7 @@ SIMD::Pointer SpirvEmitter::WalkExplicitLayoutAccessChain(Object::ID baseId, Obj
 				}
 				else
 				{
-					ptr += SIMD::Int(d.ArrayStride) * getIntermediate(indexIds[i]).Int(0);
+					OffsetByIndex(ptr, indexIds[i], d.ArrayStride);
 				}
 				typeId = type.element;
 			}
@@ -1326,7 +1355,7 @@ SIMD::Pointer SpirvEmitter::WalkExplicitLayoutAccessChain(Object::ID baseId, Obj
 				}
 				else
 				{
-					ptr += SIMD::Int(columnStride) * getIntermediate(indexIds[i]).Int(0);
+					OffsetByIndex(ptr, indexIds[i], columnStride);
 				}
 				typeId = type.element;
 			}
@@ -1341,7 +1370,7 @@ SIMD::Pointer SpirvEmitter::WalkExplicitLayoutAccessChain(Object::ID baseId, Obj
 				}
 				else
 				{
-					ptr += SIMD::Int(elemStride) * getIntermediate(indexIds[i]).Int(0);
+					OffsetByIndex(ptr, indexIds[i], elemStride);
 				}
 				typeId = type.element;
 			}
@@ -1445,7 +1474,7 @@ SIMD::Pointer SpirvEmitter::WalkAccessChain(Object::ID baseId, Object::ID elemen
 					}
 					else
 					{
-						ptr += SIMD::Int(stride) * getIntermediate(indexIds[i]).Int(0);
+						OffsetByIndex(ptr, indexIds[i], stride);
 					}
 				}
 				typeId = type.element;
@@ -1827,6 +1856,11 @@ void SpirvShader::emitProlog(SpirvRoutine *routine) const
 			break;
 		}
 	}
+
+	if(profileData)
+	{
+		routine->profileCounters = Call(SpirvProfileData::GetThreadCounters, profileData);
+	}
 }
 
 void SpirvShader::emit(SpirvRoutine *routine, const RValue<SIMD::Int> &activeLaneMask, const RValue<SIMD::Int> &storesAndAtomicsMask, const vk::DescriptorSet::Bindings &descriptorSets, const vk::Attachments *attachments, unsigned int multiSampleCount) const
@@ -1893,6 +1927,58 @@ SpirvShader::~SpirvShader()
 {
 }
 
+void SpirvShader::enableProfiling(SpirvProfiler *profiler)
+{
+	std::vector<SpirvProfileData::Block> profileBlocks;
+	std::vector<SpirvProfileData::Line> lines(1);  // Index 0 is 'no source location'.
+	std::map<std::pair<uint32_t, uint32_t>, uint32_t> lineIndices;
+
+	for(const auto &function : functions)
+	{
+		for(const auto &it : function.second.blocks)
+		{
+			SpirvProfileData::Block profileBlock;
+			profileBlock.labelId = it.first.value();
+
+			// OpLine applies until the next OpLine, OpNoLine or the end of the block.
+			uint32_t lineIndex = 0;
+
+			for(auto insn = it.second.begin(); insn != it.second.end(); insn++)
+			{
+				spv::Op opcode = insn.opcode();
+
+				if(opcode == spv::OpLine)
+				{
+					auto key = std::make_pair(insn.word(1), insn.word(2));
+					auto inserted = lineIndices.emplace(key, static_cast<uint32_t>(lines.size()));
+					if(inserted.second)
+					{
+						auto file = strings.find(StringID(insn.word(1)));
+						lines.push_back({ (file != strings.end()) ? file->second : "", insn.word(2) });
+					}
+					lineIndex = inserted.first->second;
+				}
+				else if(opcode == spv::OpNoLine)
+				{
+					lineIndex = 0;
+				}
+				else if(IsStatement(opcode))
+				{
+					uint32_t resultId = HasTypeAndResult(opcode) ? insn.resultId().value() : 0;
+					profileBlock.instructions.push_back({ opcode, resultId, lineIndex });
+				}
+			}
+
+			profileBlocks.push_back(std::move(profileBlock));
+		}
+	}
+
+	char shaderId[32];
+	snprintf(shaderId, sizeof(shaderId), "shader_%016llx", static_cast<unsigned long long>(getIdentifier()));
+
+	profileData = profiler->RegisterShaderForProfiling(shaderId, std::make_unique<SpirvProfileData>(std::move(profileBlocks), std::move(lines)));
+}
+
 SpirvEmitter::SpirvEmitter(const SpirvShader &shader,
                            SpirvRoutine *routine,
                            Spirv::Function::ID entryPoint,
@@ -1981,6 +2067,8 @@ void SpirvEmitter::EmitInstruction(InsnIterator insn)
 
 	if(shader.IsTerminator(opcode))
 	{
+		EndBlockProfile();
+
 		switch(opcode)
 		{
 		case spv::OpBranch:
@@ -2772,6 +2860,13 @@ void SpirvEmitter::EmitExtendedInstruction(InsnIterator insn)
 	}
 }
 
+rr::OptimizationProfileType Spirv::getOptimizationProfile() const
+{
+	bool loops = analysis.ContainsLoops || executionModel == spv::ExecutionModelGLCompute;
+
+	return (loops && getConfiguration().enableLoopOptimizations) ? rr::LoopProfile : rr::FastCompileProfile;
+}
+
 uint32_t Spirv::GetConstScalarInt(Object::ID id) const
 {
 	auto &scopeObj = getObject(id);
@@ -2781,6 +2876,351 @@ uint32_t Spirv::GetConstScalarInt(Object::ID id) const
 	return scopeObj.constantValue[0];
 }
 
+bool Spirv::GetUnsignedBound(Object::ID id, uint32_t &bound, int depth) const
+{
+	// Limits the search through long chains of arithmetic.
+	constexpr int maxDepth = 8;
+	if(depth > maxDepth)
+	{
+		return false;
+	}
+
+	auto &obj = getObject(id);
+	auto &type = getType(obj);
+	if(type.opcode() != spv::OpTypeInt || type.definition.word(2) != 32 || type.componentCount != 1)
+	{
+		return false;
+	}
+
+	if(obj.kind == Object::Kind::Constant)
+	{
+		bound = obj.constantValue[0];
+		return true;
+	}
+
+	if(obj.kind != Object::Kind::Intermediate)
+	{
+		return false;
+	}
+
+	auto insn = obj.definition;
+	auto constant = [&](uint32_t operandId, uint32_t &value) {
+		auto &operand = getObject(operandId);
+		if(operand.kind != Object::Kind::Constant || getType(operand).componentCount != 1)
+		{
+			return false;
+		}
+		value = operand.constantValue[0];
+		return true;
+	};
+
+	uint32_t a = 0, b = 0;
+	switch(insn.opcode())
+	{
+	case spv::OpBitwiseAnd:
+		{
+			bool hasA = GetUnsignedBound(insn.word(3), a, depth + 1);
+			bool hasB = GetUnsignedBound(insn.word(4), b, depth + 1);
+			if(!hasA && !hasB)
+			{
+				return false;
+			}
+			bound = std::min(hasA ? a : ~0u, hasB ? b : ~0u);
+			return true;
+		}
+	case spv::OpUMod:
+		if(!constant(insn.word(4), b) || b == 0)
+		{
+			return false;
+		}
+		bound = b - 1;
+		if(GetUnsignedBound(insn.word(3), a, depth + 1))
+		{
+			bound = std::min(bound, a);
+		}
+		return true;
+	case spv::OpUDiv:
+		if(!constant(insn.word(4), b) || b == 0)
+		{
+			return false;
+		}
+		bound = (GetUnsignedBound(insn.word(3), a, depth + 1) ? a : ~0u) / b;
+		return true;
+	case spv::OpShiftRightLogical:
+		if(!constant(insn.word(4), b) || b >= 32)
+		{
+			return false;
+		}
+		bound = (GetUnsignedBound(insn.word(3), a, depth + 1) ? a : ~0u) >> b;
+		return true;
+	case spv::OpIAdd:
+		if(!GetUnsignedBound(insn.word(3), a, depth + 1) ||
+		   !GetUnsignedBound(insn.word(4), b, depth + 1) ||
+		   uint64_t(a) + b > ~0u)
+		{
+			return false;
+		}
+		bound = a + b;
+		return true;
+	case spv::OpIMul:
+		if(!GetUnsignedBound(insn.word(3), a, depth + 1) ||
+		   !GetUnsignedBound(insn.word(4), b, depth + 1) ||
+		   uint64_t(a) * b > ~0u)
+		{
+			return false;
+		}
+		bound = a * b;
+		return true;
+	case spv::OpSelect:
+		if(!GetUnsignedBound(insn.word(4), a, depth + 1) ||
+		   !GetUnsignedBound(insn.word(5), b, depth + 1))
+		{
+			return false;
+		}
+		bound = std::max(a, b);
+		return true;
+	case spv::OpExtInst:
+		if(getExtension(insn.word(3)).name != Extension::GLSLstd450)
+		{
+			return false;
+		}
+		switch(insn.word(4))
+		{
+		case GLSLstd450UMin:
+			{
+				bool hasA = GetUnsignedBound(insn.word(5), a, depth + 1);
+				bool hasB = GetUnsignedBound(insn.word(6), b, depth + 1);
+				if(!hasA && !hasB)
+				{
+					return false;
+				}
+				bound = std::min(hasA ? a : ~0u, hasB ? b : ~0u);
+				return true;
+			}
+		case GLSLstd450UClamp:
+			return GetUnsignedBound(insn.word(7), bound, depth + 1);
+		case GLSLstd450SClamp:
+			// Clamping to a non-negative signed range also bounds the unsigned value.
+			if(!constant(insn.word(6), a) || !constant(insn.word(7), b) ||
+			   int32_t(a) < 0 || int32_t(a) > int32_t(b))
+			{
+				return false;
+			}
+			bound = b;
+			return true;
+		default:
+			return false;
+		}
+	default:
+		return false;
+	}
+}
+
+void Spirv::AnalyzeUniformity()
+{
+	auto isShared = [](spv::StorageClass storageClass) {
+		switch(storageClass)
+		{
+		case spv::StorageClassUniform:
+		case spv::StorageClassUniformConstant:
+		case spv::StorageClassStorageBuffer:
+		case spv::StorageClassPushConstant:
+		case spv::StorageClassWorkgroup:
+			return true;
+		default:
+			return false;
+		}
+	};
+
+	auto isUniform = [&](uint32_t id) {
+		auto it = defs.find(id);
+		return it != defs.end() && it->second.isUniform;
+	};
+
+	auto allUniform = [&](InsnIterator insn, uint32_t firstOperand) {
+		for(uint32_t w = firstOperand; w < insn.wordCount(); w++)
+		{
+			if(!isUniform(insn.word(w)))
+			{
+				return false;
+			}
+		}
+		return true;
+	};
+
+	// Definitions precede their uses in SPIR-V, apart from OpPhi operands,
+	// so a single pass suffices. Phis are conservatively treated as
+	// divergent, as that would require analyzing branch conditions.
+	for(auto insn : *this)
+	{
+		bool hasResult = false;
+		bool hasResultType = false;
+		spv::HasResultAndType(insn.opcode(), &hasResult, &hasResultType);
+		if(!hasResult || !hasResultType)
+		{
+			continue;
+		}
+
+		auto it = defs.find(insn.resultId());
+		if(it == defs.end())
+		{
+			continue;
+		}
+
+		auto &object = it->second;
+		if(object.kind == Object::Kind::Constant)
+		{
+			object.isUniform = true;
+			continue;
+		}
+
+		if(GetDecorationsForId(object.id()).NonUniform)
+		{
+			continue;
+		}
+
+		switch(insn.opcode())
+		{
+		case spv::OpVariable:
+			object.isUniform = isShared(getType(object).storageClass);
+			break;
+
+		case spv::OpLoad:
+			{
+				// All lanes read the same address at the same time, and the value
+				// is replicated to every lane, including inactive ones. Pointers
+				// in memory are only read by active lanes, while image and
+				// sampler handles are propagated. Trailing operands are memory
+				// access literals.
+				auto storageClass = getObjectType(insn.word(3)).storageClass;
+				object.isUniform = isUniform(insn.word(3)) && isShared(storageClass) &&
+				                   (object.kind != Object::Kind::Pointer || storageClass == spv::StorageClassUniformConstant);
+			}
+			break;
+
+		case spv::OpAccessChain:
+		case spv::OpInBoundsAccessChain:
+		case spv::OpPtrAccessChain:
+		case spv::OpInBoundsPtrAccessChain:
+		case spv::OpSNegate:
+		case spv::OpFNegate:
+		case spv::OpIAdd:
+		case spv::OpFAdd:
+		case spv::OpISub:
+		case spv::OpFSub:
+		case spv::OpIMul:
+		case spv::OpFMul:
+		case spv::OpUDiv:
+		case spv::OpSDiv:
+		case spv::OpFDiv:
+		case spv::OpUMod:
+		case spv::OpSRem:
+		case spv::OpSMod:
+		case spv::OpFRem:
+		case spv::OpFMod:
+		case spv::OpVectorTimesScalar:
+		case spv::OpMatrixTimesScalar:
+		case spv::OpVectorTimesMatrix:
+		case spv::OpMatrixTimesVector:
+		case spv::OpMatrixTimesMatrix:
+		case spv::OpOuterProduct:
+		case spv::OpDot:
+		case spv::OpTranspose:
+		case spv::OpShiftRightLogical:
+		case spv::OpShiftRightArithmetic:
+		case spv::OpShiftLeftLogical:
+		case spv::OpBitwiseOr:
+		case spv::OpBitwiseXor:
+		case spv::OpBitwiseAnd:
+		case spv::OpNot:
+		case spv::OpBitFieldInsert:
+		case spv::OpBitFieldSExtract:
+		case spv::OpBitFieldUExtract:
+		case spv::OpBitReverse:
+		case spv::OpBitCount:
+		case spv::OpAny:
+		case spv::OpAll:
+		case spv::OpIsNan:
+		case spv::OpIsInf:
+		case spv::OpLogicalEqual:
+		case spv::OpLogicalNotEqual:
+		case spv::OpLogicalOr:
+		case spv::OpLogicalAnd:
+		case spv::OpLogicalNot:
+		case spv::OpSelect:
+		case spv::OpIEqual:
+		case spv::OpINotEqual:
+		case spv::OpUGreaterThan:
+		case spv::OpSGreaterThan:
+		case spv::OpUGreaterThanEqual:
+		case spv::OpSGreaterThanEqual:
+		case spv::OpULessThan:
+		case spv::OpSLessThan:
+		case spv::OpULessThanEqual:
+		case spv::OpSLessThanEqual:
+		case spv::OpFOrdEqual:
+		case spv::OpFUnordEqual:
+		case spv::OpFOrdNotEqual:
+		case spv::OpFUnordNotEqual:
+		case spv::OpFOrdLessThan:
+		case spv::OpFUnordLessThan:
+		case spv::OpFOrdGreaterThan:
+		case spv::OpFUnordGreaterThan:
+		case spv::OpFOrdLessThanEqual:
+		case spv::OpFUnordLessThanEqual:
+		case spv::OpFOrdGreaterThanEqual:
+		case spv::OpFUnordGreaterThanEqual:
+		case spv::OpConvertFToU:
+		case spv::OpConvertFToS:
+		case spv::OpConvertSToF:
+		case spv::OpConvertUToF:
+		case spv::OpUConvert:
+		case spv::OpSConvert:
+		case spv::OpFConvert:
+		case spv::OpQuantizeToF16:
+		case spv::OpBitcast:
+		case spv::OpVectorExtractDynamic:
+		case spv::OpVectorInsertDynamic:
+		case spv::OpCompositeConstruct:
+		case spv::OpCopyObject:
+		case spv::OpCopyLogical:
+			object.isUniform = allUniform(insn, 3);
+			break;
+
+		case spv::OpVectorShuffle:
+		case spv::OpCompositeInsert:
+			// Trailing component selectors and indices are literals.
+			object.isUniform = isUniform(insn.word(3)) && isUniform(insn.word(4));
+			break;
+
+		case spv::OpCompositeExtract:
+			object.isUniform = isUniform(insn.word(3));
+			break;
+
+		case spv::OpExtInst:
+			if(getExtension(insn.word(3)).name == Extension::GLSLstd450)
+			{
+				switch(insn.word(4))
+				{
+				case GLSLstd450Modf:
+				case GLSLstd450Frexp:
+				case GLSLstd450InterpolateAtCentroid:
+				case GLSLstd450InterpolateAtSample:
+				case GLSLstd450InterpolateAtOffset:
+					break;
+				default:
+					object.isUniform = allUniform(insn, 5);
+					break;
+				}
+			}
+			break;
+
+		default:
+			break;
+		}
+	}
+}
+
 void SpirvShader::emitEpilog(SpirvRoutine *routine) const
 {
 	for(auto insn : *this)
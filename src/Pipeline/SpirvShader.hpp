@@ -62,6 +62,8 @@ namespace sw {
 
 // Forward declarations.
 class SpirvRoutine;
+class SpirvProfiler;
+class SpirvProfileData;
 
 // Incrementally constructed complex bundle of rvalues
 // Effectively a restricted vector, supporting only:
@@ -389,6 +391,10 @@ public:
 		};
 
 		Kind kind = Kind::Unknown;
+
+		// True if the value is dynamically uniform: equal in all active
+		// lanes. For pointers, the address is uniform.
+		bool isUniform = false;
 	};
 
 	// Block is an interval of SPIR-V instructions, starting with the
@@ -444,6 +450,12 @@ public:
 		Set outs;                        // Blocks that this block branches to.
 		bool isLoopMerge = false;
 
+		// True if the block is costly enough to be branched over when no
+		// lanes are active. liveOuts lists the block's results which are
+		// used by other blocks.
+		bool skippable = false;
+		std::vector<Object::ID> liveOuts;
+
 	private:
 		InsnIterator begin_;
 		InsnIterator end_;
@@ -565,11 +577,58 @@ public:
 		bool NeedsCentroid : 1;
 		bool ContainsSampleQualifier : 1;
 		bool ContainsImageWrite : 1;
+		bool ContainsLoops : 1;
+		bool ContainsMemoryWrite : 1;  // Stores or atomics on memory other than Function, Private or Output
 	};
 
 	const Analysis &getAnalysis() const { return analysis; }
 	bool containsImageWrite() const { return analysis.ContainsImageWrite; }
 
+	// Returns the Reactor optimization profile for routines emitted from
+	// this shader. Compute shaders and shaders with loops run long enough to
+	// repay the compile time of loop optimizations.
+	rr::OptimizationProfileType getOptimizationProfile() const;
+
+	// BarrierPhases describes how a compute entry point can be split at its
+	// workgroup control barriers into phases, each of which is run for all the
+	// subgroups of a workgroup before the next phase starts. This avoids
+	// running each subgroup as a coroutine which yields at every barrier.
+	// Splitting is only possible when every barrier is in a block which the
+	// whole workgroup executes exactly once, i.e. outside of any structured
+	// selection or loop construct of the entry point.
+	struct BarrierPhases
+	{
+		bool splittable = false;
+
+		// The intermediates which are defined before, and used after each
+		// workgroup barrier, keyed by the barrier's instruction position.
+		std::unordered_map<uint32_t, std::vector<Object::ID>> liveIntermediates;
+
+		// The Function and Private storage variables, which hold
+		// per-invocation state across every barrier.
+		std::vector<Object::ID> variables;
+
+		// The number of SIMD::Float slots needed to spill the state of one
+		// subgroup at any of the barriers.
+		uint32_t spillSlots = 0;
+	};
+
+	const BarrierPhases &getBarrierPhases() const { return barrierPhases; }
+
+	// A loop counter which the loop compares against a limit before each
+	// iteration, exiting once the limit is reached. In the blocks of the
+	// loop's body, the counter lies within [0, limit - 1] in all active lanes.
+	struct InductionVariable
+	{
+		Object::ID limit;
+		bool isSigned = false;  // Compared as signed. Starts non-negative and counts up by one.
+		Block::Set body;
+	};
+
+	// Returns the induction variable for the object, if the block lies in
+	// the body of its loop.
+	const InductionVariable *GetInductionVariable(Object::ID id, Block::ID block) const;
+
 	bool coverageModified() const
 	{
 		return analysis.ContainsDiscard ||
@@ -835,6 +894,8 @@ public:
 	std::unordered_set<uint32_t> extensionsImported;
 
 	Analysis analysis = {};
+	BarrierPhases barrierPhases;
+	std::unordered_map<Object::ID, InductionVariable> inductionVariables;
 
 	HandleMap<Type> types;
 	HandleMap<Object> defs;
@@ -859,6 +920,22 @@ public:
 	// Creates an Object for the instruction's result in 'defs'.
 	void DefineResult(const InsnIterator &insn);
 
+	// Determines whether the entry point's workgroup control barriers can be
+	// split into phases, and fills in barrierPhases if so.
+	void AnalyzeBarrierPhases();
+
+	// Marks the blocks which can be skipped at runtime when their active
+	// lane mask is empty, and collects their live-out values.
+	void AnalyzeSkippableBlocks();
+
+	// Determines which objects are dynamically uniform, being derived only
+	// from constants and loads of uniform addresses in shared memory.
+	void AnalyzeUniformity();
+
+	// Finds the counters of loops which are bounded by the loop's condition
+	// in the loop's body.
+	void AnalyzeInductionVariables();
+
 	using InterfaceVisitor = std::function<void(Decorations const, AttribType)>;
 
 	void VisitInterface(Object::ID id, const InterfaceVisitor &v) const;
@@ -937,6 +1014,13 @@ public:
 	uint32_t WalkLiteralAccessChain(Type::ID id, const Span &indexes) const;
 
 	uint32_t GetConstScalarInt(Object::ID id) const;
+
+	// Returns true and sets bound to an inclusive upper limit of the unsigned
+	// 32-bit integer value of the object in every lane, if one can be derived
+	// from the constant operands of the instructions producing it.
+	bool GetUnsignedBound(Object::ID id, uint32_t &bound, int depth = 0) const;
+
+	bool IsUniform(Object::ID id) const { return getObject(id).isUniform; }
 	void EvalSpecConstantOp(InsnIterator insn);
 	void EvalSpecConstantUnaryOp(InsnIterator insn);
 	void EvalSpecConstantBinaryOp(InsnIterator insn);
@@ -995,8 +1079,14 @@ public:
 
 	vk::Format getInputAttachmentFormat(const vk::Attachments &attachments, int32_t index) const;
 
+	// Registers the shader with the profiler, which makes the emitted code
+	// count the executions, active lanes and cycles of each block.
+	void enableProfiling(SpirvProfiler *profiler);
+	SpirvProfileData *getProfileData() const { return profileData; }
+
 private:
 	const bool robustBufferAccess;
+	SpirvProfileData *profileData = nullptr;
 
 	// When reading from an input attachment, its format is needed.  When the fragment shader
 	// pipeline library is created, the formats are available with render pass objects, but not
@@ -1412,6 +1502,7 @@ private:
 	void EmitCopyObject(InsnIterator insn);
 	void EmitCopyMemory(InsnIterator insn);
 	void EmitControlBarrier(InsnIterator insn);
+	void EmitBarrierPhaseSplit(InsnIterator insn);
 	void EmitMemoryBarrier(InsnIterator insn);
 	void EmitGroupNonUniform(InsnIterator insn);
 	void EmitArrayLength(InsnIterator insn);
@@ -1485,6 +1576,13 @@ private:
 	SIMD::Pointer GetPointerToData(Object::ID id, SIMD::Int arrayIndex, bool nonUniform) const;
 	void OffsetToElement(SIMD::Pointer &ptr, Object::ID elementId, int32_t arrayStride) const;
 
+	// Offsets the pointer by stride times the dynamic index. Indices with a
+	// known bound keep the pointer's offsets bounded, so that accesses which
+	// are provably within a static limit need no per-lane bounds checks.
+	// Uniform indices keep the offsets equal across lanes, so that accesses
+	// touch memory once.
+	void OffsetByIndex(SIMD::Pointer &ptr, Object::ID indexId, uint32_t stride) const;
+
 	/* image istructions */
 
 	// Emits code to sample an image, regardless of whether any SIMD lanes are active.
@@ -1524,10 +1622,17 @@ private:
 	void EmitBlocks(Block::ID id, Block::ID ignore = 0);
 	void EmitNonLoop();
 	void EmitLoop();
+	void EmitSkippableBlock(Block::ID blockId, const Block &block);
 
 	void EmitInstructions(InsnIterator begin, InsnIterator end);
 	void EmitInstruction(InsnIterator insn);
 
+	// Emits the profiling counter updates for entering and leaving the
+	// current block. Passing countExecution = false resumes cycle counting
+	// after a barrier without counting the block as entered again.
+	void BeginBlockProfile(bool countExecution);
+	void EndBlockProfile();
+
 	// Helper for implementing OpStore, which doesn't take an InsnIterator so it
 	// can also store independent operands.
 	void Store(Object::ID pointerId, const Operand &value, bool atomic, std::memory_order memoryOrder) const;
@@ -1570,6 +1675,8 @@ private:
 	Block::ID block;                                 // The current block being built.
 	rr::Value *activeLaneMaskValue = nullptr;        // The current active lane mask.
 	rr::Value *storesAndAtomicsMaskValue = nullptr;  // The current atomics mask.
+	Block::ID profiledBlock = 0;                     // The block being profiled, if any.
+	rr::Value *profileStartTicks = nullptr;          // Cycle counter at the start of the profiled block.
 	Spirv::Block::Set visited;                       // Blocks already built.
 	std::unordered_map<Block::Edge, RValue<SIMD::Int>, Block::Edge::Hash> edgeActiveLaneMasks;
 	std::deque<Block::ID> *pending;
@@ -1660,6 +1767,17 @@ public:
 	std::array<SIMD::Int, 3> localInvocationID;   // TODO(b/236162233): SIMD::Int3
 	std::array<SIMD::Int, 3> globalInvocationID;  // TODO(b/236162233): SIMD::Int3
 
+	// Workgroup barrier phase splitting state (see Spirv::BarrierPhases).
+	// When nextBarrierPhase is set, workgroup barriers don't yield. Instead the
+	// state of the current subgroup is spilled to barrierPhaseSpill, and
+	// nextBarrierPhase() is called to start the next phase, after which the
+	// state of the subgroup it selected is reloaded from barrierPhaseSpill.
+	std::function<void()> nextBarrierPhase;
+	Pointer<Byte> barrierPhaseSpill;
+
+	// The calling thread's SpirvProfileData::Counters when profiling.
+	Pointer<Byte> profileCounters;
+
 	void createVariable(Object::ID id, uint32_t componentCount)
 	{
 		bool added = variables.emplace(id, Variable(componentCount)).second;
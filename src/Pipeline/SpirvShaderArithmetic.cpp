@@ -353,6 +353,15 @@ void SpirvEmitter::EmitBinaryOp(Spirv::InsnIterator insn)
 	auto lhs = Operand(shader, *this, insn.word(3));
 	auto rhs = Operand(shader, *this, insn.word(4));
 
+	// Integer division has no vector instructions and gets emitted once per
+	// lane. Splatting lane 0 of dynamically uniform operands lets the backend
+	// perform it once. Lane 0 may be inactive, but uniform values derive only
+	// from constants and replicated loads, so they're equal in all lanes.
+	// Phis, function parameters and lane-dependent loads are never uniform.
+	bool uniform = shader.IsUniform(insn.resultId());
+	auto splatInt = [&](RValue<SIMD::Int> x) { return uniform ? SIMD::Int(Extract(x, 0)) : SIMD::Int(x); };
+	auto splatUInt = [&](RValue<SIMD::UInt> x) { return uniform ? SIMD::UInt(Extract(x, 0)) : SIMD::UInt(x); };
+
 	for(auto i = 0u; i < lhsType.componentCount; i++)
 	{
 		switch(insn.opcode())
@@ -368,8 +377,8 @@ void SpirvEmitter::EmitBinaryOp(Spirv::InsnIterator insn)
 			break;
 		case spv::OpSDiv:
 			{
-				SIMD::Int a = lhs.Int(i);
-				SIMD::Int b = rhs.Int(i);
+				SIMD::Int a = splatInt(lhs.Int(i));
+				SIMD::Int b = splatInt(rhs.Int(i));
 				b = b | CmpEQ(b, SIMD::Int(0));                                       // prevent divide-by-zero
 				a = a | (CmpEQ(a, SIMD::Int(0x80000000)) & CmpEQ(b, SIMD::Int(-1)));  // prevent integer overflow
 				dst.move(i, a / b);
@@ -377,14 +386,16 @@ void SpirvEmitter::EmitBinaryOp(Spirv::InsnIterator insn)
 			break;
 		case spv::OpUDiv:
 			{
-				auto zeroMask = As<SIMD::UInt>(CmpEQ(rhs.Int(i), SIMD::Int(0)));
-				dst.move(i, lhs.UInt(i) / (rhs.UInt(i) | zeroMask));
+				SIMD::UInt a = splatUInt(lhs.UInt(i));
+				SIMD::UInt b = splatUInt(rhs.UInt(i));
+				auto zeroMask = As<SIMD::UInt>(CmpEQ(As<SIMD::Int>(b), SIMD::Int(0)));
+				dst.move(i, a / (b | zeroMask));
 			}
 			break;
 		case spv::OpSRem:
 			{
-				SIMD::Int a = lhs.Int(i);
-				SIMD::Int b = rhs.Int(i);
+				SIMD::Int a = splatInt(lhs.Int(i));
+				SIMD::Int b = splatInt(rhs.Int(i));
 				b = b | CmpEQ(b, SIMD::Int(0));                                       // prevent divide-by-zero
 				a = a | (CmpEQ(a, SIMD::Int(0x80000000)) & CmpEQ(b, SIMD::Int(-1)));  // prevent integer overflow
 				dst.move(i, a % b);
@@ -392,8 +403,8 @@ void SpirvEmitter::EmitBinaryOp(Spirv::InsnIterator insn)
 			break;
 		case spv::OpSMod:
 			{
-				SIMD::Int a = lhs.Int(i);
-				SIMD::Int b = rhs.Int(i);
+				SIMD::Int a = splatInt(lhs.Int(i));
+				SIMD::Int b = splatInt(rhs.Int(i));
 				b = b | CmpEQ(b, SIMD::Int(0));                                       // prevent divide-by-zero
 				a = a | (CmpEQ(a, SIMD::Int(0x80000000)) & CmpEQ(b, SIMD::Int(-1)));  // prevent integer overflow
 				auto mod = a % b;
@@ -410,8 +421,10 @@ void SpirvEmitter::EmitBinaryOp(Spirv::InsnIterator insn)
 			break;
 		case spv::OpUMod:
 			{
-				auto zeroMask = As<SIMD::UInt>(CmpEQ(rhs.Int(i), SIMD::Int(0)));
-				dst.move(i, lhs.UInt(i) % (rhs.UInt(i) | zeroMask));
+				SIMD::UInt a = splatUInt(lhs.UInt(i));
+				SIMD::UInt b = splatUInt(rhs.UInt(i));
+				auto zeroMask = As<SIMD::UInt>(CmpEQ(As<SIMD::Int>(b), SIMD::Int(0)));
+				dst.move(i, a % (b | zeroMask));
 			}
 			break;
 		case spv::OpIEqual:
@@ -13,6 +13,8 @@
 // limitations under the License.
 
 #include "SpirvShader.hpp"
+
+#include "SpirvProfiler.hpp"
 #include "SpirvShaderDebug.hpp"
 
 #include "Reactor/Coroutine.hpp"  // rr::Yield
@@ -21,7 +23,9 @@
 
 #include <spirv/unified1/spirv.hpp>
 
+#include <algorithm>
 #include <queue>
+#include <unordered_set>
 
 #include <fstream>
 #include <iostream>
@@ -195,6 +199,537 @@ bool Spirv::Function::ExistsPath(Block::ID from, Block::ID to, Block::ID notPass
 	return false;
 }
 
+void Spirv::AnalyzeBarrierPhases()
+{
+	if(executionModel != spv::ExecutionModelGLCompute || !analysis.ContainsControlBarriers)
+	{
+		return;
+	}
+
+	// Spilled state larger than this is better served by a coroutine per subgroup.
+	constexpr uint32_t maxSpillSlots = 256;
+
+	const auto &function = getFunction(entryPoint);
+
+	auto isWorkgroupBarrier = [&](InsnIterator insn) {
+		return insn.opcode() == spv::OpControlBarrier &&
+		       spv::Scope(GetConstScalarInt(insn.word(1))) == spv::ScopeWorkgroup;
+	};
+
+	// Only the blocks of the entry point are analyzed, so barriers reached
+	// through function calls can't be phase boundaries.
+	uint32_t barrierCount = 0;
+	for(auto insn : *this)
+	{
+		if(insn.opcode() == spv::OpFunctionCall)
+		{
+			return;
+		}
+
+		if(isWorkgroupBarrier(insn))
+		{
+			barrierCount++;
+		}
+	}
+
+	// Find the 'spine' of the entry point: the sequence of blocks executed
+	// exactly once by all invocations. Selection and loop constructs are
+	// stepped over by continuing at their merge block.
+	std::vector<Block::ID> spine;
+	Block::Set onSpine;
+	for(Block::ID id = function.entry; id != 0;)
+	{
+		const auto &block = function.getBlock(id);
+		if(!onSpine.emplace(id).second || (id != function.entry && block.ins.empty()))
+		{
+			return;
+		}
+
+		spine.push_back(id);
+
+		switch(block.kind)
+		{
+		case Block::Simple:
+			id = block.outs.empty() ? Block::ID(0) : *block.outs.begin();
+			break;
+		case Block::StructuredBranchConditional:
+		case Block::StructuredSwitch:
+		case Block::Loop:
+			id = block.mergeBlock;
+			break;
+		default:
+			return;  // Unstructured control flow.
+		}
+	}
+
+	std::unordered_map<Object::ID, uint32_t> definitionPhase;
+	std::vector<std::unordered_set<Object::ID>> live;  // Live intermediates, per barrier.
+	std::vector<uint32_t> barriers;                    // Barrier instruction positions.
+
+	// Records the phase of the instruction's result, and which intermediates
+	// it uses from earlier phases. Any word which matches the identifier of an
+	// earlier result is conservatively treated as a use, since literal operands
+	// can at most cause a redundant spill. Returns false if the instruction uses
+	// a pointer or image from an earlier phase, as those can't be spilled.
+	auto visit = [&](InsnIterator insn, uint32_t phase) {
+		bool hasResult = false, hasResultType = false;
+		spv::HasResultAndType(insn.opcode(), &hasResult, &hasResultType);
+
+		for(uint32_t w = 1 + (hasResult ? 1 : 0) + (hasResultType ? 1 : 0); w < insn.wordCount(); w++)
+		{
+			auto it = definitionPhase.find(Object::ID(insn.word(w)));
+			if(it == definitionPhase.end() || it->second >= phase)
+			{
+				continue;
+			}
+
+			const auto &object = getObject(it->first);
+			if(object.kind == Object::Kind::Intermediate)
+			{
+				for(uint32_t barrier = it->second; barrier < phase; barrier++)
+				{
+					live[barrier].emplace(it->first);
+				}
+			}
+			else if(object.opcode() != spv::OpVariable)  // Variables are uniform pointers to per-subgroup storage.
+			{
+				return false;
+			}
+		}
+
+		if(hasResult && hasResultType && defs.count(insn.resultId()) != 0)
+		{
+			definitionPhase.emplace(insn.resultId(), phase);
+		}
+
+		return true;
+	};
+
+	uint32_t phase = 0;
+	for(auto spineId : spine)
+	{
+		const auto &block = function.getBlock(spineId);
+		for(auto insn : block)
+		{
+			if(isWorkgroupBarrier(insn))
+			{
+				if(block.kind == Block::Loop)
+				{
+					return;  // Loop headers are executed once per iteration.
+				}
+
+				barriers.push_back(insn.distanceFrom(begin()));
+				live.emplace_back();
+				phase++;
+			}
+			else if(!visit(insn, phase))
+			{
+				return;
+			}
+		}
+
+		// Visit the blocks of the constructs headed by this block, which all
+		// belong to the current phase.
+		Block::Set region;
+		std::vector<Block::ID> pending(block.outs.begin(), block.outs.end());
+		while(!pending.empty())
+		{
+			auto id = pending.back();
+			pending.pop_back();
+
+			if(onSpine.count(id) != 0 || !region.emplace(id).second)
+			{
+				continue;
+			}
+
+			const auto &regionBlock = function.getBlock(id);
+			if(regionBlock.outs.empty())
+			{
+				// Returning from within a construct would let the emitter visit
+				// this block after the following spine blocks.
+				return;
+			}
+
+			for(auto insn : regionBlock)
+			{
+				if(isWorkgroupBarrier(insn) || !visit(insn, phase))
+				{
+					return;
+				}
+			}
+
+			pending.insert(pending.end(), regionBlock.outs.begin(), regionBlock.outs.end());
+		}
+	}
+
+	if(barriers.size() != barrierCount)
+	{
+		return;  // Some barriers are not on the analyzed path.
+	}
+
+	std::vector<Object::ID> variables;
+	uint32_t variableSlots = 0;
+	for(auto insn : *this)
+	{
+		if(insn.opcode() != spv::OpVariable)
+		{
+			continue;
+		}
+
+		auto storageClass = spv::StorageClass(insn.word(3));
+		auto componentCount = getType(getType(insn.resultTypeId()).element).componentCount;
+
+		if(storageClass == spv::StorageClassWorkgroup && insn.wordCount() > 4)
+		{
+			return;  // Workgroup memory initialization requires a barrier of its own.
+		}
+
+		if((storageClass == spv::StorageClassFunction || storageClass == spv::StorageClassPrivate) &&
+		   componentCount > 0)
+		{
+			variables.push_back(insn.resultId());
+			variableSlots += componentCount;
+		}
+	}
+
+	// The active lane mask and the stores and atomics mask take a slot each.
+	uint32_t spillSlots = 0;
+	for(uint32_t i = 0; i < barriers.size(); i++)
+	{
+		uint32_t slots = 2 + variableSlots;
+		for(auto id : live[i])
+		{
+			slots += getObjectType(id).componentCount;
+		}
+
+		spillSlots = std::max(spillSlots, slots);
+	}
+
+	if(spillSlots > maxSpillSlots)
+	{
+		return;
+	}
+
+	for(uint32_t i = 0; i < barriers.size(); i++)
+	{
+		barrierPhases.liveIntermediates.emplace(barriers[i], std::vector<Object::ID>(live[i].begin(), live[i].end()));
+	}
+
+	barrierPhases.variables = std::move(variables);
+	barrierPhases.spillSlots = spillSlots;
+	barrierPhases.splittable = true;
+}
+
+void Spirv::AnalyzeSkippableBlocks()
+{
+	// Blocks cheaper than this run faster with no active lanes than the
+	// branch around them costs.
+	constexpr int minSkippableCost = 8;
+
+	for(auto &functionIt : functions)
+	{
+		auto &function = functionIt.second;
+
+		std::unordered_map<Object::ID, Block::ID> definingBlock;
+		for(auto &it : function.blocks)
+		{
+			for(auto insn = it.second.begin(); insn != it.second.end(); insn++)
+			{
+				bool hasResult = false;
+				bool hasResultType = false;
+				spv::HasResultAndType(insn.opcode(), &hasResult, &hasResultType);
+
+				if(hasResult && insn.opcode() != spv::OpLabel && defs.count(insn.resultId()) != 0)
+				{
+					definingBlock.emplace(insn.resultId(), it.first);
+				}
+			}
+		}
+
+		// Any operand word naming a result of another block is treated as a
+		// use. Literals which happen to match a result ID only make the
+		// analysis more conservative.
+		std::unordered_map<Block::ID, std::unordered_set<Object::ID>> liveOuts;
+		for(auto &it : function.blocks)
+		{
+			for(auto insn = it.second.begin(); insn != it.second.end(); insn++)
+			{
+				for(uint32_t w = 1; w < insn.wordCount(); w++)
+				{
+					auto defIt = definingBlock.find(Object::ID(insn.word(w)));
+					if(defIt != definingBlock.end() && defIt->second != it.first)
+					{
+						liveOuts[defIt->second].emplace(defIt->first);
+					}
+				}
+			}
+		}
+
+		for(auto &it : function.blocks)
+		{
+			auto &block = it.second;
+			if(it.first == function.entry || block.kind == Block::Loop)
+			{
+				continue;
+			}
+
+			bool eligible = true;
+			int cost = 0;
+			for(auto insn = block.begin(); insn != block.end() && eligible; insn++)
+			{
+				switch(insn.opcode())
+				{
+				case spv::OpFunctionCall:
+				case spv::OpControlBarrier:
+				case spv::OpReturn:
+				case spv::OpReturnValue:
+				case spv::OpKill:
+				case spv::OpTerminateInvocation:
+				case spv::OpDemoteToHelperInvocationEXT:
+				case spv::OpUnreachable:
+					// These affect state beyond the block's own results.
+					eligible = false;
+					break;
+				case spv::OpLabel:
+				case spv::OpPhi:
+				case spv::OpSelectionMerge:
+				case spv::OpBranch:
+				case spv::OpBranchConditional:
+				case spv::OpSwitch:
+				case spv::OpLine:
+				case spv::OpNoLine:
+				case spv::OpNop:
+					break;
+				case spv::OpLoad:
+				case spv::OpStore:
+				case spv::OpCopyMemory:
+				case spv::OpImageSampleImplicitLod:
+				case spv::OpImageSampleExplicitLod:
+				case spv::OpImageSampleDrefImplicitLod:
+				case spv::OpImageSampleDrefExplicitLod:
+				case spv::OpImageSampleProjImplicitLod:
+				case spv::OpImageSampleProjExplicitLod:
+				case spv::OpImageSampleProjDrefImplicitLod:
+				case spv::OpImageSampleProjDrefExplicitLod:
+				case spv::OpImageFetch:
+				case spv::OpImageGather:
+				case spv::OpImageDrefGather:
+				case spv::OpImageRead:
+				case spv::OpImageWrite:
+					cost += 4;
+					break;
+				default:
+					cost += 1;
+					break;
+				}
+			}
+
+			// Values used elsewhere are passed out through variables, which
+			// only intermediates support.
+			auto &blockLiveOuts = liveOuts[it.first];
+			for(auto id : blockLiveOuts)
+			{
+				if(getObject(id).kind != Object::Kind::Intermediate)
+				{
+					eligible = false;
+				}
+			}
+
+			if(eligible && cost >= minSkippableCost)
+			{
+				block.skippable = true;
+				block.liveOuts.assign(blockLiveOuts.begin(), blockLiveOuts.end());
+				std::sort(block.liveOuts.begin(), block.liveOuts.end());
+			}
+		}
+	}
+}
+
+void Spirv::AnalyzeInductionVariables()
+{
+	auto isScalarInt32 = [&](const Object &object) {
+		auto &type = getType(object);
+		return type.opcode() == spv::OpTypeInt && type.definition.word(2) == 32 && type.componentCount == 1;
+	};
+
+	for(auto &functionIt : functions)
+	{
+		auto &function = functionIt.second;
+
+		for(auto &it : function.blocks)
+		{
+			auto headerId = it.first;
+			auto &header = it.second;
+			if(header.kind != Block::Loop)
+			{
+				continue;
+			}
+
+			// The condition is evaluated either by the header, or by a block
+			// which only the header branches to.
+			auto conditionId = headerId;
+			if(header.branchInstruction.opcode() == spv::OpBranch)
+			{
+				conditionId = Block::ID(header.branchInstruction.word(1));
+				if(conditionId == header.mergeBlock || function.blocks.count(conditionId) == 0)
+				{
+					continue;
+				}
+			}
+
+			auto &condition = function.getBlock(conditionId);
+			if(condition.branchInstruction.opcode() != spv::OpBranchConditional)
+			{
+				continue;
+			}
+
+			if(conditionId != headerId && (condition.ins.size() != 1 || condition.ins.count(headerId) == 0))
+			{
+				continue;
+			}
+
+			// Lanes continue into the body while the comparison holds, and
+			// leave the loop otherwise.
+			Block::ID bodyId = condition.branchInstruction.word(2);
+			if(Block::ID(condition.branchInstruction.word(3)) != header.mergeBlock ||
+			   bodyId == header.mergeBlock || bodyId == headerId || bodyId == conditionId)
+			{
+				continue;
+			}
+
+			auto &comparison = getObject(condition.branchInstruction.word(1));
+			if(comparison.kind != Object::Kind::Intermediate)
+			{
+				continue;
+			}
+
+			auto compare = comparison.definition;
+			Object::ID counterId;
+			Object::ID limitId;
+			bool isSigned = false;
+			switch(compare.opcode())
+			{
+			case spv::OpSLessThan:
+				isSigned = true;
+				// [[fallthrough]]
+			case spv::OpULessThan:
+				counterId = compare.word(3);
+				limitId = compare.word(4);
+				break;
+			case spv::OpSGreaterThan:
+				isSigned = true;
+				// [[fallthrough]]
+			case spv::OpUGreaterThan:
+				counterId = compare.word(4);
+				limitId = compare.word(3);
+				break;
+			default:
+				continue;
+			}
+
+			auto &counter = getObject(counterId);
+			if(counter.kind != Object::Kind::Intermediate || !isScalarInt32(counter))
+			{
+				continue;
+			}
+
+			// The counter must hold the same value throughout an iteration,
+			// which a phi of the header does.
+			bool isHeaderPhi = false;
+			for(auto insn = header.begin(); insn != header.end(); insn++)
+			{
+				if(insn.opcode() == spv::OpPhi && insn.resultId() == counterId)
+				{
+					isHeaderPhi = true;
+				}
+			}
+
+			if(!isHeaderPhi)
+			{
+				continue;
+			}
+
+			InductionVariable inductionVariable;
+			inductionVariable.limit = limitId;
+			inductionVariable.isSigned = isSigned;
+
+			// Structured loops are only left through the merge block, and
+			// only start new iterations through the header.
+			std::deque<Block::ID> pending = { bodyId };
+			while(!pending.empty())
+			{
+				auto id = pending.front();
+				pending.pop_front();
+
+				if(id == headerId || id == conditionId || id == header.mergeBlock ||
+				   !inductionVariable.body.emplace(id).second)
+				{
+					continue;
+				}
+
+				for(auto out : function.getBlock(id).outs)
+				{
+					pending.push_back(out);
+				}
+			}
+
+			// A signed comparison only bounds the counter from above. It is
+			// known to be non-negative if it starts that way, and only ever
+			// counts up by one while below the limit.
+			if(isSigned)
+			{
+				auto phi = counter.definition;
+				for(uint32_t w = 3; w + 1 < phi.wordCount() && isSigned; w += 2)
+				{
+					auto &value = getObject(phi.word(w));
+					Block::ID parent = phi.word(w + 1);
+
+					if(inductionVariable.body.count(parent) != 0)
+					{
+						bool increments = false;
+						if(value.kind == Object::Kind::Intermediate && value.definition.opcode() == spv::OpIAdd)
+						{
+							Object::ID lhs = value.definition.word(3);
+							Object::ID rhs = value.definition.word(4);
+							auto &step = getObject((lhs == counterId) ? rhs : lhs);
+							increments = (lhs == counterId || rhs == counterId) &&
+							             step.kind == Object::Kind::Constant && step.constantValue[0] == 1;
+						}
+
+						isSigned = increments;
+					}
+					else if(parent == headerId || parent == conditionId)
+					{
+						isSigned = false;
+					}
+					else
+					{
+						isSigned = value.kind == Object::Kind::Constant && static_cast<int32_t>(value.constantValue[0]) >= 0;
+					}
+				}
+
+				if(!isSigned)
+				{
+					continue;
+				}
+			}
+
+			inductionVariables.emplace(counterId, std::move(inductionVariable));
+		}
+	}
+}
+
+const Spirv::InductionVariable *Spirv::GetInductionVariable(Object::ID id, Block::ID block) const
+{
+	auto it = inductionVariables.find(id);
+	if(it == inductionVariables.end() || it->second.body.count(block) == 0)
+	{
+		return nullptr;
+	}
+
+	return &it->second;
+}
+
 void SpirvEmitter::addOutputActiveLaneMaskEdge(Block::ID to, RValue<SIMD::Int> mask)
 {
 	addActiveLaneMaskEdge(block, to, mask & activeLaneMask());
@@ -284,6 +819,60 @@ void SpirvEmitter::EmitBlocks(Block::ID id, Block::ID ignore /* = 0 */)
 	this->pending = oldPending;
 }
 
+void SpirvEmitter::BeginBlockProfile(bool countExecution)
+{
+	auto *profileData = shader.getProfileData();
+	if(!profileData)
+	{
+		return;
+	}
+
+	using Counters = SpirvProfileData::Counters;
+
+	profiledBlock = block;
+	Pointer<Byte> counters = routine->profileCounters + profileData->getBlockIndex(block.value()) * sizeof(Counters);
+
+	if(countExecution)
+	{
+		Int activeLanes = 0;
+		for(int i = 0; i < SIMD::Width; i++)
+		{
+			activeLanes -= Extract(activeLaneMask(), i);
+		}
+
+		Pointer<Long> executions = counters + OFFSET(Counters, executions);
+		Pointer<Long> invocations = counters + OFFSET(Counters, invocations);
+		AddAtomic(executions, Long(Int(1)));
+		AddAtomic(invocations, Long(activeLanes));
+	}
+
+	if(rr::Caps::ticksSupported())
+	{
+		profileStartTicks = Ticks().value();
+	}
+}
+
+void SpirvEmitter::EndBlockProfile()
+{
+	if(profiledBlock == 0)
+	{
+		return;
+	}
+
+	using Counters = SpirvProfileData::Counters;
+
+	if(profileStartTicks)
+	{
+		auto *profileData = shader.getProfileData();
+		Pointer<Byte> counters = routine->profileCounters + profileData->getBlockIndex(profiledBlock.value()) * sizeof(Counters);
+		Pointer<Long> cycles = counters + OFFSET(Counters, cycles);
+		AddAtomic(cycles, Ticks() - RValue<Long>(profileStartTicks));
+	}
+
+	profiledBlock = 0;
+	profileStartTicks = nullptr;
+}
+
 void SpirvEmitter::EmitNonLoop()
 {
 	auto &function = shader.getFunction(this->function);
@@ -309,7 +898,15 @@ void SpirvEmitter::EmitNonLoop()
 		SetActiveLaneMask(activeLaneMask);
 	}
 
-	EmitInstructions(block.begin(), block.end());
+	if(block.skippable && !shader.getProfileData())
+	{
+		EmitSkippableBlock(blockId, block);
+	}
+	else
+	{
+		BeginBlockProfile(true);
+		EmitInstructions(block.begin(), block.end());
+	}
 
 	for(auto out : block.outs)
 	{
@@ -322,6 +919,78 @@ void SpirvEmitter::EmitNonLoop()
 	SPIRV_SHADER_DBG("Block {0} done", blockId);
 }
 
+void SpirvEmitter::EmitSkippableBlock(Block::ID blockId, const Block &block)
+{
+	// Coherent branches leave many blocks with no active lanes, so branch
+	// around their instructions. Values which reach beyond the block, being
+	// its live-out results and outgoing edge masks, are carried across the
+	// branch through variables. When skipped, the edge masks stay zero and
+	// the results are zero. Dominated blocks may still run and use them as
+	// uniform, statically bounded offsets in unmasked loads, so they must
+	// be defined and equal in all lanes.
+	SIMD::Int mask = activeLaneMask();
+
+	std::vector<SIMD::Int> outMasks;
+	outMasks.reserve(block.outs.size());
+	for(size_t i = 0; i < block.outs.size(); i++)
+	{
+		outMasks.emplace_back(0);
+	}
+
+	std::vector<std::vector<SIMD::Float>> liveOuts;
+	liveOuts.reserve(block.liveOuts.size());
+	for(auto id : block.liveOuts)
+	{
+		liveOuts.emplace_back(shader.getObjectType(id).componentCount, SIMD::Float(0));
+	}
+
+	If(AnyTrue(mask))
+	{
+		EmitInstructions(block.begin(), block.end());
+
+		size_t i = 0;
+		for(auto out : block.outs)
+		{
+			auto it = edgeActiveLaneMasks.find(Block::Edge{ blockId, out });
+			if(it != edgeActiveLaneMasks.end())
+			{
+				outMasks[i] = it->second;
+			}
+			i++;
+		}
+
+		for(size_t i = 0; i < block.liveOuts.size(); i++)
+		{
+			const auto &value = getIntermediate(block.liveOuts[i]);
+			for(uint32_t c = 0; c < liveOuts[i].size(); c++)
+			{
+				liveOuts[i][c] = value.Float(c);
+			}
+		}
+	}
+
+	size_t i = 0;
+	for(auto out : block.outs)
+	{
+		auto edge = Block::Edge{ blockId, out };
+		edgeActiveLaneMasks.erase(edge);
+		edgeActiveLaneMasks.emplace(edge, outMasks[i++]);
+	}
+
+	for(size_t i = 0; i < block.liveOuts.size(); i++)
+	{
+		auto id = block.liveOuts[i];
+		intermediates.erase(id);
+		auto &dst = createIntermediate(id, static_cast<uint32_t>(liveOuts[i].size()));
+		for(uint32_t c = 0; c < liveOuts[i].size(); c++)
+		{
+			dst.move(c, RValue<SIMD::Float>(liveOuts[i][c]));
+		}
+	}
+
+	SetActiveLaneMask(mask);
+}
+
 void SpirvEmitter::EmitLoop()
 {
 	auto &function = shader.getFunction(this->function);
@@ -390,6 +1059,7 @@ void SpirvEmitter::EmitLoop()
 
 	// Load the active lane mask.
 	SetActiveLaneMask(loopActiveLaneMask);
+	BeginBlockProfile(true);
 
 	// Emit the non-phi loop header block's instructions.
 	for(auto insn = block.begin(); insn != block.end(); insn++)
@@ -634,7 +1304,25 @@ void SpirvEmitter::EmitControlBarrier(InsnIterator insn)
 	switch(executionScope)
 	{
 	case spv::ScopeWorkgroup:
-		Yield(YieldResult::ControlBarrier);
+		// Don't count the time spent waiting for the other subgroups.
+		EndBlockProfile();
+
+		if(routine->nextBarrierPhase)
+		{
+			EmitBarrierPhaseSplit(insn);
+		}
+		else
+		{
+			Yield(YieldResult::ControlBarrier);
+
+			// The coroutine may have been resumed on another thread.
+			if(auto *profileData = shader.getProfileData())
+			{
+				routine->profileCounters = Call(SpirvProfileData::GetThreadCounters, profileData);
+			}
+		}
+
+		BeginBlockProfile(false);
 		break;
 	case spv::ScopeSubgroup:
 		break;
@@ -645,6 +1333,92 @@ void SpirvEmitter::EmitControlBarrier(InsnIterator insn)
 	}
 }
 
+void SpirvEmitter::EmitBarrierPhaseSplit(InsnIterator insn)
+{
+	const auto &barrierPhases = shader.getBarrierPhases();
+
+	auto it = barrierPhases.liveIntermediates.find(insn.distanceFrom(shader.begin()));
+	if(!barrierPhases.splittable || it == barrierPhases.liveIntermediates.end())
+	{
+		// Spirv::AnalyzeBarrierPhases() only marks shaders splittable when all
+		// their barriers are phase boundaries.
+		UNREACHABLE("Workgroup barrier is not a phase boundary");
+		return;
+	}
+
+	const auto &liveIntermediates = it->second;
+
+	// Spill the state of the current subgroup.
+	Pointer<SIMD::Float> spill = routine->barrierPhaseSpill;
+	int slot = 0;
+
+	spill[slot++] = As<SIMD::Float>(activeLaneMask());
+	spill[slot++] = As<SIMD::Float>(storesAndAtomicsMask());
+
+	for(auto id : liveIntermediates)
+	{
+		// Live intermediates are found conservatively, and may include
+		// objects which were never emitted.
+		auto intermediate = intermediates.find(id);
+		if(intermediate == intermediates.end())
+		{
+			continue;
+		}
+
+		for(uint32_t i = 0; i < intermediate->second.componentCount; i++)
+		{
+			spill[slot++] = intermediate->second.Float(i);
+		}
+	}
+
+	for(auto id : barrierPhases.variables)
+	{
+		auto &variable = routine->getVariable(id);
+		for(int i = 0; i < variable.getArraySize(); i++)
+		{
+			spill[slot++] = variable[i];
+		}
+	}
+
+	ASSERT(slot <= int(barrierPhases.spillSlots));
+
+	// Continue with the next phase, for the subgroup it selects.
+	routine->nextBarrierPhase();
+
+	Pointer<SIMD::Float> reload = routine->barrierPhaseSpill;
+	slot = 0;
+
+	SetActiveLaneMask(As<SIMD::Int>(reload[slot++]));
+	SetStoresAndAtomicsMask(As<SIMD::Int>(reload[slot++]));
+
+	for(auto id : liveIntermediates)
+	{
+		auto intermediate = intermediates.find(id);
+		if(intermediate == intermediates.end())
+		{
+			continue;
+		}
+
+		auto componentCount = intermediate->second.componentCount;
+		intermediates.erase(intermediate);
+
+		auto &dst = createIntermediate(id, componentCount);
+		for(uint32_t i = 0; i < componentCount; i++)
+		{
+			dst.move(i, reload[slot++].load());
+		}
+	}
+
+	for(auto id : barrierPhases.variables)
+	{
+		auto &variable = routine->getVariable(id);
+		for(int i = 0; i < variable.getArraySize(); i++)
+		{
+			variable[i] = reload[slot++];
+		}
+	}
+}
+
 void SpirvEmitter::EmitPhi(InsnIterator insn)
 {
 	auto &function = shader.getFunction(this->function);
@@ -495,7 +495,7 @@ void SpirvEmitter::callSamplerFunction(Pointer<Byte> samplerFunction, Array<SIMD
 		in[i] = As<SIMD::Float>(sampleValue.Int(0));
 	}
 
-	Pointer<Byte> texture = imageDescriptor + OFFSET(vk::SampledImageDescriptor, texture);  // sw::Texture*
+	Pointer<Byte> texture = *Pointer<Pointer<Byte>>(imageDescriptor + OFFSET(vk::SampledImageDescriptor, texture));  // sw::Texture*
 
 	Call<ImageSampler>(samplerFunction, texture, &in, &out, routine->constants);
 }
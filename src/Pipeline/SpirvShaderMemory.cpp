@@ -156,7 +156,10 @@ void SpirvEmitter::EmitVariable(InsnIterator insn)
 			ASSERT(objectTy.opcode() == spv::OpTypePointer);
 			auto base = &routine->workgroupMemory[0];
 			auto size = shader.workgroupMemory.size();
-			createPointer(resultId, SIMD::Pointer(base, size, shader.workgroupMemory.offsetOf(resultId)));
+			// Keep the variable's offset static, so that bounds checks against the
+			// fixed workgroup memory size can be resolved at compile time.
+			auto offset = static_cast<int>(shader.workgroupMemory.offsetOf(resultId));
+			createPointer(resultId, SIMD::Pointer(base, size) + offset);
 		}
 		break;
 	case spv::StorageClassInput:
@@ -492,11 +495,57 @@ void SpirvEmitter::OffsetToElement(SIMD::Pointer &ptr, Object::ID elementId, int
 		}
 		else
 		{
-			ptr += getIntermediate(elementId).Int(0) * arrayStride;
+			OffsetByIndex(ptr, elementId, arrayStride);
 		}
 	}
 }
 
+void SpirvEmitter::OffsetByIndex(SIMD::Pointer &ptr, Object::ID indexId, uint32_t stride) const
+{
+	SIMD::Int offset = SIMD::Int(stride) * getIntermediate(indexId).Int(0);
+
+	uint32_t bound = 0;
+	bool bounded = shader.GetUnsignedBound(indexId, bound) && uint64_t(bound) * stride <= uint64_t(INT32_MAX);
+
+	auto inductionVariable = shader.GetInductionVariable(indexId, block);
+	if(!bounded && inductionVariable && stride != 0)
+	{
+		// In the loop's body the index of every active lane lies below the
+		// loop's limit, so the largest limit of any lane bounds the offsets.
+		SIMD::Int limit = Operand(shader, *this, inductionVariable->limit).Int(0);
+		UInt maxIndex = 0;
+		if(inductionVariable->isSigned)
+		{
+			Int maxLimit = Extract(limit, 0);
+			for(int i = 1; i < SIMD::Width; i++)
+			{
+				maxLimit = Max(maxLimit, Extract(limit, i));
+			}
+
+			// Non-positive limits leave no lanes in the body.
+			maxIndex = IfThenElse(maxLimit > 0, As<UInt>(maxLimit - 1), UInt(0));
+		}
+		else
+		{
+			UInt maxLimit = As<UInt>(Extract(limit, 0));
+			for(int i = 1; i < SIMD::Width; i++)
+			{
+				maxLimit = Max(maxLimit, As<UInt>(Extract(limit, i)));
+			}
+
+			// A zero limit leaves no lanes in the body, and wraps around to
+			// an index too large to bound the offsets.
+			maxIndex = maxLimit - 1;
+		}
+
+		Int maxOffset = IfThenElse(maxIndex <= UInt(INT32_MAX / stride), As<Int>(maxIndex) * Int(stride), Int(-1));
+		ptr.addOffsets(offset, shader.IsUniform(indexId), maxOffset);
+		return;
+	}
+
+	ptr.addOffsets(offset, shader.IsUniform(indexId), bounded, bounded ? bound * stride : 0);
+}
+
 void SpirvEmitter::Fence(spv::MemorySemanticsMask semantics) const
 {
 	if(semantics != spv::MemorySemanticsMaskNone)
@@ -51,6 +51,13 @@ SpirvEmitter::ImageSampler *SpirvEmitter::getImageSampler(const vk::Device *devi
 		ASSERT(instruction.coordinates >= samplerState.dimensionality());  // "It may be a vector larger than needed, but all unused components appear after all used components."
 		samplerState.textureFormat = imageViewState.format;
 
+		if(samplerState.textureFormat.isCompressed())
+		{
+			ASSERT(samplerState.textureFormat.isDecodedBySampler());
+			samplerState.compressedFormat = samplerState.textureFormat;
+			samplerState.textureFormat = samplerState.compressedFormat.getDecompressedFormat();
+		}
+
 		samplerState.addressingModeU = convertAddressingMode(0, vkSamplerState, type);
 		samplerState.addressingModeV = convertAddressingMode(1, vkSamplerState, type);
 		samplerState.addressingModeW = convertAddressingMode(2, vkSamplerState, type);
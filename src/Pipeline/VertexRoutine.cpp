@@ -23,6 +23,8 @@
 #include "System/Half.hpp"
 #include "Vulkan/VkDevice.hpp"
 
+#include <algorithm>
+
 namespace sw {
 
 VertexRoutine::VertexRoutine(
@@ -86,14 +88,110 @@ void VertexRoutine::generate()
 	Return();
 }
 
+// Returns whether the attribute's format is decoded by readInterleavedStreams(),
+// which handles 4-byte aligned attributes made of whole 32-bit words.
+static bool IsInterleavable(const VertexProcessor::State::Input &stream)
+{
+	if((stream.offset % 4) != 0)
+	{
+		return false;
+	}
+
+	switch(stream.format)
+	{
+	case VK_FORMAT_R32_SFLOAT:
+	case VK_FORMAT_R32G32_SFLOAT:
+	case VK_FORMAT_R32G32B32_SFLOAT:
+	case VK_FORMAT_R32G32B32A32_SFLOAT:
+	case VK_FORMAT_R32_SINT:
+	case VK_FORMAT_R32G32_SINT:
+	case VK_FORMAT_R32G32B32_SINT:
+	case VK_FORMAT_R32G32B32A32_SINT:
+	case VK_FORMAT_R32_UINT:
+	case VK_FORMAT_R32G32_UINT:
+	case VK_FORMAT_R32G32B32_UINT:
+	case VK_FORMAT_R32G32B32A32_UINT:
+	case VK_FORMAT_B8G8R8A8_UNORM:
+	case VK_FORMAT_R8G8B8A8_UNORM:
+	case VK_FORMAT_A8B8G8R8_UNORM_PACK32:
+	case VK_FORMAT_R8G8B8A8_SNORM:
+	case VK_FORMAT_A8B8G8R8_SNORM_PACK32:
+	case VK_FORMAT_R8G8B8A8_UINT:
+	case VK_FORMAT_A8B8G8R8_UINT_PACK32:
+	case VK_FORMAT_R8G8B8A8_SINT:
+	case VK_FORMAT_A8B8G8R8_SINT_PACK32:
+	case VK_FORMAT_R8G8B8A8_USCALED:
+	case VK_FORMAT_A8B8G8R8_USCALED_PACK32:
+	case VK_FORMAT_R8G8B8A8_SSCALED:
+	case VK_FORMAT_A8B8G8R8_SSCALED_PACK32:
+	case VK_FORMAT_R16G16_UNORM:
+	case VK_FORMAT_R16G16B16A16_UNORM:
+	case VK_FORMAT_R16G16_SNORM:
+	case VK_FORMAT_R16G16B16A16_SNORM:
+	case VK_FORMAT_R16G16_USCALED:
+	case VK_FORMAT_R16G16B16A16_USCALED:
+	case VK_FORMAT_R16G16_SSCALED:
+	case VK_FORMAT_R16G16B16A16_SSCALED:
+	case VK_FORMAT_R16G16_UINT:
+	case VK_FORMAT_R16G16B16A16_UINT:
+	case VK_FORMAT_R16G16_SINT:
+	case VK_FORMAT_R16G16B16A16_SINT:
+	case VK_FORMAT_R16G16_SFLOAT:
+	case VK_FORMAT_R16G16B16A16_SFLOAT:
+		return true;
+	default:
+		return false;
+	}
+}
+
 void VertexRoutine::readInput(Pointer<UInt> &batch)
 {
+	uint32_t usedLocations = 0;
 	for(int i = 0; i < MAX_INTERFACE_COMPONENTS; i += 4)
 	{
 		if(spirvShader->inputs[i + 0].Type != Spirv::ATTRIBTYPE_UNUSED ||
 		   spirvShader->inputs[i + 1].Type != Spirv::ATTRIBTYPE_UNUSED ||
 		   spirvShader->inputs[i + 2].Type != Spirv::ATTRIBTYPE_UNUSED ||
 		   spirvShader->inputs[i + 3].Type != Spirv::ATTRIBTYPE_UNUSED)
+		{
+			usedLocations |= 1u << (i / 4);
+		}
+	}
+
+	// Attributes interleaved in the same binding are fetched together, which
+	// takes a single set of wide loads and transposes per vertex. Robust buffer
+	// access bounds each attribute separately, so it keeps the per-attribute path.
+	if(!state.robustBufferAccess)
+	{
+		for(uint32_t binding = 0; binding < vk::MAX_VERTEX_INPUT_BINDINGS; binding++)
+		{
+			uint32_t locations = 0;
+			uint32_t spanBegin = ~0u;
+			uint32_t spanEnd = 0;
+			for(int location = 0; location < MAX_INTERFACE_COMPONENTS / 4; location++)
+			{
+				const Stream &stream = state.input[location];
+				if((usedLocations & (1u << location)) && (stream.binding == binding) && IsInterleavable(stream))
+				{
+					locations |= 1u << location;
+					spanBegin = std::min(spanBegin, static_cast<uint32_t>(stream.offset));
+					spanEnd = std::max(spanEnd, stream.offset + static_cast<uint32_t>(vk::Format(stream.format).bytes()));
+				}
+			}
+
+			// Requires at least two attributes. Spans of more than 16 words
+			// would mostly load unused data.
+			if(((locations & (locations - 1)) != 0) && (spanEnd - spanBegin) <= 64)
+			{
+				readInterleavedStreams(batch, locations);
+				usedLocations &= ~locations;
+			}
+		}
+	}
+
+	for(int i = 0; i < MAX_INTERFACE_COMPONENTS; i += 4)
+	{
+		if(usedLocations & (1u << (i / 4)))
 		{
 			Pointer<Byte> input = *Pointer<Pointer<Byte>>(data + OFFSET(DrawData, input) + sizeof(void *) * (i / 4));
 			UInt stride = *Pointer<UInt>(data + OFFSET(DrawData, stride) + sizeof(uint32_t) * (i / 4));
@@ -113,6 +211,236 @@ void VertexRoutine::readInput(Pointer<UInt> &batch)
 	}
 }
 
+void VertexRoutine::readInterleavedStreams(Pointer<UInt> &batch, uint32_t locations)
+{
+	// All attributes of a binding share its buffer and stride, so they are
+	// addressed relative to the one with the lowest offset.
+	int first = -1;
+	uint32_t spanEnd = 0;
+	for(int location = 0; location < MAX_INTERFACE_COMPONENTS / 4; location++)
+	{
+		if(locations & (1u << location))
+		{
+			const Stream &stream = state.input[location];
+			if(first < 0 || stream.offset < state.input[first].offset)
+			{
+				first = location;
+			}
+			spanEnd = std::max(spanEnd, stream.offset + static_cast<uint32_t>(vk::Format(stream.format).bytes()));
+		}
+	}
+
+	const uint32_t spanBegin = state.input[first].offset;
+	const int words = (spanEnd - spanBegin) / 4;
+	ASSERT(words <= 16);
+
+	// Only load the words which hold attribute data.
+	uint32_t usedWords = 0;
+	for(int location = 0; location < MAX_INTERFACE_COMPONENTS / 4; location++)
+	{
+		if(locations & (1u << location))
+		{
+			const Stream &stream = state.input[location];
+			int word = (stream.offset - spanBegin) / 4;
+			int count = vk::Format(stream.format).bytes() / 4;
+			usedWords |= ((1u << count) - 1) << word;
+		}
+	}
+
+	Pointer<Byte> buffer = *Pointer<Pointer<Byte>>(data + OFFSET(DrawData, input) + sizeof(void *) * first);
+	UInt stride = *Pointer<UInt>(data + OFFSET(DrawData, stride) + sizeof(uint32_t) * first);
+	Int baseVertex = *Pointer<Int>(data + OFFSET(DrawData, baseVertex));
+
+	UInt4 offsets = (*Pointer<UInt4>(As<Pointer<UInt4>>(batch)) + As<UInt4>(Int4(baseVertex))) * UInt4(stride);
+
+	Pointer<Byte> source0 = buffer + offsets.x;
+	Pointer<Byte> source1 = buffer + offsets.y;
+	Pointer<Byte> source2 = buffer + offsets.z;
+	Pointer<Byte> source3 = buffer + offsets.w;
+
+	// Load the span four words at a time for each vertex, and transpose them
+	// so that column[i] holds word i of all four vertices.
+	Float4 column[16];
+	for(int word = 0; word < words; word += 4)
+	{
+		if(((usedWords >> word) & 0xF) == 0)
+		{
+			continue;
+		}
+
+		int count = std::min(words - word, 4);
+		Float4 v0, v1, v2, v3;
+
+		if(count == 4)
+		{
+			v0 = *Pointer<Float4>(source0 + 4 * word);
+			v1 = *Pointer<Float4>(source1 + 4 * word);
+			v2 = *Pointer<Float4>(source2 + 4 * word);
+			v3 = *Pointer<Float4>(source3 + 4 * word);
+		}
+		else
+		{
+			// Don't read past the end of the last attribute.
+			for(int i = 0; i < count; i++)
+			{
+				v0 = Insert(v0, *Pointer<Float>(source0 + 4 * (word + i)), i);
+				v1 = Insert(v1, *Pointer<Float>(source1 + 4 * (word + i)), i);
+				v2 = Insert(v2, *Pointer<Float>(source2 + 4 * (word + i)), i);
+				v3 = Insert(v3, *Pointer<Float>(source3 + 4 * (word + i)), i);
+			}
+		}
+
+		transpose4xN(v0, v1, v2, v3, count);
+
+		column[word + 0] = v0;
+		if(count > 1) column[word + 1] = v1;
+		if(count > 2) column[word + 2] = v2;
+		if(count > 3) column[word + 3] = v3;
+	}
+
+	for(int location = 0; location < MAX_INTERFACE_COMPONENTS / 4; location++)
+	{
+		if(!(locations & (1u << location)))
+		{
+			continue;
+		}
+
+		const Stream &stream = state.input[location];
+		int word = (stream.offset - spanBegin) / 4;
+		int componentCount = vk::Format(stream.format).componentCount();
+		Int4 packed = As<Int4>(column[word]);
+		bool bgra = false;
+
+		// Component i of a 16-bit format, zero or sign extended.
+		auto component16 = [&](int i, bool isSigned) {
+			Int4 packed16 = As<Int4>(column[word + i / 2]);
+			Int4 shifted = (i % 2 == 0) ? Int4(packed16 << 16) : packed16;
+			return isSigned ? (shifted >> 16) : As<Int4>(As<UInt4>(shifted) >> 16);
+		};
+
+		Vector4f v;
+		switch(stream.format)
+		{
+		case VK_FORMAT_R32_SFLOAT:
+		case VK_FORMAT_R32G32_SFLOAT:
+		case VK_FORMAT_R32G32B32_SFLOAT:
+		case VK_FORMAT_R32G32B32A32_SFLOAT:
+		case VK_FORMAT_R32_SINT:
+		case VK_FORMAT_R32G32_SINT:
+		case VK_FORMAT_R32G32B32_SINT:
+		case VK_FORMAT_R32G32B32A32_SINT:
+		case VK_FORMAT_R32_UINT:
+		case VK_FORMAT_R32G32_UINT:
+		case VK_FORMAT_R32G32B32_UINT:
+		case VK_FORMAT_R32G32B32A32_UINT:
+			if(componentCount >= 1) v.x = column[word + 0];
+			if(componentCount >= 2) v.y = column[word + 1];
+			if(componentCount >= 3) v.z = column[word + 2];
+			if(componentCount >= 4) v.w = column[word + 3];
+			break;
+		case VK_FORMAT_B8G8R8A8_UNORM:
+			bgra = true;
+			// [[fallthrough]]
+		case VK_FORMAT_R8G8B8A8_UNORM:
+		case VK_FORMAT_A8B8G8R8_UNORM_PACK32:
+			v.x = Float4(packed & Int4(0xFF)) * (1.0f / 0xFF);
+			v.y = Float4((packed >> 8) & Int4(0xFF)) * (1.0f / 0xFF);
+			v.z = Float4((packed >> 16) & Int4(0xFF)) * (1.0f / 0xFF);
+			v.w = Float4((packed >> 24) & Int4(0xFF)) * (1.0f / 0xFF);
+			break;
+		case VK_FORMAT_R8G8B8A8_SNORM:
+		case VK_FORMAT_A8B8G8R8_SNORM_PACK32:
+			v.x = Max(Float4((packed << 24) >> 24) * (1.0f / 0x7F), Float4(-1.0f));
+			v.y = Max(Float4((packed << 16) >> 24) * (1.0f / 0x7F), Float4(-1.0f));
+			v.z = Max(Float4((packed << 8) >> 24) * (1.0f / 0x7F), Float4(-1.0f));
+			v.w = Max(Float4(packed >> 24) * (1.0f / 0x7F), Float4(-1.0f));
+			break;
+		case VK_FORMAT_R8G8B8A8_UINT:
+		case VK_FORMAT_A8B8G8R8_UINT_PACK32:
+			v.x = As<Float4>(packed & Int4(0xFF));
+			v.y = As<Float4>((packed >> 8) & Int4(0xFF));
+			v.z = As<Float4>((packed >> 16) & Int4(0xFF));
+			v.w = As<Float4>((packed >> 24) & Int4(0xFF));
+			break;
+		case VK_FORMAT_R8G8B8A8_SINT:
+		case VK_FORMAT_A8B8G8R8_SINT_PACK32:
+			v.x = As<Float4>((packed << 24) >> 24);
+			v.y = As<Float4>((packed << 16) >> 24);
+			v.z = As<Float4>((packed << 8) >> 24);
+			v.w = As<Float4>(packed >> 24);
+			break;
+		case VK_FORMAT_R8G8B8A8_USCALED:
+		case VK_FORMAT_A8B8G8R8_USCALED_PACK32:
+			v.x = Float4(packed & Int4(0xFF));
+			v.y = Float4((packed >> 8) & Int4(0xFF));
+			v.z = Float4((packed >> 16) & Int4(0xFF));
+			v.w = Float4((packed >> 24) & Int4(0xFF));
+			break;
+		case VK_FORMAT_R8G8B8A8_SSCALED:
+		case VK_FORMAT_A8B8G8R8_SSCALED_PACK32:
+			v.x = Float4((packed << 24) >> 24);
+			v.y = Float4((packed << 16) >> 24);
+			v.z = Float4((packed << 8) >> 24);
+			v.w = Float4(packed >> 24);
+			break;
+		case VK_FORMAT_R16G16_UNORM:
+		case VK_FORMAT_R16G16B16A16_UNORM:
+			if(componentCount >= 1) v.x = Float4(component16(0, false)) * (1.0f / 0xFFFF);
+			if(componentCount >= 2) v.y = Float4(component16(1, false)) * (1.0f / 0xFFFF);
+			if(componentCount >= 3) v.z = Float4(component16(2, false)) * (1.0f / 0xFFFF);
+			if(componentCount >= 4) v.w = Float4(component16(3, false)) * (1.0f / 0xFFFF);
+			break;
+		case VK_FORMAT_R16G16_SNORM:
+		case VK_FORMAT_R16G16B16A16_SNORM:
+			if(componentCount >= 1) v.x = Max(Float4(component16(0, true)) * (1.0f / 0x7FFF), Float4(-1.0f));
+			if(componentCount >= 2) v.y = Max(Float4(component16(1, true)) * (1.0f / 0x7FFF), Float4(-1.0f));
+			if(componentCount >= 3) v.z = Max(Float4(component16(2, true)) * (1.0f / 0x7FFF), Float4(-1.0f));
+			if(componentCount >= 4) v.w = Max(Float4(component16(3, true)) * (1.0f / 0x7FFF), Float4(-1.0f));
+			break;
+		case VK_FORMAT_R16G16_USCALED:
+		case VK_FORMAT_R16G16B16A16_USCALED:
+		case VK_FORMAT_R16G16_SSCALED:
+		case VK_FORMAT_R16G16B16A16_SSCALED:
+			{
+				bool isSigned = (stream.format == VK_FORMAT_R16G16_SSCALED) || (stream.format == VK_FORMAT_R16G16B16A16_SSCALED);
+				if(componentCount >= 1) v.x = Float4(component16(0, isSigned));
+				if(componentCount >= 2) v.y = Float4(component16(1, isSigned));
+				if(componentCount >= 3) v.z = Float4(component16(2, isSigned));
+				if(componentCount >= 4) v.w = Float4(component16(3, isSigned));
+			}
+			break;
+		case VK_FORMAT_R16G16_UINT:
+		case VK_FORMAT_R16G16B16A16_UINT:
+		case VK_FORMAT_R16G16_SINT:
+		case VK_FORMAT_R16G16B16A16_SINT:
+			{
+				bool isSigned = (stream.format == VK_FORMAT_R16G16_SINT) || (stream.format == VK_FORMAT_R16G16B16A16_SINT);
+				if(componentCount >= 1) v.x = As<Float4>(component16(0, isSigned));
+				if(componentCount >= 2) v.y = As<Float4>(component16(1, isSigned));
+				if(componentCount >= 3) v.z = As<Float4>(component16(2, isSigned));
+				if(componentCount >= 4) v.w = As<Float4>(component16(3, isSigned));
+			}
+			break;
+		case VK_FORMAT_R16G16_SFLOAT:
+		case VK_FORMAT_R16G16B16A16_SFLOAT:
+			if(componentCount >= 1) v.x = As<Float4>(halfToFloatBits(As<UInt4>(component16(0, false))));
+			if(componentCount >= 2) v.y = As<Float4>(halfToFloatBits(As<UInt4>(component16(1, false))));
+			if(componentCount >= 3) v.z = As<Float4>(halfToFloatBits(As<UInt4>(component16(2, false))));
+			if(componentCount >= 4) v.w = As<Float4>(halfToFloatBits(As<UInt4>(component16(3, false))));
+			break;
+		default:
+			UNREACHABLE("stream.format %d", int(stream.format));
+		}
+
+		applyDefaults(v, stream, bgra);
+
+		routine.inputs[location * 4 + 0] = v.x;
+		routine.inputs[location * 4 + 1] = v.y;
+		routine.inputs[location * 4 + 2] = v.z;
+		routine.inputs[location * 4 + 3] = v.w;
+	}
+}
+
 void VertexRoutine::computeClipFlags()
 {
 	auto it = spirvShader->outputBuiltins.find(spv::BuiltInPosition);
@@ -207,8 +535,6 @@ Vector4f VertexRoutine::readStream(Pointer<Byte> &buffer, UInt &stride, const St
 	}
 
 	int componentCount = format.componentCount();
-	bool normalized = !format.isUnnormalizedInteger();
-	bool isNativeFloatAttrib = (stream.attribType == Spirv::ATTRIBTYPE_FLOAT) || normalized;
 	bool bgra = false;
 
 	switch(stream.format)
@@ -551,6 +877,18 @@ Vector4f VertexRoutine::readStream(Pointer<Byte> &buffer, UInt &stride, const St
 		UNSUPPORTED("stream.format %d", int(stream.format));
 	}
 
+	applyDefaults(v, stream, bgra);
+
+	return v;
+}
+
+void VertexRoutine::applyDefaults(Vector4f &v, const Stream &stream, bool bgra)
+{
+	vk::Format format(stream.format);
+	int componentCount = format.componentCount();
+	bool normalized = !format.isUnnormalizedInteger();
+	bool isNativeFloatAttrib = (stream.attribType == Spirv::ATTRIBTYPE_FLOAT) || normalized;
+
 	if(bgra)
 	{
 		// Swap red and blue
@@ -563,8 +901,6 @@ Vector4f VertexRoutine::readStream(Pointer<Byte> &buffer, UInt &stride, const St
 	if(componentCount < 2) v.y = Float4(0.0f);
 	if(componentCount < 3) v.z = Float4(0.0f);
 	if(componentCount < 4) v.w = isNativeFloatAttrib ? As<Float4>(Float4(1.0f)) : As<Float4>(Int4(1));
-
-	return v;
 }
 
 void VertexRoutine::writeCache(Pointer<Byte> &vertexCache, Pointer<UInt> &tagCache, Pointer<UInt> &batch)
@@ -74,6 +74,8 @@ private:
 
 	Vector4f readStream(Pointer<Byte> &buffer, UInt &stride, const Stream &stream, Pointer<UInt> &batch,
 	                    bool robustBufferAccess, UInt &robustnessSize, Int baseVertex);
+	void readInterleavedStreams(Pointer<UInt> &batch, uint32_t locations);
+	void applyDefaults(Vector4f &v, const Stream &stream, bool bgra);
 	void readInput(Pointer<UInt> &batch);
 	void computeClipFlags();
 	void computeCullMask();
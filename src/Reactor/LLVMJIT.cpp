@@ -65,7 +65,12 @@ __pragma(warning(push))
 #	include "llvm/Transforms/Scalar/ADCE.h"
 #	include "llvm/Transforms/Scalar/DeadStoreElimination.h"
 #	include "llvm/Transforms/Scalar/EarlyCSE.h"
+#	include "llvm/Transforms/Scalar/IndVarSimplify.h"
 #	include "llvm/Transforms/Scalar/LICM.h"
+#	include "llvm/Transforms/Scalar/LoopPassManager.h"
+#	include "llvm/Transforms/Scalar/LoopRotation.h"
+#	include "llvm/Transforms/Scalar/LoopStrengthReduce.h"
+#	include "llvm/Transforms/Scalar/LoopUnrollPass.h"
 #	include "llvm/Transforms/Scalar/Reassociate.h"
 #	include "llvm/Transforms/Scalar/SCCP.h"
 #	include "llvm/Transforms/Scalar/SROA.h"
@@ -963,6 +968,7 @@ void JITBuilder::runPasses()
 #endif
 
 	int optimizationLevel = getPragmaState(OptimizationLevel);
+	int optimizationProfile = getPragmaState(OptimizationProfile);
 
 #ifdef ENABLE_RR_DEBUG_INFO
 	if(debugInfo != nullptr)
@@ -997,6 +1003,32 @@ void JITBuilder::runPasses()
 	{
 		fpm.addPass(llvm::SROAPass(llvm::SROAOptions::PreserveCFG));
 		fpm.addPass(llvm::InstCombinePass());
+
+		if(optimizationProfile == LoopProfile)
+		{
+			// Canonicalize loops, hoist invariant code out of them, and simplify
+			// their induction variables before unrolling them.
+			fpm.addPass(llvm::EarlyCSEPass(true /* UseMemorySSA */));
+			fpm.addPass(llvm::SimplifyCFGPass());
+
+			llvm::LoopPassManager lpm;
+			lpm.addPass(llvm::LoopRotatePass());
+			lpm.addPass(llvm::LICMPass(llvm::LICMOptions()));
+			fpm.addPass(llvm::createFunctionToLoopPassAdaptor(std::move(lpm), true /* UseMemorySSA */));
+
+			llvm::LoopPassManager indVarLpm;
+			indVarLpm.addPass(llvm::IndVarSimplifyPass());
+			fpm.addPass(llvm::createFunctionToLoopPassAdaptor(std::move(indVarLpm)));
+
+			fpm.addPass(llvm::LoopUnrollPass(llvm::LoopUnrollOptions(optimizationLevel)));
+			fpm.addPass(llvm::GVNPass());
+			fpm.addPass(llvm::InstCombinePass());
+
+			llvm::LoopPassManager lsrLpm;
+			lsrLpm.addPass(llvm::LoopStrengthReducePass());
+			fpm.addPass(llvm::createFunctionToLoopPassAdaptor(std::move(lsrLpm)));
+			fpm.addPass(llvm::SimplifyCFGPass());
+		}
 	}
 
 	if(!fpm.isEmpty())
@@ -1033,6 +1065,22 @@ void JITBuilder::runPasses()
 	{
 		passManager.add(llvm::createSROAPass());
 		passManager.add(llvm::createInstructionCombiningPass());
+
+		if(optimizationProfile == LoopProfile)
+		{
+			// Canonicalize loops, hoist invariant code out of them, and simplify
+			// their induction variables before unrolling them.
+			passManager.add(llvm::createEarlyCSEPass(true /* UseMemorySSA */));
+			passManager.add(llvm::createCFGSimplificationPass());
+			passManager.add(llvm::createLoopRotatePass());
+			passManager.add(llvm::createLICMPass());
+			passManager.add(llvm::createIndVarSimplifyPass());
+			passManager.add(llvm::createLoopUnrollPass(optimizationLevel));
+			passManager.add(llvm::createGVNPass());
+			passManager.add(llvm::createInstructionCombiningPass());
+			passManager.add(llvm::createLoopStrengthReducePass());
+			passManager.add(llvm::createCFGSimplificationPass());
+		}
 	}
 
 	if(__has_feature(memory_sanitizer) && msanInstrumentation)
@@ -392,6 +392,11 @@ bool Caps::fmaIsFast()
 	return AVX2;
 }
 
+bool Caps::ticksSupported()
+{
+	return true;
+}
+
 // The abstract Type* types are implemented as LLVM types, except that
 // 64-bit vectors are emulated using 128-bit ones to avoid use of MMX in x86
 // and VFP in ARM, and eliminate the overhead of converting them to explicit
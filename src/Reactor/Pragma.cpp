@@ -33,6 +33,7 @@ struct PragmaState
 	bool memorySanitizerInstrumentation = true;
 	bool initializeLocalVariables = false;
 	int optimizationLevel = 2;  // Default
+	int optimizationProfile = rr::FastCompileProfile;
 };
 
 // The initialization of static thread-local data is not observed by MemorySanitizer
@@ -87,6 +88,9 @@ void Pragma(IntegerPragmaOption option, int value)
 	case OptimizationLevel:
 		state.optimizationLevel = value;
 		break;
+	case OptimizationProfile:
+		state.optimizationProfile = value;
+		break;
 	default:
 		UNSUPPORTED("Unknown integer pragma option %d", int(option));
 	}
@@ -116,6 +120,8 @@ int getPragmaState(IntegerPragmaOption option)
 	{
 	case OptimizationLevel:
 		return state.optimizationLevel;
+	case OptimizationProfile:
+		return state.optimizationProfile;
 	default:
 		UNSUPPORTED("Unknown integer pragma option %d", int(option));
 		return 0;
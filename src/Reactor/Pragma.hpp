@@ -27,7 +27,15 @@ enum BooleanPragmaOption
 
 enum IntegerPragmaOption
 {
-	OptimizationLevel,  // O0, O1, O2 (default), O3
+	OptimizationLevel,    // O0, O1, O2 (default), O3
+	OptimizationProfile,  // An OptimizationProfileType
+};
+
+// Sets of optimization passes run when OptimizationLevel is above O0.
+enum OptimizationProfileType
+{
+	FastCompileProfile,  // Scalar replacement and instruction combining only (default)
+	LoopProfile,         // Also optimizes loops, for routines that spend most of their time in them
 };
 
 void Pragma(BooleanPragmaOption option, bool enable);
@@ -18,6 +18,7 @@
 #include "Debug.hpp"
 #include "Print.hpp"
 
+#include <algorithm>
 #include <cmath>
 
 namespace rr {
@@ -925,6 +926,8 @@ SIMD::Pointer::Pointer(scalar::Pointer<Byte> base, rr::Int limit, SIMD::Int offs
     , staticOffsets(SIMD::Width)
     , hasDynamicLimit(true)
     , hasDynamicOffsets(true)
+    , hasDynamicOffsetsBound(false)
+    , hasUniformOffsets(false)
     , isBasePlusOffset(true)
 {}
 
@@ -936,6 +939,8 @@ SIMD::Pointer::Pointer(scalar::Pointer<Byte> base, unsigned int limit, SIMD::Int
     , staticOffsets(SIMD::Width)
     , hasDynamicLimit(false)
     , hasDynamicOffsets(true)
+    , hasDynamicOffsetsBound(false)
+    , hasUniformOffsets(false)
     , isBasePlusOffset(true)
 {}
 
@@ -975,6 +980,9 @@ SIMD::Pointer &SIMD::Pointer::operator+=(SIMD::Int i)
 	{
 		dynamicOffsets += i;
 		hasDynamicOffsets = true;
+		hasDynamicOffsetsBound = false;
+		hasActiveOffsetsBound = false;
+		hasUniformOffsets = false;
 	}
 	else
 	{
@@ -983,6 +991,73 @@ SIMD::Pointer &SIMD::Pointer::operator+=(SIMD::Int i)
 	return *this;
 }
 
+// Adds two inclusive offset bounds, either of which may be negative to denote
+// that no bound holds. Offsets beyond the positive 32-bit integer range may
+// wrap around, so larger sums aren't bounds either.
+static RValue<Int> AddOffsetsBounds(RValue<Int> a, RValue<Int> b)
+{
+	return IfThenElse(a < 0 || b < 0 || a > Int(INT32_MAX) - b, Int(-1), a + b);
+}
+
+SIMD::Pointer &SIMD::Pointer::addOffsets(SIMD::Int i, bool uniform, bool bounded, uint32_t maxOffset)
+{
+	bool wasUniform = hasUniformOffsets;
+	bool wasBounded = hasDynamicOffsetsBound;
+	bool wasActiveBounded = hasActiveOffsetsBound;
+
+	*this += i;
+
+	if(isBasePlusOffset)
+	{
+		hasUniformOffsets = wasUniform && uniform;
+
+		// Offsets beyond the positive 32-bit integer range may wrap around.
+		uint64_t bound = uint64_t(dynamicOffsetsBound) + maxOffset;
+		if(wasBounded && bounded && bound <= uint64_t(INT32_MAX))
+		{
+			dynamicOffsetsBound = static_cast<uint32_t>(bound);
+			hasDynamicOffsetsBound = true;
+		}
+
+		if(wasActiveBounded && bounded)
+		{
+			activeOffsetsBound = AddOffsetsBounds(activeOffsetsBound, scalar::Int(maxOffset));
+			hasActiveOffsetsBound = true;
+		}
+	}
+
+	return *this;
+}
+
+SIMD::Pointer &SIMD::Pointer::addOffsets(SIMD::Int i, bool uniform, scalar::Int maxOffset)
+{
+	bool wasUniform = hasUniformOffsets;
+	bool wasBounded = hasDynamicOffsetsBound;
+	bool wasActiveBounded = hasActiveOffsetsBound;
+	uint32_t staticBound = dynamicOffsetsBound;
+
+	*this += i;
+
+	if(isBasePlusOffset)
+	{
+		hasUniformOffsets = wasUniform && uniform;
+
+		// A bound of all lanes also holds for the active ones.
+		if(wasActiveBounded)
+		{
+			activeOffsetsBound = AddOffsetsBounds(activeOffsetsBound, maxOffset);
+			hasActiveOffsetsBound = true;
+		}
+		else if(wasBounded)
+		{
+			activeOffsetsBound = AddOffsetsBounds(scalar::Int(staticBound), maxOffset);
+			hasActiveOffsetsBound = true;
+		}
+	}
+
+	return *this;
+}
+
 SIMD::Pointer SIMD::Pointer::operator+(SIMD::Int i)
 {
 	SIMD::Pointer p = *this;
@@ -1036,12 +1111,47 @@ SIMD::Int SIMD::Pointer::isInBounds(unsigned int accessSize, OutOfBoundsBehavior
 		    (staticOffsets[3] + accessSize - 1 < staticLimit) ? 0xFFFFFFFF : 0);
 	}
 
-	return CmpGE(offsets(), 0) & CmpLT(offsets() + SIMD::Int(accessSize - 1), limit());
+	auto laneInBounds = [&] {
+		return CmpGE(offsets(), 0) & CmpLT(offsets() + SIMD::Int(accessSize - 1), limit());
+	};
+
+	// With a bound on the dynamic offsets, a single scalar comparison against
+	// the limit can show all lanes to be in bounds. Neither the bound nor the
+	// limit depend on the lanes' offsets, so within a loop they are typically
+	// invariant, and the check can be hoisted out of it or the loop unswitched
+	// on it, leaving only partially out-of-bounds loops with per-lane checks.
+	if(hasActiveOffsetsBound || (hasDynamicLimit && hasDynamicOffsetsBound))
+	{
+		int64_t minOffset = staticOffsets[0];
+		int64_t maxOffset = staticOffsets[0];
+		for(int i = 1; i < SIMD::Width; i++)
+		{
+			minOffset = std::min(minOffset, int64_t(staticOffsets[i]));
+			maxOffset = std::max(maxOffset, int64_t(staticOffsets[i]));
+		}
+
+		int64_t extent = maxOffset + accessSize - 1;
+		if(minOffset >= 0 && extent <= INT32_MAX)
+		{
+			scalar::Int bound = hasActiveOffsetsBound ? scalar::Int(activeOffsetsBound) : scalar::Int(static_cast<int32_t>(dynamicOffsetsBound));
+			scalar::Int scalarLimit = dynamicLimit + scalar::Int(static_cast<int32_t>(staticLimit));
+
+			SIMD::Int inBounds = SIMD::Int(0xFFFFFFFF);
+			If(bound < 0 || bound >= scalarLimit - scalar::Int(static_cast<int32_t>(extent)))
+			{
+				inBounds = laneInBounds();
+			}
+
+			return inBounds;
+		}
+	}
+
+	return laneInBounds();
 }
 
 bool SIMD::Pointer::isStaticallyInBounds(unsigned int accessSize, OutOfBoundsBehavior robustness) const
 {
-	if(hasDynamicOffsets)
+	if(hasDynamicOffsets && (!hasDynamicOffsetsBound || hasDynamicLimit))
 	{
 		return false;
 	}
@@ -1066,7 +1176,8 @@ bool SIMD::Pointer::isStaticallyInBounds(unsigned int accessSize, OutOfBoundsBeh
 
 	for(int i = 0; i < SIMD::Width; i++)
 	{
-		if(staticOffsets[i] + accessSize - 1 >= staticLimit)
+		// Negative static offsets are out of bounds, and wrap around to large unsigned values.
+		if(uint64_t(uint32_t(staticOffsets[i])) + dynamicOffsetsBound + accessSize - 1 >= staticLimit)
 		{
 			return false;
 		}
@@ -1122,6 +1233,25 @@ bool SIMD::Pointer::hasStaticEqualOffsets() const
 	return true;
 }
 
+bool SIMD::Pointer::hasEqualOffsets() const
+{
+	ASSERT_MSG(isBasePlusOffset, "No offsets for this type of pointer");
+	if(hasDynamicOffsets && !hasUniformOffsets)
+	{
+		return false;
+	}
+
+	for(int i = 1; i < SIMD::Width; i++)
+	{
+		if(staticOffsets[0] != staticOffsets[i])
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
 scalar::Pointer<Byte> SIMD::Pointer::getUniformPointer() const
 {
 #ifndef NDEBUG
@@ -161,6 +161,18 @@ public:
 	Pointer &operator+=(int i);
 	Pointer operator+(int i);
 
+	// Adds offsets with known properties. Uniform offsets are equal in all
+	// lanes, which lets loads and stores access memory once. Bounded offsets
+	// lie within [0, maxOffset] in all lanes, which lets bounds checks against
+	// a static limit be resolved at compile time.
+	Pointer &addOffsets(SIMD::Int i, bool uniform, bool bounded, uint32_t maxOffset);
+
+	// Adds offsets which lie within [0, maxOffset] in all active lanes, with
+	// the bound only known at run time. A negative maxOffset denotes that no
+	// bound holds. Lanes which aren't active may then be reported in bounds,
+	// so isInBounds() must be combined with the active lane mask.
+	Pointer &addOffsets(SIMD::Int i, bool uniform, scalar::Int maxOffset);
+
 	SIMD::Int offsets() const;
 
 	SIMD::Int isInBounds(unsigned int accessSize, OutOfBoundsBehavior robustness) const;
@@ -177,6 +189,10 @@ public:
 	// (N, N, N, N)
 	bool hasStaticEqualOffsets() const;
 
+	// Returns true if all offsets are equal, either statically or because
+	// the dynamic offsets are uniform.
+	bool hasEqualOffsets() const;
+
 	template<typename T>
 	inline T Load(OutOfBoundsBehavior robustness, SIMD::Int mask, bool atomic = false, std::memory_order order = std::memory_order_relaxed, int alignment = sizeof(float));
 
@@ -212,9 +228,19 @@ public:
 	SIMD::Int dynamicOffsets;  // If hasDynamicOffsets is false, all dynamicOffsets are zero.
 	std::vector<int32_t> staticOffsets;
 
-	bool hasDynamicLimit = false;    // True if dynamicLimit is non-zero.
-	bool hasDynamicOffsets = false;  // True if any dynamicOffsets are non-zero.
-	bool isBasePlusOffset = false;   // True if this uses base+offset. False if this is a collection of Pointers
+	// Inclusive upper bound of dynamicOffsets, if hasDynamicOffsetsBound is true.
+	uint32_t dynamicOffsetsBound = 0;
+
+	// Inclusive upper bound of the dynamicOffsets of active lanes, computed at
+	// run time, if hasActiveOffsetsBound is true. Negative if no bound holds.
+	scalar::Int activeOffsetsBound;
+
+	bool hasDynamicLimit = false;         // True if dynamicLimit is non-zero.
+	bool hasDynamicOffsets = false;       // True if any dynamicOffsets are non-zero.
+	bool hasDynamicOffsetsBound = true;   // True if all dynamicOffsets lie within [0, dynamicOffsetsBound].
+	bool hasActiveOffsetsBound = false;   // True if activeOffsetsBound is set.
+	bool hasUniformOffsets = true;        // True if dynamicOffsets are equal in all lanes.
+	bool isBasePlusOffset = false;        // True if this uses base+offset. False if this is a collection of Pointers
 };
 
 }  // namespace SIMD
@@ -520,10 +546,10 @@ inline T SIMD::Pointer::Load(OutOfBoundsBehavior robustness, SIMD::Int mask, boo
 			return rr::Load(scalar::Pointer<T>(base + staticOffsets[0]), alignment, atomic, order);
 		}
 
-		if(hasStaticEqualOffsets())
+		if(hasEqualOffsets())
 		{
 			// Load one, replicate.
-			return T(*scalar::Pointer<EL>(base + staticOffsets[0], alignment));
+			return T(*scalar::Pointer<EL>(base + Extract(offsets(), 0), alignment));
 		}
 	}
 	else
@@ -545,7 +571,7 @@ inline T SIMD::Pointer::Load(OutOfBoundsBehavior robustness, SIMD::Int mask, boo
 
 	if(!atomic && order == std::memory_order_relaxed)
 	{
-		if(hasStaticEqualOffsets())
+		if(hasEqualOffsets())
 		{
 			// Load one, replicate.
 			// Be careful of the case where the post-bounds-check mask
@@ -553,7 +579,7 @@ inline T SIMD::Pointer::Load(OutOfBoundsBehavior robustness, SIMD::Int mask, boo
 			T out = T(0);
 			If(AnyTrue(mask))
 			{
-				EL el = *scalar::Pointer<EL>(base + staticOffsets[0], alignment);
+				EL el = *scalar::Pointer<EL>(base + Extract(offs, 0), alignment);
 				out = T(el);
 			}
 			return out;
@@ -580,7 +606,7 @@ inline T SIMD::Pointer::Load(OutOfBoundsBehavior robustness, SIMD::Int mask, boo
 	{
 		T out;
 		auto anyLanesDisabled = AnyFalse(mask);
-		If(hasStaticEqualOffsets() && !anyLanesDisabled)
+		If(hasEqualOffsets() && !anyLanesDisabled)
 		{
 			// Load one, replicate.
 			auto offset = Extract(offs, 0);
@@ -659,7 +685,7 @@ inline void SIMD::Pointer::Store(T val, OutOfBoundsBehavior robustness, SIMD::In
 
 	if(!atomic && order == std::memory_order_relaxed)
 	{
-		if(hasStaticEqualOffsets())
+		if(hasEqualOffsets())
 		{
 			If(AnyTrue(mask))
 			{
@@ -673,7 +699,7 @@ inline void SIMD::Pointer::Store(T val, OutOfBoundsBehavior robustness, SIMD::In
 				                 Extract(maskedVal, 1) |
 				                 Extract(maskedVal, 2) |
 				                 Extract(maskedVal, 3);
-				*scalar::Pointer<EL>(base + staticOffsets[0], alignment) = As<EL>(scalarVal);
+				*scalar::Pointer<EL>(base + Extract(offs, 0), alignment) = As<EL>(scalarVal);
 			}
 		}
 		else if(hasStaticSequentialOffsets(sizeof(float)) &&
@@ -361,6 +361,11 @@ bool Caps::fmaIsFast()
 	return false;
 }
 
+bool Caps::ticksSupported()
+{
+	return false;
+}
+
 enum EmulatedType
 {
 	EmulatedShift = 16,
@@ -30,6 +30,7 @@
 #	include <unistd.h>
 #endif
 
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 
@@ -40,6 +41,12 @@
 #	define __x86__
 #endif
 
+#if defined(__x86__)
+#	include <emmintrin.h>
+#elif defined(__aarch64__)
+#	include <arm_neon.h>
+#endif
+
 // A Clang extension to determine compiler features.
 // We use it to detect Sanitizer builds (e.g. -fsanitize=memory).
 #ifndef __has_feature
@@ -155,4 +162,106 @@ void clear(uint32_t *memory, uint32_t element, size_t count)
 #endif
 }
 
+void copyStreaming(void *destination, const void *source, size_t bytes)
+{
+	uint8_t *dst = static_cast<uint8_t *>(destination);
+	const uint8_t *src = static_cast<const uint8_t *>(source);
+
+#if defined(__x86__) || defined(__aarch64__)
+	// Streaming stores require 16-byte aligned destinations.
+	size_t head = std::min(static_cast<size_t>(-reinterpret_cast<uintptr_t>(dst) & 15), bytes);
+	memcpy(dst, src, head);
+	dst += head;
+	src += head;
+	bytes -= head;
+
+	for(; bytes >= 64; bytes -= 64, dst += 64, src += 64)
+	{
+#	if defined(__x86__)
+		__m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+		__m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 16));
+		__m128i v2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 32));
+		__m128i v3 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 48));
+		_mm_stream_si128(reinterpret_cast<__m128i *>(dst), v0);
+		_mm_stream_si128(reinterpret_cast<__m128i *>(dst + 16), v1);
+		_mm_stream_si128(reinterpret_cast<__m128i *>(dst + 32), v2);
+		_mm_stream_si128(reinterpret_cast<__m128i *>(dst + 48), v3);
+#	else
+		uint8x16_t v0 = vld1q_u8(src);
+		uint8x16_t v1 = vld1q_u8(src + 16);
+		uint8x16_t v2 = vld1q_u8(src + 32);
+		uint8x16_t v3 = vld1q_u8(src + 48);
+		__asm__ __volatile__("stnp %q0, %q1, [%2]\n"
+		                     "stnp %q3, %q4, [%2, #32]"
+		                     :
+		                     : "w"(v0), "w"(v1), "r"(dst), "w"(v2), "w"(v3)
+		                     : "memory");
+#	endif
+	}
+
+#	if defined(__x86__)
+	_mm_sfence();  // Order the streaming stores before any subsequent synchronization.
+#	endif
+#endif
+
+	memcpy(dst, src, bytes);
+}
+
+void clearStreaming(uint32_t *memory, uint32_t element, size_t count)
+{
+#if defined(__x86__) || defined(__aarch64__)
+	// Memory is 4-byte aligned, so this reaches 16-byte alignment.
+	size_t head = std::min(static_cast<size_t>((-reinterpret_cast<uintptr_t>(memory) & 15) / 4), count);
+	clear(memory, element, head);
+	memory += head;
+	count -= head;
+
+#	if defined(__x86__)
+	__m128i v = _mm_set1_epi32(static_cast<int>(element));
+#	else
+	uint32x4_t v = vdupq_n_u32(element);
+#	endif
+
+	for(; count >= 16; count -= 16, memory += 16)
+	{
+#	if defined(__x86__)
+		_mm_stream_si128(reinterpret_cast<__m128i *>(memory), v);
+		_mm_stream_si128(reinterpret_cast<__m128i *>(memory + 4), v);
+		_mm_stream_si128(reinterpret_cast<__m128i *>(memory + 8), v);
+		_mm_stream_si128(reinterpret_cast<__m128i *>(memory + 12), v);
+#	else
+		__asm__ __volatile__("stnp %q0, %q0, [%1]\n"
+		                     "stnp %q0, %q0, [%1, #32]"
+		                     :
+		                     : "w"(v), "r"(memory)
+		                     : "memory");
+#	endif
+	}
+
+#	if defined(__x86__)
+	_mm_sfence();
+#	endif
+#endif
+
+	clear(memory, element, count);
+}
+
+size_t lastLevelCacheSize()
+{
+	static size_t cacheSize = [] {
+		long bytes = 0;
+#if defined(_SC_LEVEL3_CACHE_SIZE) && defined(_SC_LEVEL2_CACHE_SIZE)
+		bytes = sysconf(_SC_LEVEL3_CACHE_SIZE);
+		if(bytes <= 0)
+		{
+			bytes = sysconf(_SC_LEVEL2_CACHE_SIZE);
+		}
+#endif
+		// Not all platforms report their cache sizes. Assume a typical 8 MiB.
+		return (bytes > 0) ? static_cast<size_t>(bytes) : (size_t(8) << 20);
+	}();
+
+	return cacheSize;
+}
+
 }  // namespace sw
@@ -30,6 +30,15 @@ void freeMemory(void *memory);
 void clear(uint16_t *memory, uint16_t element, size_t count);
 void clear(uint32_t *memory, uint32_t element, size_t count);
 
+// Non-temporal variants of memcpy() and clear(), for transfers too large to
+// stay cached. Their stores bypass the cache instead of evicting the working
+// set, and are complete when the functions return.
+void copyStreaming(void *destination, const void *source, size_t bytes);
+void clearStreaming(uint32_t *memory, uint32_t element, size_t count);
+
+// Size of the last level cache, or an estimate when it can't be queried.
+size_t lastLevelCacheSize();
+
 }  // namespace sw
 
 #endif  // Memory_hpp
@@ -0,0 +1,120 @@
+// Copyright 2024 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef sw_Parallel_hpp
+#define sw_Parallel_hpp
+
+#include "Memory.hpp"
+
+#include "marl/scheduler.h"
+#include "marl/waitgroup.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace sw {
+
+// parallelFor() calls function(begin, end) for disjoint ranges covering
+// [0, count), using the marl scheduler bound to the calling thread, and returns
+// once all of them have completed. Each range holds at least minCount items,
+// so small amounts of work run on the calling thread alone, as does all work
+// when no scheduler is bound.
+template<typename Function>
+void parallelFor(uint32_t count, uint32_t minCount, const Function &function)
+{
+	marl::Scheduler *scheduler = marl::Scheduler::get();
+	uint32_t workerCount = scheduler ? static_cast<uint32_t>(scheduler->config().workerThread.count) : 0;
+	uint32_t rangeCount = std::min(count / std::max(minCount, 1u), workerCount + 1);
+
+	if(rangeCount <= 1)
+	{
+		if(count > 0)
+		{
+			function(0u, count);
+		}
+		return;
+	}
+
+	// The calling thread processes the last range itself.
+	marl::WaitGroup wg(rangeCount - 1);
+	for(uint32_t i = 0; i < rangeCount - 1; i++)
+	{
+		uint32_t begin = static_cast<uint32_t>(uint64_t(count) * i / rangeCount);
+		uint32_t end = static_cast<uint32_t>(uint64_t(count) * (i + 1) / rangeCount);
+		marl::schedule([&function, wg, begin, end] {
+			function(begin, end);
+			wg.done();
+		});
+	}
+
+	function(static_cast<uint32_t>(uint64_t(count) * (rangeCount - 1) / rangeCount), count);
+	wg.wait();
+}
+
+// Bulk transfers are split into chunks of this size, and only spread across
+// workers when each of them gets at least ParallelTransferMinChunks chunks.
+constexpr size_t ParallelTransferChunkSize = 64 * 1024;
+constexpr uint32_t ParallelTransferMinChunks = 4;
+
+// parallelCopy() is memcpy() spread across workers as by parallelFor().
+// Copies larger than the last level cache use streaming stores, since the
+// start of the destination would be evicted before the copy ends anyway.
+inline void parallelCopy(void *destination, const void *source, size_t size)
+{
+	uint8_t *dst = static_cast<uint8_t *>(destination);
+	const uint8_t *src = static_cast<const uint8_t *>(source);
+	const bool streaming = size > lastLevelCacheSize();
+	const size_t chunkCount = (size + ParallelTransferChunkSize - 1) / ParallelTransferChunkSize;
+
+	parallelFor(static_cast<uint32_t>(chunkCount), ParallelTransferMinChunks, [&](uint32_t begin, uint32_t end) {
+		size_t offset = begin * ParallelTransferChunkSize;
+		size_t bytes = std::min(end * ParallelTransferChunkSize, size) - offset;
+
+		if(streaming)
+		{
+			copyStreaming(dst + offset, src + offset, bytes);
+		}
+		else
+		{
+			memcpy(dst + offset, src + offset, bytes);
+		}
+	});
+}
+
+// parallelFill() sets count 32-bit elements to element, like parallelCopy().
+inline void parallelFill(uint32_t *memory, uint32_t element, size_t count)
+{
+	constexpr size_t chunkElements = ParallelTransferChunkSize / sizeof(uint32_t);
+	const bool streaming = count * sizeof(uint32_t) > lastLevelCacheSize();
+	const size_t chunkCount = (count + chunkElements - 1) / chunkElements;
+
+	parallelFor(static_cast<uint32_t>(chunkCount), ParallelTransferMinChunks, [&](uint32_t begin, uint32_t end) {
+		size_t offset = begin * chunkElements;
+		size_t elements = std::min(end * chunkElements, count) - offset;
+
+		if(streaming)
+		{
+			clearStreaming(memory + offset, element, elements);
+		}
+		else
+		{
+			clear(memory + offset, element, elements);
+		}
+	});
+}
+
+}  // namespace sw
+
+#endif  // sw_Parallel_hpp
@@ -108,12 +108,26 @@ Configuration readConfigurationFromFile()
 		// Default.
 		config.affinityPolicy = Configuration::AffinityPolicy::AnyOf;
 	}
+	config.enableComputeWorkgroupTiling = ini.getBoolean("Processor", "EnableComputeWorkgroupTiling", true);
+
+	// Compiler flags.
+	config.enableLoopOptimizations = ini.getBoolean("Compiler", "EnableLoopOptimizations", false);
+	config.spirvCacheSize = ini.getInteger<uint32_t>("Compiler", "SpirvCacheSize", 1024);
+	config.spirvCacheDir = ini.getValue("Compiler", "SpirvCacheDir");
 
 	// Profiling flags.
 	config.enableSpirvProfiling = ini.getBoolean("Profiler", "EnableSpirvProfiling");
 	config.spvProfilingReportPeriodMs = ini.getInteger<uint64_t>("Profiler", "SpirvProfilingReportPeriodMs");
 	config.spvProfilingReportDir = ini.getValue("Profiler", "SpirvProfilingReportDir");
 
+	// Tracing flags.
+	config.enableTracing = ini.getBoolean("Tracing", "EnableTracing");
+	config.traceFile = ini.getValue("Tracing", "TraceFile", "swiftshader_trace.json");
+	config.traceBufferSize = ini.getInteger<uint32_t>("Tracing", "TraceBufferSize", 65536);
+
+	// WSI flags.
+	config.headlessSharedMemoryPath = ini.getValue("WSI", "HeadlessSharedMemoryPath");
+
 	return config;
 }
 
@@ -41,13 +41,48 @@ struct Configuration
 	uint64_t affinityMask = 0xFFFFFFFFFFFFFFFFu;
 	AffinityPolicy affinityPolicy = AffinityPolicy::AnyOf;
 
+	// Whether compute dispatches with a 2D or 3D workgroup grid are scheduled
+	// in square or cubic tiles of workgroups rather than in rows.
+	bool enableComputeWorkgroupTiling = true;
+
+	// -------- [Compiler] --------
+	// Whether compute shaders and shaders containing loops are compiled with
+	// loop optimizations, trading longer compile times for faster routines.
+	bool enableLoopOptimizations = false;
+	// Number of optimized SPIR-V binaries each device keeps, independently of
+	// VkPipelineCache objects. A size of 0 disables the cache.
+	uint32_t spirvCacheSize = 1024;
+	// Directory optimized SPIR-V binaries are written to and read back from,
+	// so that they persist across runs. Persistence is disabled when empty.
+	// The SWIFTSHADER_SPIRV_CACHE_DIR environment variable overrides it.
+	std::string spirvCacheDir = "";
+
 	// -------- [Profiler] --------
 	// Whether SPIR-V profiling is enabled.
 	bool enableSpirvProfiling = false;
 	// Period controlling how often SPIR-V profiles are reported.
 	uint64_t spvProfilingReportPeriodMs = 1000;
-	// Directory where SPIR-V profile reports will be written.
+	// Directory where SPIR-V profile reports will be written. Besides the text
+	// report, per-instruction invocation and cycle counts are written in the
+	// folded stack format read by flame graph tools.
 	std::string spvProfilingReportDir = "";
+
+	// -------- [Tracing] --------
+	// Whether a timeline of renderer, queue and compiler activity is recorded.
+	// Setting the SWIFTSHADER_TRACE_FILE environment variable also enables it.
+	bool enableTracing = false;
+	// File the timeline is written to, in the Chrome trace event format.
+	std::string traceFile = "swiftshader_trace.json";
+	// Number of most recent events kept per thread.
+	uint32_t traceBufferSize = 65536;
+
+	// -------- [WSI] --------
+	// File that images of headless surface swapchains are allocated in, so
+	// that another process can map it and read presented frames directly.
+	// Typically a path under /dev/shm. The SWIFTSHADER_HEADLESS_SHM_PATH
+	// environment variable overrides it, and SWIFTSHADER_HEADLESS_SHM_FD
+	// selects an inherited file descriptor, such as a memfd, instead.
+	std::string headlessSharedMemoryPath = "";
 };
 
 // Get the configuration as parsed from a configuration file.
@@ -0,0 +1,251 @@
+// Copyright 2024 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Trace.hpp"
+
+#include "Debug.hpp"
+#include "SwiftConfig.hpp"
+
+#include "marl/mutex.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Event
+{
+	const char *category;
+	const char *name;
+	sw::Trace::Arg args[sw::Trace::MaxArgs];
+	uint64_t begin;
+	uint64_t end;
+};
+
+// Events recorded by a single thread. Only the owning thread writes to the
+// buffer. Flush() may read it concurrently, in which case events being
+// overwritten at that moment can come out torn.
+//
+// When its thread exits, a buffer is handed to the next thread which starts
+// tracing. The events of both threads are then reported on the same track,
+// which is fine since their lifetimes don't overlap.
+struct ThreadBuffer
+{
+	ThreadBuffer(uint32_t threadID, size_t capacity)
+	    : threadID(threadID)
+	    , capacity(capacity)
+	    , events(new Event[capacity])
+	{}
+
+	const uint32_t threadID;
+	const size_t capacity;
+	std::unique_ptr<Event[]> events;
+	std::atomic<uint64_t> written = { 0 };
+};
+
+// Bounds the memory used for tracing. Threads started while this many
+// others are tracing don't record events.
+constexpr size_t MaxThreadBuffers = 128;
+
+struct State
+{
+	std::string path;
+	size_t bufferSize = 0;
+
+	marl::mutex mutex;
+	std::vector<ThreadBuffer *> buffers GUARDED_BY(mutex);
+	std::vector<ThreadBuffer *> freeBuffers GUARDED_BY(mutex);  // Of exited threads
+};
+
+// Never destroyed, as threads may still record events during process exit.
+State &getState()
+{
+	static State *state = new State();
+	return *state;
+}
+
+// Returns the buffer of the calling thread, or nullptr if the bound on
+// buffers has been reached.
+ThreadBuffer *getThreadBuffer()
+{
+	struct Lease
+	{
+		Lease()
+		{
+			State &state = getState();
+			marl::lock lock(state.mutex);
+
+			if(!state.freeBuffers.empty())
+			{
+				buffer = state.freeBuffers.back();
+				state.freeBuffers.pop_back();
+			}
+			else if(state.buffers.size() < MaxThreadBuffers)
+			{
+				buffer = new ThreadBuffer(static_cast<uint32_t>(state.buffers.size()), state.bufferSize);
+				state.buffers.push_back(buffer);
+			}
+		}
+
+		~Lease()
+		{
+			if(buffer)
+			{
+				State &state = getState();
+				marl::lock lock(state.mutex);
+				state.freeBuffers.push_back(buffer);
+			}
+		}
+
+		ThreadBuffer *buffer = nullptr;
+	};
+
+	thread_local Lease lease;
+	return lease.buffer;
+}
+
+void writeString(std::ofstream &f, const char *str)
+{
+	f << '"';
+	for(const char *c = str; *c; c++)
+	{
+		if(*c == '"' || *c == '\\')
+		{
+			f << '\\';
+		}
+		f << *c;
+	}
+	f << '"';
+}
+
+}  // namespace
+
+namespace sw {
+
+std::atomic<bool> Trace::enabled = { false };
+
+void Trace::Initialize(const Configuration &config)
+{
+	static std::once_flag once;
+	std::call_once(once, [&] {
+		State &state = getState();
+		state.path = config.traceFile;
+		state.bufferSize = std::max<size_t>(config.traceBufferSize, 1);
+
+		bool enable = config.enableTracing;
+		if(const char *path = getenv("SWIFTSHADER_TRACE_FILE"))
+		{
+			state.path = path;
+			enable = true;
+		}
+
+		if(enable)
+		{
+			enabled.store(true, std::memory_order_relaxed);
+			atexit(Flush);
+		}
+	});
+}
+
+uint64_t Trace::Now()
+{
+	auto now = std::chrono::steady_clock::now().time_since_epoch();
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
+
+void Trace::Record(const char *category, const char *name, const Arg *args, uint64_t begin, uint64_t end)
+{
+	ThreadBuffer *buffer = getThreadBuffer();
+	if(!buffer)
+	{
+		return;
+	}
+
+	uint64_t index = buffer->written.load(std::memory_order_relaxed);
+
+	Event &event = buffer->events[index % buffer->capacity];
+	event.category = category;
+	event.name = name;
+	std::copy(args, args + MaxArgs, event.args);
+	event.begin = begin;
+	event.end = end;
+
+	buffer->written.store(index + 1, std::memory_order_release);
+}
+
+void Trace::Flush()
+{
+	if(!IsEnabled())
+	{
+		return;
+	}
+
+	State &state = getState();
+	std::ofstream f{ state.path };
+
+	if(!f)
+	{
+		warn("Error writing trace to file %s: %s\n", state.path.c_str(), strerror(errno));
+		return;
+	}
+
+	f << std::fixed << std::setprecision(3);
+	f << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+	bool first = true;
+	marl::lock lock(state.mutex);
+	for(ThreadBuffer *buffer : state.buffers)
+	{
+		uint64_t written = buffer->written.load(std::memory_order_acquire);
+		uint64_t count = std::min<uint64_t>(written, buffer->capacity);
+
+		for(uint64_t i = written - count; i < written; i++)
+		{
+			const Event &event = buffer->events[i % buffer->capacity];
+
+			f << (first ? "\n" : ",\n");
+			first = false;
+
+			// Timestamps are in microseconds.
+			f << "{\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadID
+			  << ",\"ts\":" << event.begin / 1000.0
+			  << ",\"dur\":" << (event.end - event.begin) / 1000.0
+			  << ",\"cat\":";
+			writeString(f, event.category);
+			f << ",\"name\":";
+			writeString(f, event.name);
+			f << ",\"args\":{";
+			for(int arg = 0; arg < MaxArgs && event.args[arg].name; arg++)
+			{
+				f << (arg == 0 ? "" : ",");
+				writeString(f, event.args[arg].name);
+				f << ":" << event.args[arg].value;
+			}
+			f << "}}";
+		}
+	}
+
+	f << "\n]}\n";
+	f.close();
+}
+
+}  // namespace sw
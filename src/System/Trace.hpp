@@ -0,0 +1,114 @@
+// Copyright 2024 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef sw_Trace_hpp
+#define sw_Trace_hpp
+
+#include <atomic>
+#include <cstdint>
+
+namespace sw {
+
+struct Configuration;
+
+// Trace records a timeline of scoped events, such as draw calls, batches and
+// routine compiles, and writes it out in the Chrome trace event JSON format,
+// which chrome://tracing and ui.perfetto.dev can load.
+//
+// Tracing is enabled at runtime through the [Tracing] section of the
+// configuration file, or by setting the SWIFTSHADER_TRACE_FILE environment
+// variable to the output path. When disabled, a scope costs a single load
+// and branch. When enabled, each thread records into its own fixed size ring
+// buffer without taking locks, so only the most recent events of each thread
+// are kept. Buffers of exited threads are reused, and their total number is
+// bounded.
+class Trace
+{
+public:
+	// A named integer argument attached to an event. Arguments without a
+	// name are omitted.
+	struct Arg
+	{
+		const char *name;
+		int64_t value;
+	};
+
+	static constexpr int MaxArgs = 3;
+
+	// Scope records an event spanning its lifetime.
+	class Scope
+	{
+	public:
+		// category and name must be string literals, or otherwise outlive
+		// the trace.
+		inline Scope(const char *category, const char *name, Arg arg0 = {}, Arg arg1 = {}, Arg arg2 = {});
+		inline ~Scope();
+
+		Scope(const Scope &) = delete;
+		Scope &operator=(const Scope &) = delete;
+
+	private:
+		const char *category;
+		const char *name;
+		Arg args[MaxArgs];
+		uint64_t begin = 0;
+	};
+
+	// Reads the tracing options. Must be called before any events are
+	// recorded, and is a no-op after the first call.
+	static void Initialize(const Configuration &config);
+
+	// Writes all recorded events to the trace file. Events keep being
+	// recorded afterwards, and later flushes rewrite the whole file.
+	static void Flush();
+
+	static bool IsEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+private:
+	static uint64_t Now();
+	static void Record(const char *category, const char *name, const Arg *args, uint64_t begin, uint64_t end);
+
+	static std::atomic<bool> enabled;
+};
+
+Trace::Scope::Scope(const char *category, const char *name, Arg arg0, Arg arg1, Arg arg2)
+    : category(category)
+    , name(name)
+    , args{ arg0, arg1, arg2 }
+{
+	if(IsEnabled())
+	{
+		begin = Now();
+	}
+}
+
+Trace::Scope::~Scope()
+{
+	if(begin != 0)
+	{
+		Record(category, name, args, begin, Now());
+	}
+}
+
+}  // namespace sw
+
+#define SW_TRACE_CONCAT_(a, b) a##b
+#define SW_TRACE_CONCAT(a, b) SW_TRACE_CONCAT_(a, b)
+
+// SW_TRACE_SCOPE(category, name [, { "arg", value }...]) records an event
+// spanning the rest of the enclosing scope.
+#define SW_TRACE_SCOPE(...) \
+	sw::Trace::Scope SW_TRACE_CONCAT(swTraceScope, __LINE__)(__VA_ARGS__)
+
+#endif  // sw_Trace_hpp
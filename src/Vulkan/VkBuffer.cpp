@@ -16,6 +16,7 @@
 
 #include "VkConfig.hpp"
 #include "VkDeviceMemory.hpp"
+#include "System/Parallel.hpp"
 
 #include <algorithm>
 #include <cstring>
@@ -108,14 +109,14 @@ void Buffer::copyFrom(const void *srcMemory, VkDeviceSize pSize, VkDeviceSize pO
 {
 	ASSERT((pSize + pOffset) <= size);
 
-	memcpy(getOffsetPointer(pOffset), srcMemory, pSize);
+	sw::parallelCopy(getOffsetPointer(pOffset), srcMemory, pSize);
 }
 
 void Buffer::copyTo(void *dstMemory, VkDeviceSize pSize, VkDeviceSize pOffset) const
 {
 	ASSERT((pSize + pOffset) <= size);
 
-	memcpy(dstMemory, getOffsetPointer(pOffset), pSize);
+	sw::parallelCopy(dstMemory, getOffsetPointer(pOffset), pSize);
 }
 
 void Buffer::copyTo(Buffer *dstBuffer, const VkBufferCopy2KHR &pRegion) const
@@ -133,16 +134,14 @@ void Buffer::fill(VkDeviceSize dstOffset, VkDeviceSize fillSize, uint32_t data)
 
 	// Vulkan 1.1 spec: "If VK_WHOLE_SIZE is used and the remaining size of the buffer is
 	//                   not a multiple of 4, then the nearest smaller multiple is used."
-	for(; bytes >= 4; bytes -= 4, memToWrite++)
-	{
-		*memToWrite = data;
-	}
+	sw::parallelFill(memToWrite, data, bytes / 4);
 }
 
 void Buffer::update(VkDeviceSize dstOffset, VkDeviceSize dataSize, const void *pData)
 {
 	ASSERT((dataSize + dstOffset) <= size);
 
+	// vkCmdUpdateBuffer() is limited to 64 KiB, too little to benefit from parallelCopy().
 	memcpy(getOffsetPointer(dstOffset), pData, dataSize);
 }
 
@@ -15,6 +15,9 @@
 #include "VkBufferView.hpp"
 #include "VkBuffer.hpp"
 #include "VkFormat.hpp"
+#include "Device/Sampler.hpp"
+
+#include <cstring>
 
 namespace vk {
 
@@ -23,6 +26,7 @@ BufferView::BufferView(const VkBufferViewCreateInfo *pCreateInfo, void *mem)
     , buffer(vk::Cast(pCreateInfo->buffer))
     , format(pCreateInfo->format)
     , offset(pCreateInfo->offset)
+    , sampledTexture(reinterpret_cast<sw::Texture *>(mem))
 {
 	if(pCreateInfo->range == VK_WHOLE_SIZE)
 	{
@@ -32,6 +36,26 @@ BufferView::BufferView(const VkBufferViewCreateInfo *pCreateInfo, void *mem)
 	{
 		range = pCreateInfo->range;
 	}
+
+	if(sampledTexture)
+	{
+		writeSampledTexture(sampledTexture);
+	}
+}
+
+size_t BufferView::ComputeRequiredAllocationSize(const VkBufferViewCreateInfo *pCreateInfo)
+{
+	const Buffer *buffer = vk::Cast(pCreateInfo->buffer);
+
+	return (buffer->getUsage() & VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT) ? sizeof(sw::Texture) : 0;
+}
+
+void BufferView::destroy(const VkAllocationCallbacks *pAllocator)
+{
+	if(sampledTexture)
+	{
+		vk::freeHostMemory(sampledTexture, pAllocator);
+	}
 }
 
 void *BufferView::getPointer() const
@@ -39,4 +63,25 @@ void *BufferView::getPointer() const
 	return buffer->getOffsetPointer(offset);
 }
 
+void BufferView::writeSampledTexture(sw::Texture *texture) const
+{
+	memset(texture, 0, sizeof(sw::Texture));
+
+	uint32_t numElements = getElementCount();
+	texture->widthWidthHeightHeight = sw::float4(static_cast<float>(numElements), static_cast<float>(numElements), 1, 1);
+	texture->width = sw::float4(static_cast<float>(numElements));
+	texture->height = sw::float4(1);
+	texture->depth = sw::float4(1);
+
+	sw::Mipmap &mipmap = texture->mipmap[0];
+	mipmap.buffer = getPointer();
+	mipmap.width[0] = mipmap.width[1] = mipmap.width[2] = mipmap.width[3] = numElements;
+	mipmap.height[0] = mipmap.height[1] = mipmap.height[2] = mipmap.height[3] = 1;
+	mipmap.depth[0] = mipmap.depth[1] = mipmap.depth[2] = mipmap.depth[3] = 1;
+	mipmap.pitchP.x = mipmap.pitchP.y = mipmap.pitchP.z = mipmap.pitchP.w = numElements;
+	mipmap.sliceP.x = mipmap.sliceP.y = mipmap.sliceP.z = mipmap.sliceP.w = 0;
+	mipmap.onePitchP[0] = mipmap.onePitchP[2] = 1;
+	mipmap.onePitchP[1] = mipmap.onePitchP[3] = 0;
+}
+
 }  // namespace vk
@@ -28,23 +28,29 @@ class BufferView : public Object<BufferView, VkBufferView>
 public:
 	BufferView(const VkBufferViewCreateInfo *pCreateInfo, void *mem);
 
-	static size_t ComputeRequiredAllocationSize(const VkBufferViewCreateInfo *pCreateInfo)
-	{
-		return 0;
-	}
+	void destroy(const VkAllocationCallbacks *pAllocator);
+
+	static size_t ComputeRequiredAllocationSize(const VkBufferViewCreateInfo *pCreateInfo);
 
 	void *getPointer() const;
 	uint32_t getElementCount() const { return static_cast<uint32_t>(range / Format(format).bytes()); }
 	uint32_t getRangeInBytes() const { return static_cast<uint32_t>(range); }
 	VkFormat getFormat() const { return format; }
 
+	// Sampling parameters of the view, computed once at creation and referenced by its
+	// uniform texel buffer descriptors. Null if the buffer can't be used as one.
+	const sw::Texture *getSampledTexture() const { return sampledTexture; }
+
 	const Identifier id;
 
 private:
+	void writeSampledTexture(sw::Texture *texture) const;
+
 	Buffer *buffer;
 	VkFormat format;
 	VkDeviceSize offset;
 	VkDeviceSize range;
+	sw::Texture *const sampledTexture = nullptr;
 };
 
 static inline BufferView *Cast(VkBufferView object)
@@ -105,13 +105,24 @@ public:
 	void execute(vk::CommandBuffer::ExecutionState &executionState) override
 	{
 		bool hasResolveAttachments = (executionState.renderPass->getSubpass(executionState.subpassIndex).pResolveAttachments != nullptr);
-		if(hasResolveAttachments)
+		bool hasDeferredClears = executionState.renderPassFramebuffer->hasDeferredClears();
+		if(hasResolveAttachments || hasDeferredClears)
 		{
 			// TODO(b/197691918): Avoid halt-the-world synchronization.
 			executionState.renderer->synchronize();
 
-			// TODO(b/197691917): Eliminate redundant resolve operations.
-			executionState.renderPassFramebuffer->resolve(executionState.renderPass, executionState.subpassIndex);
+			// Deferred clears don't outlive the subpass, so that later subpasses
+			// can read the attachments without knowing about them.
+			if(hasDeferredClears)
+			{
+				executionState.renderPassFramebuffer->resolveDeferredClears();
+			}
+
+			if(hasResolveAttachments)
+			{
+				// TODO(b/197691917): Eliminate redundant resolve operations.
+				executionState.renderPassFramebuffer->resolve(executionState.renderPass, executionState.subpassIndex);
+			}
 		}
 
 		executionState.subpassIndex++;
@@ -129,6 +140,9 @@ public:
 		// TODO(b/197691918): Avoid halt-the-world synchronization.
 		executionState.renderer->synchronize();
 
+		// Clear whatever rows of the attachments haven't been drawn to.
+		executionState.renderPassFramebuffer->resolveDeferredClears();
+
 		// TODO(b/197691917): Eliminate redundant resolve operations.
 		executionState.renderPassFramebuffer->resolve(executionState.renderPass, executionState.subpassIndex);
 
@@ -959,7 +973,8 @@ class CmdDrawBase : public vk::CommandBuffer::Command
 {
 public:
 	void draw(vk::CommandBuffer::ExecutionState &executionState, bool indexed,
-	          uint32_t count, uint32_t instanceCount, uint32_t first, int32_t vertexOffset, uint32_t firstInstance)
+	          uint32_t count, uint32_t instanceCount, uint32_t first, int32_t vertexOffset, uint32_t firstInstance,
+	          const std::vector<vk::DrawRecord> *records = nullptr)
 	{
 		const auto &pipelineState = executionState.pipelineState[VK_PIPELINE_BIND_POINT_GRAPHICS];
 
@@ -981,25 +996,45 @@ public:
 			indexBuffer.setIndexBufferBinding(executionState.indexBufferBinding, executionState.indexType);
 		}
 
-		std::vector<std::pair<uint32_t, void *>> indexBuffers;
+		auto &indexBuffers = executionState.indexBuffers;
+		indexBuffers.clear();
 		pipeline->getIndexBuffers(executionState.dynamicState, count, first, indexed, &indexBuffers);
 
+		// Records of merged draws refer to primitives of a single range.
+		ASSERT(!records || indexBuffers.size() == 1);
+
 		VkRect2D renderArea = executionState.getRenderArea();
 
 		for(uint32_t instance = firstInstance; instance != firstInstance + instanceCount; instance++)
 		{
 			// FIXME: reconsider instances/views nesting.
 			auto layerMask = executionState.getLayerMask();
-			while(layerMask)
-			{
-				int layer = sw::log2i(layerMask);
-				layerMask &= ~(1 << layer);
 
+			// All views are rendered by a single draw which processes each vertex once,
+			// and only recomputes positions for views beyond the first, unless other
+			// results of the vertex shader differ between views.
+			if(pipeline->canShareVertexProcessingBetweenViews())
+			{
 				for(auto indexBuffer : indexBuffers)
 				{
 					executionState.renderer->draw(pipeline, executionState.dynamicState, indexBuffer.first, vertexOffset,
-					                              executionState.events, instance, layer, indexBuffer.second,
-					                              renderArea, executionState.pushConstants);
+					                              executionState.events, instance, layerMask, indexBuffer.second,
+					                              renderArea, executionState.pushConstants, records);
+				}
+			}
+			else
+			{
+				while(layerMask)
+				{
+					int layer = sw::log2i(layerMask);
+					layerMask &= ~(1 << layer);
+
+					for(auto indexBuffer : indexBuffers)
+					{
+						executionState.renderer->draw(pipeline, executionState.dynamicState, indexBuffer.first, vertexOffset,
+						                              executionState.events, instance, 1u << layer, indexBuffer.second,
+						                              renderArea, executionState.pushConstants, records);
+					}
 				}
 			}
 
@@ -1010,6 +1045,115 @@ public:
 			}
 		}
 	}
+
+	// Issues the records of an indirect draw. Consecutive records with the same
+	// instance count are merged into a single draw when the previous ones hold
+	// whole primitives and, for indexed draws, their index ranges are contiguous.
+	// Each record keeps its own base vertex and first instance in the merged
+	// draw's record table, so shaders can't tell the records apart, and they
+	// share one DrawCall and its batches. Records with different first instances
+	// are only merged when no attributes are read per instance.
+	template<typename Command>
+	void drawIndirect(vk::CommandBuffer::ExecutionState &executionState, bool indexed, const vk::Buffer *buffer, VkDeviceSize offset, uint32_t drawCount, uint32_t stride)
+	{
+		auto *pipeline = static_cast<vk::GraphicsPipeline *>(executionState.pipelineState[VK_PIPELINE_BIND_POINT_GRAPHICS].pipeline);
+		const uint32_t granularity = pipeline->getDrawMergeGranularity(executionState.dynamicState);
+
+		vk::Inputs &inputs = pipeline->getInputs();
+		inputs.setVertexInputBinding(executionState.vertexInputBindings, executionState.dynamicState);
+		const bool hasInstanceAttributes = inputs.hasInstanceAttributes();
+
+		auto &records = executionState.drawRecords;
+		DrawRange merged = {};
+
+		for(auto drawId = 0u; drawId < drawCount; drawId++)
+		{
+			const auto *cmd = reinterpret_cast<const Command *>(buffer->getOffsetPointer(offset + drawId * stride));
+			const DrawRange range = GetDrawRange(cmd);
+
+			if(range.count == 0 || range.instanceCount == 0)
+			{
+				continue;  // Draws nothing
+			}
+
+			if(granularity != 0 && merged.canAppend(range, granularity, indexed, hasInstanceAttributes))
+			{
+				records.push_back(merged.getRecord(range, granularity, indexed));
+				merged.count += range.count;
+				continue;
+			}
+
+			drawRange(executionState, indexed, merged, records);
+			merged = range;
+			records.clear();
+			records.push_back({ 0, indexed ? range.vertexOffset : static_cast<int32_t>(range.first), 0 });
+		}
+
+		drawRange(executionState, indexed, merged, records);
+	}
+
+private:
+	// The vertices of a non-indexed draw, or the indices of an indexed draw.
+	struct DrawRange
+	{
+		uint32_t first;
+		uint32_t count;
+		int32_t vertexOffset;
+		uint32_t instanceCount;
+		uint32_t firstInstance;
+
+		bool canAppend(const DrawRange &next, uint32_t granularity, bool indexed, bool hasInstanceAttributes) const
+		{
+			return (count != 0) && (count % granularity == 0) &&
+			       (static_cast<uint64_t>(count) + next.count <= UINT32_MAX) &&
+			       (!indexed || static_cast<uint64_t>(first) + count == next.first) &&
+			       (instanceCount == next.instanceCount) &&
+			       (!hasInstanceAttributes || firstInstance == next.firstInstance);
+		}
+
+		// Returns the record of the next range, appended at the end of this one.
+		// Non-indexed draws number their vertices from the start of the merged
+		// range, so their base vertex is relative to it.
+		vk::DrawRecord getRecord(const DrawRange &next, uint32_t granularity, bool indexed) const
+		{
+			const uint32_t firstPrimitive = count / granularity;
+			const int32_t baseVertex = indexed ? next.vertexOffset : static_cast<int32_t>(next.first - count);
+			const int32_t instanceOffset = static_cast<int32_t>(next.firstInstance - firstInstance);
+
+			return { firstPrimitive, baseVertex, instanceOffset };
+		}
+	};
+
+	static DrawRange GetDrawRange(const VkDrawIndirectCommand *cmd)
+	{
+		return { cmd->firstVertex, cmd->vertexCount, 0, cmd->instanceCount, cmd->firstInstance };
+	}
+
+	static DrawRange GetDrawRange(const VkDrawIndexedIndirectCommand *cmd)
+	{
+		return { cmd->firstIndex, cmd->indexCount, cmd->vertexOffset, cmd->instanceCount, cmd->firstInstance };
+	}
+
+	void drawRange(vk::CommandBuffer::ExecutionState &executionState, bool indexed, const DrawRange &range, const std::vector<vk::DrawRecord> &records)
+	{
+		if(range.count == 0)
+		{
+			return;
+		}
+
+		// A single record is drawn without the record table.
+		const std::vector<vk::DrawRecord> *mergedRecords = (records.size() > 1) ? &records : nullptr;
+
+		if(indexed)
+		{
+			draw(executionState, true, range.count, range.instanceCount, range.first, range.vertexOffset, range.firstInstance, mergedRecords);
+		}
+		else
+		{
+			// Non-indexed draws start at their first vertex through the vertex offset.
+			draw(executionState, false, range.count, range.instanceCount, 0, static_cast<int32_t>(range.first), range.firstInstance, mergedRecords);
+		}
+	}
 };
 
 class CmdDraw : public CmdDrawBase
@@ -1077,11 +1221,7 @@ public:
 
 	void execute(vk::CommandBuffer::ExecutionState &executionState) override
 	{
-		for(auto drawId = 0u; drawId < drawCount; drawId++)
-		{
-			const auto *cmd = reinterpret_cast<const VkDrawIndirectCommand *>(buffer->getOffsetPointer(offset + drawId * stride));
-			draw(executionState, false, cmd->vertexCount, cmd->instanceCount, 0, cmd->firstVertex, cmd->firstInstance);
-		}
+		drawIndirect<VkDrawIndirectCommand>(executionState, false, buffer, offset, drawCount, stride);
 	}
 
 	std::string description() override { return "vkCmdDrawIndirect()"; }
@@ -1106,11 +1246,7 @@ public:
 
 	void execute(vk::CommandBuffer::ExecutionState &executionState) override
 	{
-		for(auto drawId = 0u; drawId < drawCount; drawId++)
-		{
-			const auto *cmd = reinterpret_cast<const VkDrawIndexedIndirectCommand *>(buffer->getOffsetPointer(offset + drawId * stride));
-			draw(executionState, true, cmd->indexCount, cmd->instanceCount, cmd->firstIndex, cmd->vertexOffset, cmd->firstInstance);
-		}
+		drawIndirect<VkDrawIndexedIndirectCommand>(executionState, true, buffer, offset, drawCount, stride);
 	}
 
 	std::string description() override { return "vkCmdDrawIndexedIndirect()"; }
@@ -1405,6 +1541,75 @@ private:
 	const VkFilter filter;
 };
 
+// Blits which each halve a mip level of an image into the next one, as
+// recorded by mipmap generation loops. Blits of consecutive levels, separated
+// by nothing but pipeline barriers, are folded into a single command so that
+// the levels can be generated in one pass.
+class CmdBlitMipChain : public vk::CommandBuffer::Command
+{
+public:
+	CmdBlitMipChain(vk::Image *image, const VkImageBlit2 &region, VkFilter filter)
+	    : image(image)
+	    , regions{ region }
+	    , filter(filter)
+	{
+	}
+
+	static bool IsLevelDownsample(const vk::Image *srcImage, const vk::Image *dstImage, const VkImageBlit2 &region)
+	{
+		if(srcImage != dstImage ||
+		   region.srcSubresource.aspectMask != VK_IMAGE_ASPECT_COLOR_BIT ||
+		   region.dstSubresource.mipLevel != region.srcSubresource.mipLevel + 1 ||
+		   region.srcSubresource.baseArrayLayer != region.dstSubresource.baseArrayLayer)
+		{
+			return false;
+		}
+
+		VkExtent3D srcExtent = srcImage->getMipLevelExtent(VK_IMAGE_ASPECT_COLOR_BIT, region.srcSubresource.mipLevel);
+		VkExtent3D dstExtent = dstImage->getMipLevelExtent(VK_IMAGE_ASPECT_COLOR_BIT, region.dstSubresource.mipLevel);
+
+		return region.srcOffsets[0] == VkOffset3D{ 0, 0, 0 } &&
+		       region.srcOffsets[1] == VkOffset3D{ static_cast<int32_t>(srcExtent.width), static_cast<int32_t>(srcExtent.height), static_cast<int32_t>(srcExtent.depth) } &&
+		       region.dstOffsets[0] == VkOffset3D{ 0, 0, 0 } &&
+		       region.dstOffsets[1] == VkOffset3D{ static_cast<int32_t>(dstExtent.width), static_cast<int32_t>(dstExtent.height), static_cast<int32_t>(dstExtent.depth) };
+	}
+
+	bool append(const vk::Image *srcImage, const VkImageBlit2 &region, VkFilter filter)
+	{
+		const VkImageBlit2 &last = regions.back();
+
+		if(srcImage != image || filter != this->filter ||
+		   region.srcSubresource.mipLevel != last.dstSubresource.mipLevel ||
+		   region.srcSubresource.baseArrayLayer != last.dstSubresource.baseArrayLayer ||
+		   region.srcSubresource.layerCount != last.dstSubresource.layerCount)
+		{
+			return false;
+		}
+
+		regions.push_back(region);
+		return true;
+	}
+
+	void execute(vk::CommandBuffer::ExecutionState &executionState) override
+	{
+		if(regions.size() > 1)
+		{
+			// Performed once up front in place of the pipeline barriers which
+			// separated the levels.
+			executionState.renderer->synchronize();
+		}
+
+		image->blitMipChain(regions.data(), static_cast<uint32_t>(regions.size()), filter);
+	}
+
+	std::string description() override { return "vkCmdBlitImage()"; }
+
+private:
+	vk::Image *const image;
+	std::vector<VkImageBlit2> regions;
+	const VkFilter filter;
+};
+
 class CmdResolveImage : public vk::CommandBuffer::Command
 {
 public:
@@ -1815,6 +2020,9 @@ void CommandBuffer::resetState()
 {
 	// FIXME (b/119409619): replace this vector by an allocator so we can control all memory allocations
 	commands.clear();
+	mipChainCommand = nullptr;
+	mipChainCommandCount = 0;
+	barrierCommandCount = 0;
 
 	state = INITIAL;
 }
@@ -1936,6 +2144,7 @@ void CommandBuffer::dispatchBase(uint32_t baseGroupX, uint32_t baseGroupY, uint3
 void CommandBuffer::pipelineBarrier(const VkDependencyInfo &pDependencyInfo)
 {
 	addCommand<::CmdPipelineBarrier>();
+	barrierCommandCount = commands.size();
 }
 
 void CommandBuffer::bindPipeline(VkPipelineBindPoint pipelineBindPoint, Pipeline *pipeline)
@@ -2211,13 +2420,35 @@ void CommandBuffer::blitImage(const VkBlitImageInfo2 &blitImageInfo)
 	ASSERT(blitImageInfo.dstImageLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL ||
 	       blitImageInfo.dstImageLayout == VK_IMAGE_LAYOUT_GENERAL);
 
+	vk::Image *srcImage = vk::Cast(blitImageInfo.srcImage);
+	vk::Image *dstImage = vk::Cast(blitImageInfo.dstImage);
+
 	for(uint32_t i = 0; i < blitImageInfo.regionCount; i++)
 	{
-		addCommand<::CmdBlitImage>(
-		    vk::Cast(blitImageInfo.srcImage),
-		    vk::Cast(blitImageInfo.dstImage),
-		    blitImageInfo.pRegions[i],
-		    blitImageInfo.filter);
+		const VkImageBlit2 &region = blitImageInfo.pRegions[i];
+
+		if(!::CmdBlitMipChain::IsLevelDownsample(srcImage, dstImage, region))
+		{
+			addCommand<::CmdBlitImage>(srcImage, dstImage, region, blitImageInfo.filter);
+			continue;
+		}
+
+		// Fold the blit into the previous level's if only a pipeline barrier
+		// was recorded since, which the mip chain performs instead.
+		bool followsMipChain = (commands.size() == mipChainCommandCount) ||
+		                       (commands.size() == mipChainCommandCount + 1 && barrierCommandCount == commands.size());
+
+		if(mipChainCommand && followsMipChain &&
+		   static_cast<::CmdBlitMipChain *>(mipChainCommand)->append(srcImage, region, blitImageInfo.filter))
+		{
+			commands.resize(mipChainCommandCount);
+			barrierCommandCount = 0;
+			continue;
+		}
+
+		addCommand<::CmdBlitMipChain>(dstImage, region, blitImageInfo.filter);
+		mipChainCommand = commands.back().get();
+		mipChainCommandCount = commands.size();
 	}
 }
 
@@ -211,6 +211,12 @@ public:
 
 		uint32_t subpassIndex = 0;
 
+		// Index ranges of the current draw, kept to reuse their allocation.
+		std::vector<std::pair<uint32_t, void *>> indexBuffers;
+
+		// Records of the current merged indirect draw, kept to reuse their allocation.
+		std::vector<DrawRecord> drawRecords;
+
 		void bindAttachments(Attachments *attachments);
 
 		VkRect2D getRenderArea() const;
@@ -249,6 +255,13 @@ private:
 
 	// FIXME (b/119409619): replace this vector by an allocator so we can control all memory allocations
 	std::vector<std::unique_ptr<Command>> commands;
+
+	// The most recent mip chain blit, and the command counts right after it and
+	// after the most recent pipeline barrier, used to fold blits of the next
+	// level into it. See blitImage().
+	Command *mipChainCommand = nullptr;
+	size_t mipChainCommandCount = 0;
+	size_t barrierCommandCount = 0;
 };
 
 using DispatchableCommandBuffer = DispatchableObject<CommandBuffer, VkCommandBuffer>;
@@ -104,6 +104,8 @@ constexpr int SUBPIXEL_PRECISION_MASK = 0xFFFFFFFF >> (32 - SUBPIXEL_PRECISION_B
 
 constexpr int MAX_VIEWPORTS = 16;
 
+constexpr int MAX_MULTIVIEW_VIEW_COUNT = 6;
+
 // TODO: The heap size should be configured based on available RAM.
 constexpr VkDeviceSize PHYSICAL_DEVICE_HEAP_SIZE = 0x80000000ull;   // 0x80000000 = 2 GiB
 constexpr VkDeviceSize MAX_MEMORY_ALLOCATION_SIZE = 0x40000000ull;  // 0x40000000 = 1 GiB
@@ -296,45 +296,6 @@ uint8_t *DescriptorSetLayout::getDescriptorPointer(DescriptorSet *descriptorSet,
 	return descriptorSet->getDataAddress() + byteOffset;
 }
 
-static void WriteTextureLevelInfo(sw::Texture *texture, uint32_t level, uint32_t width, uint32_t height, uint32_t depth, uint32_t pitchP, uint32_t sliceP, uint32_t samplePitchP, uint32_t sampleMax)
-{
-	if(level == 0)
-	{
-		texture->widthWidthHeightHeight[0] = static_cast<float>(width);
-		texture->widthWidthHeightHeight[1] = static_cast<float>(width);
-		texture->widthWidthHeightHeight[2] = static_cast<float>(height);
-		texture->widthWidthHeightHeight[3] = static_cast<float>(height);
-
-		texture->width = sw::float4(static_cast<float>(width));
-		texture->height = sw::float4(static_cast<float>(height));
-		texture->depth = sw::float4(static_cast<float>(depth));
-	}
-
-	sw::Mipmap &mipmap = texture->mipmap[level];
-
-	uint16_t halfTexelU = 0x8000 / width;
-	uint16_t halfTexelV = 0x8000 / height;
-	uint16_t halfTexelW = 0x8000 / depth;
-
-	mipmap.uHalf = sw::ushort4(halfTexelU);
-	mipmap.vHalf = sw::ushort4(halfTexelV);
-	mipmap.wHalf = sw::ushort4(halfTexelW);
-
-	mipmap.width = sw::uint4(width);
-	mipmap.height = sw::uint4(height);
-	mipmap.depth = sw::uint4(depth);
-
-	mipmap.onePitchP[0] = 1;
-	mipmap.onePitchP[1] = sw::assert_cast<short>(pitchP);
-	mipmap.onePitchP[2] = 1;
-	mipmap.onePitchP[3] = sw::assert_cast<short>(pitchP);
-
-	mipmap.pitchP = sw::uint4(pitchP);
-	mipmap.sliceP = sw::uint4(sliceP);
-	mipmap.samplePitchP = sw::uint4(samplePitchP);
-	mipmap.sampleMax = sw::uint4(sampleMax);
-}
-
 void DescriptorSetLayout::WriteDescriptorSet(Device *device, DescriptorSet *dstSet, const VkDescriptorUpdateTemplateEntry &entry, const char *src)
 {
 	DescriptorSetLayout *dstLayout = dstSet->header.layout;
@@ -380,20 +341,7 @@ void DescriptorSetLayout::WriteDescriptorSet(Device *device, DescriptorSet *dstS
 			sampledImage[i].depth = 1;
 			sampledImage[i].mipLevels = 1;
 			sampledImage[i].sampleCount = 1;
-			sampledImage[i].texture.widthWidthHeightHeight = sw::float4(static_cast<float>(numElements), static_cast<float>(numElements), 1, 1);
-			sampledImage[i].texture.width = sw::float4(static_cast<float>(numElements));
-			sampledImage[i].texture.height = sw::float4(1);
-			sampledImage[i].texture.depth = sw::float4(1);
-
-			sw::Mipmap &mipmap = sampledImage[i].texture.mipmap[0];
-			mipmap.buffer = bufferView->getPointer();
-			mipmap.width[0] = mipmap.width[1] = mipmap.width[2] = mipmap.width[3] = numElements;
-			mipmap.height[0] = mipmap.height[1] = mipmap.height[2] = mipmap.height[3] = 1;
-			mipmap.depth[0] = mipmap.depth[1] = mipmap.depth[2] = mipmap.depth[3] = 1;
-			mipmap.pitchP.x = mipmap.pitchP.y = mipmap.pitchP.z = mipmap.pitchP.w = numElements;
-			mipmap.sliceP.x = mipmap.sliceP.y = mipmap.sliceP.z = mipmap.sliceP.w = 0;
-			mipmap.onePitchP[0] = mipmap.onePitchP[2] = 1;
-			mipmap.onePitchP[1] = mipmap.onePitchP[3] = 0;
+			sampledImage[i].texture = bufferView->getSampledTexture();
 		}
 	}
 	else if(entry.descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER ||
@@ -406,9 +354,6 @@ void DescriptorSetLayout::WriteDescriptorSet(Device *device, DescriptorSet *dstS
 			const VkDescriptorImageInfo *update = reinterpret_cast<const VkDescriptorImageInfo *>(src + entry.offset + entry.stride * i);
 
 			vk::ImageView *imageView = vk::Cast(update->imageView);
-			Format format = imageView->getFormat(ImageView::SAMPLING);
-
-			sw::Texture *texture = &sampledImage[i].texture;
 
 			if(entry.descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER)
 			{
@@ -423,6 +368,7 @@ void DescriptorSetLayout::WriteDescriptorSet(Device *device, DescriptorSet *dstS
 			const auto &extent = imageView->getMipLevelExtent(0);
 
 			sampledImage[i].imageViewId = imageView->id;
+			sampledImage[i].texture = imageView->getSampledTexture();
 			sampledImage[i].width = extent.width;
 			sampledImage[i].height = extent.height;
 			sampledImage[i].depth = imageView->getDepthOrLayerCount(0);
@@ -430,78 +376,7 @@ void DescriptorSetLayout::WriteDescriptorSet(Device *device, DescriptorSet *dstS
 			sampledImage[i].sampleCount = imageView->getSampleCount();
 			sampledImage[i].memoryOwner = imageView;
 
-			auto &subresourceRange = imageView->getSubresourceRange();
-
-			if(format.isYcbcrFormat())
-			{
-				ASSERT(subresourceRange.levelCount == 1);
-
-				// YCbCr images can only have one level, so we can store parameters for the
-				// different planes in the descriptor's mipmap levels instead.
-
-				const int level = 0;
-				VkOffset3D offset = { 0, 0, 0 };
-				texture->mipmap[0].buffer = imageView->getOffsetPointer(offset, VK_IMAGE_ASPECT_PLANE_0_BIT, level, 0, ImageView::SAMPLING);
-				texture->mipmap[1].buffer = imageView->getOffsetPointer(offset, VK_IMAGE_ASPECT_PLANE_1_BIT, level, 0, ImageView::SAMPLING);
-				if(format.getAspects() & VK_IMAGE_ASPECT_PLANE_2_BIT)
-				{
-					texture->mipmap[2].buffer = imageView->getOffsetPointer(offset, VK_IMAGE_ASPECT_PLANE_2_BIT, level, 0, ImageView::SAMPLING);
-				}
-
-				VkExtent2D extent = imageView->getMipLevelExtent(0);
-
-				uint32_t width = extent.width;
-				uint32_t height = extent.height;
-				uint32_t pitchP0 = imageView->rowPitchBytes(VK_IMAGE_ASPECT_PLANE_0_BIT, level, ImageView::SAMPLING) /
-				                   imageView->getFormat(VK_IMAGE_ASPECT_PLANE_0_BIT).bytes();
-
-				// Write plane 0 parameters to mipmap level 0.
-				WriteTextureLevelInfo(texture, 0, width, height, 1, pitchP0, 0, 0, 0);
-
-				// Plane 2, if present, has equal parameters to plane 1, so we use mipmap level 1 for both.
-				uint32_t pitchP1 = imageView->rowPitchBytes(VK_IMAGE_ASPECT_PLANE_1_BIT, level, ImageView::SAMPLING) /
-				                   imageView->getFormat(VK_IMAGE_ASPECT_PLANE_1_BIT).bytes();
-
-				WriteTextureLevelInfo(texture, 1, width / 2, height / 2, 1, pitchP1, 0, 0, 0);
-			}
-			else
-			{
-				for(int mipmapLevel = 0; mipmapLevel < sw::MIPMAP_LEVELS; mipmapLevel++)
-				{
-					int level = sw::clamp(mipmapLevel, 0, (int)subresourceRange.levelCount - 1);  // Level within the image view
-
-					VkImageAspectFlagBits aspect = static_cast<VkImageAspectFlagBits>(imageView->getSubresourceRange().aspectMask);
-					sw::Mipmap &mipmap = texture->mipmap[mipmapLevel];
-
-					if((imageView->getType() == VK_IMAGE_VIEW_TYPE_CUBE) ||
-					   (imageView->getType() == VK_IMAGE_VIEW_TYPE_CUBE_ARRAY))
-					{
-						// Obtain the pointer to the corner of the level including the border, for seamless sampling.
-						// This is taken into account in the sampling routine, which can't handle negative texel coordinates.
-						VkOffset3D offset = { -1, -1, 0 };
-						mipmap.buffer = imageView->getOffsetPointer(offset, aspect, level, 0, ImageView::SAMPLING);
-					}
-					else
-					{
-						VkOffset3D offset = { 0, 0, 0 };
-						mipmap.buffer = imageView->getOffsetPointer(offset, aspect, level, 0, ImageView::SAMPLING);
-					}
-
-					VkExtent2D extent = imageView->getMipLevelExtent(level);
-
-					uint32_t width = extent.width;
-					uint32_t height = extent.height;
-					uint32_t layerCount = imageView->getSubresourceRange().layerCount;
-					uint32_t depth = imageView->getDepthOrLayerCount(level);
-					uint32_t bytes = format.bytes();
-					uint32_t pitchP = imageView->rowPitchBytes(aspect, level, ImageView::SAMPLING) / bytes;
-					uint32_t sliceP = (layerCount > 1 ? imageView->layerPitchBytes(aspect, ImageView::SAMPLING) : imageView->slicePitchBytes(aspect, level, ImageView::SAMPLING)) / bytes;
-					uint32_t samplePitchP = imageView->getMipLevelSize(aspect, level, ImageView::SAMPLING) / bytes;
-					uint32_t sampleMax = imageView->getSampleCount() - 1;
-
-					WriteTextureLevelInfo(texture, mipmapLevel, width, height, depth, pitchP, sliceP, samplePitchP, sampleMax);
-				}
-			}
+			ASSERT(sampledImage[i].texture);
 		}
 	}
 	else if(entry.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE ||
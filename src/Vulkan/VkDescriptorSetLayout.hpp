@@ -40,8 +40,8 @@ struct alignas(16) SampledImageDescriptor : ImageDescriptor
 
 	uint32_t samplerId;
 
-	alignas(16) sw::Texture texture;
-	int width;  // Of base mip-level.
+	const sw::Texture *texture;  // Owned by the image or buffer view
+	int width;                   // Of base mip-level.
 	int height;
 	int depth;  // Layer/cube count for arrayed images
 	int mipLevels;
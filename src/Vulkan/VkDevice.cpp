@@ -25,9 +25,11 @@
 #include "Debug/Server.hpp"
 #include "Device/Blitter.hpp"
 #include "System/Debug.hpp"
+#include "System/Trace.hpp"
 
 #include <chrono>
 #include <climits>
+#include <cstdlib>
 #include <new>  // Must #include this to use "placement new"
 
 namespace {
@@ -154,8 +156,19 @@ Device::Device(const VkDeviceCreateInfo *pCreateInfo, void *mem, PhysicalDevice
 
 	// TODO(b/119409619): use an allocator here so we can control all memory allocations
 	blitter.reset(new sw::Blitter());
+
+	const sw::Configuration &config = sw::getConfiguration();
+	if(config.enableSpirvProfiling)
+	{
+		spirvProfiler.reset(new sw::SpirvProfiler(config));
+	}
 	samplingRoutineCache.reset(new SamplingRoutineCache());
 	samplerIndexer.reset(new SamplerIndexer());
+	if(config.spirvCacheSize > 0)
+	{
+		const char *spirvCacheDir = getenv("SWIFTSHADER_SPIRV_CACHE_DIR");
+		spirvCache.reset(new SpirvCache(config.spirvCacheSize, spirvCacheDir ? spirvCacheDir : config.spirvCacheDir));
+	}
 
 	const auto *deviceMemoryReportCreateInfo = GetExtendedStruct<VkDeviceDeviceMemoryReportCreateInfoEXT>(pCreateInfo->pNext, VK_STRUCTURE_TYPE_DEVICE_DEVICE_MEMORY_REPORT_CREATE_INFO_EXT);
 	if(deviceMemoryReportCreateInfo && deviceMemoryReportCreateInfo->pfnUserCallback != nullptr)
@@ -172,6 +185,8 @@ void Device::destroy(const VkAllocationCallbacks *pAllocator)
 	}
 
 	vk::freeHostMemory(queues, pAllocator);
+
+	sw::Trace::Flush();
 }
 
 size_t Device::ComputeRequiredAllocationSize(const VkDeviceCreateInfo *pCreateInfo)
@@ -17,8 +17,10 @@
 
 #include "VkImageView.hpp"
 #include "VkSampler.hpp"
+#include "VkSpirvCache.hpp"
 #include "Device/Blitter.hpp"
 #include "Pipeline/Constants.hpp"
+#include "Pipeline/SpirvProfiler.hpp"
 #include "Reactor/Routine.hpp"
 #include "System/LRUCache.hpp"
 
@@ -63,6 +65,9 @@ public:
 	void getRequirements(VkMemoryDedicatedRequirements *requirements) const;
 	const VkPhysicalDeviceFeatures &getEnabledFeatures() const { return enabledFeatures; }
 	sw::Blitter *getBlitter() const { return blitter.get(); }
+	sw::SpirvProfiler *getSpirvProfiler() const { return spirvProfiler.get(); }
+	SpirvCache *getSpirvCache() const { return spirvCache.get(); }  // Null if disabled.
+	marl::Scheduler *getScheduler() const { return scheduler.get(); }
 
 	void registerImageView(ImageView *imageView);
 	void unregisterImageView(ImageView *imageView);
@@ -171,6 +176,7 @@ private:
 	Queue *const queues = nullptr;
 	uint32_t queueCount = 0;
 	std::unique_ptr<sw::Blitter> blitter;
+	std::unique_ptr<sw::SpirvProfiler> spirvProfiler;
 	uint32_t enabledExtensionCount = 0;
 	typedef char ExtensionName[VK_MAX_EXTENSION_NAME_SIZE];
 	ExtensionName *extensions = nullptr;
@@ -179,6 +185,7 @@ private:
 	std::shared_ptr<marl::Scheduler> scheduler;
 	std::unique_ptr<SamplingRoutineCache> samplingRoutineCache;
 	std::unique_ptr<SamplerIndexer> samplerIndexer;
+	std::unique_ptr<SpirvCache> spirvCache;
 
 	marl::mutex imageViewSetMutex;
 	std::unordered_set<ImageView *> imageViewSet GUARDED_BY(imageViewSetMutex);
@@ -52,6 +52,7 @@ public:
 	std::vector<Format> getCompatibleFormats() const;
 
 	bool isCompressed() const;
+	bool isDecodedBySampler() const;
 	VkFormat getDecompressedFormat() const;
 	int blockWidth() const;
 	int blockHeight() const;
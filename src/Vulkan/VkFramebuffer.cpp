@@ -122,8 +122,14 @@ void Framebuffer::executeLoadOp(const RenderPass *renderPass, uint32_t clearValu
 			continue;
 		}
 
+		// Clears of the whole attachment are deferred until its rows are first written. Whatever
+		// hasn't been written by the end of the subpass gets cleared by resolveDeferredClears().
 		uint32_t viewMask = renderPass->isMultiView() ? renderPass->getAttachmentViewMask(i) : 0;
-		attachments[i]->clear(pClearValues[i], clearMask, renderArea, viewMask);
+		VkClearRect rect = { renderArea, 0, attachments[i]->getSubresourceRange().layerCount };
+		if(!attachments[i]->deferClear(pClearValues[i], clearMask, rect, viewMask))
+		{
+			attachments[i]->clear(pClearValues[i], clearMask, renderArea, viewMask);
+		}
 	}
 }
 
@@ -142,7 +148,10 @@ void Framebuffer::clearAttachment(const RenderPass *renderPass, uint32_t subpass
 			ASSERT(attachmentIndex < attachmentCount);
 			ImageView *imageView = attachments[attachmentIndex];
 
-			imageView->clear(attachment.clearValue, attachment.aspectMask, rect, viewMask);
+			if(!imageView->deferClear(attachment.clearValue, attachment.aspectMask, rect, viewMask))
+			{
+				imageView->clear(attachment.clearValue, attachment.aspectMask, rect, viewMask);
+			}
 		}
 	}
 	else if(attachment.aspectMask & (VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT))
@@ -154,7 +163,10 @@ void Framebuffer::clearAttachment(const RenderPass *renderPass, uint32_t subpass
 			ASSERT(attachmentIndex < attachmentCount);
 			ImageView *imageView = attachments[attachmentIndex];
 
-			imageView->clear(attachment.clearValue, attachment.aspectMask, rect, viewMask);
+			if(!imageView->deferClear(attachment.clearValue, attachment.aspectMask, rect, viewMask))
+			{
+				imageView->clear(attachment.clearValue, attachment.aspectMask, rect, viewMask);
+			}
 		}
 	}
 	else
@@ -172,6 +184,30 @@ ImageView *Framebuffer::getAttachment(uint32_t index) const
 	return attachments[index];
 }
 
+bool Framebuffer::hasDeferredClears() const
+{
+	for(uint32_t i = 0; i < attachmentCount; i++)
+	{
+		if(attachments[i] && attachments[i]->hasDeferredClears())
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void Framebuffer::resolveDeferredClears()
+{
+	for(uint32_t i = 0; i < attachmentCount; i++)
+	{
+		if(attachments[i] && attachments[i]->hasDeferredClears())
+		{
+			attachments[i]->resolveDeferredClears();
+		}
+	}
+}
+
 void Framebuffer::resolve(const RenderPass *renderPass, uint32_t subpassIndex)
 {
 	const auto &subpass = renderPass->getSubpass(subpassIndex);
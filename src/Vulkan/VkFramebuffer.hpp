@@ -35,6 +35,8 @@ public:
 	void setAttachment(ImageView *imageView, uint32_t index);
 	ImageView *getAttachment(uint32_t index) const;
 	void resolve(const RenderPass *renderPass, uint32_t subpassIndex);
+	bool hasDeferredClears() const;
+	void resolveDeferredClears();
 
 	const VkExtent2D &getExtent() const { return extent; }
 
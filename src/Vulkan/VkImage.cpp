@@ -24,6 +24,7 @@
 #include "Device/BC_Decoder.hpp"
 #include "Device/Blitter.hpp"
 #include "Device/ETC_Decoder.hpp"
+#include "System/Parallel.hpp"
 
 #ifdef __ANDROID__
 #	include <vndk/hardware_buffer.h>
@@ -31,6 +32,7 @@
 #	include "VkDeviceMemoryExternalAndroid.hpp"
 #endif
 
+#include <algorithm>
 #include <cstring>
 
 namespace {
@@ -181,6 +183,26 @@ VkFormat GetImageFormat(const VkImageCreateInfo *pCreateInfo)
 	return pCreateInfo->format;
 }
 
+bool IsDecodedBySampler(const vk::Format &format, VkImageCreateFlags flags)
+{
+	// Cube maps are sampled from a decompressed copy holding their seamless borders.
+	return format.isDecodedBySampler() && !(flags & VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT);
+}
+
+bool RequiresDecompressedImage(const VkImageCreateInfo *pCreateInfo)
+{
+	vk::Format format = pCreateInfo->format;
+	if(!format.isCompressed())
+	{
+		return false;
+	}
+
+	// Images sampled straight from their compressed blocks only need a
+	// decompressed copy when they may be the source of a blit.
+	return !IsDecodedBySampler(format, pCreateInfo->flags) ||
+	       (pCreateInfo->usage & VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+}
+
 }  // anonymous namespace
 
 namespace vk {
@@ -197,7 +219,7 @@ Image::Image(const VkImageCreateInfo *pCreateInfo, void *mem, Device *device)
     , tiling(pCreateInfo->tiling)
     , usage(pCreateInfo->usage)
 {
-	if(format.isCompressed())
+	if(RequiresDecompressedImage(pCreateInfo))
 	{
 		VkImageCreateInfo compressedImageCreateInfo = *pCreateInfo;
 		compressedImageCreateInfo.format = format.getDecompressedFormat();
@@ -221,7 +243,7 @@ void Image::destroy(const VkAllocationCallbacks *pAllocator)
 
 size_t Image::ComputeRequiredAllocationSize(const VkImageCreateInfo *pCreateInfo)
 {
-	return Format(pCreateInfo->format).isCompressed() ? sizeof(Image) : 0;
+	return RequiresDecompressedImage(pCreateInfo) ? sizeof(Image) : 0;
 }
 
 const VkMemoryRequirements Image::getMemoryRequirements() const
@@ -647,27 +669,67 @@ void Image::copy(const void *srcCopyMemory,
 
 	const uint32_t layerCount = imageSubresource.layerCount == VK_REMAINING_ARRAY_LAYERS ?
 		arrayLayers - imageSubresource.baseArrayLayer : imageSubresource.layerCount;
-	for(uint32_t i = 0; i < layerCount; i++)
+
+	// Merge rows, then slices, then layers into contiguous spans wherever
+	// both sides are tightly packed, so that large transfers reduce to a few
+	// big copies.
+	VkDeviceSize spanSize = copySize;
+	uint32_t spansPerSlice = imageExtent.height;
+	uint32_t slicesPerLayer = imageExtent.depth;
+	uint32_t layersPerSpan = 1;
+	if(srcRowPitchBytes == static_cast<int>(copySize) && dstRowPitchBytes == static_cast<int>(copySize))
 	{
-		const uint8_t *srcLayerMemory = srcMemory;
-		uint8_t *dstLayerMemory = dstMemory;
-		for(uint32_t z = 0; z < imageExtent.depth; z++)
+		spanSize *= imageExtent.height;
+		spansPerSlice = 1;
+
+		if(srcSlicePitchBytes == static_cast<int>(spanSize) && dstSlicePitchBytes == static_cast<int>(spanSize))
 		{
-			const uint8_t *srcSliceMemory = srcLayerMemory;
-			uint8_t *dstSliceMemory = dstLayerMemory;
-			for(uint32_t y = 0; y < imageExtent.height; y++)
+			spanSize *= imageExtent.depth;
+			slicesPerLayer = 1;
+
+			if(srcLayerSize == spanSize && dstLayerSize == spanSize)
 			{
-				ASSERT(((memoryIsSource ? dstSliceMemory : srcSliceMemory) + copySize) < end());
-				memcpy(dstSliceMemory, srcSliceMemory, copySize);
-				srcSliceMemory += srcRowPitchBytes;
-				dstSliceMemory += dstRowPitchBytes;
+				spanSize *= layerCount;
+				layersPerSpan = layerCount;
 			}
-			srcLayerMemory += srcSlicePitchBytes;
-			dstLayerMemory += dstSlicePitchBytes;
 		}
+	}
 
-		srcMemory += srcLayerSize;
-		dstMemory += dstLayerSize;
+	const uint32_t spansPerLayer = slicesPerLayer * spansPerSlice;
+	const uint32_t spanCount = (layerCount / layersPerSpan) * spansPerLayer;
+
+	if(spanCount == 1)
+	{
+		ASSERT(((memoryIsSource ? dstMemory : srcMemory) + spanSize) < end());
+		sw::parallelCopy(dstMemory, srcMemory, spanSize);
+	}
+	else
+	{
+		// Spans of all layers and slices are copied concurrently, in ranges
+		// large enough to amortize scheduling.
+		const bool streaming = spanCount * spanSize > sw::lastLevelCacheSize();
+		const uint32_t minSpans = static_cast<uint32_t>(std::max<VkDeviceSize>((64 * 1024) / spanSize, 1));
+		sw::parallelFor(spanCount, minSpans, [&](uint32_t firstSpan, uint32_t lastSpan) {
+			for(uint32_t span = firstSpan; span < lastSpan; span++)
+			{
+				uint32_t layer = span / spansPerLayer;
+				uint32_t z = (span % spansPerLayer) / spansPerSlice;
+				uint32_t y = span % spansPerSlice;
+
+				const uint8_t *srcSpanMemory = srcMemory + layer * srcLayerSize + z * srcSlicePitchBytes + y * srcRowPitchBytes;
+				uint8_t *dstSpanMemory = dstMemory + layer * dstLayerSize + z * dstSlicePitchBytes + y * dstRowPitchBytes;
+
+				ASSERT(((memoryIsSource ? dstSpanMemory : srcSpanMemory) + spanSize) < end());
+				if(streaming)
+				{
+					sw::copyStreaming(dstSpanMemory, srcSpanMemory, spanSize);
+				}
+				else
+				{
+					memcpy(dstSpanMemory, srcSpanMemory, spanSize);
+				}
+			}
+		});
 	}
 
 	if(memoryIsSource)
@@ -1028,18 +1090,31 @@ const Image *Image::getSampledImage(const vk::Format &imageViewFormat) const
 		ASSERT(format.bytesPerBlock() == imageViewFormat.bytesPerBlock());
 	}
 	// If the ImageView's format is compressed, then we do need to decompress the image so that
-	// it may be sampled properly by texture sampling functions, which don't support compressed
-	// textures. If the ImageView's format is NOT compressed, then we reinterpret cast the
+	// it may be sampled properly by texture sampling functions, unless they decode the format
+	// themselves. If the ImageView's format is NOT compressed, then we reinterpret cast the
 	// compressed image into the ImageView's format, so we must return the compressed image as is.
-	return (decompressedImage && isImageViewCompressed) ? decompressedImage : this;
+	return (decompressedImage && isImageViewCompressed && !isDecodedBySampler()) ? decompressedImage : this;
 }
 
 void Image::blitTo(Image *dstImage, const VkImageBlit2KHR &region, VkFilter filter) const
 {
-	prepareForSampling(ImageSubresourceRange(region.srcSubresource));
+	processDirtySubresources(ImageSubresourceRange(region.srcSubresource));
 	device->getBlitter()->blit(decompressedImage ? decompressedImage : this, dstImage, region, filter);
 }
 
+void Image::blitMipChain(const VkImageBlit2KHR *regions, uint32_t levelCount, VkFilter filter)
+{
+	if(!decompressedImage && device->getBlitter()->fastMipChain(this, regions, levelCount, filter))
+	{
+		return;
+	}
+
+	for(uint32_t i = 0; i < levelCount; i++)
+	{
+		blitTo(this, regions[i], filter);
+	}
+}
+
 void Image::copyTo(uint8_t *dst, unsigned int dstPitch) const
 {
 	device->getBlitter()->copy(this, dst, dstPitch);
@@ -1067,6 +1142,11 @@ uint32_t Image::getLastMipLevel(const VkImageSubresourceRange &subresourceRange)
 
 void Image::clear(const void *pixelData, VkFormat pixelFormat, const vk::Format &viewFormat, const VkImageSubresourceRange &subresourceRange, const VkRect2D *renderArea)
 {
+	if(hasDeferredClears())
+	{
+		resolveDeferredClears(subresourceRange);
+	}
+
 	device->getBlitter()->clear(pixelData, pixelFormat, this, viewFormat, subresourceRange, renderArea);
 }
 
@@ -1125,11 +1205,163 @@ void Image::clear(const VkClearValue &clearValue, const vk::Format &viewFormat,
 	}
 }
 
+bool Image::deferClear(const VkClearValue &clearValue, const vk::Format &viewFormat, const VkImageSubresourceRange &subresourceRange)
+{
+	// Pending rows are tracked per pair of rows of a single 2D plane, which
+	// matches how the rasterizer assigns rows to pixel clusters.
+	if((imageType != VK_IMAGE_TYPE_2D) || (subresourceRange.levelCount != 1) || requiresPreprocessing())
+	{
+		return false;
+	}
+
+	VkImageAspectFlagBits aspects[2] = {};
+	uint32_t texels[2] = {};
+	int aspectCount = 0;
+
+	for(VkImageAspectFlagBits aspect : { VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_ASPECT_DEPTH_BIT, VK_IMAGE_ASPECT_STENCIL_BIT })
+	{
+		if(!(subresourceRange.aspectMask & aspect))
+		{
+			continue;
+		}
+
+		const void *value = nullptr;
+		vk::Format clearFormat;
+		switch(aspect)
+		{
+		case VK_IMAGE_ASPECT_COLOR_BIT:
+			value = clearValue.color.float32;
+			clearFormat = viewFormat.getClearFormat();
+			break;
+		case VK_IMAGE_ASPECT_DEPTH_BIT:
+			value = &clearValue.depthStencil.depth;
+			clearFormat = VK_FORMAT_D32_SFLOAT;
+			break;
+		default:
+			value = &clearValue.depthStencil.stencil;
+			clearFormat = VK_FORMAT_S8_UINT;
+			break;
+		}
+
+		if(!sw::Blitter::GetClearTexel(value, clearFormat, viewFormat, aspect, texels[aspectCount]))
+		{
+			return false;
+		}
+
+		aspects[aspectCount++] = aspect;
+	}
+
+	uint32_t lastLayer = getLastLayerIndex(subresourceRange);
+	for(int i = 0; i < aspectCount; i++)
+	{
+		VkImageSubresource subresource = { static_cast<VkImageAspectFlags>(aspects[i]), subresourceRange.baseMipLevel, 0 };
+		uint32_t rowPairs = (getMipLevelExtent(aspects[i], subresource.mipLevel).height + 1) / 2;
+
+		for(subresource.arrayLayer = subresourceRange.baseArrayLayer; subresource.arrayLayer <= lastLayer; subresource.arrayLayer++)
+		{
+			auto clear = std::find_if(deferredClears.begin(), deferredClears.end(), [&](const DeferredClear &c) {
+				return Subresource(c.subresource) == Subresource(subresource);
+			});
+
+			if(clear == deferredClears.end())
+			{
+				clear = deferredClears.insert(deferredClears.end(), { subresource, 0, {} });
+			}
+
+			clear->texel = texels[i];
+			clear->pendingRowPairs.assign(rowPairs, 1);
+		}
+	}
+
+	return true;
+}
+
+void Image::clearDeferredRowPair(const VkImageSubresource &subresource, uint32_t texel, int rowPair) const
+{
+	VkImageAspectFlagBits aspect = static_cast<VkImageAspectFlagBits>(subresource.aspectMask);
+	VkExtent3D extent = getMipLevelExtent(aspect, subresource.mipLevel);
+	size_t rowPitch = rowPitchBytes(aspect, subresource.mipLevel);
+	size_t slicePitch = slicePitchBytes(aspect, subresource.mipLevel);
+
+	int32_t y = rowPair * 2;
+	uint32_t height = std::min(extent.height - y, 2u);
+	uint8_t *rows = static_cast<uint8_t *>(getTexelPointer({ 0, y, 0 }, subresource));
+
+	for(int sample = 0; sample < samples; sample++)
+	{
+		sw::Blitter::ClearRows(rows, getFormat(aspect).bytes(), texel, extent.width, height, rowPitch);
+		rows += slicePitch;
+	}
+}
+
+void Image::clearDeferredRows(const VkImageSubresource &subresource, int yMin, int yMax, int cluster, int clusterCount)
+{
+	auto clear = std::find_if(deferredClears.begin(), deferredClears.end(), [&](const DeferredClear &c) {
+		return Subresource(c.subresource) == Subresource(subresource);
+	});
+
+	if(clear == deferredClears.end())
+	{
+		return;
+	}
+
+	// Each cluster owns every clusterCount'th pair of rows, so clusters only
+	// ever touch their own pending flags.
+	std::vector<uint8_t> &pending = clear->pendingRowPairs;
+	int first = std::max(yMin, 0) / 2;
+	int last = std::min((yMax + 1) / 2, static_cast<int>(pending.size()));
+
+	for(int rowPair = first + (cluster - first % clusterCount + clusterCount) % clusterCount; rowPair < last; rowPair += clusterCount)
+	{
+		if(pending[rowPair])
+		{
+			clearDeferredRowPair(subresource, clear->texel, rowPair);
+			pending[rowPair] = 0;
+		}
+	}
+}
+
+void Image::resolveDeferredClears(const VkImageSubresourceRange &subresourceRange)
+{
+	uint32_t lastLayer = getLastLayerIndex(subresourceRange);
+	uint32_t lastMipLevel = getLastMipLevel(subresourceRange);
+
+	for(auto clear = deferredClears.begin(); clear != deferredClears.end();)
+	{
+		const VkImageSubresource &subresource = clear->subresource;
+		if(!(subresource.aspectMask & subresourceRange.aspectMask) ||
+		   (subresource.mipLevel < subresourceRange.baseMipLevel) || (subresource.mipLevel > lastMipLevel) ||
+		   (subresource.arrayLayer < subresourceRange.baseArrayLayer) || (subresource.arrayLayer > lastLayer))
+		{
+			clear++;
+			continue;
+		}
+
+		const std::vector<uint8_t> &pending = clear->pendingRowPairs;
+		sw::parallelFor(static_cast<uint32_t>(pending.size()), 64, [&](uint32_t firstRowPair, uint32_t lastRowPair) {
+			for(uint32_t rowPair = firstRowPair; rowPair < lastRowPair; rowPair++)
+			{
+				if(pending[rowPair])
+				{
+					clearDeferredRowPair(subresource, clear->texel, rowPair);
+				}
+			}
+		});
+
+		clear = deferredClears.erase(clear);
+	}
+}
+
 bool Image::requiresPreprocessing() const
 {
 	return isCubeCompatible() || decompressedImage;
 }
 
+bool Image::isDecodedBySampler() const
+{
+	return IsDecodedBySampler(format, flags);
+}
+
 void Image::contentsChanged(const VkImageSubresourceRange &subresourceRange, ContentsChangedContext contentsChangedContext)
 {
 	// If this function is called after (possibly) writing to this image from a shader,
@@ -1172,6 +1404,18 @@ void Image::contentsChanged(const VkImageSubresourceRange &subresourceRange, Con
 }
 
 void Image::prepareForSampling(const VkImageSubresourceRange &subresourceRange) const
+{
+	// The sampler reads these straight from the compressed blocks. Their
+	// decompressed copy, if any, is only brought up to date for blits.
+	if(isDecodedBySampler())
+	{
+		return;
+	}
+
+	processDirtySubresources(subresourceRange);
+}
+
+void Image::processDirtySubresources(const VkImageSubresourceRange &subresourceRange) const
 {
 	// If this isn't a cube or a compressed image, there's nothing to do
 	if(!requiresPreprocessing())
@@ -1229,13 +1473,27 @@ void Image::prepareForSampling(const VkImageSubresourceRange &subresourceRange)
 				auto it = dirtySubresources.find(subresource);
 				if(it != dirtySubresources.end())
 				{
-					// Since cube faces affect each other's borders, we update all 6 layers.
+					// Cube faces affect each other's borders, so gather the dirty faces of
+					// the whole cube and let the blitter update the edges they touch.
 
 					subresource.arrayLayer -= subresource.arrayLayer % 6;  // Round down to a multiple of 6.
 
 					if(subresource.arrayLayer + 5 <= lastLayer)
 					{
-						device->getBlitter()->updateBorders(decompressedImage ? decompressedImage : this, subresource);
+						uint32_t dirtyFaces = 0;
+						for(uint32_t face = 0; face < 6; face++)
+						{
+							VkImageSubresource faceSubresource = subresource;
+							faceSubresource.arrayLayer += face;
+
+							if((faceSubresource.arrayLayer >= subresourceRange.baseArrayLayer) &&
+							   (dirtySubresources.find(faceSubresource) != dirtySubresources.end()))
+							{
+								dirtyFaces |= 1u << face;
+							}
+						}
+
+						device->getBlitter()->updateBorders(decompressedImage ? decompressedImage : this, subresource, dirtyFaces);
 					}
 
 					subresource.arrayLayer += 5;  // Together with the loop increment, advances to the next cube.
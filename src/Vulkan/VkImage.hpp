@@ -25,6 +25,7 @@
 #endif
 
 #include <unordered_set>
+#include <vector>
 
 namespace vk {
 
@@ -68,6 +69,7 @@ public:
 	void copyFromMemory(const VkMemoryToImageCopyEXT &region);
 
 	void blitTo(Image *dstImage, const VkImageBlit2KHR &region, VkFilter filter) const;
+	void blitMipChain(const VkImageBlit2KHR *regions, uint32_t levelCount, VkFilter filter);
 	void copyTo(uint8_t *dst, unsigned int dstPitch) const;
 	void resolveTo(Image *dstImage, const VkImageResolve2KHR &region) const;
 	void resolveDepthStencilTo(const ImageView *src, ImageView *dst, VkResolveModeFlagBits depthResolveMode, VkResolveModeFlagBits stencilResolveMode) const;
@@ -75,6 +77,16 @@ public:
 	void clear(const VkClearColorValue &color, const VkImageSubresourceRange &subresourceRange);
 	void clear(const VkClearDepthStencilValue &color, const VkImageSubresourceRange &subresourceRange);
 
+	// Deferred clears record the clear value of whole subresources and leave the
+	// memory untouched until the rows are first written. Pending rows are cleared
+	// in pairs by the pixel cluster which owns them, and the remainder by
+	// resolveDeferredClears(). Deferred clears must not be recorded or resolved
+	// while draws to this image are in flight.
+	bool deferClear(const VkClearValue &clearValue, const vk::Format &viewFormat, const VkImageSubresourceRange &subresourceRange);
+	void clearDeferredRows(const VkImageSubresource &subresource, int yMin, int yMax, int cluster, int clusterCount);
+	void resolveDeferredClears(const VkImageSubresourceRange &subresourceRange);
+	bool hasDeferredClears() const { return !deferredClears.empty(); }
+
 	// Get the last layer and mipmap level, handling VK_REMAINING_ARRAY_LAYERS and
 	// VK_REMAINING_MIP_LEVELS, respectively. Note VkImageSubresourceLayers does not
 	// allow these symbolic values, so only VkImageSubresourceRange is accepted.
@@ -143,8 +155,11 @@ private:
 	VkExtent2D bufferExtentInBlocks(const VkExtent2D &extent, uint32_t rowLength, uint32_t imageHeight, const VkImageSubresourceLayers &imageSubresource, const VkOffset3D &imageOffset) const;
 	void clear(const void *pixelData, VkFormat pixelFormat, const vk::Format &viewFormat, const VkImageSubresourceRange &subresourceRange, const VkRect2D *renderArea);
 	int borderSize() const;
+	void clearDeferredRowPair(const VkImageSubresource &subresource, uint32_t texel, int rowPair) const;
 
 	bool requiresPreprocessing() const;
+	bool isDecodedBySampler() const;
+	void processDirtySubresources(const VkImageSubresourceRange &subresourceRange) const;
 	void decompress(const VkImageSubresource &subresource) const;
 	void decodeETC2(const VkImageSubresource &subresource) const;
 	void decodeBC(const VkImageSubresource &subresource) const;
@@ -168,6 +183,15 @@ private:
 
 	VkExternalMemoryHandleTypeFlags supportedExternalMemoryHandleTypes = (VkExternalMemoryHandleTypeFlags)0;
 
+	struct DeferredClear
+	{
+		VkImageSubresource subresource;
+		uint32_t texel;
+		std::vector<uint8_t> pendingRowPairs;  // Non-zero for each pair of rows not yet cleared
+	};
+
+	std::vector<DeferredClear> deferredClears;
+
 	// VkImageSubresource wrapper for use in unordered_set
 	class Subresource
 	{
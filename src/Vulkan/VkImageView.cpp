@@ -16,10 +16,12 @@
 
 #include "VkImage.hpp"
 #include "VkStructConversion.hpp"
+#include "Device/Sampler.hpp"
 #include "System/Math.hpp"
 #include "System/Types.hpp"
 
 #include <climits>
+#include <cstring>
 
 namespace vk {
 namespace {
@@ -133,17 +135,160 @@ ImageView::ImageView(const VkImageViewCreateInfo *pCreateInfo, void *mem, const
     , components(ResolveComponentMapping(pCreateInfo->components, format))
     , subresourceRange(ResolveRemainingLevelsLayers(pCreateInfo->subresourceRange, image))
     , ycbcrConversion(ycbcrConversion)
+    , sampledTexture(reinterpret_cast<sw::Texture *>(mem))
     , id(pCreateInfo)
 {
+	if(sampledTexture)
+	{
+		writeSampledTexture(sampledTexture);
+	}
+}
+
+bool ImageView::RequiresSampledTexture(const VkImageViewCreateInfo *pCreateInfo)
+{
+	const Image *image = vk::Cast(pCreateInfo->image);
+	VkImageAspectFlags aspectMask = pCreateInfo->subresourceRange.aspectMask;
+
+	// Views of both the depth and stencil aspects can only be used as attachments.
+	if(aspectMask == (VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT))
+	{
+		return false;
+	}
+
+	// The stencil aspect may have its own usage flags, which the image doesn't keep track of.
+	return (image->getUsage() & VK_IMAGE_USAGE_SAMPLED_BIT) || (aspectMask & VK_IMAGE_ASPECT_STENCIL_BIT);
 }
 
 size_t ImageView::ComputeRequiredAllocationSize(const VkImageViewCreateInfo *pCreateInfo)
 {
-	return 0;
+	return RequiresSampledTexture(pCreateInfo) ? sizeof(sw::Texture) : 0;
 }
 
 void ImageView::destroy(const VkAllocationCallbacks *pAllocator)
 {
+	if(sampledTexture)
+	{
+		vk::freeHostMemory(sampledTexture, pAllocator);
+	}
+}
+
+static void WriteTextureLevelInfo(sw::Texture *texture, uint32_t level, uint32_t width, uint32_t height, uint32_t depth, uint32_t pitchP, uint32_t sliceP, uint32_t samplePitchP, uint32_t sampleMax)
+{
+	if(level == 0)
+	{
+		texture->widthWidthHeightHeight[0] = static_cast<float>(width);
+		texture->widthWidthHeightHeight[1] = static_cast<float>(width);
+		texture->widthWidthHeightHeight[2] = static_cast<float>(height);
+		texture->widthWidthHeightHeight[3] = static_cast<float>(height);
+
+		texture->width = sw::float4(static_cast<float>(width));
+		texture->height = sw::float4(static_cast<float>(height));
+		texture->depth = sw::float4(static_cast<float>(depth));
+	}
+
+	sw::Mipmap &mipmap = texture->mipmap[level];
+
+	uint16_t halfTexelU = 0x8000 / width;
+	uint16_t halfTexelV = 0x8000 / height;
+	uint16_t halfTexelW = 0x8000 / depth;
+
+	mipmap.uHalf = sw::ushort4(halfTexelU);
+	mipmap.vHalf = sw::ushort4(halfTexelV);
+	mipmap.wHalf = sw::ushort4(halfTexelW);
+
+	mipmap.width = sw::uint4(width);
+	mipmap.height = sw::uint4(height);
+	mipmap.depth = sw::uint4(depth);
+
+	mipmap.onePitchP[0] = 1;
+	mipmap.onePitchP[1] = sw::assert_cast<short>(pitchP);
+	mipmap.onePitchP[2] = 1;
+	mipmap.onePitchP[3] = sw::assert_cast<short>(pitchP);
+
+	mipmap.pitchP = sw::uint4(pitchP);
+	mipmap.sliceP = sw::uint4(sliceP);
+	mipmap.samplePitchP = sw::uint4(samplePitchP);
+	mipmap.sampleMax = sw::uint4(sampleMax);
+}
+
+void ImageView::writeSampledTexture(sw::Texture *texture) const
+{
+	memset(texture, 0, sizeof(sw::Texture));
+
+	Format format = getFormat(SAMPLING);
+
+	if(format.isYcbcrFormat())
+	{
+		ASSERT(subresourceRange.levelCount == 1);
+
+		// YCbCr images can only have one level, so we can store parameters for the
+		// different planes in the texture's mipmap levels instead.
+
+		const int level = 0;
+		VkOffset3D offset = { 0, 0, 0 };
+		texture->mipmap[0].buffer = getOffsetPointer(offset, VK_IMAGE_ASPECT_PLANE_0_BIT, level, 0, SAMPLING);
+		texture->mipmap[1].buffer = getOffsetPointer(offset, VK_IMAGE_ASPECT_PLANE_1_BIT, level, 0, SAMPLING);
+		if(format.getAspects() & VK_IMAGE_ASPECT_PLANE_2_BIT)
+		{
+			texture->mipmap[2].buffer = getOffsetPointer(offset, VK_IMAGE_ASPECT_PLANE_2_BIT, level, 0, SAMPLING);
+		}
+
+		VkExtent2D extent = getMipLevelExtent(0);
+
+		uint32_t width = extent.width;
+		uint32_t height = extent.height;
+		uint32_t pitchP0 = rowPitchBytes(VK_IMAGE_ASPECT_PLANE_0_BIT, level, SAMPLING) /
+		                   getFormat(VK_IMAGE_ASPECT_PLANE_0_BIT).bytes();
+
+		// Write plane 0 parameters to mipmap level 0.
+		WriteTextureLevelInfo(texture, 0, width, height, 1, pitchP0, 0, 0, 0);
+
+		// Plane 2, if present, has equal parameters to plane 1, so we use mipmap level 1 for both.
+		uint32_t pitchP1 = rowPitchBytes(VK_IMAGE_ASPECT_PLANE_1_BIT, level, SAMPLING) /
+		                   getFormat(VK_IMAGE_ASPECT_PLANE_1_BIT).bytes();
+
+		WriteTextureLevelInfo(texture, 1, width / 2, height / 2, 1, pitchP1, 0, 0, 0);
+	}
+	else
+	{
+		VkImageAspectFlagBits aspect = static_cast<VkImageAspectFlagBits>(subresourceRange.aspectMask);
+
+		for(int mipmapLevel = 0; mipmapLevel < sw::MIPMAP_LEVELS; mipmapLevel++)
+		{
+			int level = sw::clamp(mipmapLevel, 0, (int)subresourceRange.levelCount - 1);  // Level within the image view
+
+			sw::Mipmap &mipmap = texture->mipmap[mipmapLevel];
+
+			if((viewType == VK_IMAGE_VIEW_TYPE_CUBE) ||
+			   (viewType == VK_IMAGE_VIEW_TYPE_CUBE_ARRAY))
+			{
+				// Obtain the pointer to the corner of the level including the border, for seamless sampling.
+				// This is taken into account in the sampling routine, which can't handle negative texel coordinates.
+				VkOffset3D offset = { -1, -1, 0 };
+				mipmap.buffer = getOffsetPointer(offset, aspect, level, 0, SAMPLING);
+			}
+			else
+			{
+				VkOffset3D offset = { 0, 0, 0 };
+				mipmap.buffer = getOffsetPointer(offset, aspect, level, 0, SAMPLING);
+			}
+
+			VkExtent2D extent = getMipLevelExtent(level);
+
+			uint32_t width = extent.width;
+			uint32_t height = extent.height;
+			uint32_t layerCount = subresourceRange.layerCount;
+			uint32_t depth = getDepthOrLayerCount(level);
+			// Formats decoded by the sampler are addressed in whole blocks.
+			uint32_t bytes = format.isCompressed() ? format.bytesPerBlock() : format.bytes();
+			uint32_t pitchP = rowPitchBytes(aspect, level, SAMPLING) / bytes;
+			uint32_t sliceP = (layerCount > 1 ? layerPitchBytes(aspect, SAMPLING) : slicePitchBytes(aspect, level, SAMPLING)) / bytes;
+			uint32_t samplePitchP = getMipLevelSize(aspect, level, SAMPLING) / bytes;
+			uint32_t sampleMax = getSampleCount() - 1;
+
+			WriteTextureLevelInfo(texture, mipmapLevel, width, height, depth, pitchP, sliceP, samplePitchP, sampleMax);
+		}
+	}
 }
 
 // Vulkan 1.2 Table 8. Image and image view parameter compatibility requirements
@@ -251,6 +396,48 @@ void ImageView::clearWithLayerMask(const VkClearValue &clearValue, VkImageAspect
 	}
 }
 
+bool ImageView::deferClear(const VkClearValue &clearValue, VkImageAspectFlags aspectMask, const VkClearRect &rect, uint32_t layerMask)
+{
+	ASSERT(imageTypesMatch(image->getImageType()));
+	ASSERT(format.isCompatible(image->getFormat()));
+
+	VkExtent2D extent = getMipLevelExtent(0, static_cast<VkImageAspectFlagBits>(aspectMask & -aspectMask));
+	if((rect.rect.offset.x != 0) || (rect.rect.offset.y != 0) ||
+	   (rect.rect.extent.width < extent.width) || (rect.rect.extent.height < extent.height))
+	{
+		return false;
+	}
+
+	VkImageSubresourceRange sr;
+	sr.aspectMask = aspectMask;
+	sr.baseMipLevel = subresourceRange.baseMipLevel;
+	sr.levelCount = 1;
+	sr.baseArrayLayer = rect.baseArrayLayer + subresourceRange.baseArrayLayer;
+	sr.layerCount = rect.layerCount;
+
+	if(layerMask == 0)
+	{
+		return image->deferClear(clearValue, format, sr);
+	}
+
+	// Whether a clear can be deferred doesn't depend on the layer, so
+	// either all of the layers are deferred or none of them are.
+	while(layerMask)
+	{
+		uint32_t layer = sw::log2i(layerMask);
+		layerMask &= ~(1 << layer);
+		sr.baseArrayLayer = layer + subresourceRange.baseArrayLayer;
+		sr.layerCount = 1;
+
+		if(!image->deferClear(clearValue, format, sr))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
 void ImageView::resolveSingleLayer(ImageView *resolveAttachment, int layer)
 {
 	if((subresourceRange.levelCount != 1) || (resolveAttachment->subresourceRange.levelCount != 1))
@@ -23,6 +23,12 @@
 
 #include <atomic>
 
+namespace sw {
+
+struct Texture;
+
+}  // namespace sw
+
 namespace vk {
 
 class SamplerYcbcrConversion;
@@ -102,6 +108,16 @@ public:
 	void resolve(ImageView *resolveAttachment, uint32_t layerMask);
 	void resolveDepthStencil(ImageView *resolveAttachment, VkResolveModeFlagBits depthResolveMode, VkResolveModeFlagBits stencilResolveMode);
 
+	// Records a clear covering the whole view, to be performed lazily by the pixel stage. Returns
+	// false when the clear can't be deferred, in which case clear() must be used instead.
+	bool deferClear(const VkClearValue &clearValue, VkImageAspectFlags aspectMask, const VkClearRect &rect, uint32_t layerMask);
+	void clearDeferredRows(VkImageAspectFlagBits aspect, uint32_t layer, int yMin, int yMax, int cluster, int clusterCount)
+	{
+		image->clearDeferredRows({ static_cast<VkImageAspectFlags>(aspect), subresourceRange.baseMipLevel, subresourceRange.baseArrayLayer + layer }, yMin, yMax, cluster, clusterCount);
+	}
+	void resolveDeferredClears() { image->resolveDeferredClears(subresourceRange); }
+	bool hasDeferredClears() const { return image->hasDeferredClears(); }
+
 	VkImageViewType getType() const { return viewType; }
 	Format getFormat(Usage usage = RAW) const;
 	Format getFormat(VkImageAspectFlagBits aspect) const { return image->getFormat(aspect); }
@@ -137,7 +153,13 @@ public:
 	const VkImageSubresourceRange &getSubresourceRange() const { return subresourceRange; }
 	size_t getSizeInBytes() const { return image->getSizeInBytes(subresourceRange); }
 
+	// Sampling parameters of all mip levels, computed once at creation and referenced by the
+	// sampled image descriptors of this view. Null if the image can't be sampled.
+	const sw::Texture *getSampledTexture() const { return sampledTexture; }
+
 private:
+	static bool RequiresSampledTexture(const VkImageViewCreateInfo *pCreateInfo);
+	void writeSampledTexture(sw::Texture *texture) const;
 	bool imageTypesMatch(VkImageType imageType) const;
 	const Image *getImage(Usage usage) const;
 	void clear(const VkClearValue &clearValues, VkImageAspectFlags aspectMask, const VkRect2D &renderArea);
@@ -154,6 +176,7 @@ private:
 	const VkImageSubresourceRange subresourceRange = {};
 
 	const vk::SamplerYcbcrConversion *ycbcrConversion = nullptr;
+	sw::Texture *const sampledTexture = nullptr;
 
 public:
 	const Identifier id;
@@ -901,7 +901,7 @@ void PhysicalDevice::getProperties(VkPhysicalDeviceMaintenance4Properties *prope
 template<typename T>
 static void getMultiviewProperties(T *properties)
 {
-	properties->maxMultiviewViewCount = 6;
+	properties->maxMultiviewViewCount = MAX_MULTIVIEW_VIEW_COUNT;
 	properties->maxMultiviewInstanceIndex = 1u << 27;
 }
 
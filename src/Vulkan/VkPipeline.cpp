@@ -20,39 +20,50 @@
 #include "VkPipelineLayout.hpp"
 #include "VkRenderPass.hpp"
 #include "VkShaderModule.hpp"
+#include "VkSpirvCache.hpp"
 #include "VkStringify.hpp"
 #include "Pipeline/ComputeProgram.hpp"
 #include "Pipeline/SpirvShader.hpp"
+#include "System/Trace.hpp"
 
+#include "marl/defer.h"
+#include "marl/scheduler.h"
 #include "marl/trace.h"
+#include "marl/waitgroup.h"
 
 #include "spirv-tools/optimizer.hpp"
 
 #include <iostream>
+#include <unordered_set>
 
 namespace {
 
+void consumeSpirvMessage(spv_message_level_t level, const char *source, const spv_position_t &position, const char *message)
+{
+	switch(level)
+	{
+	case SPV_MSG_FATAL: sw::warn("SPIR-V FATAL: %d:%d %s\n", int(position.line), int(position.column), message);
+	case SPV_MSG_INTERNAL_ERROR: sw::warn("SPIR-V INTERNAL_ERROR: %d:%d %s\n", int(position.line), int(position.column), message);
+	case SPV_MSG_ERROR: sw::warn("SPIR-V ERROR: %d:%d %s\n", int(position.line), int(position.column), message);
+	case SPV_MSG_WARNING: sw::warn("SPIR-V WARNING: %d:%d %s\n", int(position.line), int(position.column), message);
+	case SPV_MSG_INFO: sw::trace("SPIR-V INFO: %d:%d %s\n", int(position.line), int(position.column), message);
+	case SPV_MSG_DEBUG: sw::trace("SPIR-V DEBUG: %d:%d %s\n", int(position.line), int(position.column), message);
+	default: sw::trace("SPIR-V MESSAGE: %d:%d %s\n", int(position.line), int(position.column), message);
+	}
+}
+
 // optimizeSpirv() applies and freezes specializations into constants, and runs spirv-opt.
 sw::SpirvBinary optimizeSpirv(const vk::PipelineCache::SpirvBinaryKey &key)
 {
+	SW_TRACE_SCOPE("compile", "optimizeSpirv");
+
 	const sw::SpirvBinary &code = key.getBinary();
 	const VkSpecializationInfo *specializationInfo = key.getSpecializationInfo();
 	bool optimize = key.getOptimization();
 
 	spvtools::Optimizer opt{ vk::SPIRV_VERSION };
 
-	opt.SetMessageConsumer([](spv_message_level_t level, const char *source, const spv_position_t &position, const char *message) {
-		switch(level)
-		{
-		case SPV_MSG_FATAL: sw::warn("SPIR-V FATAL: %d:%d %s\n", int(position.line), int(position.column), message);
-		case SPV_MSG_INTERNAL_ERROR: sw::warn("SPIR-V INTERNAL_ERROR: %d:%d %s\n", int(position.line), int(position.column), message);
-		case SPV_MSG_ERROR: sw::warn("SPIR-V ERROR: %d:%d %s\n", int(position.line), int(position.column), message);
-		case SPV_MSG_WARNING: sw::warn("SPIR-V WARNING: %d:%d %s\n", int(position.line), int(position.column), message);
-		case SPV_MSG_INFO: sw::trace("SPIR-V INFO: %d:%d %s\n", int(position.line), int(position.column), message);
-		case SPV_MSG_DEBUG: sw::trace("SPIR-V DEBUG: %d:%d %s\n", int(position.line), int(position.column), message);
-		default: sw::trace("SPIR-V MESSAGE: %d:%d %s\n", int(position.line), int(position.column), message);
-		}
-	});
+	opt.SetMessageConsumer(consumeSpirvMessage);
 
 	// If the pipeline uses specialization, apply the specializations before freezing
 	if(specializationInfo)
@@ -112,6 +123,144 @@ sw::SpirvBinary optimizeSpirv(const vk::PipelineCache::SpirvBinaryKey &key)
 	return optimized;
 }
 
+// readsViewIndex() returns whether any instruction of the binary accesses a
+// variable decorated with the ViewIndex built-in.
+bool readsViewIndex(const sw::SpirvBinary &code)
+{
+	constexpr size_t headerSize = 5;
+
+	std::unordered_set<uint32_t> viewIndexVariables;
+	for(size_t i = headerSize; i < code.size(); i += code[i] >> spv::WordCountShift)
+	{
+		spv::Op opcode = static_cast<spv::Op>(code[i] & spv::OpCodeMask);
+		if(opcode == spv::OpDecorate && code[i + 2] == spv::DecorationBuiltIn && code[i + 3] == spv::BuiltInViewIndex)
+		{
+			viewIndexVariables.insert(code[i + 1]);
+		}
+	}
+
+	if(viewIndexVariables.empty())
+	{
+		return false;
+	}
+
+	for(size_t i = headerSize; i < code.size(); i += code[i] >> spv::WordCountShift)
+	{
+		uint32_t wordCount = code[i] >> spv::WordCountShift;
+		spv::Op opcode = static_cast<spv::Op>(code[i] & spv::OpCodeMask);
+		if(opcode == spv::OpDecorate || opcode == spv::OpName || opcode == spv::OpEntryPoint || opcode == spv::OpVariable)
+		{
+			continue;
+		}
+
+		for(uint32_t w = 1; w < wordCount; w++)
+		{
+			if(viewIndexVariables.count(code[i + w]) != 0)
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+// removeOutputs() returns the binary without stores to outputs other than the
+// given locations and built-ins, and without the code which only fed them.
+sw::SpirvBinary removeOutputs(const sw::SpirvBinary &code, std::unordered_set<uint32_t> liveLocations, std::unordered_set<uint32_t> liveBuiltins)
+{
+	spvtools::Optimizer opt{ vk::SPIRV_VERSION };
+	opt.SetMessageConsumer(consumeSpirvMessage);
+
+	opt.RegisterPass(spvtools::CreateEliminateDeadOutputStoresPass(&liveLocations, &liveBuiltins));
+	opt.RegisterPass(spvtools::CreateAggressiveDCEPass(false, true));
+
+	spvtools::OptimizerOptions optimizerOptions = {};
+	optimizerOptions.set_run_validator(false);
+
+	sw::SpirvBinary result;
+	if(!opt.Run(code.data(), code.size(), &result, optimizerOptions))
+	{
+		return {};
+	}
+
+	return result;
+}
+
+// extractPositionSpirv() returns a vertex shader which only computes the outputs
+// determining where primitives are rasterized. Multiview draws run it for each
+// view beyond the first, and take the other outputs from the first view. If any
+// other output depends on the view index, an empty binary is returned, and each
+// view must run the complete shader.
+sw::SpirvBinary extractPositionSpirv(const sw::SpirvBinary &code)
+{
+	SW_TRACE_SCOPE("compile", "extractPositionSpirv");
+
+	const std::unordered_set<uint32_t> positionBuiltins = {
+		spv::BuiltInPosition,
+		spv::BuiltInPointSize,
+		spv::BuiltInClipDistance,
+		spv::BuiltInCullDistance,
+	};
+
+	std::unordered_set<uint32_t> allLocations;
+	for(uint32_t location = 0; location < sw::MAX_INTERFACE_COMPONENTS / 4; location++)
+	{
+		allLocations.insert(location);
+	}
+
+	sw::SpirvBinary varyings = removeOutputs(code, allLocations, {});
+	if(varyings.empty() || readsViewIndex(varyings))
+	{
+		return {};
+	}
+
+	return removeOutputs(code, {}, positionBuiltins);
+}
+
+// getOrOptimizeSpirv() returns the optimized SPIR-V binary for the given key, taken from the
+// application's pipeline cache or the device's SPIR-V cache when either has it.
+sw::SpirvBinary getOrOptimizeSpirv(vk::Device *device, vk::PipelineCache *pipelineCache, const vk::PipelineCache::SpirvBinaryKey &key, bool &pipelineCacheHit)
+{
+	auto optimize = [&] {
+		if(vk::SpirvCache *spirvCache = device->getSpirvCache())
+		{
+			return spirvCache->getOrOptimize(key, [&] { return optimizeSpirv(key); });
+		}
+
+		return optimizeSpirv(key);
+	};
+
+	if(pipelineCache)
+	{
+		return pipelineCache->getOrOptimizeSpirv(key, optimize, [&] { pipelineCacheHit = true; });
+	}
+
+	sw::SpirvBinary spirv = optimize();
+
+	// If the pipeline does not have specialization constants, there's a 1-to-1 mapping between the unoptimized and optimized SPIR-V,
+	// so we should use a 1-to-1 mapping of the identifiers to avoid JIT routine recompiles.
+	if(!key.getSpecializationInfo())
+	{
+		spirv.mapOptimizedIdentifier(key.getBinary());
+	}
+
+	return spirv;
+}
+
+// isCompileRequired() returns whether obtaining the optimized SPIR-V binary for the given key
+// requires running spirv-opt.
+bool isCompileRequired(vk::Device *device, vk::PipelineCache *pipelineCache, const vk::PipelineCache::SpirvBinaryKey &key)
+{
+	if(pipelineCache && pipelineCache->contains(key))
+	{
+		return false;
+	}
+
+	vk::SpirvCache *spirvCache = device->getSpirvCache();
+	return !spirvCache || !spirvCache->contains(key);
+}
+
 std::shared_ptr<sw::ComputeProgram> createProgram(vk::Device *device, std::shared_ptr<sw::SpirvShader> shader, const vk::PipelineLayout *layout)
 {
 	MARL_SCOPED_EVENT("createProgram");
@@ -120,7 +269,6 @@ std::shared_ptr<sw::ComputeProgram> createProgram(vk::Device *device, std::share
 	// TODO(b/119409619): use allocator.
 	auto program = std::make_shared<sw::ComputeProgram>(device, shader, layout, descriptorSets);
 	program->generate();
-	program->finalize("ComputeProgram");
 
 	return program;
 }
@@ -351,6 +499,7 @@ GraphicsPipeline::GraphicsPipeline(const VkGraphicsPipelineCreateInfo *pCreateIn
 			if(library->state.hasPreRasterizationState())
 			{
 				vertexShader = library->vertexShader;
+				positionShader = library->positionShader;
 			}
 			if(library->state.hasFragmentState())
 			{
@@ -407,6 +556,7 @@ GraphicsPipeline::GraphicsPipeline(const VkGraphicsPipelineCreateInfo *pCreateIn
 void GraphicsPipeline::destroyPipeline(const VkAllocationCallbacks *pAllocator)
 {
 	vertexShader.reset();
+	positionShader.reset();
 	fragmentShader.reset();
 }
 
@@ -461,6 +611,32 @@ void GraphicsPipeline::getIndexBuffers(const vk::DynamicState &dynamicState, uin
 	indexBuffer.getIndexBuffers(topology, count, first, indexed, hasPrimitiveRestartEnable, indexBuffers);
 }
 
+uint32_t GraphicsPipeline::getDrawMergeGranularity(const vk::DynamicState &dynamicState) const
+{
+	const vk::VertexInputInterfaceState &vertexInputInterfaceState = state.getVertexInputInterfaceState();
+
+	// Restart indices realign list primitives, so a merged range could assemble different ones.
+	const bool hasPrimitiveRestartEnable = vertexInputInterfaceState.hasDynamicPrimitiveRestartEnable() ? dynamicState.primitiveRestartEnable : vertexInputInterfaceState.hasPrimitiveRestartEnable();
+	if(hasPrimitiveRestartEnable)
+	{
+		return 0;
+	}
+
+	// Strip and fan primitives depend on the start of the range.
+	const VkPrimitiveTopology topology = vertexInputInterfaceState.hasDynamicTopology() ? dynamicState.primitiveTopology : vertexInputInterfaceState.getTopology();
+	switch(topology)
+	{
+	case VK_PRIMITIVE_TOPOLOGY_POINT_LIST:
+		return 1;
+	case VK_PRIMITIVE_TOPOLOGY_LINE_LIST:
+		return 2;
+	case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST:
+		return 3;
+	default:
+		return 0;
+	}
+}
+
 bool GraphicsPipeline::preRasterizationContainsImageWrite() const
 {
 	return vertexShader.get() && vertexShader->containsImageWrite();
@@ -471,6 +647,22 @@ bool GraphicsPipeline::fragmentContainsImageWrite() const
 	return fragmentShader.get() && fragmentShader->containsImageWrite();
 }
 
+bool GraphicsPipeline::canShareVertexProcessingBetweenViews() const
+{
+	if(!vertexShader.get())
+	{
+		return false;
+	}
+
+	const auto &analysis = vertexShader->getAnalysis();
+	if(analysis.ContainsImageWrite || analysis.ContainsMemoryWrite)
+	{
+		return false;
+	}
+
+	return !vertexShader->hasBuiltinInput(spv::BuiltInViewIndex) || (positionShader.get() != nullptr);
+}
+
 void GraphicsPipeline::setShader(const VkShaderStageFlagBits &stage, const std::shared_ptr<sw::SpirvShader> spirvShader)
 {
 	switch(stage)
@@ -514,6 +706,29 @@ VkResult GraphicsPipeline::compileShaders(const VkAllocationCallbacks *pAllocato
 
 	const auto *inputAttachmentMapping = GetExtendedStruct<VkRenderingInputAttachmentIndexInfoKHR>(pCreateInfo->pNext, VK_STRUCTURE_TYPE_RENDERING_INPUT_ATTACHMENT_INDEX_INFO_KHR);
 
+	struct Stage
+	{
+		uint32_t stageIndex;
+		const VkPipelineShaderStageCreateInfo *stageInfo;
+		VkShaderModule tempModule;
+		std::unique_ptr<PipelineCache::SpirvBinaryKey> key;
+		sw::SpirvBinary spirv;
+		bool pipelineCacheHit;
+	};
+
+	std::vector<Stage> stages;
+	stages.reserve(pCreateInfo->stageCount);
+
+	auto destroyTempModules = [&] {
+		for(auto &stage : stages)
+		{
+			if(stage.tempModule != VK_NULL_HANDLE)
+			{
+				vk::destroy(stage.tempModule, nullptr);
+			}
+		}
+	};
+
 	for(uint32_t stageIndex = 0; stageIndex < pCreateInfo->stageCount; stageIndex++)
 	{
 		const VkPipelineShaderStageCreateInfo &stageInfo = pCreateInfo->pStages[stageIndex];
@@ -550,57 +765,101 @@ VkResult GraphicsPipeline::compileShaders(const VkAllocationCallbacks *pAllocato
 			VkResult createResult = vk::ShaderModule::Create(nullptr, moduleCreateInfo, &tempModule);
 			if(createResult != VK_SUCCESS)
 			{
+				destroyTempModules();
 				return createResult;
 			}
 
 			module = vk::Cast(tempModule);
 		}
 
-		const PipelineCache::SpirvBinaryKey key(module->getBinary(), stageInfo.pSpecializationInfo, robustBufferAccess, optimize);
+		auto key = std::make_unique<PipelineCache::SpirvBinaryKey>(module->getBinary(), stageInfo.pSpecializationInfo, robustBufferAccess, optimize);
+		stages.push_back({ stageIndex, &stageInfo, tempModule, std::move(key), {}, false });
 
 		if((pCreateInfo->flags & VK_PIPELINE_CREATE_FAIL_ON_PIPELINE_COMPILE_REQUIRED_BIT_EXT) &&
-		   (!pPipelineCache || !pPipelineCache->contains(key)))
+		   isCompileRequired(device, pPipelineCache, *stages.back().key))
 		{
+			destroyTempModules();
 			pipelineCreationFeedback.pipelineCreationError();
 			return VK_PIPELINE_COMPILE_REQUIRED_EXT;
 		}
+	}
 
-		sw::SpirvBinary spirv;
+	// Optimize the stages concurrently, so that pipeline creation takes as long as its
+	// most expensive stage rather than the sum of all of them. Cache lookups are cheap,
+	// so the first stage is handled by this thread while the others are scheduled.
+	if(stages.size() > 1)
+	{
+		marl::Scheduler *scheduler = device->getScheduler();
+		const bool bindScheduler = (marl::Scheduler::get() == nullptr);
+		if(bindScheduler)
+		{
+			scheduler->bind();
+		}
 
-		if(pPipelineCache)
+		marl::WaitGroup wg(static_cast<unsigned int>(stages.size() - 1));
+		for(size_t i = 1; i < stages.size(); i++)
 		{
-			auto onCacheMiss = [&] { return optimizeSpirv(key); };
-			auto onCacheHit = [&] { pipelineCreationFeedback.cacheHit(stageIndex); };
-			spirv = pPipelineCache->getOrOptimizeSpirv(key, onCacheMiss, onCacheHit);
+			Stage &stage = stages[i];
+			marl::schedule([this, &stage, pPipelineCache, wg] {
+				defer(wg.done());
+				stage.spirv = getOrOptimizeSpirv(device, pPipelineCache, *stage.key, stage.pipelineCacheHit);
+			});
 		}
-		else
+
+		stages[0].spirv = getOrOptimizeSpirv(device, pPipelineCache, *stages[0].key, stages[0].pipelineCacheHit);
+		wg.wait();
+
+		if(bindScheduler)
 		{
-			spirv = optimizeSpirv(key);
+			scheduler->unbind();
+		}
+	}
+	else if(stages.size() == 1)
+	{
+		stages[0].spirv = getOrOptimizeSpirv(device, pPipelineCache, *stages[0].key, stages[0].pipelineCacheHit);
+	}
 
-			// If the pipeline does not have specialization constants, there's a 1-to-1 mapping between the unoptimized and optimized SPIR-V,
-			// so we should use a 1-to-1 mapping of the identifiers to avoid JIT routine recompiles.
-			if(!key.getSpecializationInfo())
-			{
-				spirv.mapOptimizedIdentifier(key.getBinary());
-			}
+	for(auto &stage : stages)
+	{
+		const VkPipelineShaderStageCreateInfo &stageInfo = *stage.stageInfo;
+
+		if(stage.pipelineCacheHit)
+		{
+			pipelineCreationFeedback.cacheHit(stage.stageIndex);
 		}
 
 		const bool stageRobustBufferAccess = getPipelineStageRobustBufferAccess(stageInfo.pNext, device, robustBufferAccess);
 
 		// TODO(b/201798871): use allocator.
-		auto shader = std::make_shared<sw::SpirvShader>(stageInfo.stage, stageInfo.pName, spirv,
+		auto shader = std::make_shared<sw::SpirvShader>(stageInfo.stage, stageInfo.pName, stage.spirv,
 		                                                vk::Cast(pCreateInfo->renderPass), pCreateInfo->subpass, inputAttachmentMapping, stageRobustBufferAccess);
 
-		setShader(stageInfo.stage, shader);
+		if(auto *profiler = device->getSpirvProfiler())
+		{
+			shader->enableProfiling(profiler);
+		}
 
-		pipelineCreationFeedback.stageCreationEnds(stageIndex);
+		setShader(stageInfo.stage, shader);
 
-		if(tempModule != VK_NULL_HANDLE)
+		// Vertex shaders which read the view index, usually to select a view-projection
+		// matrix, only have to compute the position for the other views of a multiview draw.
+		const auto &analysis = shader->getAnalysis();
+		if(stageInfo.stage == VK_SHADER_STAGE_VERTEX_BIT && shader->hasBuiltinInput(spv::BuiltInViewIndex) &&
+		   !analysis.ContainsImageWrite && !analysis.ContainsMemoryWrite)
 		{
-			vk::destroy(tempModule, nullptr);
+			sw::SpirvBinary positionSpirv = extractPositionSpirv(stage.spirv);
+			if(!positionSpirv.empty())
+			{
+				positionShader = std::make_shared<sw::SpirvShader>(stageInfo.stage, stageInfo.pName, positionSpirv,
+				                                                   vk::Cast(pCreateInfo->renderPass), pCreateInfo->subpass, inputAttachmentMapping, stageRobustBufferAccess);
+			}
 		}
+
+		pipelineCreationFeedback.stageCreationEnds(stage.stageIndex);
 	}
 
+	destroyTempModules();
+
 	return VK_SUCCESS;
 }
 
@@ -654,30 +913,18 @@ VkResult ComputePipeline::compileShaders(const VkAllocationCallbacks *pAllocator
 	const PipelineCache::SpirvBinaryKey shaderKey(module->getBinary(), stage.pSpecializationInfo, robustBufferAccess, optimize);
 
 	if((pCreateInfo->flags & VK_PIPELINE_CREATE_FAIL_ON_PIPELINE_COMPILE_REQUIRED_BIT_EXT) &&
-	   (!pPipelineCache || !pPipelineCache->contains(shaderKey)))
+	   isCompileRequired(device, pPipelineCache, shaderKey))
 	{
 		pipelineCreationFeedback.pipelineCreationError();
 		return VK_PIPELINE_COMPILE_REQUIRED_EXT;
 	}
 
-	sw::SpirvBinary spirv;
+	bool pipelineCacheHit = false;
+	sw::SpirvBinary spirv = getOrOptimizeSpirv(device, pPipelineCache, shaderKey, pipelineCacheHit);
 
-	if(pPipelineCache)
+	if(pipelineCacheHit)
 	{
-		auto onCacheMiss = [&] { return optimizeSpirv(shaderKey); };
-		auto onCacheHit = [&] { pipelineCreationFeedback.cacheHit(0); };
-		spirv = pPipelineCache->getOrOptimizeSpirv(shaderKey, onCacheMiss, onCacheHit);
-	}
-	else
-	{
-		spirv = optimizeSpirv(shaderKey);
-
-		// If the pipeline does not have specialization constants, there's a 1-to-1 mapping between the unoptimized and optimized SPIR-V,
-		// so we should use a 1-to-1 mapping of the identifiers to avoid JIT routine recompiles.
-		if(!shaderKey.getSpecializationInfo())
-		{
-			spirv.mapOptimizedIdentifier(shaderKey.getBinary());
-		}
+		pipelineCreationFeedback.cacheHit(0);
 	}
 
 	const bool stageRobustBufferAccess = getPipelineStageRobustBufferAccess(stage.pNext, device, robustBufferAccess);
@@ -686,6 +933,11 @@ VkResult ComputePipeline::compileShaders(const VkAllocationCallbacks *pAllocator
 	shader = std::make_shared<sw::SpirvShader>(stage.stage, stage.pName, spirv,
 	                                           nullptr, 0, nullptr, stageRobustBufferAccess);
 
+	if(auto *profiler = device->getSpirvProfiler())
+	{
+		shader->enableProfiling(profiler);
+	}
+
 	const PipelineCache::ComputeProgramKey programKey(shader->getIdentifier(), layout->identifier);
 
 	if(pPipelineCache)
@@ -97,6 +97,10 @@ public:
 
 	void getIndexBuffers(const vk::DynamicState &dynamicState, uint32_t count, uint32_t first, bool indexed, std::vector<std::pair<uint32_t, void *>> *indexBuffers) const;
 
+	// Returns the number of vertices per primitive if consecutive draws can be
+	// merged into one, or 0 otherwise.
+	uint32_t getDrawMergeGranularity(const vk::DynamicState &dynamicState) const;
+
 	IndexBuffer &getIndexBuffer() { return indexBuffer; }
 	const IndexBuffer &getIndexBuffer() const { return indexBuffer; }
 	Attachments &getAttachments() { return attachments; }
@@ -107,11 +111,22 @@ public:
 	bool preRasterizationContainsImageWrite() const;
 	bool fragmentContainsImageWrite() const;
 
+	// Returns true if the views of a multiview draw can share vertex processing,
+	// because it has no side effects, and only the position shader's outputs
+	// depend on the view index.
+	bool canShareVertexProcessingBetweenViews() const;
+
 	const std::shared_ptr<sw::SpirvShader> getShader(const VkShaderStageFlagBits &stage) const;
 
+	// Returns the part of the vertex shader computing the position, for views of
+	// a multiview draw beyond the first, or null if the shader doesn't read the
+	// view index or its other outputs depend on it.
+	const sw::SpirvShader *getPositionShader() const { return positionShader.get(); }
+
 private:
 	void setShader(const VkShaderStageFlagBits &stage, const std::shared_ptr<sw::SpirvShader> spirvShader);
 	std::shared_ptr<sw::SpirvShader> vertexShader;
+	std::shared_ptr<sw::SpirvShader> positionShader;
 	std::shared_ptr<sw::SpirvShader> fragmentShader;
 
 	const GraphicsState state;
@@ -66,6 +66,7 @@ public:
 
 		const sw::SpirvBinary &getBinary() const { return spirv; }
 		const VkSpecializationInfo *getSpecializationInfo() const { return specializationInfo.get(); }
+		bool getRobustBufferAccess() const { return robustBufferAccess; }
 		bool getOptimization() const { return optimize; }
 
 	private:
@@ -81,6 +82,8 @@ public:
 	// getOrOptimizeSpirv() queries the cache for a shader with the given key.
 	// If one is found, it is returned, otherwise create() is called, the
 	// returned SPIR-V binary is added to the cache, and it is returned.
+	// The cache is not locked during create(), so that the stages of a
+	// pipeline can be optimized concurrently.
 	// CreateOnCacheMiss must be a function of the signature:
 	//     sw::ShaderBinary()
 	template<typename CreateOnCacheMiss, typename CacheHit>
@@ -158,18 +161,21 @@ inline bool PipelineCache::contains(const PipelineCache::SpirvBinaryKey &key)
 template<typename CreateOnCacheMiss, typename CacheHit>
 sw::SpirvBinary PipelineCache::getOrOptimizeSpirv(const PipelineCache::SpirvBinaryKey &key, CreateOnCacheMiss &&create, CacheHit &&cacheHit)
 {
-	marl::lock lock(spirvShadersMutex);
-
-	auto it = spirvShaders.find(key);
-	if(it != spirvShaders.end())
 	{
-		cacheHit();
-		return it->second;
+		marl::lock lock(spirvShadersMutex);
+
+		auto it = spirvShaders.find(key);
+		if(it != spirvShaders.end())
+		{
+			cacheHit();
+			return it->second;
+		}
 	}
 
 	sw::SpirvBinary outShader = create();
-	spirvShaders.emplace(key, outShader);
-	return outShader;
+
+	marl::lock lock(spirvShadersMutex);
+	return spirvShaders.emplace(key, outShader).first->second;
 }
 
 }  // namespace vk
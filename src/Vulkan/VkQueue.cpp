@@ -21,6 +21,7 @@
 #include "VkStructConversion.hpp"
 #include "VkTimelineSemaphore.hpp"
 #include "Device/Renderer.hpp"
+#include "System/Trace.hpp"
 #include "WSI/VkSwapchainKHR.hpp"
 
 #include "marl/defer.h"
@@ -70,6 +71,8 @@ VkResult Queue::submit(uint32_t submitCount, SubmitInfo *pSubmits, Fence *fence)
 
 void Queue::submitQueue(const Task &task)
 {
+	SW_TRACE_SCOPE("queue", "submit", { "submitCount", task.submitCount });
+
 	if(renderer == nullptr)
 	{
 		renderer.reset(new sw::Renderer(device));
@@ -80,6 +83,8 @@ void Queue::submitQueue(const Task &task)
 		SubmitInfo &submitInfo = task.pSubmits[i];
 		for(uint32_t j = 0; j < submitInfo.waitSemaphoreCount; j++)
 		{
+			SW_TRACE_SCOPE("queue", "waitSemaphore");
+
 			if(auto *sem = DynamicCast<TimelineSemaphore>(submitInfo.pWaitSemaphores[j]))
 			{
 				ASSERT(j < submitInfo.waitSemaphoreValueCount);
@@ -101,6 +106,7 @@ void Queue::submitQueue(const Task &task)
 			executionState.events = task.events.get();
 			for(uint32_t j = 0; j < submitInfo.commandBufferCount; j++)
 			{
+				SW_TRACE_SCOPE("queue", "commandBuffer", { "submit", i }, { "commandBuffer", j });
 				Cast(submitInfo.pCommandBuffers[j])->submit(executionState);
 			}
 		}
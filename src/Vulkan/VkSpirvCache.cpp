@@ -0,0 +1,302 @@
+// Copyright 2024 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "VkSpirvCache.hpp"
+
+#include "VkConfig.hpp"
+#include "System/Debug.hpp"
+
+#include "spirv-tools/libspirv.hpp"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+namespace {
+
+// Identifies files written by SpirvCache::store(). Must be changed whenever
+// the file layout or the optimization passes change.
+constexpr uint32_t kFileMagic = 0x53505643;  // 'SPVC'
+constexpr uint32_t kFileVersion = 2;
+
+// The header is followed by the build identifier, the key and the binary.
+struct FileHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t buildIdSize;
+	uint32_t keySize;
+	uint32_t wordCount;
+};
+
+// Identifies the SwiftShader and SPIRV-Tools builds that wrote a file.
+// Binaries optimized by other builds may have been produced by different
+// passes, so they are not reused even if kFileVersion wasn't changed.
+const std::string &GetBuildId()
+{
+	static const std::string buildId = std::string("SwiftShader " VERSION_STRING
+#if defined(SWIFTSHADER_COMMIT_HASH)
+	                                               " " SWIFTSHADER_COMMIT_HASH
+#endif
+	                                               ", ") +
+	                                   spvSoftwareVersionDetailsString();
+	return buildId;
+}
+
+// Validates a binary read back from disk, with the options shaders are
+// optimized with, so that a corrupted or tampered file is never compiled.
+bool Validate(const std::vector<uint32_t> &words)
+{
+	spvtools::SpirvTools core(vk::SPIRV_VERSION);
+	if(!core.IsValid())
+	{
+		return false;
+	}
+
+	spvtools::ValidatorOptions validatorOptions = {};
+	validatorOptions.SetScalarBlockLayout(true);            // VK_EXT_scalar_block_layout
+	validatorOptions.SetUniformBufferStandardLayout(true);  // VK_KHR_uniform_buffer_standard_layout
+	validatorOptions.SetAllowLocalSizeId(true);             // VK_KHR_maintenance4
+
+	return core.Validate(words.data(), words.size(), validatorOptions);
+}
+
+template<typename T>
+void Append(std::vector<uint8_t> &data, const T *values, size_t count)
+{
+	const uint8_t *bytes = reinterpret_cast<const uint8_t *>(values);
+	data.insert(data.end(), bytes, bytes + count * sizeof(T));
+}
+
+template<typename T>
+void Append(std::vector<uint8_t> &data, const T &value)
+{
+	Append(data, &value, 1);
+}
+
+}  // anonymous namespace
+
+namespace vk {
+
+SpirvCache::SpirvCache(size_t capacity, const std::string &directory)
+    : directory(directory)
+    , cache(capacity)
+{
+}
+
+std::size_t SpirvCache::KeyHash::operator()(const Key &key) const noexcept
+{
+	// 64-bit FNV-1a.
+	uint64_t hash = 0xCBF29CE484222325ull;
+	for(uint8_t byte : key)
+	{
+		hash = (hash ^ byte) * 0x100000001B3ull;
+	}
+	return static_cast<std::size_t>(hash);  // Truncates to 32-bits on 32-bit platforms.
+}
+
+SpirvCache::Key SpirvCache::Serialize(const PipelineCache::SpirvBinaryKey &key)
+{
+	const sw::SpirvBinary &binary = key.getBinary();
+	const VkSpecializationInfo *specializationInfo = key.getSpecializationInfo();
+
+	Key serialized;
+	serialized.reserve(binary.size() * sizeof(uint32_t) + 64);
+
+	Append(serialized, static_cast<uint32_t>(binary.size()));
+	Append(serialized, binary.data(), binary.size());
+	Append(serialized, static_cast<uint8_t>(key.getRobustBufferAccess()));
+	Append(serialized, static_cast<uint8_t>(key.getOptimization()));
+
+	if(specializationInfo)
+	{
+		Append(serialized, specializationInfo->mapEntryCount);
+		Append(serialized, specializationInfo->pMapEntries, specializationInfo->mapEntryCount);
+		Append(serialized, static_cast<uint64_t>(specializationInfo->dataSize));
+		Append(serialized, static_cast<const uint8_t *>(specializationInfo->pData), specializationInfo->dataSize);
+	}
+	else
+	{
+		Append(serialized, uint32_t(0));
+	}
+
+	return serialized;
+}
+
+bool SpirvCache::contains(const PipelineCache::SpirvBinaryKey &key)
+{
+	Key serialized = Serialize(key);
+
+	if(!lookup(serialized).empty())
+	{
+		return true;
+	}
+
+	// Binaries persisted by previous runs count as cached, so that pipelines
+	// created with VK_PIPELINE_CREATE_FAIL_ON_PIPELINE_COMPILE_REQUIRED_BIT
+	// succeed for them. Keep the loaded binary so it isn't read again.
+	sw::SpirvBinary binary = load(serialized);
+	if(binary.empty())
+	{
+		return false;
+	}
+
+	add(serialized, binary);
+
+	return true;
+}
+
+sw::SpirvBinary SpirvCache::lookup(const Key &key)
+{
+	marl::lock lock(mutex);
+
+	return cache.lookup(key);
+}
+
+sw::SpirvBinary SpirvCache::add(const Key &key, const sw::SpirvBinary &binary)
+{
+	marl::lock lock(mutex);
+
+	// Another thread may have optimized the same binary while the lock was
+	// released. Keep its result, so that all pipelines share one identifier.
+	sw::SpirvBinary existing = cache.lookup(key);
+	if(!existing.empty())
+	{
+		return existing;
+	}
+
+	cache.add(key, binary);
+
+	return binary;
+}
+
+std::string SpirvCache::getFilePath(const Key &key) const
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016" PRIx64 ".spv", static_cast<uint64_t>(KeyHash()(key)));
+
+	char lastChar = directory.back();
+	if(lastChar == '\\' || lastChar == '/')
+	{
+		return directory + name;
+	}
+	return directory + "/" + name;
+}
+
+sw::SpirvBinary SpirvCache::load(const Key &key) const
+{
+	if(directory.empty())
+	{
+		return {};
+	}
+
+	std::string path = getFilePath(key);
+	std::ifstream f{ path, std::ios::binary };
+	if(!f)
+	{
+		return {};
+	}
+
+	const std::string &buildId = GetBuildId();
+
+	FileHeader header = {};
+	f.read(reinterpret_cast<char *>(&header), sizeof(header));
+	if(!f || (header.magic != kFileMagic) || (header.version != kFileVersion) ||
+	   (header.buildIdSize != buildId.size()) || (header.keySize != key.size()) ||
+	   (header.wordCount == 0))
+	{
+		return {};
+	}
+
+	std::string storedBuildId(header.buildIdSize, '\0');
+	f.read(&storedBuildId[0], storedBuildId.size());
+	if(!f || (storedBuildId != buildId))
+	{
+		return {};
+	}
+
+	// The file name only holds a hash of the key, so compare the full key
+	// to rule out collisions.
+	Key storedKey(header.keySize);
+	f.read(reinterpret_cast<char *>(storedKey.data()), storedKey.size());
+	if(!f || (storedKey != key))
+	{
+		return {};
+	}
+
+	std::vector<uint32_t> words(header.wordCount);
+	f.read(reinterpret_cast<char *>(words.data()), words.size() * sizeof(uint32_t));
+	if(!f)
+	{
+		return {};
+	}
+	f.close();
+
+	if(!Validate(words))
+	{
+		sw::warn("Invalid SPIR-V cache file %s\n", path.c_str());
+		remove(path.c_str());
+		return {};
+	}
+
+	return sw::SpirvBinary(words.data(), header.wordCount);
+}
+
+void SpirvCache::store(const Key &key, const sw::SpirvBinary &binary) const
+{
+	if(directory.empty() || binary.empty())
+	{
+		return;
+	}
+
+	// Write to a temporary file first, so that concurrent readers, possibly
+	// from other processes, never observe a partially written binary.
+	std::string path = getFilePath(key);
+	std::string tempPath = path + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+
+	{
+		std::ofstream f{ tempPath, std::ios::binary | std::ios::trunc };
+		if(!f)
+		{
+			sw::warn("Error writing SPIR-V cache file %s: %s\n", tempPath.c_str(), strerror(errno));
+			return;
+		}
+
+		const std::string &buildId = GetBuildId();
+
+		FileHeader header = { kFileMagic, kFileVersion, static_cast<uint32_t>(buildId.size()), static_cast<uint32_t>(key.size()), static_cast<uint32_t>(binary.size()) };
+		f.write(reinterpret_cast<const char *>(&header), sizeof(header));
+		f.write(buildId.data(), buildId.size());
+		f.write(reinterpret_cast<const char *>(key.data()), key.size());
+		f.write(reinterpret_cast<const char *>(binary.data()), binary.size() * sizeof(uint32_t));
+
+		if(!f)
+		{
+			sw::warn("Error writing SPIR-V cache file %s: %s\n", tempPath.c_str(), strerror(errno));
+			f.close();
+			remove(tempPath.c_str());
+			return;
+		}
+	}
+
+	if(rename(tempPath.c_str(), path.c_str()) != 0)
+	{
+		remove(tempPath.c_str());
+	}
+}
+
+}  // namespace vk
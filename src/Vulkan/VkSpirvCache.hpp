@@ -0,0 +1,106 @@
+// Copyright 2024 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VK_SPIRV_CACHE_HPP_
+#define VK_SPIRV_CACHE_HPP_
+
+#include "VkPipelineCache.hpp"
+#include "Pipeline/SpirvBinary.hpp"
+#include "System/LRUCache.hpp"
+
+#include "marl/mutex.h"
+#include "marl/tsa.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vk {
+
+// SpirvCache is a device-wide cache of optimized SPIR-V binaries. Entries are
+// addressed by the contents of the unoptimized binary along with the
+// specialization and options it is optimized with, so all pipelines of a
+// device share them, regardless of the VkPipelineCache they are created with.
+//
+// When given a directory, optimized binaries are also written to it, and read
+// back on a miss, so that they persist across runs. Files written by another
+// build of SwiftShader or SPIRV-Tools are ignored, and binaries read back are
+// validated before use.
+class SpirvCache
+{
+public:
+	SpirvCache(size_t capacity, const std::string &directory);
+
+	// contains() queries whether the cache, or its directory, contains a binary
+	// for the given key.
+	bool contains(const PipelineCache::SpirvBinaryKey &key);
+
+	// getOrOptimize() queries the cache for a binary with the given key.
+	// If one is found, it is returned, otherwise optimize() is called, and the
+	// returned SPIR-V binary is added to the cache and returned. The cache is
+	// not locked while optimizing, so concurrent misses on different keys are
+	// optimized in parallel.
+	// Function must be a function of the signature:
+	//     sw::SpirvBinary()
+	template<typename Function>
+	sw::SpirvBinary getOrOptimize(const PipelineCache::SpirvBinaryKey &key, Function &&optimize);
+
+private:
+	// Serialized contents of a PipelineCache::SpirvBinaryKey.
+	using Key = std::vector<uint8_t>;
+
+	struct KeyHash
+	{
+		std::size_t operator()(const Key &key) const noexcept;
+	};
+
+	static Key Serialize(const PipelineCache::SpirvBinaryKey &key);
+
+	sw::SpirvBinary lookup(const Key &key);
+	sw::SpirvBinary add(const Key &key, const sw::SpirvBinary &binary);
+
+	std::string getFilePath(const Key &key) const;
+	sw::SpirvBinary load(const Key &key) const;
+	void store(const Key &key, const sw::SpirvBinary &binary) const;
+
+	const std::string directory;
+
+	marl::mutex mutex;
+	sw::LRUCache<Key, sw::SpirvBinary, KeyHash> cache GUARDED_BY(mutex);
+};
+
+template<typename Function>
+sw::SpirvBinary SpirvCache::getOrOptimize(const PipelineCache::SpirvBinaryKey &key, Function &&optimize)
+{
+	Key serialized = Serialize(key);
+
+	sw::SpirvBinary binary = lookup(serialized);
+	if(!binary.empty())
+	{
+		return binary;
+	}
+
+	binary = load(serialized);
+	if(binary.empty())
+	{
+		binary = optimize();
+		store(serialized, binary);
+	}
+
+	return add(serialized, binary);
+}
+
+}  // namespace vk
+
+#endif  // VK_SPIRV_CACHE_HPP_
@@ -49,6 +49,7 @@
 #include "System/CPUID.hpp"
 #include "System/Debug.hpp"
 #include "System/SwiftConfig.hpp"
+#include "System/Trace.hpp"
 #include "WSI/HeadlessSurfaceKHR.hpp"
 #include "WSI/VkSwapchainKHR.hpp"
 
@@ -143,6 +144,7 @@ void initializeLibrary()
 #if defined(__ANDROID__) && defined(ENABLE_BUILD_VERSION_OUTPUT)
 		logBuildVersionInformation();
 #endif  // __ANDROID__ && ENABLE_BUILD_VERSION_OUTPUT
+		sw::Trace::Initialize(sw::getConfiguration());
 		return true;
 	}();
 	(void)doOnce;
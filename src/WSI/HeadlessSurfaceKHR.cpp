@@ -14,10 +14,31 @@
 
 #include "HeadlessSurfaceKHR.hpp"
 
+#include "System/Debug.hpp"
+#include "System/Math.hpp"
+#include "System/SwiftConfig.hpp"
+#include "Vulkan/VkConfig.hpp"
+#include "Vulkan/VkImage.hpp"
+
+#if defined(__linux__) || defined(__ANDROID__)
+#	include <errno.h>
+#	include <fcntl.h>
+#	include <stdlib.h>
+#	include <string.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <string>
+
 namespace vk {
 
 HeadlessSurfaceKHR::HeadlessSurfaceKHR(const VkHeadlessSurfaceCreateInfoEXT *pCreateInfo, void *mem)
 {
+#if defined(__linux__) || defined(__ANDROID__)
+	openSharedMemory();
+#endif
 }
 
 size_t HeadlessSurfaceKHR::ComputeRequiredAllocationSize(const VkHeadlessSurfaceCreateInfoEXT *pCreateInfo)
@@ -27,6 +48,14 @@ size_t HeadlessSurfaceKHR::ComputeRequiredAllocationSize(const VkHeadlessSurface
 
 void HeadlessSurfaceKHR::destroySurface(const VkAllocationCallbacks *pAllocator)
 {
+#if defined(__linux__) || defined(__ANDROID__)
+	if(header)
+	{
+		memfd.unmap(header, headerSize);
+		header = nullptr;
+	}
+	memfd.close();
+#endif
 }
 
 VkResult HeadlessSurfaceKHR::getSurfaceCapabilities(const void *pSurfaceInfoPNext, VkSurfaceCapabilitiesKHR *pSurfaceCapabilities, void *pSurfaceCapabilitiesPNext) const
@@ -39,6 +68,166 @@ VkResult HeadlessSurfaceKHR::getSurfaceCapabilities(const void *pSurfaceInfoPNex
 	return VK_SUCCESS;
 }
 
+#if defined(__linux__) || defined(__ANDROID__)
+void HeadlessSurfaceKHR::openSharedMemory()
+{
+	int fd = -1;
+	std::string path = sw::getConfiguration().headlessSharedMemoryPath;
+
+	if(const char *fdString = getenv("SWIFTSHADER_HEADLESS_SHM_FD"))
+	{
+		fd = ::fcntl(atoi(fdString), F_DUPFD_CLOEXEC, 0);
+		if(fd < 0)
+		{
+			sw::warn("Invalid SWIFTSHADER_HEADLESS_SHM_FD %s: %s\n", fdString, strerror(errno));
+			return;
+		}
+	}
+	else
+	{
+		if(const char *pathString = getenv("SWIFTSHADER_HEADLESS_SHM_PATH"))
+		{
+			path = pathString;
+		}
+
+		if(path.empty())
+		{
+			return;
+		}
+
+		fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+		if(fd < 0)
+		{
+			sw::warn("Error opening headless shared memory %s: %s\n", path.c_str(), strerror(errno));
+			return;
+		}
+	}
+
+	memfd.importFd(fd);
+
+	// Slots are mapped individually, so they must be aligned to the page size
+	// as well as to the host pointer import alignment.
+	pageSize = std::max<size_t>(::sysconf(_SC_PAGESIZE), static_cast<size_t>(vk::MIN_IMPORTED_HOST_POINTER_ALIGNMENT));
+	headerSize = sw::align(sizeof(HeadlessFrameHeader), static_cast<unsigned int>(pageSize));
+
+	struct stat info = {};
+	if(::fstat(fd, &info) < 0)
+	{
+		sw::warn("Error querying headless shared memory: %s\n", strerror(errno));
+		memfd.close();
+		return;
+	}
+
+	// A region smaller than the header has just been created.
+	bool created = static_cast<size_t>(info.st_size) < headerSize;
+	if(created && ::ftruncate(fd, headerSize) < 0)
+	{
+		sw::warn("Error resizing headless shared memory: %s\n", strerror(errno));
+		memfd.close();
+		return;
+	}
+
+	header = static_cast<HeadlessFrameHeader *>(memfd.mapReadWrite(0, headerSize));
+	if(!header)
+	{
+		sw::warn("Error mapping headless shared memory: %s\n", strerror(errno));
+		memfd.close();
+		return;
+	}
+
+	// Only initialize the header of a new region, or one from an incompatible
+	// version, so that reopening a region doesn't wipe the state a consumer
+	// is reading. Slots allocated before are kept and reused.
+	if(created || header->magic != HeadlessFrameHeader::Magic || header->version != HeadlessFrameHeader::Version)
+	{
+		memset(static_cast<void *>(header), 0, sizeof(HeadlessFrameHeader));
+		header->magic = HeadlessFrameHeader::Magic;
+		header->version = HeadlessFrameHeader::Version;
+		regionSize = headerSize;
+		return;
+	}
+
+	regionSize = std::max(headerSize, static_cast<size_t>(info.st_size));
+	for(const HeadlessFrameHeader::Slot &slot : header->slots)
+	{
+		regionSize = std::max(regionSize, static_cast<size_t>(slot.offset + slot.size));
+	}
+}
+
+void *HeadlessSurfaceKHR::allocateImageMemory(PresentImage *image, const VkMemoryAllocateInfo &allocateInfo)
+{
+	if(!header)
+	{
+		return nullptr;
+	}
+
+	size_t size = sw::align(static_cast<size_t>(allocateInfo.allocationSize), static_cast<unsigned int>(pageSize));
+
+	// Reuse the first free slot large enough, or else append a new one.
+	uint32_t index = HeadlessFrameHeader::MaxSlots;
+	for(uint32_t i = 0; i < HeadlessFrameHeader::MaxSlots; i++)
+	{
+		const HeadlessFrameHeader::Slot &slot = header->slots[i];
+		if(!slotMappings[i].image && (slot.size == 0 || slot.size >= size))
+		{
+			index = i;
+			break;
+		}
+	}
+
+	if(index == HeadlessFrameHeader::MaxSlots)
+	{
+		sw::warn("Out of headless shared memory slots\n");
+		return nullptr;
+	}
+
+	HeadlessFrameHeader::Slot &slot = header->slots[index];
+	if(slot.size == 0)
+	{
+		if(::ftruncate(memfd.fd(), regionSize + size) < 0)
+		{
+			sw::warn("Error resizing headless shared memory: %s\n", strerror(errno));
+			return nullptr;
+		}
+
+		slot.offset = regionSize;
+		slot.size = size;
+		regionSize += size;
+	}
+
+	void *memory = memfd.mapReadWrite(slot.offset, slot.size);
+	if(!memory)
+	{
+		sw::warn("Error mapping headless shared memory: %s\n", strerror(errno));
+		return nullptr;
+	}
+
+	const Image *vkImage = image->getImage();
+	slot.width = vkImage->getExtent().width;
+	slot.height = vkImage->getExtent().height;
+	slot.rowPitch = vkImage->rowPitchBytes(VK_IMAGE_ASPECT_COLOR_BIT, 0);
+	slot.format = vkImage->getFormat();
+	slot.presentIndex.store(0, std::memory_order_relaxed);
+
+	slotMappings[index] = { image, memory };
+
+	return memory;
+}
+
+void HeadlessSurfaceKHR::releaseImageMemory(PresentImage *image)
+{
+	for(uint32_t i = 0; i < HeadlessFrameHeader::MaxSlots; i++)
+	{
+		if(slotMappings[i].image == image)
+		{
+			memfd.unmap(slotMappings[i].memory, header->slots[i].size);
+			slotMappings[i] = {};
+			return;
+		}
+	}
+}
+#endif
+
 void HeadlessSurfaceKHR::attachImage(PresentImage *image)
 {
 }
@@ -49,6 +238,22 @@ void HeadlessSurfaceKHR::detachImage(PresentImage *image)
 
 VkResult HeadlessSurfaceKHR::present(PresentImage *image)
 {
+#if defined(__linux__) || defined(__ANDROID__)
+	for(uint32_t i = 0; header && i < HeadlessFrameHeader::MaxSlots; i++)
+	{
+		if(slotMappings[i].image == image)
+		{
+			// The image was rendered to in place, so presenting only needs to
+			// publish which slot holds the latest frame.
+			uint64_t presentIndex = header->presentCount.load(std::memory_order_relaxed) + 1;
+			header->slots[i].presentIndex.store(presentIndex, std::memory_order_relaxed);
+			header->latestSlot.store(i, std::memory_order_relaxed);
+			header->presentCount.store(presentIndex, std::memory_order_release);
+			break;
+		}
+	}
+#endif
+
 	return VK_SUCCESS;
 }
 
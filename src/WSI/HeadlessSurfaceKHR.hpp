@@ -17,8 +17,57 @@
 
 #include "VkSurfaceKHR.hpp"
 
+#if defined(__linux__) || defined(__ANDROID__)
+#	include "System/Linux/MemFd.hpp"
+#endif
+
+#include <atomic>
+
 namespace vk {
 
+// Layout of the shared memory region that headless swapchain images are
+// allocated in, when one is configured. The header is at offset 0 and each
+// swapchain image occupies a page aligned slot after it, which is rendered
+// into directly.
+//
+// On present, the slot's presentIndex and latestSlot are updated, then
+// presentCount is incremented with release semantics. A consumer which loads
+// presentCount with acquire semantics and finds slots[latestSlot].presentIndex
+// equal to it can read the frame without further synchronization. Slots are
+// rendered into again once the application reacquires their image, so a
+// consumer that needs a stable copy should check that presentIndex is
+// unchanged after copying.
+//
+// A region has a single owner: at most one surface, in any process, may
+// render into it at a time. The header is only initialized when the region
+// is created, or holds an incompatible version, so surfaces created later
+// take over the existing slots without disturbing a consumer. Concurrent
+// surfaces on the same region would render into the same slots.
+struct HeadlessFrameHeader
+{
+	static constexpr uint32_t Magic = 0x52465753;  // "SWFR"
+	static constexpr uint32_t Version = 1;
+	static constexpr uint32_t MaxSlots = 16;
+
+	struct Slot
+	{
+		uint64_t offset;  // From the start of the region.
+		uint64_t size;    // Zero for slots never allocated.
+		uint32_t width;
+		uint32_t height;
+		uint32_t rowPitch;  // In bytes.
+		uint32_t format;    // VkFormat
+		std::atomic<uint64_t> presentIndex;
+	};
+
+	uint32_t magic;
+	uint32_t version;
+	std::atomic<uint64_t> presentCount;
+	std::atomic<uint32_t> latestSlot;
+	uint32_t padding;
+	Slot slots[MaxSlots];
+};
+
 class HeadlessSurfaceKHR : public SurfaceKHR, public ObjectBase<HeadlessSurfaceKHR, VkSurfaceKHR>
 {
 public:
@@ -28,9 +77,31 @@ public:
 
 	void destroySurface(const VkAllocationCallbacks *pAllocator) override;
 	VkResult getSurfaceCapabilities(const void *pSurfaceInfoPNext, VkSurfaceCapabilitiesKHR *pSurfaceCapabilities, void *pSurfaceCapabilitiesPNext) const override;
+#if defined(__linux__) || defined(__ANDROID__)
+	void *allocateImageMemory(PresentImage *image, const VkMemoryAllocateInfo &allocateInfo) override;
+	void releaseImageMemory(PresentImage *image) override;
+#endif
 	void attachImage(PresentImage *image) override;
 	void detachImage(PresentImage *image) override;
 	VkResult present(PresentImage *image) override;
+
+#if defined(__linux__) || defined(__ANDROID__)
+private:
+	void openSharedMemory();
+
+	LinuxMemFd memfd;
+	size_t pageSize = 0;
+	size_t headerSize = 0;
+	size_t regionSize = 0;
+	HeadlessFrameHeader *header = nullptr;
+
+	struct SlotMapping
+	{
+		PresentImage *image;
+		void *memory;
+	};
+	SlotMapping slotMappings[HeadlessFrameHeader::MaxSlots] = {};
+#endif
 };
 
 }  // namespace vk
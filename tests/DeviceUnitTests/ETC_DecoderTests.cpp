@@ -0,0 +1,135 @@
+// Copyright 2024 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ETC_ReferenceDecoder.hpp"
+
+#include "marl/scheduler.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+struct ETCFormat
+{
+	const char *name;
+	ETC_Decoder::InputType inputType;
+	int blockBytes;
+	int texelBytes;
+};
+
+const ETCFormat formats[] = {
+	{ "R11", ETC_Decoder::ETC_R_UNSIGNED, 8, 2 },
+	{ "R11_SNORM", ETC_Decoder::ETC_R_SIGNED, 8, 2 },
+	{ "RG11", ETC_Decoder::ETC_RG_UNSIGNED, 16, 4 },
+	{ "RG11_SNORM", ETC_Decoder::ETC_RG_SIGNED, 16, 4 },
+	{ "RGB8", ETC_Decoder::ETC_RGB, 8, 4 },
+	{ "RGB8A1", ETC_Decoder::ETC_RGB_PUNCHTHROUGH_ALPHA, 8, 4 },
+	{ "RGBA8", ETC_Decoder::ETC_RGBA, 16, 4 },
+};
+
+struct ETCDecoderParams
+{
+	const ETCFormat *format;
+	int width;
+	int height;
+	int workerThreads;
+};
+
+std::ostream &operator<<(std::ostream &os, const ETCDecoderParams &params)
+{
+	return os << params.format->name << ", " << params.width << "x" << params.height
+	          << ", worker threads: " << params.workerThreads;
+}
+
+std::vector<ETCDecoderParams> allParams()
+{
+	// Sizes cover single partial blocks, partial edge blocks on either side,
+	// and images large enough for rows of blocks to be decoded in parallel.
+	const int sizes[][2] = { { 1, 1 }, { 3, 2 }, { 4, 4 }, { 13, 7 }, { 16, 16 }, { 258, 141 } };
+
+	std::vector<ETCDecoderParams> params;
+	for(const ETCFormat &format : formats)
+	{
+		for(const auto &size : sizes)
+		{
+			for(int workerThreads : { 0, 4 })
+			{
+				params.push_back({ &format, size[0], size[1], workerThreads });
+			}
+		}
+	}
+
+	return params;
+}
+
+}  // anonymous namespace
+
+class ETCDecoderTest : public testing::TestWithParam<ETCDecoderParams>
+{
+};
+
+// Every bit pattern is a legal ETC2 or EAC block, so random blocks exercise
+// all modes, including punch-through alpha and the T, H and planar modes.
+TEST_P(ETCDecoderTest, MatchesReference)
+{
+	const ETCDecoderParams &params = GetParam();
+	const ETCFormat &format = *params.format;
+
+	std::unique_ptr<marl::Scheduler> scheduler;
+	if(params.workerThreads > 0)
+	{
+		marl::Scheduler::Config config;
+		config.setWorkerThreadCount(params.workerThreads);
+		scheduler.reset(new marl::Scheduler(config));
+		scheduler->bind();
+	}
+
+	const int blockCount = ((params.width + 3) / 4) * ((params.height + 3) / 4);
+	std::vector<unsigned char> source(blockCount * format.blockBytes);
+	std::mt19937 random(params.width * 1000 + params.height);
+	for(auto &byte : source)
+	{
+		byte = static_cast<unsigned char>(random());
+	}
+
+	// Rows are padded, so that writes past the edge of the image show up as
+	// differences in the padding.
+	const int pitch = params.width * format.texelBytes + 12;
+	std::vector<unsigned char> expected(pitch * params.height, 0xCD);
+	std::vector<unsigned char> actual(pitch * params.height, 0xCD);
+
+	ASSERT_TRUE(ETC_ReferenceDecoder::Decode(source.data(), expected.data(), params.width, params.height, pitch, format.texelBytes, format.inputType));
+	ASSERT_TRUE(ETC_Decoder::Decode(source.data(), actual.data(), params.width, params.height, pitch, format.texelBytes, format.inputType));
+
+	if(scheduler)
+	{
+		scheduler->unbind();
+	}
+
+	for(int y = 0; y < params.height; y++)
+	{
+		for(int i = 0; i < pitch; i++)
+		{
+			ASSERT_EQ(expected[y * pitch + i], actual[y * pitch + i])
+			    << "x " << (i / format.texelBytes) << ", y " << y << ", byte " << (i % format.texelBytes);
+		}
+	}
+}
+
+INSTANTIATE_TEST_SUITE_P(ETC2, ETCDecoderTest, testing::ValuesIn(allParams()));
@@ -0,0 +1,28 @@
+// Copyright 2024 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ETC_REFERENCE_DECODER_HPP_
+#define ETC_REFERENCE_DECODER_HPP_
+
+#include "Device/ETC_Decoder.hpp"
+
+// Scalar ETC2/EAC decoder which ETC_Decoder must match bit for bit.
+class ETC_ReferenceDecoder : public ETC_Decoder
+{
+public:
+	/// ETC_ReferenceDecoder::Decode - Same as ETC_Decoder::Decode
+	static bool Decode(const unsigned char *src, unsigned char *dst, int w, int h, int dstPitch, int dstBpp, InputType inputType);
+};
+
+#endif  // ETC_REFERENCE_DECODER_HPP_
@@ -0,0 +1,116 @@
+// Copyright 2024 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Device/ASTC_Decoder.hpp"
+#include "Device/ETC_Decoder.hpp"
+#include "WorkerThreads.hpp"
+
+#include "benchmark/benchmark.h"
+
+#ifdef SWIFTSHADER_ENABLE_ASTC
+#	include "astc_codec_internals.h"
+#endif
+
+#include <memory>
+#include <random>
+#include <vector>
+
+// Decodes a 2048x2048 ASTC image with the given block footprint into RGBA8.
+// The argument is the number of scheduler worker threads, where 0 decodes on
+// the calling thread alone. Items processed are decoded texels.
+static void ASTCDecode(benchmark::State &state, int xBlockSize, int yBlockSize)
+{
+#ifdef SWIFTSHADER_ENABLE_ASTC
+	const int width = 2048;
+	const int height = 2048;
+	const int bytes = 4;
+	const int xblocks = (width + xBlockSize - 1) / xBlockSize;
+	const int yblocks = (height + yBlockSize - 1) / yBlockSize;
+
+	// Most random blocks are illegal encodings, which decode to the error color
+	// much faster than legal ones. Only keep blocks which decode successfully.
+	build_quantization_mode_table();
+	std::unique_ptr<block_size_descriptor> bsd(new block_size_descriptor);
+	init_block_size_descriptor(xBlockSize, yBlockSize, 1, bsd.get());
+
+	std::vector<physical_compressed_block> source(xblocks * yblocks);
+	std::unique_ptr<symbolic_compressed_block> scb(new symbolic_compressed_block);
+	std::mt19937 random;
+	for(auto &block : source)
+	{
+		do
+		{
+			for(auto &byte : block.data)
+			{
+				byte = static_cast<uint8_t>(random());
+			}
+			physical_to_symbolic(bsd.get(), block, scb.get());
+		} while(scb->error_block);
+	}
+
+	term_block_size_descriptor(bsd.get());
+
+	std::vector<unsigned char> dest(width * height * bytes);
+
+	WorkerThreads workerThreads(static_cast<int>(state.range(0)));
+
+	for(auto _ : state)
+	{
+		ASTC_Decoder::Decode(reinterpret_cast<const unsigned char *>(source.data()), dest.data(),
+		                     width, height, 1, bytes, width * bytes, width * height * bytes,
+		                     xBlockSize, yBlockSize, 1, xblocks, yblocks, 1, true);
+	}
+
+	state.SetItemsProcessed(state.iterations() * width * height);
+#else
+	state.SkipWithError("ASTC support is disabled");
+#endif
+}
+
+BENCHMARK_CAPTURE(ASTCDecode, 4x4, 4, 4)->Arg(0)->Arg(4)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(ASTCDecode, 6x6, 6, 6)->Arg(0)->Arg(4)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(ASTCDecode, 8x8, 8, 8)->Arg(0)->Arg(4)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(ASTCDecode, 12x12, 12, 12)->Arg(0)->Arg(4)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Decodes a 2048x2048 ETC2 or EAC image. Every bit pattern is a legal block,
+// so the blocks are random. Arguments are as for ASTCDecode.
+static void ETC2Decode(benchmark::State &state, ETC_Decoder::InputType inputType, int blockBytes, int texelBytes)
+{
+	const int width = 2048;
+	const int height = 2048;
+
+	std::vector<unsigned char> source((width / 4) * (height / 4) * blockBytes);
+	std::mt19937 random;
+	for(auto &byte : source)
+	{
+		byte = static_cast<unsigned char>(random());
+	}
+
+	std::vector<unsigned char> dest(width * height * texelBytes);
+
+	WorkerThreads workerThreads(static_cast<int>(state.range(0)));
+
+	for(auto _ : state)
+	{
+		ETC_Decoder::Decode(source.data(), dest.data(), width, height, width * texelBytes, texelBytes, inputType);
+	}
+
+	state.SetItemsProcessed(state.iterations() * width * height);
+}
+
+BENCHMARK_CAPTURE(ETC2Decode, RGB8, ETC_Decoder::ETC_RGB, 8, 4)->Arg(0)->Arg(4)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(ETC2Decode, RGB8A1, ETC_Decoder::ETC_RGB_PUNCHTHROUGH_ALPHA, 8, 4)->Arg(0)->Arg(4)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(ETC2Decode, RGBA8, ETC_Decoder::ETC_RGBA, 16, 4)->Arg(0)->Arg(4)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(ETC2Decode, EAC_R11, ETC_Decoder::ETC_R_UNSIGNED, 8, 2)->Arg(0)->Arg(4)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(ETC2Decode, EAC_RG11, ETC_Decoder::ETC_RG_UNSIGNED, 16, 4)->Arg(0)->Arg(4)->Unit(benchmark::kMillisecond)->UseRealTime();
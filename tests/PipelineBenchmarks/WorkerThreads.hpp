@@ -0,0 +1,50 @@
+// Copyright 2024 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PipelineBenchmarks_WorkerThreads_hpp
+#define PipelineBenchmarks_WorkerThreads_hpp
+
+#include "marl/scheduler.h"
+
+#include <memory>
+
+// Binds a scheduler with the given number of worker threads to the calling
+// thread for its lifetime. No scheduler is bound for 0 workers.
+class WorkerThreads
+{
+public:
+	WorkerThreads(int count)
+	{
+		if(count > 0)
+		{
+			marl::Scheduler::Config config;
+			config.setWorkerThreadCount(count);
+			scheduler.reset(new marl::Scheduler(config));
+			scheduler->bind();
+		}
+	}
+
+	~WorkerThreads()
+	{
+		if(scheduler)
+		{
+			scheduler->unbind();
+		}
+	}
+
+private:
+	std::unique_ptr<marl::Scheduler> scheduler;
+};
+
+#endif  // PipelineBenchmarks_WorkerThreads_hpp
@@ -17,6 +17,8 @@
 
 #include "benchmark/benchmark.h"
 
+#include <vector>
+
 using namespace rr;
 
 BENCHMARK_MAIN();
@@ -140,3 +142,70 @@ BENCHMARK_CAPTURE(Transcedental1, rr_Exp, Exp);
 BENCHMARK_CAPTURE(Transcedental1, rr_Log, Log);
 BENCHMARK_CAPTURE(Transcedental1, rr_Exp2, LIFT(Exp2));
 BENCHMARK_CAPTURE(Transcedental1, rr_Log2, LIFT(Log2));
+
+// Emits a loop nest shaped like a compute shader's: an outer loop over output
+// elements, and an inner loop whose body recomputes loop-invariant values and
+// addresses from the induction variables.
+static void EmitLoopKernel(Pointer<Byte> out, Pointer<Byte> in, Pointer<Byte> coefficients, Int count)
+{
+	For(Int i = 0, i < count, i++)
+	{
+		Float4 sum = Float4(0.0f);
+		For(Int j = 0, j < 16, j++)
+		{
+			Float4 scale = *Pointer<Float4>(coefficients + 16 * 16) * Float4(0.5f);
+			Float4 c = *Pointer<Float4>(coefficients + j * 16);
+			Float4 x = *Pointer<Float4>(in + (i * 16 + j) * 16);
+			sum += x * c * scale;
+		}
+		*Pointer<Float4>(out + i * 16) = sum;
+	}
+}
+
+using LoopKernelFunction = FunctionT<void(uint8_t *, uint8_t *, uint8_t *, int)>;
+
+// Compile time of the loop kernel under each optimization profile.
+static void LoopKernelCompile(benchmark::State &state, OptimizationProfileType profile)
+{
+	ScopedPragma pragma(OptimizationProfile, profile);
+
+	for(auto _ : state)
+	{
+		LoopKernelFunction function;
+		EmitLoopKernel(function.Arg<0>(), function.Arg<1>(), function.Arg<2>(), function.Arg<3>());
+		auto routine = function("LoopKernel");
+		benchmark::DoNotOptimize(routine);
+	}
+}
+
+// Run time of the loop kernel under each optimization profile. Items
+// processed are output elements.
+static void LoopKernelRun(benchmark::State &state, OptimizationProfileType profile)
+{
+	ScopedPragma pragma(OptimizationProfile, profile);
+
+	LoopKernelFunction function;
+	EmitLoopKernel(function.Arg<0>(), function.Arg<1>(), function.Arg<2>(), function.Arg<3>());
+	auto routine = function("LoopKernel");
+
+	const int count = 4096;
+	std::vector<float> out(count * 4);
+	std::vector<float> in(count * 16 * 4, 1.0f);
+	std::vector<float> coefficients(17 * 4, 0.25f);
+
+	for(auto _ : state)
+	{
+		routine(reinterpret_cast<uint8_t *>(out.data()),
+		        reinterpret_cast<uint8_t *>(in.data()),
+		        reinterpret_cast<uint8_t *>(coefficients.data()),
+		        count);
+		benchmark::ClobberMemory();
+	}
+
+	state.SetItemsProcessed(state.iterations() * count);
+}
+
+BENCHMARK_CAPTURE(LoopKernelCompile, FastCompileProfile, FastCompileProfile)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(LoopKernelCompile, LoopProfile, LoopProfile)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(LoopKernelRun, FastCompileProfile, FastCompileProfile);
+BENCHMARK_CAPTURE(LoopKernelRun, LoopProfile, LoopProfile);
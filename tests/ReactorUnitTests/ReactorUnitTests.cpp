@@ -16,6 +16,7 @@
 #include "Coroutine.hpp"
 #include "Print.hpp"
 #include "Reactor.hpp"
+#include "SIMD.hpp"
 
 #include "gtest/gtest.h"
 
@@ -2061,6 +2062,196 @@ TEST(ReactorUnitTests, LargeStack)
 	}
 }
 
+// Routines spending most of their time in loops are compiled with the
+// LoopProfile, which additionally rotates, hoists from, simplifies and unrolls
+// their loops. Their results must match those of the FastCompileProfile. The
+// loop passes run through the legacy pass manager with LLVM 10, and through
+// the new pass manager with later versions, so each backend build tests its own.
+using LoopKernelFunction = FunctionT<void(int *, int *, int)>;
+
+template<typename EmitKernel>
+static std::vector<int> runLoopKernel(OptimizationProfileType profile, EmitKernel emitKernel, std::vector<int> in, size_t outSize)
+{
+	ScopedPragma pragma(OptimizationProfile, profile);
+
+	LoopKernelFunction function;
+	{
+		Pointer<Int> out = function.Arg<0>();
+		Pointer<Int> input = function.Arg<1>();
+		Int count = function.Arg<2>();
+
+		emitKernel(out, input, count);
+	}
+
+	auto routine = function(testName().c_str());
+
+	std::vector<int> out(outSize, -1);
+	routine(out.data(), in.data(), static_cast<int>(in.size()));
+
+	return out;
+}
+
+template<typename EmitKernel>
+static void testLoopKernel(EmitKernel emitKernel, const std::vector<int> &in, const std::vector<int> &expected)
+{
+	auto fastCompile = runLoopKernel(FastCompileProfile, emitKernel, in, expected.size());
+	auto loop = runLoopKernel(LoopProfile, emitKernel, in, expected.size());
+
+	EXPECT_EQ(fastCompile, expected);
+	EXPECT_EQ(loop, fastCompile);
+}
+
+TEST(ReactorUnitTests, LoopProfileNestedLoops)
+{
+	// An odd trip count, which isn't a multiple of any unroll factor.
+	const int count = 37;
+
+	std::vector<int> in(count);
+	for(int i = 0; i < count; i++)
+	{
+		in[i] = (i * 37) % 61 - 10;
+	}
+
+	std::vector<int> expected(count);
+	for(int i = 0; i < count; i++)
+	{
+		int sum = 0;
+		for(int j = 0; j < 8; j++)
+		{
+			for(int k = 0; k <= j; k++)
+			{
+				sum += in[(i + j * k) % count] * (j - k + 1);
+			}
+		}
+		expected[i] = sum;
+	}
+
+	testLoopKernel([](Pointer<Int> &out, Pointer<Int> &in, Int &count) {
+		For(Int i = 0, i < count, i++)
+		{
+			Int sum = 0;
+			For(Int j = 0, j < 8, j++)
+			{
+				For(Int k = 0, k <= j, k++)
+				{
+					sum += in[(i + j * k) % count] * (j - k + 1);
+				}
+			}
+			out[i] = sum;
+		}
+	},
+	               in, expected);
+}
+
+TEST(ReactorUnitTests, LoopProfileLoopCarriedVariables)
+{
+	const int count = 29;
+
+	std::vector<int> in(count);
+	for(int i = 0; i < count; i++)
+	{
+		in[i] = (i * 13) % 17 + 1;
+	}
+
+	// The loop's variables depend on each other's values from the previous
+	// iteration, and one of them is only conditionally updated.
+	std::vector<int> expected(count + 2);
+	{
+		int a = 1;
+		int b = 0;
+		for(int i = 0; i < count; i++)
+		{
+			int t = (a + b * in[i]) & 0xFFFF;
+			b = a;
+			a = t;
+			if(a > 1000)
+			{
+				a -= 1000;
+			}
+			expected[i] = a ^ b;
+		}
+		expected[count] = a;
+		expected[count + 1] = b;
+	}
+
+	testLoopKernel([](Pointer<Int> &out, Pointer<Int> &in, Int &count) {
+		Int a = 1;
+		Int b = 0;
+		Int i = 0;
+		While(i < count)
+		{
+			Int t = (a + b * in[i]) & 0xFFFF;
+			b = a;
+			a = t;
+			If(a > 1000)
+			{
+				a -= 1000;
+			}
+			out[i] = a ^ b;
+			i++;
+		}
+		out[count] = a;
+		out[count + 1] = b;
+	},
+	               in, expected);
+}
+
+TEST(ReactorUnitTests, LoopProfileMaskedStores)
+{
+	const int rows = 11;
+	const int width = SIMD::Width;
+
+	std::vector<int> in(rows * width);
+	for(int i = 0; i < rows * width; i++)
+	{
+		in[i] = (i * 37) % 61 - 10;
+	}
+
+	// Each row is stored several times, by a loop whose lane masks depend on
+	// both induction variables and on the loaded values. Lanes which are never
+	// enabled must keep their initial value.
+	std::vector<int> expected(rows * width, -1);
+	for(int row = 0; row < rows; row++)
+	{
+		for(int k = 0; k < 3; k++)
+		{
+			for(int lane = 0; lane < width; lane++)
+			{
+				int x = in[row * width + lane];
+				if(((lane + row + k) & 3) == 0 || x < k * 10)
+				{
+					expected[row * width + lane] = x * (k + 1) + row;
+				}
+			}
+		}
+	}
+
+	testLoopKernel([](Pointer<Int> &out, Pointer<Int> &in, Int &count) {
+		SIMD::Int lane = 0;
+		for(int i = 0; i < SIMD::Width; i++)
+		{
+			lane = Insert(lane, Int(i), i);
+		}
+		SIMD::Int offsets = lane * SIMD::Int(sizeof(int));
+
+		Int rows = count / SIMD::Width;
+		For(Int row = 0, row < rows, row++)
+		{
+			Int rowOffset = row * SIMD::Width * sizeof(int);
+			Pointer<Int> dst = Pointer<Byte>(out) + rowOffset;
+			SIMD::Int x = *Pointer<SIMD::Int>(Pointer<Byte>(in) + rowOffset);
+
+			For(Int k = 0, k < 3, k++)
+			{
+				SIMD::Int mask = CmpEQ((lane + SIMD::Int(row + k)) & SIMD::Int(3), SIMD::Int(0)) |
+				                 CmpLT(x, SIMD::Int(k * 10));
+				Scatter(dst, x * SIMD::Int(k + 1) + SIMD::Int(row), offsets, mask, sizeof(int));
+			}
+		}
+	},
+	               in, expected);
+}
+
 TEST(ReactorUnitTests, ShlSmallRHSScalar)
 {
 	// TODO(crbug.com/swiftshader/185): Testing a temporary LLVM workaround
@@ -12,12 +12,16 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include "Buffer.hpp"
 #include "Util.hpp"
 #include "VulkanTester.hpp"
 
 #include "benchmark/benchmark.h"
 
 #include <cassert>
+#include <cstring>
+#include <memory>
+#include <vector>
 
 class ClearImageBenchmark
 {
@@ -154,3 +158,191 @@ static void ClearImage(benchmark::State &state, vk::Format clearFormat, vk::Imag
 BENCHMARK_CAPTURE(ClearImage, VK_FORMAT_R8G8B8A8_UNORM, vk::Format::eR8G8B8A8Unorm, vk::ImageAspectFlagBits::eColor)->Unit(benchmark::kMillisecond)->MeasureProcessCPUTime();
 BENCHMARK_CAPTURE(ClearImage, VK_FORMAT_R32_SFLOAT, vk::Format::eR32Sfloat, vk::ImageAspectFlagBits::eColor)->Unit(benchmark::kMillisecond)->MeasureProcessCPUTime();
 BENCHMARK_CAPTURE(ClearImage, VK_FORMAT_D32_SFLOAT, vk::Format::eD32Sfloat, vk::ImageAspectFlagBits::eDepth)->Unit(benchmark::kMillisecond)->MeasureProcessCPUTime();
+
+// Records a single transfer command into a command buffer, which is then
+// submitted repeatedly.
+class TransferBenchmark
+{
+public:
+	enum class Operation
+	{
+		Blit,
+		Resolve,
+		Upload,
+	};
+
+	void initialize(Operation operation, uint32_t width, uint32_t height)
+	{
+		tester.initialize();
+		auto &device = tester.getDevice();
+
+		vk::CommandPoolCreateInfo commandPoolCreateInfo;
+		commandPoolCreateInfo.queueFamilyIndex = tester.getQueueFamilyIndex();
+
+		commandPool = device.createCommandPool(commandPoolCreateInfo);
+
+		vk::CommandBufferAllocateInfo commandBufferAllocateInfo;
+		commandBufferAllocateInfo.commandPool = commandPool;
+		commandBufferAllocateInfo.commandBufferCount = 1;
+
+		commandBuffer = device.allocateCommandBuffers(commandBufferAllocateInfo)[0];
+
+		vk::CommandBufferBeginInfo commandBufferBeginInfo;
+		commandBufferBeginInfo.flags = {};
+
+		commandBuffer.begin(commandBufferBeginInfo);
+
+		vk::ImageSubresourceLayers subresource;
+		subresource.aspectMask = vk::ImageAspectFlagBits::eColor;
+		subresource.mipLevel = 0;
+		subresource.baseArrayLayer = 0;
+		subresource.layerCount = 1;
+
+		switch(operation)
+		{
+		case Operation::Blit:
+			{
+				// Converting between formats with linear filtering requires the
+				// generic blit routine.
+				vk::Image src = createImage(vk::Format::eR8G8B8A8Unorm, width, height, vk::SampleCountFlagBits::e1);
+				vk::Image dst = createImage(vk::Format::eB8G8R8A8Unorm, width, height, vk::SampleCountFlagBits::e1);
+
+				vk::ImageBlit region;
+				region.srcSubresource = subresource;
+				region.srcOffsets[1] = vk::Offset3D(width, height, 1);
+				region.dstSubresource = subresource;
+				region.dstOffsets[1] = vk::Offset3D(width, height, 1);
+
+				commandBuffer.blitImage(src, vk::ImageLayout::eGeneral, dst, vk::ImageLayout::eGeneral, region, vk::Filter::eLinear);
+			}
+			break;
+		case Operation::Resolve:
+			{
+				vk::Image src = createImage(vk::Format::eR8G8B8A8Unorm, width, height, vk::SampleCountFlagBits::e4);
+				vk::Image dst = createImage(vk::Format::eR8G8B8A8Unorm, width, height, vk::SampleCountFlagBits::e1);
+
+				vk::ImageResolve region;
+				region.srcSubresource = subresource;
+				region.dstSubresource = subresource;
+				region.extent = vk::Extent3D(width, height, 1);
+
+				commandBuffer.resolveImage(src, vk::ImageLayout::eGeneral, dst, vk::ImageLayout::eGeneral, region);
+			}
+			break;
+		case Operation::Upload:
+			{
+				vk::DeviceSize size = vk::DeviceSize(width) * height * 4;
+				buffer = std::make_unique<Buffer>(device, size, vk::BufferUsageFlagBits::eTransferSrc);
+				memset(buffer->mapMemory(), 0x80, size);
+				buffer->unmapMemory();
+
+				vk::Image dst = createImage(vk::Format::eR8G8B8A8Unorm, width, height, vk::SampleCountFlagBits::e1);
+
+				vk::BufferImageCopy region;
+				region.imageSubresource = subresource;
+				region.imageExtent = vk::Extent3D(width, height, 1);
+
+				commandBuffer.copyBufferToImage(buffer->getBuffer(), dst, vk::ImageLayout::eGeneral, region);
+			}
+			break;
+		}
+
+		commandBuffer.end();
+	}
+
+	~TransferBenchmark()
+	{
+		auto &device = tester.getDevice();
+		device.freeCommandBuffers(commandPool, 1, &commandBuffer);
+		device.destroyCommandPool(commandPool, nullptr);
+		buffer.reset();
+		for(auto &image : images)
+		{
+			device.freeMemory(image.second, nullptr);
+			device.destroyImage(image.first, nullptr);
+		}
+	}
+
+	void run()
+	{
+		auto &queue = tester.getQueue();
+
+		vk::SubmitInfo submitInfo;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &commandBuffer;
+
+		queue.submit(1, &submitInfo, nullptr);
+		queue.waitIdle();
+	}
+
+private:
+	vk::Image createImage(vk::Format format, uint32_t width, uint32_t height, vk::SampleCountFlagBits samples)
+	{
+		auto &device = tester.getDevice();
+		auto &physicalDevice = tester.getPhysicalDevice();
+
+		vk::ImageCreateInfo imageInfo;
+		imageInfo.imageType = vk::ImageType::e2D;
+		imageInfo.format = format;
+		imageInfo.tiling = vk::ImageTiling::eOptimal;
+		imageInfo.initialLayout = vk::ImageLayout::eUndefined;
+		imageInfo.usage = vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst;
+		if(samples != vk::SampleCountFlagBits::e1)
+		{
+			imageInfo.usage |= vk::ImageUsageFlagBits::eColorAttachment;
+		}
+		imageInfo.samples = samples;
+		imageInfo.extent = vk::Extent3D(width, height, 1);
+		imageInfo.mipLevels = 1;
+		imageInfo.arrayLayers = 1;
+
+		vk::Image image = device.createImage(imageInfo);
+
+		vk::MemoryRequirements memoryRequirements = device.getImageMemoryRequirements(image);
+
+		vk::MemoryAllocateInfo allocateInfo;
+		allocateInfo.allocationSize = memoryRequirements.size;
+		allocateInfo.memoryTypeIndex = Util::getMemoryTypeIndex(physicalDevice, memoryRequirements.memoryTypeBits);
+
+		vk::DeviceMemory memory = device.allocateMemory(allocateInfo);
+
+		device.bindImageMemory(image, memory, 0);
+		images.emplace_back(image, memory);
+
+		vk::ImageMemoryBarrier imageMemoryBarrier;
+		imageMemoryBarrier.image = image;
+		imageMemoryBarrier.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
+		imageMemoryBarrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+		imageMemoryBarrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+		imageMemoryBarrier.oldLayout = vk::ImageLayout::eUndefined;
+		imageMemoryBarrier.newLayout = vk::ImageLayout::eGeneral;
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eTopOfPipe,
+		                              vk::DependencyFlagBits::eDeviceGroup, {}, {}, imageMemoryBarrier);
+
+		return image;
+	}
+
+	VulkanTester tester;
+	std::vector<std::pair<vk::Image, vk::DeviceMemory>> images;  // Owning handles
+	std::unique_ptr<Buffer> buffer;
+	vk::CommandPool commandPool;      // Owning handle
+	vk::CommandBuffer commandBuffer;  // Owning handle
+};
+
+static void Transfer(benchmark::State &state, TransferBenchmark::Operation operation, uint32_t width, uint32_t height)
+{
+	TransferBenchmark benchmark;
+	benchmark.initialize(operation, width, height);
+
+	// Execute once to have the Reactor routine generated.
+	benchmark.run();
+
+	for(auto _ : state)
+	{
+		benchmark.run();
+	}
+}
+
+BENCHMARK_CAPTURE(Transfer, Blit_4K, TransferBenchmark::Operation::Blit, 3840, 2160)->Unit(benchmark::kMillisecond)->MeasureProcessCPUTime()->UseRealTime();
+BENCHMARK_CAPTURE(Transfer, Resolve_4x_4K, TransferBenchmark::Operation::Resolve, 3840, 2160)->Unit(benchmark::kMillisecond)->MeasureProcessCPUTime()->UseRealTime();
+BENCHMARK_CAPTURE(Transfer, Upload_4K, TransferBenchmark::Operation::Upload, 3840, 2160)->Unit(benchmark::kMillisecond)->MeasureProcessCPUTime()->UseRealTime();
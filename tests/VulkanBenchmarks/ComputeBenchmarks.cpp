@@ -336,4 +336,63 @@ BENCHMARK_CAPTURE(Compute, sqrt_mediump, "sqrt", "mediump")->Arg(4 * 1024 * 1024
 BENCHMARK_CAPTURE(Compute, sin_mediump, "sin", "mediump")->Arg(4 * 1024 * 1024)->Unit(benchmark::kMillisecond)->MeasureProcessCPUTime();
 BENCHMARK_CAPTURE(Compute, cos_mediump, "cos", "mediump")->Arg(4 * 1024 * 1024)->Unit(benchmark::kMillisecond)->MeasureProcessCPUTime();
 BENCHMARK_CAPTURE(Compute, exp_mediump, "exp", "mediump")->Arg(4 * 1024 * 1024)->Unit(benchmark::kMillisecond)->MeasureProcessCPUTime();
-BENCHMARK_CAPTURE(Compute, log_mediump, "log", "mediump")->Arg(4 * 1024 * 1024)->Unit(benchmark::kMillisecond)->MeasureProcessCPUTime();
\ No newline at end of file
+BENCHMARK_CAPTURE(Compute, log_mediump, "log", "mediump")->Arg(4 * 1024 * 1024)->Unit(benchmark::kMillisecond)->MeasureProcessCPUTime();
+
+// Runs a loop whose trip count varies per workgroup, to measure how well the
+// work is balanced across threads when some workgroups are far more
+// expensive than others.
+class SkewedComputeOp : public BufferToBufferComputeBenchmark
+{
+public:
+	SkewedComputeOp(const benchmark::State &state, const char *heavyWorkgroup)
+	    : BufferToBufferComputeBenchmark(state)
+	{
+		localSizeX = 64;
+
+		std::stringstream src;
+		src << R"(#version 450
+			layout(local_size_x = 64, local_size_y = 1, local_size_z = 1) in;
+			layout(binding = 0, std430) buffer InBuffer
+			{
+				float Data[];
+			} In;
+			layout(binding = 1, std430) buffer OutBuffer
+			{
+				float Data[];
+			} Out;
+			void main()
+			{
+				uint id = gl_WorkGroupID.x;
+				uint count = gl_NumWorkGroups.x;
+				uint iterations = ()"
+		    << heavyWorkgroup << R"() ? 256 : 1;
+				float x = In.Data[gl_GlobalInvocationID.x];
+				for(uint i = 0; i < iterations; i++)
+				{
+					x = sqrt(x + 1.0);
+				}
+				Out.Data[gl_GlobalInvocationID.x] = x;
+			})";
+
+		initialize(src.str());
+	}
+};
+
+static void SkewedCompute(benchmark::State &state, const char *heavyWorkgroup)
+{
+	SkewedComputeOp benchmark(state, heavyWorkgroup);
+
+	// Execute once to have the Reactor routine generated.
+	benchmark.run();
+
+	for(auto _ : state)
+	{
+		benchmark.run();
+	}
+}
+
+// Measured in wall time, as idle workers waiting on the last workgroups
+// don't show up in CPU time.
+BENCHMARK_CAPTURE(SkewedCompute, uniform, "false")->Arg(4 * 1024 * 1024)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(SkewedCompute, heavy_tail, "id * 16 >= count * 15")->Arg(4 * 1024 * 1024)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(SkewedCompute, heavy_stride, "id % 16 == 0")->Arg(4 * 1024 * 1024)->Unit(benchmark::kMillisecond)->UseRealTime();
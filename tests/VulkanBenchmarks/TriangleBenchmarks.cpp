@@ -14,9 +14,12 @@
 
 #include "Buffer.hpp"
 #include "DrawTester.hpp"
+#include "OffscreenTester.hpp"
 #include "benchmark/benchmark.h"
 
+#include <array>
 #include <cassert>
+#include <cstdint>
 #include <vector>
 
 template<typename T>
@@ -281,9 +284,309 @@ static void TriangleSampleTexture(benchmark::State &state, Multisample multisamp
 	RunBenchmark(state, tester);
 }
 
+enum class DrawOrder
+{
+	FrontToBack,
+	BackToFront
+};
+
+// Draws full-screen layers with an expensive fragment shader and the depth test
+// enabled. Drawn front to back, all layers but the first are occluded and their
+// shading can be skipped. Drawn back to front, every layer must be shaded.
+static void TriangleOverdraw(benchmark::State &state, Multisample multisample, DrawOrder drawOrder)
+{
+	DrawTester tester(multisample, DepthTest::True);
+
+	tester.onCreateVertexBuffers([drawOrder](DrawTester &tester) {
+		struct Vertex
+		{
+			float position[3];
+			float color[3];
+		};
+
+		constexpr int layerCount = 16;
+		std::vector<Vertex> vertexBufferData;
+
+		for(int layer = 0; layer < layerCount; layer++)
+		{
+			float depth = ((drawOrder == DrawOrder::FrontToBack) ? (layer + 1) : (layerCount - layer)) / (layerCount + 1.0f);
+			float shade = static_cast<float>(layer) / layerCount;
+
+			vertexBufferData.push_back({ { -1.0f, -1.0f, depth }, { shade, 0.0f, 1.0f } });
+			vertexBufferData.push_back({ { 1.0f, -1.0f, depth }, { 1.0f, shade, 0.0f } });
+			vertexBufferData.push_back({ { -1.0f, 1.0f, depth }, { 0.0f, 1.0f, shade } });
+			vertexBufferData.push_back({ { -1.0f, 1.0f, depth }, { 0.0f, 1.0f, shade } });
+			vertexBufferData.push_back({ { 1.0f, -1.0f, depth }, { 1.0f, shade, 0.0f } });
+			vertexBufferData.push_back({ { 1.0f, 1.0f, depth }, { shade, shade, shade } });
+		}
+
+		std::vector<vk::VertexInputAttributeDescription> inputAttributes;
+		inputAttributes.push_back(vk::VertexInputAttributeDescription(0, 0, vk::Format::eR32G32B32Sfloat, offsetof(Vertex, position)));
+		inputAttributes.push_back(vk::VertexInputAttributeDescription(1, 0, vk::Format::eR32G32B32Sfloat, offsetof(Vertex, color)));
+
+		tester.addVertexBuffer(vertexBufferData.data(), vertexBufferData.size() * sizeof(Vertex), std::move(inputAttributes));
+	});
+
+	tester.onCreateVertexShader([](DrawTester &tester) {
+		const char *vertexShader = R"(#version 310 es
+			layout(location = 0) in vec3 inPos;
+			layout(location = 1) in vec3 inColor;
+
+			layout(location = 0) out vec3 outColor;
+
+			void main()
+			{
+				outColor = inColor;
+				gl_Position = vec4(inPos.xyz, 1.0);
+			})";
+
+		return tester.createShaderModule(vertexShader, EShLanguage::EShLangVertex);
+	});
+
+	tester.onCreateFragmentShader([](DrawTester &tester) {
+		// Has no side effects and doesn't write depth, so the depth test can
+		// be performed ahead of shading without an early_fragment_tests layout.
+		const char *fragmentShader = R"(#version 310 es
+			precision highp float;
+
+			layout(location = 0) in vec3 inColor;
+
+			layout(location = 0) out vec4 outColor;
+
+			void main()
+			{
+				vec3 color = inColor;
+				for(int i = 0; i < 32; i++)
+				{
+					color = fract(sin(color * 12.9898 + float(i)) * 43758.5453);
+				}
+				outColor = vec4(color, 1.0);
+			})";
+
+		return tester.createShaderModule(fragmentShader, EShLanguage::EShLangFragment);
+	});
+
+	RunBenchmark(state, tester);
+}
+
+enum class VertexFormats
+{
+	Unorm8,   // Float position, RGBA8 unorm attributes
+	Snorm16,  // RGBA16 and RG16 snorm attributes
+	Half      // RGBA16 and RG16 float attributes
+};
+
+// Draws many degenerate triangles from an interleaved vertex buffer, so that
+// the cost is dominated by fetching and shading vertices.
+static void VertexFetch(benchmark::State &state, VertexFormats formats)
+{
+	DrawTester tester;
+
+	tester.onCreateVertexBuffers([formats](DrawTester &tester) {
+		struct Vertex
+		{
+			uint8_t data[20];
+		};
+
+		std::vector<vk::VertexInputAttributeDescription> inputAttributes;
+		switch(formats)
+		{
+		case VertexFormats::Unorm8:
+			inputAttributes.push_back(vk::VertexInputAttributeDescription(0, 0, vk::Format::eR32G32B32Sfloat, 0));
+			inputAttributes.push_back(vk::VertexInputAttributeDescription(1, 0, vk::Format::eR8G8B8A8Unorm, 12));
+			inputAttributes.push_back(vk::VertexInputAttributeDescription(2, 0, vk::Format::eR8G8B8A8Unorm, 16));
+			break;
+		case VertexFormats::Snorm16:
+			inputAttributes.push_back(vk::VertexInputAttributeDescription(0, 0, vk::Format::eR16G16B16A16Snorm, 0));
+			inputAttributes.push_back(vk::VertexInputAttributeDescription(1, 0, vk::Format::eR16G16B16A16Snorm, 8));
+			inputAttributes.push_back(vk::VertexInputAttributeDescription(2, 0, vk::Format::eR16G16Snorm, 16));
+			break;
+		case VertexFormats::Half:
+			inputAttributes.push_back(vk::VertexInputAttributeDescription(0, 0, vk::Format::eR16G16B16A16Sfloat, 0));
+			inputAttributes.push_back(vk::VertexInputAttributeDescription(1, 0, vk::Format::eR16G16B16A16Sfloat, 8));
+			inputAttributes.push_back(vk::VertexInputAttributeDescription(2, 0, vk::Format::eR16G16Sfloat, 16));
+			break;
+		}
+
+		// All positions are zero in every format, which makes every triangle
+		// degenerate. The other attributes hold arbitrary values.
+		constexpr int vertexCount = 3 * 65536;
+		std::vector<Vertex> vertexBufferData(vertexCount);
+		for(int i = 0; i < vertexCount; i++)
+		{
+			for(int j = 0; j < 20; j++)
+			{
+				vertexBufferData[i].data[j] = (j < static_cast<int>(inputAttributes[1].offset)) ? 0 : static_cast<uint8_t>((i * 7 + j * 13) & 0x3F);
+			}
+		}
+
+		tester.addVertexBuffer(vertexBufferData.data(), vertexBufferData.size() * sizeof(Vertex), std::move(inputAttributes));
+	});
+
+	tester.onCreateVertexShader([](DrawTester &tester) {
+		const char *vertexShader = R"(#version 310 es
+			layout(location = 0) in vec4 inPos;
+			layout(location = 1) in vec4 inA;
+			layout(location = 2) in vec4 inB;
+
+			layout(location = 0) out vec4 outColor;
+
+			void main()
+			{
+				outColor = inA + inB;
+				gl_Position = vec4(inPos.xyz, 1.0);
+			})";
+
+		return tester.createShaderModule(vertexShader, EShLanguage::EShLangVertex);
+	});
+
+	tester.onCreateFragmentShader([](DrawTester &tester) {
+		const char *fragmentShader = R"(#version 310 es
+			precision highp float;
+
+			layout(location = 0) in vec4 inColor;
+
+			layout(location = 0) out vec4 outColor;
+
+			void main()
+			{
+				outColor = inColor;
+			})";
+
+		return tester.createShaderModule(fragmentShader, EShLanguage::EShLangFragment);
+	});
+
+	RunBenchmark(state, tester);
+}
+
+enum class IndirectRecords
+{
+	Contiguous,    // Non-indexed records with consecutive vertex ranges
+	BaseVertex,    // Indexed records of one triangle, each with its own vertex offset
+	FirstInstance  // Non-indexed records of one triangle, each with its own first instance
+};
+
+// Draws a grid of tiny triangles with one indirect record each, so that the
+// cost is dominated by issuing the records rather than by rendering them.
+static void IndirectDraw(benchmark::State &state, IndirectRecords records)
+{
+	constexpr uint32_t size = 256;
+	constexpr uint32_t gridSize = 64;
+	constexpr uint32_t recordCount = gridSize * gridSize;
+	constexpr float cellSize = 2.0f / gridSize;
+	const vk::Format colorFormat = vk::Format::eR8G8B8A8Unorm;
+
+	OffscreenTester tester;
+	tester.initialize();
+
+	OffscreenTester::RenderTarget colorTarget = tester.createRenderTarget(colorFormat, vk::Extent2D(size, size));
+	vk::RenderPass renderPass = tester.createRenderPass(colorFormat, vk::Format::eUndefined, vk::AttachmentLoadOp::eClear);
+	vk::Framebuffer framebuffer = tester.createFramebuffer(renderPass, { colorTarget.view }, vk::Extent2D(size, size));
+
+	// Records which draw the same triangle are moved to their cell by their instance.
+	const char *vertexShader = R"(#version 450
+		layout(location = 0) in vec2 inPos;
+
+		void main()
+		{
+			vec2 cell = vec2(gl_InstanceIndex % 64, gl_InstanceIndex / 64);
+			gl_Position = vec4(inPos + cell * (2.0 / 64.0), 0.5, 1.0);
+		})";
+
+	const char *fragmentShader = R"(#version 450
+		layout(location = 0) out vec4 outColor;
+
+		void main()
+		{
+			outColor = vec4(1.0, 1.0, 1.0, 1.0);
+		})";
+
+	OffscreenTester::GraphicsPipelineState pipelineState;
+	pipelineState.renderPass = renderPass;
+	pipelineState.layout = tester.createPipelineLayout();
+	pipelineState.vertexShader = tester.createShaderModule(vertexShader, EShLanguage::EShLangVertex);
+	pipelineState.fragmentShader = tester.createShaderModule(fragmentShader, EShLanguage::EShLangFragment);
+	pipelineState.vertexBindings = { vk::VertexInputBindingDescription(0, 2 * sizeof(float), vk::VertexInputRate::eVertex) };
+	pipelineState.vertexAttributes = { vk::VertexInputAttributeDescription(0, 0, vk::Format::eR32G32Sfloat, 0) };
+	vk::Pipeline pipeline = tester.createGraphicsPipeline(pipelineState);
+
+	// One triangle in the bottom left corner of each cell, or only in the first.
+	const uint32_t triangleCount = (records == IndirectRecords::FirstInstance) ? 1 : recordCount;
+	std::vector<float> positions;
+	for(uint32_t i = 0; i < triangleCount; i++)
+	{
+		float x = -1.0f + (i % gridSize) * cellSize;
+		float y = -1.0f + (i / gridSize) * cellSize;
+		positions.insert(positions.end(), { x, y, x + cellSize, y, x, y + cellSize });
+	}
+	vk::Buffer vertexBuffer = tester.createBuffer(positions.size() * sizeof(float), vk::BufferUsageFlagBits::eVertexBuffer, positions.data());
+
+	std::vector<uint16_t> indices(3 * recordCount);
+	for(uint32_t i = 0; i < indices.size(); i++)
+	{
+		indices[i] = static_cast<uint16_t>(i % 3);
+	}
+	vk::Buffer indexBuffer = tester.createBuffer(indices.size() * sizeof(uint16_t), vk::BufferUsageFlagBits::eIndexBuffer, indices.data());
+
+	std::vector<vk::DrawIndirectCommand> drawCommands(recordCount);
+	std::vector<vk::DrawIndexedIndirectCommand> drawIndexedCommands(recordCount);
+	for(uint32_t i = 0; i < recordCount; i++)
+	{
+		switch(records)
+		{
+		case IndirectRecords::Contiguous:
+			drawCommands[i] = vk::DrawIndirectCommand(3, 1, 3 * i, 0);
+			break;
+		case IndirectRecords::BaseVertex:
+			drawIndexedCommands[i] = vk::DrawIndexedIndirectCommand(3, 1, 3 * i, static_cast<int32_t>(3 * i), 0);
+			break;
+		case IndirectRecords::FirstInstance:
+			drawCommands[i] = vk::DrawIndirectCommand(3, 1, 0, i);
+			break;
+		}
+	}
+
+	const bool indexed = (records == IndirectRecords::BaseVertex);
+	vk::Buffer indirectBuffer = indexed ? tester.createBuffer(recordCount * sizeof(vk::DrawIndexedIndirectCommand), vk::BufferUsageFlagBits::eIndirectBuffer, drawIndexedCommands.data())
+	                                    : tester.createBuffer(recordCount * sizeof(vk::DrawIndirectCommand), vk::BufferUsageFlagBits::eIndirectBuffer, drawCommands.data());
+
+	auto render = [&](vk::CommandBuffer &commandBuffer) {
+		vk::DeviceSize offset = 0;
+		OffscreenTester::beginRenderPass(commandBuffer, renderPass, framebuffer, vk::Extent2D(size, size), { Color{ 0, 0, 0, 255 }.toClearColor() });
+		commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
+		commandBuffer.bindVertexBuffers(0, 1, &vertexBuffer, &offset);
+		if(indexed)
+		{
+			commandBuffer.bindIndexBuffer(indexBuffer, 0, vk::IndexType::eUint16);
+			commandBuffer.drawIndexedIndirect(indirectBuffer, 0, recordCount, sizeof(vk::DrawIndexedIndirectCommand));
+		}
+		else
+		{
+			commandBuffer.drawIndirect(indirectBuffer, 0, recordCount, sizeof(vk::DrawIndirectCommand));
+		}
+		commandBuffer.endRenderPass();
+	};
+
+	// Warmup
+	tester.submit(render);
+
+	for(auto _ : state)
+	{
+		tester.submit(render);
+	}
+}
+
 BENCHMARK_CAPTURE(TriangleSolidColor, TriangleSolidColor, Multisample::False)->Unit(benchmark::kMillisecond)->MeasureProcessCPUTime();
 BENCHMARK_CAPTURE(TriangleInterpolateColor, TriangleInterpolateColor, Multisample::False)->Unit(benchmark::kMillisecond)->MeasureProcessCPUTime();
 BENCHMARK_CAPTURE(TriangleSampleTexture, TriangleSampleTexture, Multisample::False)->Unit(benchmark::kMillisecond)->MeasureProcessCPUTime();
 BENCHMARK_CAPTURE(TriangleSolidColor, TriangleSolidColor_Multisample, Multisample::True)->Unit(benchmark::kMillisecond)->MeasureProcessCPUTime();
 BENCHMARK_CAPTURE(TriangleInterpolateColor, TriangleInterpolateColor_Multisample, Multisample::True)->Unit(benchmark::kMillisecond)->MeasureProcessCPUTime();
 BENCHMARK_CAPTURE(TriangleSampleTexture, TriangleSampleTexture_Multisample, Multisample::True)->Unit(benchmark::kMillisecond)->MeasureProcessCPUTime();
+BENCHMARK_CAPTURE(TriangleOverdraw, TriangleOverdraw_FrontToBack, Multisample::False, DrawOrder::FrontToBack)->Unit(benchmark::kMillisecond)->MeasureProcessCPUTime();
+BENCHMARK_CAPTURE(TriangleOverdraw, TriangleOverdraw_BackToFront, Multisample::False, DrawOrder::BackToFront)->Unit(benchmark::kMillisecond)->MeasureProcessCPUTime();
+BENCHMARK_CAPTURE(VertexFetch, VertexFetch_Unorm8, VertexFormats::Unorm8)->Unit(benchmark::kMillisecond)->MeasureProcessCPUTime();
+BENCHMARK_CAPTURE(VertexFetch, VertexFetch_Snorm16, VertexFormats::Snorm16)->Unit(benchmark::kMillisecond)->MeasureProcessCPUTime();
+BENCHMARK_CAPTURE(VertexFetch, VertexFetch_Half, VertexFormats::Half)->Unit(benchmark::kMillisecond)->MeasureProcessCPUTime();
+BENCHMARK_CAPTURE(IndirectDraw, IndirectDraw_Contiguous, IndirectRecords::Contiguous)->Unit(benchmark::kMillisecond)->MeasureProcessCPUTime();
+BENCHMARK_CAPTURE(IndirectDraw, IndirectDraw_BaseVertex, IndirectRecords::BaseVertex)->Unit(benchmark::kMillisecond)->MeasureProcessCPUTime();
+BENCHMARK_CAPTURE(IndirectDraw, IndirectDraw_FirstInstance, IndirectRecords::FirstInstance)->Unit(benchmark::kMillisecond)->MeasureProcessCPUTime();
@@ -20,6 +20,7 @@
 
 #include "spirv-tools/libspirv.hpp"
 
+#include <algorithm>
 #include <cstring>
 #include <sstream>
 
@@ -121,13 +122,15 @@ class SwiftShaderVulkanBufferToBufferComputeTest : public ComputeTest
 public:
 	void test(const std::string &shader,
 	          std::function<uint32_t(uint32_t idx)> input,
-	          std::function<uint32_t(uint32_t idx)> expected);
+	          std::function<uint32_t(uint32_t idx)> expected,
+	          bool robustBufferAccess = false);
 };
 
 void SwiftShaderVulkanBufferToBufferComputeTest::test(
     const std::string &shader,
     std::function<uint32_t(uint32_t idx)> input,
-    std::function<uint32_t(uint32_t idx)> expected)
+    std::function<uint32_t(uint32_t idx)> expected,
+    bool robustBufferAccess)
 {
 	auto code = compileSpirv(shader.c_str());
 
@@ -147,8 +150,11 @@ void SwiftShaderVulkanBufferToBufferComputeTest::test(
 
 	ASSERT_TRUE(driver.resolve(instance));
 
+	VkPhysicalDeviceFeatures features = {};
+	features.robustBufferAccess = robustBufferAccess ? VK_TRUE : VK_FALSE;
+
 	std::unique_ptr<Device> device;
-	VK_ASSERT(Device::CreateComputeDevice(&driver, instance, device));
+	VK_ASSERT(Device::CreateComputeDevice(&driver, instance, device, &features));
 	ASSERT_TRUE(device->IsValid());
 
 	// struct Buffers
@@ -1481,3 +1487,1254 @@ TEST_P(SwiftShaderVulkanBufferToBufferComputeTest, LoopDivergentMergePhi)
 	test(
 	    src.str(), [](uint32_t i) { return i; }, [](uint32_t i) { return i; });
 }
+
+TEST_P(SwiftShaderVulkanBufferToBufferComputeTest, WorkgroupBarrier)
+{
+	uint32_t localSize = GetParam().localSizeX * GetParam().localSizeY * GetParam().localSizeZ;
+
+	std::stringstream src;
+	// #version 450
+	// layout(local_size_x = N) in;
+	// layout(binding = 0, std430) buffer InBuffer
+	// {
+	//     int Data[];
+	// } In;
+	// layout(binding = 1, std430) buffer OutBuffer
+	// {
+	//     int Data[];
+	// } Out;
+	// shared int s[N];
+	// void main()
+	// {
+	//     int v = In.Data[gl_GlobalInvocationID.x];
+	//     s[gl_LocalInvocationIndex] = v;
+	//     barrier();
+	//     Out.Data[gl_GlobalInvocationID.x] = s[N - 1 - gl_LocalInvocationIndex] + v;
+	// }
+	// clang-format off
+    src <<
+        "OpCapability Shader\n"
+        "OpMemoryModel Logical GLSL450\n"
+        "OpEntryPoint GLCompute %1 \"main\" %2 %3\n"
+        "OpExecutionMode %1 LocalSize " <<
+        GetParam().localSizeX << " " <<
+        GetParam().localSizeY << " " <<
+        GetParam().localSizeZ << "\n" <<
+        "OpDecorate %4 ArrayStride 4\n"
+        "OpMemberDecorate %5 0 Offset 0\n"
+        "OpDecorate %5 BufferBlock\n"
+        "OpDecorate %6 DescriptorSet 0\n"
+        "OpDecorate %6 Binding 1\n"
+        "OpDecorate %2 BuiltIn GlobalInvocationId\n"
+        "OpDecorate %3 BuiltIn LocalInvocationIndex\n"
+        "OpDecorate %7 DescriptorSet 0\n"
+        "OpDecorate %7 Binding 0\n"
+        "%8 = OpTypeVoid\n"
+        "%9 = OpTypeFunction %8\n"             // void()
+        "%10 = OpTypeInt 32 1\n"               // int32
+        "%11 = OpTypeInt 32 0\n"               // uint32
+        "%4 = OpTypeRuntimeArray %10\n"        // int32[]
+        "%5 = OpTypeStruct %4\n"               // struct{ int32[] }
+        "%12 = OpTypePointer Uniform %5\n"     // struct{ int32[] }*
+        "%6 = OpVariable %12 Uniform\n"        // struct{ int32[] }* out
+        "%7 = OpVariable %12 Uniform\n"        // struct{ int32[] }* in
+        "%13 = OpConstant %10 0\n"             // int32(0)
+        "%14 = OpConstant %11 0\n"             // uint32(0)
+        "%15 = OpConstant %11 " << (localSize - 1) << "\n" << // uint32(N - 1)
+        "%16 = OpConstant %11 2\n"             // Workgroup scope
+        "%17 = OpConstant %11 264\n"           // AcquireRelease | WorkgroupMemory
+        "%18 = OpTypeVector %11 3\n"           // vec3<uint32>
+        "%19 = OpTypePointer Input %18\n"      // vec3<uint32>*
+        "%2 = OpVariable %19 Input\n"          // gl_GlobalInvocationId
+        "%20 = OpTypePointer Input %11\n"      // uint32*
+        "%3 = OpVariable %20 Input\n"          // gl_LocalInvocationIndex
+        "%21 = OpConstant %11 " << localSize << "\n" << // uint32(N)
+        "%22 = OpTypeArray %10 %21\n"          // int32[N]
+        "%23 = OpTypePointer Workgroup %22\n"  // int32[N]*
+        "%24 = OpVariable %23 Workgroup\n"     // s
+        "%25 = OpTypePointer Workgroup %10\n"  // int32*
+        "%26 = OpTypePointer Uniform %10\n"    // int32*
+        "%1 = OpFunction %8 None %9\n"         // -- Function begin --
+        "%27 = OpLabel\n"
+        "%28 = OpAccessChain %20 %2 %14\n"     // &gl_GlobalInvocationId.x
+        "%29 = OpLoad %11 %28\n"               // gl_GlobalInvocationId.x
+        "%30 = OpLoad %11 %3\n"                // gl_LocalInvocationIndex
+        "%31 = OpAccessChain %26 %7 %13 %29\n" // &in.arr[gl_GlobalInvocationId.x]
+        "%32 = OpLoad %10 %31\n"               // v
+        "%33 = OpAccessChain %25 %24 %30\n"    // &s[gl_LocalInvocationIndex]
+        "OpStore %33 %32\n"                    // s[gl_LocalInvocationIndex] = v
+        "OpControlBarrier %16 %16 %17\n"       // barrier()
+        "%34 = OpISub %11 %15 %30\n"           // N - 1 - gl_LocalInvocationIndex
+        "%35 = OpAccessChain %25 %24 %34\n"    // &s[N - 1 - gl_LocalInvocationIndex]
+        "%36 = OpLoad %10 %35\n"               // s[N - 1 - gl_LocalInvocationIndex]
+        "%37 = OpIAdd %10 %36 %32\n"           // s[N - 1 - gl_LocalInvocationIndex] + v
+        "%38 = OpAccessChain %26 %6 %13 %29\n" // &out.arr[gl_GlobalInvocationId.x]
+        "OpStore %38 %37\n"                    // out.arr[gl_GlobalInvocationId.x] = s[N - 1 - gl_LocalInvocationIndex] + v
+        "OpReturn\n"
+        "OpFunctionEnd\n";
+	// clang-format on
+
+	test(
+	    src.str(), [](uint32_t i) { return i; },
+	    [localSize](uint32_t i) {
+		    uint32_t local = i % localSize;
+		    return (i - local + localSize - 1 - local) + i;
+	    });
+}
+
+TEST_P(SwiftShaderVulkanBufferToBufferComputeTest, WorkgroupBarrierInFunction)
+{
+	uint32_t localSize = GetParam().localSizeX * GetParam().localSizeY * GetParam().localSizeZ;
+
+	std::stringstream src;
+	// #version 450
+	// layout(local_size_x = N) in;
+	// layout(binding = 0, std430) buffer InBuffer
+	// {
+	//     int Data[];
+	// } In;
+	// layout(binding = 1, std430) buffer OutBuffer
+	// {
+	//     int Data[];
+	// } Out;
+	// shared int s[N];
+	// void sync()
+	// {
+	//     barrier();
+	// }
+	// void main()
+	// {
+	//     int v = In.Data[gl_GlobalInvocationID.x];
+	//     s[gl_LocalInvocationIndex] = v;
+	//     sync();
+	//     Out.Data[gl_GlobalInvocationID.x] = s[N - 1 - gl_LocalInvocationIndex] + v;
+	// }
+	// clang-format off
+    src <<
+        "OpCapability Shader\n"
+        "OpMemoryModel Logical GLSL450\n"
+        "OpEntryPoint GLCompute %1 \"main\" %2 %3\n"
+        "OpExecutionMode %1 LocalSize " <<
+        GetParam().localSizeX << " " <<
+        GetParam().localSizeY << " " <<
+        GetParam().localSizeZ << "\n" <<
+        "OpDecorate %4 ArrayStride 4\n"
+        "OpMemberDecorate %5 0 Offset 0\n"
+        "OpDecorate %5 BufferBlock\n"
+        "OpDecorate %6 DescriptorSet 0\n"
+        "OpDecorate %6 Binding 1\n"
+        "OpDecorate %2 BuiltIn GlobalInvocationId\n"
+        "OpDecorate %3 BuiltIn LocalInvocationIndex\n"
+        "OpDecorate %7 DescriptorSet 0\n"
+        "OpDecorate %7 Binding 0\n"
+        "%8 = OpTypeVoid\n"
+        "%9 = OpTypeFunction %8\n"             // void()
+        "%10 = OpTypeInt 32 1\n"               // int32
+        "%11 = OpTypeInt 32 0\n"               // uint32
+        "%4 = OpTypeRuntimeArray %10\n"        // int32[]
+        "%5 = OpTypeStruct %4\n"               // struct{ int32[] }
+        "%12 = OpTypePointer Uniform %5\n"     // struct{ int32[] }*
+        "%6 = OpVariable %12 Uniform\n"        // struct{ int32[] }* out
+        "%7 = OpVariable %12 Uniform\n"        // struct{ int32[] }* in
+        "%13 = OpConstant %10 0\n"             // int32(0)
+        "%14 = OpConstant %11 0\n"             // uint32(0)
+        "%15 = OpConstant %11 " << (localSize - 1) << "\n" << // uint32(N - 1)
+        "%16 = OpConstant %11 2\n"             // Workgroup scope
+        "%17 = OpConstant %11 264\n"           // AcquireRelease | WorkgroupMemory
+        "%18 = OpTypeVector %11 3\n"           // vec3<uint32>
+        "%19 = OpTypePointer Input %18\n"      // vec3<uint32>*
+        "%2 = OpVariable %19 Input\n"          // gl_GlobalInvocationId
+        "%20 = OpTypePointer Input %11\n"      // uint32*
+        "%3 = OpVariable %20 Input\n"          // gl_LocalInvocationIndex
+        "%21 = OpConstant %11 " << localSize << "\n" << // uint32(N)
+        "%22 = OpTypeArray %10 %21\n"          // int32[N]
+        "%23 = OpTypePointer Workgroup %22\n"  // int32[N]*
+        "%24 = OpVariable %23 Workgroup\n"     // s
+        "%25 = OpTypePointer Workgroup %10\n"  // int32*
+        "%26 = OpTypePointer Uniform %10\n"    // int32*
+        "%39 = OpFunction %8 None %9\n"        // -- sync() begin --
+        "%40 = OpLabel\n"
+        "OpControlBarrier %16 %16 %17\n"       // barrier()
+        "OpReturn\n"
+        "OpFunctionEnd\n"                      // -- sync() end --
+        "%1 = OpFunction %8 None %9\n"         // -- Function begin --
+        "%27 = OpLabel\n"
+        "%28 = OpAccessChain %20 %2 %14\n"     // &gl_GlobalInvocationId.x
+        "%29 = OpLoad %11 %28\n"               // gl_GlobalInvocationId.x
+        "%30 = OpLoad %11 %3\n"                // gl_LocalInvocationIndex
+        "%31 = OpAccessChain %26 %7 %13 %29\n" // &in.arr[gl_GlobalInvocationId.x]
+        "%32 = OpLoad %10 %31\n"               // v
+        "%33 = OpAccessChain %25 %24 %30\n"    // &s[gl_LocalInvocationIndex]
+        "OpStore %33 %32\n"                    // s[gl_LocalInvocationIndex] = v
+        "%41 = OpFunctionCall %8 %39\n"        // sync()
+        "%34 = OpISub %11 %15 %30\n"           // N - 1 - gl_LocalInvocationIndex
+        "%35 = OpAccessChain %25 %24 %34\n"    // &s[N - 1 - gl_LocalInvocationIndex]
+        "%36 = OpLoad %10 %35\n"               // s[N - 1 - gl_LocalInvocationIndex]
+        "%37 = OpIAdd %10 %36 %32\n"           // s[N - 1 - gl_LocalInvocationIndex] + v
+        "%38 = OpAccessChain %26 %6 %13 %29\n" // &out.arr[gl_GlobalInvocationId.x]
+        "OpStore %38 %37\n"                    // out.arr[gl_GlobalInvocationId.x] = s[N - 1 - gl_LocalInvocationIndex] + v
+        "OpReturn\n"
+        "OpFunctionEnd\n";
+	// clang-format on
+
+	test(
+	    src.str(), [](uint32_t i) { return i; },
+	    [localSize](uint32_t i) {
+		    uint32_t local = i % localSize;
+		    return (i - local + localSize - 1 - local) + i;
+	    });
+}
+
+// #version 450
+// layout(local_size_x = X, local_size_y = Y, local_size_z = Z) in;
+// layout(binding = 0, std430) buffer InBuffer
+// {
+//     uint Data[];
+// } In;
+// layout(binding = 1, std430) buffer OutBuffer
+// {
+//     uint Data[];
+// } Out;
+// void main()
+// {
+//     uint n = In.Data[0] + (gl_GlobalInvocationID.x & 3);
+//     uint sum = 0;
+//     for (uint i = 0; i < n; i++)
+//     {
+//         sum += In.Data[i];
+//     }
+//     Out.Data[gl_GlobalInvocationID.x] = sum;
+// }
+static std::string loopLoadShader(const ComputeParams &params)
+{
+	std::stringstream src;
+	// clang-format off
+    src <<
+        "OpCapability Shader\n"
+        "OpMemoryModel Logical GLSL450\n"
+        "OpEntryPoint GLCompute %1 \"main\" %2\n"
+        "OpExecutionMode %1 LocalSize " <<
+        params.localSizeX << " " <<
+        params.localSizeY << " " <<
+        params.localSizeZ << "\n" <<
+        "OpDecorate %2 BuiltIn GlobalInvocationId\n"
+        "OpDecorate %3 ArrayStride 4\n"
+        "OpMemberDecorate %4 0 Offset 0\n"
+        "OpDecorate %4 BufferBlock\n"
+        "OpDecorate %5 DescriptorSet 0\n"
+        "OpDecorate %5 Binding 0\n"
+        "OpDecorate %6 DescriptorSet 0\n"
+        "OpDecorate %6 Binding 1\n"
+        "%7 = OpTypeVoid\n"
+        "%8 = OpTypeFunction %7\n"             // void()
+        "%9 = OpTypeInt 32 0\n"                // uint32
+        "%10 = OpTypeBool\n"
+        "%3 = OpTypeRuntimeArray %9\n"         // uint32[]
+        "%4 = OpTypeStruct %3\n"               // struct{ uint32[] }
+        "%11 = OpTypePointer Uniform %4\n"     // struct{ uint32[] }*
+        "%5 = OpVariable %11 Uniform\n"        // struct{ uint32[] }* in
+        "%6 = OpVariable %11 Uniform\n"        // struct{ uint32[] }* out
+        "%12 = OpTypePointer Uniform %9\n"     // uint32*
+        "%13 = OpConstant %9 0\n"              // uint32(0)
+        "%14 = OpConstant %9 1\n"              // uint32(1)
+        "%15 = OpConstant %9 3\n"              // uint32(3)
+        "%16 = OpTypeVector %9 3\n"            // vec3<uint32>
+        "%17 = OpTypePointer Input %16\n"      // vec3<uint32>*
+        "%2 = OpVariable %17 Input\n"          // gl_GlobalInvocationId
+        "%18 = OpTypePointer Input %9\n"       // uint32*
+        "%1 = OpFunction %7 None %8\n"         // -- Function begin --
+        "%19 = OpLabel\n"
+        "%20 = OpAccessChain %18 %2 %13\n"     // &gl_GlobalInvocationId.x
+        "%21 = OpLoad %9 %20\n"                // gl_GlobalInvocationId.x
+        "%22 = OpAccessChain %12 %5 %13 %13\n" // &in.arr[0]
+        "%23 = OpLoad %9 %22\n"                // in.arr[0]
+        "%24 = OpBitwiseAnd %9 %21 %15\n"      // gl_GlobalInvocationId.x & 3
+        "%25 = OpIAdd %9 %23 %24\n"            // n
+        "OpBranch %26\n"
+        "%26 = OpLabel\n"                      // loop header
+        "%27 = OpPhi %9 %13 %19 %28 %29\n"     // i
+        "%30 = OpPhi %9 %13 %19 %31 %29\n"     // sum
+        "OpLoopMerge %32 %29 None\n"
+        "OpBranch %33\n"
+        "%33 = OpLabel\n"
+        "%34 = OpULessThan %10 %27 %25\n"      // i < n
+        "OpBranchConditional %34 %35 %32\n"
+        "%35 = OpLabel\n"                      // loop body
+        "%36 = OpAccessChain %12 %5 %13 %27\n" // &in.arr[i]
+        "%37 = OpLoad %9 %36\n"                // in.arr[i]
+        "%31 = OpIAdd %9 %30 %37\n"            // sum + in.arr[i]
+        "OpBranch %29\n"
+        "%29 = OpLabel\n"                      // continue target
+        "%28 = OpIAdd %9 %27 %14\n"            // i + 1
+        "OpBranch %26\n"
+        "%32 = OpLabel\n"                      // loop merge
+        "%38 = OpAccessChain %12 %6 %13 %21\n" // &out.arr[gl_GlobalInvocationId.x]
+        "OpStore %38 %30\n"                    // out.arr[gl_GlobalInvocationId.x] = sum
+        "OpReturn\n"
+        "OpFunctionEnd\n";
+	// clang-format on
+
+	return src.str();
+}
+
+// Out-of-bounds loads of a robust buffer access return zero, so only the
+// in-bounds elements contribute to the sums.
+static uint32_t loopLoadSum(uint32_t n, uint32_t numElements, uint32_t idx)
+{
+	uint32_t count = std::min(n + (idx & 3), numElements);
+	return (count > 0 ? n : 0) + count * (count - 1) / 2;
+}
+
+TEST_P(SwiftShaderVulkanBufferToBufferComputeTest, LoopLoadInBoundsRobust)
+{
+	uint32_t numElements = static_cast<uint32_t>(GetParam().numElements);
+	uint32_t n = numElements > 3 ? numElements - 3 : 0;
+
+	test(
+	    loopLoadShader(GetParam()), [n](uint32_t i) { return (i == 0) ? n : i; },
+	    [n, numElements](uint32_t i) { return loopLoadSum(n, numElements, i); },
+	    true);
+}
+
+TEST_P(SwiftShaderVulkanBufferToBufferComputeTest, LoopLoadOutOfBoundsRobust)
+{
+	uint32_t numElements = static_cast<uint32_t>(GetParam().numElements);
+	uint32_t n = numElements + 5;
+
+	test(
+	    loopLoadShader(GetParam()), [n](uint32_t i) { return (i == 0) ? n : i; },
+	    [n, numElements](uint32_t i) { return loopLoadSum(n, numElements, i); },
+	    true);
+}
+
+// #version 450
+// layout(local_size_x = X, local_size_y = Y, local_size_z = Z) in;
+// layout(binding = 0, std430) buffer InBuffer
+// {
+//     int Data[];
+// } In;
+// layout(binding = 1, std430) buffer OutBuffer
+// {
+//     int Data[];
+// } Out;
+// void main()
+// {
+//     int n = In.Data[0];
+//     for (int i = 0; i < n; i++)
+//     {
+//         Out.Data[i] = i + 1;
+//     }
+// }
+static std::string loopStoreShader(const ComputeParams &params)
+{
+	std::stringstream src;
+	// clang-format off
+    src <<
+        "OpCapability Shader\n"
+        "OpMemoryModel Logical GLSL450\n"
+        "OpEntryPoint GLCompute %1 \"main\"\n"
+        "OpExecutionMode %1 LocalSize " <<
+        params.localSizeX << " " <<
+        params.localSizeY << " " <<
+        params.localSizeZ << "\n" <<
+        "OpDecorate %3 ArrayStride 4\n"
+        "OpMemberDecorate %4 0 Offset 0\n"
+        "OpDecorate %4 BufferBlock\n"
+        "OpDecorate %5 DescriptorSet 0\n"
+        "OpDecorate %5 Binding 0\n"
+        "OpDecorate %6 DescriptorSet 0\n"
+        "OpDecorate %6 Binding 1\n"
+        "%7 = OpTypeVoid\n"
+        "%8 = OpTypeFunction %7\n"             // void()
+        "%9 = OpTypeInt 32 1\n"                // int32
+        "%10 = OpTypeBool\n"
+        "%3 = OpTypeRuntimeArray %9\n"         // int32[]
+        "%4 = OpTypeStruct %3\n"               // struct{ int32[] }
+        "%11 = OpTypePointer Uniform %4\n"     // struct{ int32[] }*
+        "%5 = OpVariable %11 Uniform\n"        // struct{ int32[] }* in
+        "%6 = OpVariable %11 Uniform\n"        // struct{ int32[] }* out
+        "%12 = OpTypePointer Uniform %9\n"     // int32*
+        "%13 = OpConstant %9 0\n"              // int32(0)
+        "%14 = OpConstant %9 1\n"              // int32(1)
+        "%1 = OpFunction %7 None %8\n"         // -- Function begin --
+        "%15 = OpLabel\n"
+        "%16 = OpAccessChain %12 %5 %13 %13\n" // &in.arr[0]
+        "%17 = OpLoad %9 %16\n"                // n
+        "OpBranch %18\n"
+        "%18 = OpLabel\n"                      // loop header
+        "%19 = OpPhi %9 %13 %15 %20 %21\n"     // i
+        "%22 = OpSLessThan %10 %19 %17\n"      // i < n
+        "OpLoopMerge %23 %21 None\n"
+        "OpBranchConditional %22 %24 %23\n"
+        "%24 = OpLabel\n"                      // loop body
+        "%25 = OpIAdd %9 %19 %14\n"            // i + 1
+        "%26 = OpAccessChain %12 %6 %13 %19\n" // &out.arr[i]
+        "OpStore %26 %25\n"                    // out.arr[i] = i + 1
+        "OpBranch %21\n"
+        "%21 = OpLabel\n"                      // continue target
+        "%20 = OpIAdd %9 %19 %14\n"            // i + 1
+        "OpBranch %18\n"
+        "%23 = OpLabel\n"                      // loop merge
+        "OpReturn\n"
+        "OpFunctionEnd\n";
+	// clang-format on
+
+	return src.str();
+}
+
+TEST_P(SwiftShaderVulkanBufferToBufferComputeTest, LoopStoreInBoundsRobust)
+{
+	uint32_t n = static_cast<uint32_t>(GetParam().numElements);
+
+	test(
+	    loopStoreShader(GetParam()), [n](uint32_t i) { return (i == 0) ? n : 0; },
+	    [](uint32_t i) { return i + 1; },
+	    true);
+}
+
+TEST_P(SwiftShaderVulkanBufferToBufferComputeTest, LoopStoreOutOfBoundsRobust)
+{
+	// Out-of-bounds stores of a robust buffer access are discarded, leaving
+	// the magic value which follows the output buffer intact.
+	uint32_t n = static_cast<uint32_t>(GetParam().numElements) + 1;
+
+	test(
+	    loopStoreShader(GetParam()), [n](uint32_t i) { return (i == 0) ? n : 0; },
+	    [](uint32_t i) { return i + 1; },
+	    true);
+}
+
+// The following shaders branch on bits of the invocation index. Shifting
+// out the two lowest bits makes the branches coherent across each group of
+// four invocations, which leaves their costlier blocks without any active
+// lanes to be skipped. Without the shift, the branches diverge in every
+// group, and the blocks run with partial masks.
+static constexpr uint32_t coherentShift = 2;
+static constexpr uint32_t divergentShift = 0;
+
+// #version 450
+// layout(local_size_x = X, local_size_y = Y, local_size_z = Z) in;
+// layout(binding = 0, std430) buffer InBuffer
+// {
+//     uint Data[];
+// } In;
+// layout(binding = 1, std430) buffer OutBuffer
+// {
+//     uint Data[];
+// } Out;
+// void main()
+// {
+//     uint x = gl_GlobalInvocationID.x;
+//     uint e = x & ~1u;
+//     uint v;
+//     if (((x >> SHIFT) & 1) == 0)
+//     {
+//         v = In.Data[x] + In.Data[e] * 2;
+//     }
+//     else
+//     {
+//         v = In.Data[x] * 3 + In.Data[e];
+//     }
+//     Out.Data[x] = v;
+// }
+static std::string skippableBranchShader(const ComputeParams &params, uint32_t shift)
+{
+	std::stringstream src;
+	// clang-format off
+    src <<
+        "OpCapability Shader\n"
+        "OpMemoryModel Logical GLSL450\n"
+        "OpEntryPoint GLCompute %1 \"main\" %2\n"
+        "OpExecutionMode %1 LocalSize " <<
+        params.localSizeX << " " <<
+        params.localSizeY << " " <<
+        params.localSizeZ << "\n" <<
+        "OpDecorate %2 BuiltIn GlobalInvocationId\n"
+        "OpDecorate %3 ArrayStride 4\n"
+        "OpMemberDecorate %4 0 Offset 0\n"
+        "OpDecorate %4 BufferBlock\n"
+        "OpDecorate %5 DescriptorSet 0\n"
+        "OpDecorate %5 Binding 0\n"
+        "OpDecorate %6 DescriptorSet 0\n"
+        "OpDecorate %6 Binding 1\n"
+        "%7 = OpTypeVoid\n"
+        "%8 = OpTypeFunction %7\n"             // void()
+        "%9 = OpTypeInt 32 0\n"                // uint32
+        "%10 = OpTypeBool\n"
+        "%3 = OpTypeRuntimeArray %9\n"         // uint32[]
+        "%4 = OpTypeStruct %3\n"               // struct{ uint32[] }
+        "%11 = OpTypePointer Uniform %4\n"     // struct{ uint32[] }*
+        "%5 = OpVariable %11 Uniform\n"        // struct{ uint32[] }* in
+        "%6 = OpVariable %11 Uniform\n"        // struct{ uint32[] }* out
+        "%12 = OpTypePointer Uniform %9\n"     // uint32*
+        "%13 = OpConstant %9 0\n"              // uint32(0)
+        "%14 = OpConstant %9 1\n"              // uint32(1)
+        "%15 = OpConstant %9 " << shift << "\n" << // uint32(SHIFT)
+        "%16 = OpConstant %9 4294967294\n"     // ~1u
+        "%17 = OpConstant %9 2\n"              // uint32(2)
+        "%18 = OpConstant %9 3\n"              // uint32(3)
+        "%19 = OpTypeVector %9 3\n"            // vec3<uint32>
+        "%20 = OpTypePointer Input %19\n"      // vec3<uint32>*
+        "%2 = OpVariable %20 Input\n"          // gl_GlobalInvocationId
+        "%21 = OpTypePointer Input %9\n"       // uint32*
+        "%1 = OpFunction %7 None %8\n"         // -- Function begin --
+        "%22 = OpLabel\n"
+        "%23 = OpAccessChain %21 %2 %13\n"     // &gl_GlobalInvocationId.x
+        "%24 = OpLoad %9 %23\n"                // x
+        "%25 = OpBitwiseAnd %9 %24 %16\n"      // e
+        "%26 = OpShiftRightLogical %9 %24 %15\n"
+        "%27 = OpBitwiseAnd %9 %26 %14\n"
+        "%28 = OpIEqual %10 %27 %13\n"         // ((x >> SHIFT) & 1) == 0
+        "OpSelectionMerge %29 None\n"
+        "OpBranchConditional %28 %30 %31\n"
+        "%30 = OpLabel\n"                      // then
+        "%32 = OpAccessChain %12 %5 %13 %24\n"
+        "%33 = OpLoad %9 %32\n"                // in.arr[x]
+        "%34 = OpAccessChain %12 %5 %13 %25\n"
+        "%35 = OpLoad %9 %34\n"                // in.arr[e]
+        "%36 = OpIMul %9 %35 %17\n"
+        "%37 = OpIAdd %9 %33 %36\n"            // in.arr[x] + in.arr[e] * 2
+        "OpBranch %29\n"
+        "%31 = OpLabel\n"                      // else
+        "%38 = OpAccessChain %12 %5 %13 %24\n"
+        "%39 = OpLoad %9 %38\n"                // in.arr[x]
+        "%40 = OpAccessChain %12 %5 %13 %25\n"
+        "%41 = OpLoad %9 %40\n"                // in.arr[e]
+        "%42 = OpIMul %9 %39 %18\n"
+        "%43 = OpIAdd %9 %42 %41\n"            // in.arr[x] * 3 + in.arr[e]
+        "OpBranch %29\n"
+        "%29 = OpLabel\n"                      // merge
+        "%44 = OpPhi %9 %37 %30 %43 %31\n"     // v
+        "%45 = OpAccessChain %12 %6 %13 %24\n"
+        "OpStore %45 %44\n"                    // out.arr[x] = v
+        "OpReturn\n"
+        "OpFunctionEnd\n";
+	// clang-format on
+
+	return src.str();
+}
+
+static uint32_t skippableBranchExpected(uint32_t shift, uint32_t x)
+{
+	uint32_t e = x & ~1u;
+	return (((x >> shift) & 1) == 0) ? x + e * 2 : x * 3 + e;
+}
+
+TEST_P(SwiftShaderVulkanBufferToBufferComputeTest, SkippableBranchPhiCoherent)
+{
+	test(
+	    skippableBranchShader(GetParam(), coherentShift), [](uint32_t i) { return i; },
+	    [](uint32_t i) { return skippableBranchExpected(coherentShift, i); });
+}
+
+TEST_P(SwiftShaderVulkanBufferToBufferComputeTest, SkippableBranchPhiDivergent)
+{
+	test(
+	    skippableBranchShader(GetParam(), divergentShift), [](uint32_t i) { return i; },
+	    [](uint32_t i) { return skippableBranchExpected(divergentShift, i); });
+}
+
+// #version 450
+// layout(local_size_x = X, local_size_y = Y, local_size_z = Z) in;
+// layout(binding = 0, std430) buffer InBuffer
+// {
+//     uint Data[];
+// } In;
+// layout(binding = 1, std430) buffer OutBuffer
+// {
+//     uint Data[];
+// } Out;
+// void main()
+// {
+//     uint x = gl_GlobalInvocationID.x;
+//     uint e = x & ~1u;
+//     uint v;
+//     switch ((x >> SHIFT) & 3)
+//     {
+//     case 0: v = In.Data[x] + In.Data[e] * 2; break;
+//     case 1: v = In.Data[x] * 3 + In.Data[e]; break;
+//     case 2: v = In.Data[x] * In.Data[e] + 1; break;
+//     default: v = e; break;
+//     }
+//     Out.Data[x] = v;
+// }
+static std::string skippableSwitchShader(const ComputeParams &params, uint32_t shift)
+{
+	std::stringstream src;
+	// clang-format off
+    src <<
+        "OpCapability Shader\n"
+        "OpMemoryModel Logical GLSL450\n"
+        "OpEntryPoint GLCompute %1 \"main\" %2\n"
+        "OpExecutionMode %1 LocalSize " <<
+        params.localSizeX << " " <<
+        params.localSizeY << " " <<
+        params.localSizeZ << "\n" <<
+        "OpDecorate %2 BuiltIn GlobalInvocationId\n"
+        "OpDecorate %3 ArrayStride 4\n"
+        "OpMemberDecorate %4 0 Offset 0\n"
+        "OpDecorate %4 BufferBlock\n"
+        "OpDecorate %5 DescriptorSet 0\n"
+        "OpDecorate %5 Binding 0\n"
+        "OpDecorate %6 DescriptorSet 0\n"
+        "OpDecorate %6 Binding 1\n"
+        "%7 = OpTypeVoid\n"
+        "%8 = OpTypeFunction %7\n"             // void()
+        "%9 = OpTypeInt 32 0\n"                // uint32
+        "%3 = OpTypeRuntimeArray %9\n"         // uint32[]
+        "%4 = OpTypeStruct %3\n"               // struct{ uint32[] }
+        "%11 = OpTypePointer Uniform %4\n"     // struct{ uint32[] }*
+        "%5 = OpVariable %11 Uniform\n"        // struct{ uint32[] }* in
+        "%6 = OpVariable %11 Uniform\n"        // struct{ uint32[] }* out
+        "%12 = OpTypePointer Uniform %9\n"     // uint32*
+        "%13 = OpConstant %9 0\n"              // uint32(0)
+        "%14 = OpConstant %9 1\n"              // uint32(1)
+        "%15 = OpConstant %9 " << shift << "\n" << // uint32(SHIFT)
+        "%16 = OpConstant %9 4294967294\n"     // ~1u
+        "%17 = OpConstant %9 2\n"              // uint32(2)
+        "%18 = OpConstant %9 3\n"              // uint32(3)
+        "%19 = OpTypeVector %9 3\n"            // vec3<uint32>
+        "%20 = OpTypePointer Input %19\n"      // vec3<uint32>*
+        "%2 = OpVariable %20 Input\n"          // gl_GlobalInvocationId
+        "%21 = OpTypePointer Input %9\n"       // uint32*
+        "%1 = OpFunction %7 None %8\n"         // -- Function begin --
+        "%22 = OpLabel\n"
+        "%23 = OpAccessChain %21 %2 %13\n"     // &gl_GlobalInvocationId.x
+        "%24 = OpLoad %9 %23\n"                // x
+        "%25 = OpBitwiseAnd %9 %24 %16\n"      // e
+        "%26 = OpShiftRightLogical %9 %24 %15\n"
+        "%27 = OpBitwiseAnd %9 %26 %18\n"      // (x >> SHIFT) & 3
+        "OpSelectionMerge %28 None\n"
+        "OpSwitch %27 %29 0 %30 1 %31 2 %32\n"
+        "%30 = OpLabel\n"                      // case 0
+        "%33 = OpAccessChain %12 %5 %13 %24\n"
+        "%34 = OpLoad %9 %33\n"                // in.arr[x]
+        "%35 = OpAccessChain %12 %5 %13 %25\n"
+        "%36 = OpLoad %9 %35\n"                // in.arr[e]
+        "%37 = OpIMul %9 %36 %17\n"
+        "%38 = OpIAdd %9 %34 %37\n"            // in.arr[x] + in.arr[e] * 2
+        "OpBranch %28\n"
+        "%31 = OpLabel\n"                      // case 1
+        "%39 = OpAccessChain %12 %5 %13 %24\n"
+        "%40 = OpLoad %9 %39\n"                // in.arr[x]
+        "%41 = OpAccessChain %12 %5 %13 %25\n"
+        "%42 = OpLoad %9 %41\n"                // in.arr[e]
+        "%43 = OpIMul %9 %40 %18\n"
+        "%44 = OpIAdd %9 %43 %42\n"            // in.arr[x] * 3 + in.arr[e]
+        "OpBranch %28\n"
+        "%32 = OpLabel\n"                      // case 2
+        "%45 = OpAccessChain %12 %5 %13 %24\n"
+        "%46 = OpLoad %9 %45\n"                // in.arr[x]
+        "%47 = OpAccessChain %12 %5 %13 %25\n"
+        "%48 = OpLoad %9 %47\n"                // in.arr[e]
+        "%49 = OpIMul %9 %46 %48\n"
+        "%50 = OpIAdd %9 %49 %14\n"            // in.arr[x] * in.arr[e] + 1
+        "OpBranch %28\n"
+        "%29 = OpLabel\n"                      // default
+        "OpBranch %28\n"
+        "%28 = OpLabel\n"                      // merge
+        "%51 = OpPhi %9 %38 %30 %44 %31 %50 %32 %25 %29\n" // v
+        "%52 = OpAccessChain %12 %6 %13 %24\n"
+        "OpStore %52 %51\n"                    // out.arr[x] = v
+        "OpReturn\n"
+        "OpFunctionEnd\n";
+	// clang-format on
+
+	return src.str();
+}
+
+static uint32_t skippableSwitchExpected(uint32_t shift, uint32_t x)
+{
+	uint32_t e = x & ~1u;
+	switch((x >> shift) & 3)
+	{
+	case 0: return x + e * 2;
+	case 1: return x * 3 + e;
+	case 2: return x * e + 1;
+	default: return e;
+	}
+}
+
+TEST_P(SwiftShaderVulkanBufferToBufferComputeTest, SkippableSwitchPhiCoherent)
+{
+	test(
+	    skippableSwitchShader(GetParam(), coherentShift), [](uint32_t i) { return i; },
+	    [](uint32_t i) { return skippableSwitchExpected(coherentShift, i); });
+}
+
+TEST_P(SwiftShaderVulkanBufferToBufferComputeTest, SkippableSwitchPhiDivergent)
+{
+	test(
+	    skippableSwitchShader(GetParam(), divergentShift), [](uint32_t i) { return i; },
+	    [](uint32_t i) { return skippableSwitchExpected(divergentShift, i); });
+}
+
+// #version 450
+// layout(local_size_x = X, local_size_y = Y, local_size_z = Z) in;
+// layout(binding = 0, std430) buffer InBuffer
+// {
+//     uint Data[];
+// } In;
+// layout(binding = 1, std430) buffer OutBuffer
+// {
+//     uint Data[];
+// } Out;
+// void main()
+// {
+//     uint x = gl_GlobalInvocationID.x;
+//     uint e = x & ~1u;
+//     uint v = 0;
+//     if (((x >> SHIFT) & 1) == 0)
+//     {
+//         uint a = In.Data[x];
+//         uint b = a + In.Data[e];
+//         if (((x >> (SHIFT + 1)) & 1) == 0)
+//         {
+//             b += In.Data[x] * In.Data[e];
+//         }
+//         v = b + a;
+//     }
+//     Out.Data[x] = v;
+// }
+static std::string skippableNestedShader(const ComputeParams &params, uint32_t shift)
+{
+	std::stringstream src;
+	// clang-format off
+    src <<
+        "OpCapability Shader\n"
+        "OpMemoryModel Logical GLSL450\n"
+        "OpEntryPoint GLCompute %1 \"main\" %2\n"
+        "OpExecutionMode %1 LocalSize " <<
+        params.localSizeX << " " <<
+        params.localSizeY << " " <<
+        params.localSizeZ << "\n" <<
+        "OpDecorate %2 BuiltIn GlobalInvocationId\n"
+        "OpDecorate %3 ArrayStride 4\n"
+        "OpMemberDecorate %4 0 Offset 0\n"
+        "OpDecorate %4 BufferBlock\n"
+        "OpDecorate %5 DescriptorSet 0\n"
+        "OpDecorate %5 Binding 0\n"
+        "OpDecorate %6 DescriptorSet 0\n"
+        "OpDecorate %6 Binding 1\n"
+        "%7 = OpTypeVoid\n"
+        "%8 = OpTypeFunction %7\n"             // void()
+        "%9 = OpTypeInt 32 0\n"                // uint32
+        "%10 = OpTypeBool\n"
+        "%3 = OpTypeRuntimeArray %9\n"         // uint32[]
+        "%4 = OpTypeStruct %3\n"               // struct{ uint32[] }
+        "%11 = OpTypePointer Uniform %4\n"     // struct{ uint32[] }*
+        "%5 = OpVariable %11 Uniform\n"        // struct{ uint32[] }* in
+        "%6 = OpVariable %11 Uniform\n"        // struct{ uint32[] }* out
+        "%12 = OpTypePointer Uniform %9\n"     // uint32*
+        "%13 = OpConstant %9 0\n"              // uint32(0)
+        "%14 = OpConstant %9 1\n"              // uint32(1)
+        "%15 = OpConstant %9 " << shift << "\n" << // uint32(SHIFT)
+        "%16 = OpConstant %9 4294967294\n"     // ~1u
+        "%17 = OpConstant %9 " << (shift + 1) << "\n" << // uint32(SHIFT + 1)
+        "%19 = OpTypeVector %9 3\n"            // vec3<uint32>
+        "%20 = OpTypePointer Input %19\n"      // vec3<uint32>*
+        "%2 = OpVariable %20 Input\n"          // gl_GlobalInvocationId
+        "%21 = OpTypePointer Input %9\n"       // uint32*
+        "%1 = OpFunction %7 None %8\n"         // -- Function begin --
+        "%22 = OpLabel\n"
+        "%23 = OpAccessChain %21 %2 %13\n"     // &gl_GlobalInvocationId.x
+        "%24 = OpLoad %9 %23\n"                // x
+        "%25 = OpBitwiseAnd %9 %24 %16\n"      // e
+        "%26 = OpShiftRightLogical %9 %24 %15\n"
+        "%27 = OpBitwiseAnd %9 %26 %14\n"
+        "%28 = OpIEqual %10 %27 %13\n"         // ((x >> SHIFT) & 1) == 0
+        "%29 = OpShiftRightLogical %9 %24 %17\n"
+        "%30 = OpBitwiseAnd %9 %29 %14\n"
+        "%31 = OpIEqual %10 %30 %13\n"         // ((x >> (SHIFT + 1)) & 1) == 0
+        "OpSelectionMerge %32 None\n"
+        "OpBranchConditional %28 %33 %32\n"
+        "%33 = OpLabel\n"                      // outer then
+        "%34 = OpAccessChain %12 %5 %13 %24\n"
+        "%35 = OpLoad %9 %34\n"                // a
+        "%36 = OpAccessChain %12 %5 %13 %25\n"
+        "%37 = OpLoad %9 %36\n"                // in.arr[e]
+        "%38 = OpIAdd %9 %35 %37\n"            // b
+        "OpSelectionMerge %39 None\n"
+        "OpBranchConditional %31 %40 %39\n"
+        "%40 = OpLabel\n"                      // inner then
+        "%41 = OpAccessChain %12 %5 %13 %24\n"
+        "%42 = OpLoad %9 %41\n"                // in.arr[x]
+        "%43 = OpAccessChain %12 %5 %13 %25\n"
+        "%44 = OpLoad %9 %43\n"                // in.arr[e]
+        "%45 = OpIMul %9 %42 %44\n"
+        "%46 = OpIAdd %9 %38 %45\n"            // b + in.arr[x] * in.arr[e]
+        "OpBranch %39\n"
+        "%39 = OpLabel\n"                      // inner merge
+        "%47 = OpPhi %9 %38 %33 %46 %40\n"     // b
+        "%48 = OpIAdd %9 %47 %35\n"            // b + a
+        "OpBranch %32\n"
+        "%32 = OpLabel\n"                      // outer merge
+        "%49 = OpPhi %9 %13 %22 %48 %39\n"     // v
+        "%50 = OpAccessChain %12 %6 %13 %24\n"
+        "OpStore %50 %49\n"                    // out.arr[x] = v
+        "OpReturn\n"
+        "OpFunctionEnd\n";
+	// clang-format on
+
+	return src.str();
+}
+
+static uint32_t skippableNestedExpected(uint32_t shift, uint32_t x)
+{
+	uint32_t e = x & ~1u;
+	if(((x >> shift) & 1) != 0)
+	{
+		return 0;
+	}
+
+	uint32_t b = x + e;
+	if(((x >> (shift + 1)) & 1) == 0)
+	{
+		b += x * e;
+	}
+	return b + x;
+}
+
+TEST_P(SwiftShaderVulkanBufferToBufferComputeTest, SkippableNestedSelectionCoherent)
+{
+	test(
+	    skippableNestedShader(GetParam(), coherentShift), [](uint32_t i) { return i; },
+	    [](uint32_t i) { return skippableNestedExpected(coherentShift, i); });
+}
+
+TEST_P(SwiftShaderVulkanBufferToBufferComputeTest, SkippableNestedSelectionDivergent)
+{
+	test(
+	    skippableNestedShader(GetParam(), divergentShift), [](uint32_t i) { return i; },
+	    [](uint32_t i) { return skippableNestedExpected(divergentShift, i); });
+}
+
+// The index into the shared table is dynamically uniform and bounded, so the
+// consuming block loads it without a mask. It's defined in a skippable block
+// which a group of invocations may not take at all, in which case the
+// consuming block still runs, with no active lanes.
+//
+// #version 450
+// layout(local_size_x = X, local_size_y = Y, local_size_z = Z) in;
+// layout(binding = 0, std430) buffer InBuffer
+// {
+//     uint Data[];
+// } In;
+// layout(binding = 1, std430) buffer OutBuffer
+// {
+//     uint Data[];
+// } Out;
+// shared uint table[16];
+// void main()
+// {
+//     uint x = gl_GlobalInvocationID.x;
+//     table[(In.Data[0] + 3) & 15] = 42;
+//     barrier();
+//     uint v;
+//     if (((x >> SHIFT) & 1) == 0)
+//     {
+//         uint k = (In.Data[0] + 3) & 15;
+//         uint w = In.Data[x] * 3 + In.Data[x & ~1u];
+//         // (separate block)
+//         v = table[k] + w;
+//     }
+//     else
+//     {
+//         v = In.Data[x];
+//     }
+//     Out.Data[x] = v;
+// }
+static std::string skippableUniformIndexShader(const ComputeParams &params, uint32_t shift)
+{
+	std::stringstream src;
+	// clang-format off
+    src <<
+        "OpCapability Shader\n"
+        "OpMemoryModel Logical GLSL450\n"
+        "OpEntryPoint GLCompute %1 \"main\" %2\n"
+        "OpExecutionMode %1 LocalSize " <<
+        params.localSizeX << " " <<
+        params.localSizeY << " " <<
+        params.localSizeZ << "\n" <<
+        "OpDecorate %2 BuiltIn GlobalInvocationId\n"
+        "OpDecorate %3 ArrayStride 4\n"
+        "OpMemberDecorate %4 0 Offset 0\n"
+        "OpDecorate %4 BufferBlock\n"
+        "OpDecorate %5 DescriptorSet 0\n"
+        "OpDecorate %5 Binding 0\n"
+        "OpDecorate %6 DescriptorSet 0\n"
+        "OpDecorate %6 Binding 1\n"
+        "%7 = OpTypeVoid\n"
+        "%8 = OpTypeFunction %7\n"             // void()
+        "%9 = OpTypeInt 32 0\n"                // uint32
+        "%10 = OpTypeBool\n"
+        "%3 = OpTypeRuntimeArray %9\n"         // uint32[]
+        "%4 = OpTypeStruct %3\n"               // struct{ uint32[] }
+        "%11 = OpTypePointer Uniform %4\n"     // struct{ uint32[] }*
+        "%5 = OpVariable %11 Uniform\n"        // struct{ uint32[] }* in
+        "%6 = OpVariable %11 Uniform\n"        // struct{ uint32[] }* out
+        "%12 = OpTypePointer Uniform %9\n"     // uint32*
+        "%13 = OpConstant %9 0\n"              // uint32(0)
+        "%14 = OpConstant %9 1\n"              // uint32(1)
+        "%15 = OpConstant %9 " << shift << "\n" << // uint32(SHIFT)
+        "%16 = OpConstant %9 4294967294\n"     // ~1u
+        "%17 = OpConstant %9 3\n"              // uint32(3)
+        "%18 = OpConstant %9 15\n"             // uint32(15)
+        "%19 = OpConstant %9 16\n"             // uint32(16)
+        "%20 = OpConstant %9 42\n"             // uint32(42)
+        "%21 = OpConstant %9 2\n"              // Workgroup scope
+        "%22 = OpConstant %9 264\n"            // AcquireRelease | WorkgroupMemory
+        "%23 = OpTypeVector %9 3\n"            // vec3<uint32>
+        "%24 = OpTypePointer Input %23\n"      // vec3<uint32>*
+        "%2 = OpVariable %24 Input\n"          // gl_GlobalInvocationId
+        "%25 = OpTypePointer Input %9\n"       // uint32*
+        "%26 = OpTypeArray %9 %19\n"           // uint32[16]
+        "%27 = OpTypePointer Workgroup %26\n"  // uint32[16]*
+        "%28 = OpVariable %27 Workgroup\n"     // table
+        "%29 = OpTypePointer Workgroup %9\n"   // uint32*
+        "%1 = OpFunction %7 None %8\n"         // -- Function begin --
+        "%30 = OpLabel\n"
+        "%31 = OpAccessChain %25 %2 %13\n"     // &gl_GlobalInvocationId.x
+        "%32 = OpLoad %9 %31\n"                // x
+        "%33 = OpAccessChain %12 %5 %13 %13\n"
+        "%34 = OpLoad %9 %33\n"                // in.arr[0]
+        "%35 = OpIAdd %9 %34 %17\n"
+        "%36 = OpBitwiseAnd %9 %35 %18\n"      // (in.arr[0] + 3) & 15
+        "%37 = OpAccessChain %29 %28 %36\n"
+        "OpStore %37 %20\n"                    // table[(in.arr[0] + 3) & 15] = 42
+        "OpControlBarrier %21 %21 %22\n"       // barrier()
+        "%38 = OpShiftRightLogical %9 %32 %15\n"
+        "%39 = OpBitwiseAnd %9 %38 %14\n"
+        "%40 = OpIEqual %10 %39 %13\n"         // ((x >> SHIFT) & 1) == 0
+        "OpSelectionMerge %41 None\n"
+        "OpBranchConditional %40 %42 %43\n"
+        "%42 = OpLabel\n"                      // then, skippable
+        "%44 = OpAccessChain %12 %5 %13 %13\n"
+        "%45 = OpLoad %9 %44\n"                // in.arr[0]
+        "%46 = OpIAdd %9 %45 %17\n"
+        "%47 = OpBitwiseAnd %9 %46 %18\n"      // k
+        "%48 = OpAccessChain %12 %5 %13 %32\n"
+        "%49 = OpLoad %9 %48\n"                // in.arr[x]
+        "%50 = OpBitwiseAnd %9 %32 %16\n"      // x & ~1
+        "%51 = OpAccessChain %12 %5 %13 %50\n"
+        "%52 = OpLoad %9 %51\n"                // in.arr[x & ~1]
+        "%53 = OpIMul %9 %49 %17\n"
+        "%54 = OpIAdd %9 %53 %52\n"            // w
+        "OpBranch %55\n"
+        "%55 = OpLabel\n"                      // then, consumer
+        "%56 = OpAccessChain %29 %28 %47\n"
+        "%57 = OpLoad %9 %56\n"                // table[k]
+        "%58 = OpIAdd %9 %57 %54\n"            // table[k] + w
+        "OpBranch %41\n"
+        "%43 = OpLabel\n"                      // else
+        "%59 = OpAccessChain %12 %5 %13 %32\n"
+        "%60 = OpLoad %9 %59\n"                // in.arr[x]
+        "OpBranch %41\n"
+        "%41 = OpLabel\n"                      // merge
+        "%61 = OpPhi %9 %58 %55 %60 %43\n"     // v
+        "%62 = OpAccessChain %12 %6 %13 %32\n"
+        "OpStore %62 %61\n"                    // out.arr[x] = v
+        "OpReturn\n"
+        "OpFunctionEnd\n";
+	// clang-format on
+
+	return src.str();
+}
+
+static uint32_t skippableUniformIndexExpected(uint32_t shift, uint32_t x)
+{
+	if(((x >> shift) & 1) != 0)
+	{
+		return x;
+	}
+
+	return 42 + x * 3 + (x & ~1u);
+}
+
+TEST_P(SwiftShaderVulkanBufferToBufferComputeTest, SkippableUniformIndexCoherent)
+{
+	test(
+	    skippableUniformIndexShader(GetParam(), coherentShift), [](uint32_t i) { return i; },
+	    [](uint32_t i) { return skippableUniformIndexExpected(coherentShift, i); });
+}
+
+TEST_P(SwiftShaderVulkanBufferToBufferComputeTest, SkippableUniformIndexDivergent)
+{
+	test(
+	    skippableUniformIndexShader(GetParam(), divergentShift), [](uint32_t i) { return i; },
+	    [](uint32_t i) { return skippableUniformIndexExpected(divergentShift, i); });
+}
+
+// Integer divisions of dynamically uniform operands are performed once, on
+// the first lane. The following tests divide by values which are divergent,
+// even though they're derived from uniform ones, and divide uniform values
+// in a branch which lane 0 doesn't take.
+
+TEST_P(SwiftShaderVulkanBufferToBufferComputeTest, DivisionByLaneDependentLoad)
+{
+	// #version 450
+	// layout(local_size_x = X, local_size_y = Y, local_size_z = Z) in;
+	// layout(binding = 0, std430) buffer InBuffer
+	// {
+	//     uint Data[];
+	// } In;
+	// layout(binding = 1, std430) buffer OutBuffer
+	// {
+	//     uint Data[];
+	// } Out;
+	// void main()
+	// {
+	//     uint x = gl_GlobalInvocationID.x;
+	//     uint n = In.Data[0];
+	//     uint d = In.Data[x] + 1;
+	//     Out.Data[x] = n / d + n % d;
+	// }
+	std::stringstream src;
+	// clang-format off
+    src <<
+        "OpCapability Shader\n"
+        "OpMemoryModel Logical GLSL450\n"
+        "OpEntryPoint GLCompute %1 \"main\" %2\n"
+        "OpExecutionMode %1 LocalSize " <<
+        GetParam().localSizeX << " " <<
+        GetParam().localSizeY << " " <<
+        GetParam().localSizeZ << "\n" <<
+        "OpDecorate %2 BuiltIn GlobalInvocationId\n"
+        "OpDecorate %3 ArrayStride 4\n"
+        "OpMemberDecorate %4 0 Offset 0\n"
+        "OpDecorate %4 BufferBlock\n"
+        "OpDecorate %5 DescriptorSet 0\n"
+        "OpDecorate %5 Binding 0\n"
+        "OpDecorate %6 DescriptorSet 0\n"
+        "OpDecorate %6 Binding 1\n"
+        "%7 = OpTypeVoid\n"
+        "%8 = OpTypeFunction %7\n"             // void()
+        "%9 = OpTypeInt 32 0\n"                // uint32
+        "%3 = OpTypeRuntimeArray %9\n"         // uint32[]
+        "%4 = OpTypeStruct %3\n"               // struct{ uint32[] }
+        "%11 = OpTypePointer Uniform %4\n"     // struct{ uint32[] }*
+        "%5 = OpVariable %11 Uniform\n"        // struct{ uint32[] }* in
+        "%6 = OpVariable %11 Uniform\n"        // struct{ uint32[] }* out
+        "%12 = OpTypePointer Uniform %9\n"     // uint32*
+        "%13 = OpConstant %9 0\n"              // uint32(0)
+        "%14 = OpConstant %9 1\n"              // uint32(1)
+        "%15 = OpTypeVector %9 3\n"            // vec3<uint32>
+        "%16 = OpTypePointer Input %15\n"      // vec3<uint32>*
+        "%2 = OpVariable %16 Input\n"          // gl_GlobalInvocationId
+        "%17 = OpTypePointer Input %9\n"       // uint32*
+        "%1 = OpFunction %7 None %8\n"         // -- Function begin --
+        "%18 = OpLabel\n"
+        "%19 = OpAccessChain %17 %2 %13\n"     // &gl_GlobalInvocationId.x
+        "%20 = OpLoad %9 %19\n"                // x
+        "%21 = OpAccessChain %12 %5 %13 %13\n" // &in.arr[0]
+        "%22 = OpLoad %9 %21\n"                // n
+        "%23 = OpAccessChain %12 %5 %13 %20\n" // &in.arr[x]
+        "%24 = OpLoad %9 %23\n"                // in.arr[x]
+        "%25 = OpIAdd %9 %24 %14\n"            // d
+        "%26 = OpUDiv %9 %22 %25\n"            // n / d
+        "%27 = OpUMod %9 %22 %25\n"            // n % d
+        "%28 = OpIAdd %9 %26 %27\n"
+        "%29 = OpAccessChain %12 %6 %13 %20\n" // &out.arr[x]
+        "OpStore %29 %28\n"                    // out.arr[x] = n / d + n % d
+        "OpReturn\n"
+        "OpFunctionEnd\n";
+	// clang-format on
+
+	constexpr uint32_t n = 1000003;
+	test(
+	    src.str(), [](uint32_t i) { return (i == 0) ? n : i * 3; },
+	    [](uint32_t i) {
+		    uint32_t d = ((i == 0) ? n : i * 3) + 1;
+		    return n / d + n % d;
+	    });
+}
+
+TEST_P(SwiftShaderVulkanBufferToBufferComputeTest, DivisionByPhiOfUniformValues)
+{
+	// #version 450
+	// layout(local_size_x = X, local_size_y = Y, local_size_z = Z) in;
+	// layout(binding = 0, std430) buffer InBuffer
+	// {
+	//     int Data[];
+	// } In;
+	// layout(binding = 1, std430) buffer OutBuffer
+	// {
+	//     int Data[];
+	// } Out;
+	// void main()
+	// {
+	//     uint x = gl_GlobalInvocationID.x;
+	//     int n = In.Data[0];
+	//     int d;
+	//     if ((x & 1) == 0)
+	//     {
+	//         d = In.Data[1];
+	//     }
+	//     else
+	//     {
+	//         d = In.Data[2];
+	//     }
+	//     Out.Data[x] = n / d + n % d;
+	// }
+	std::stringstream src;
+	// clang-format off
+    src <<
+        "OpCapability Shader\n"
+        "OpMemoryModel Logical GLSL450\n"
+        "OpEntryPoint GLCompute %1 \"main\" %2\n"
+        "OpExecutionMode %1 LocalSize " <<
+        GetParam().localSizeX << " " <<
+        GetParam().localSizeY << " " <<
+        GetParam().localSizeZ << "\n" <<
+        "OpDecorate %2 BuiltIn GlobalInvocationId\n"
+        "OpDecorate %3 ArrayStride 4\n"
+        "OpMemberDecorate %4 0 Offset 0\n"
+        "OpDecorate %4 BufferBlock\n"
+        "OpDecorate %5 DescriptorSet 0\n"
+        "OpDecorate %5 Binding 0\n"
+        "OpDecorate %6 DescriptorSet 0\n"
+        "OpDecorate %6 Binding 1\n"
+        "%7 = OpTypeVoid\n"
+        "%8 = OpTypeFunction %7\n"             // void()
+        "%9 = OpTypeInt 32 1\n"                // int32
+        "%10 = OpTypeInt 32 0\n"               // uint32
+        "%11 = OpTypeBool\n"
+        "%3 = OpTypeRuntimeArray %9\n"         // int32[]
+        "%4 = OpTypeStruct %3\n"               // struct{ int32[] }
+        "%12 = OpTypePointer Uniform %4\n"     // struct{ int32[] }*
+        "%5 = OpVariable %12 Uniform\n"        // struct{ int32[] }* in
+        "%6 = OpVariable %12 Uniform\n"        // struct{ int32[] }* out
+        "%13 = OpTypePointer Uniform %9\n"     // int32*
+        "%14 = OpConstant %9 0\n"              // int32(0)
+        "%15 = OpConstant %9 1\n"              // int32(1)
+        "%16 = OpConstant %9 2\n"              // int32(2)
+        "%17 = OpConstant %10 0\n"             // uint32(0)
+        "%18 = OpConstant %10 1\n"             // uint32(1)
+        "%19 = OpTypeVector %10 3\n"           // vec3<uint32>
+        "%20 = OpTypePointer Input %19\n"      // vec3<uint32>*
+        "%2 = OpVariable %20 Input\n"          // gl_GlobalInvocationId
+        "%21 = OpTypePointer Input %10\n"      // uint32*
+        "%1 = OpFunction %7 None %8\n"         // -- Function begin --
+        "%22 = OpLabel\n"
+        "%23 = OpAccessChain %21 %2 %17\n"     // &gl_GlobalInvocationId.x
+        "%24 = OpLoad %10 %23\n"               // x
+        "%25 = OpAccessChain %13 %5 %14 %14\n" // &in.arr[0]
+        "%26 = OpLoad %9 %25\n"                // n
+        "%27 = OpBitwiseAnd %10 %24 %18\n"
+        "%28 = OpIEqual %11 %27 %17\n"         // (x & 1) == 0
+        "OpSelectionMerge %29 None\n"
+        "OpBranchConditional %28 %30 %31\n"
+        "%30 = OpLabel\n"
+        "%32 = OpAccessChain %13 %5 %14 %15\n" // &in.arr[1]
+        "%33 = OpLoad %9 %32\n"                // in.arr[1]
+        "OpBranch %29\n"
+        "%31 = OpLabel\n"
+        "%34 = OpAccessChain %13 %5 %14 %16\n" // &in.arr[2]
+        "%35 = OpLoad %9 %34\n"                // in.arr[2]
+        "OpBranch %29\n"
+        "%29 = OpLabel\n"
+        "%36 = OpPhi %9 %33 %30 %35 %31\n"     // d
+        "%37 = OpSDiv %9 %26 %36\n"            // n / d
+        "%38 = OpSRem %9 %26 %36\n"            // n % d
+        "%39 = OpIAdd %9 %37 %38\n"
+        "%40 = OpAccessChain %13 %6 %14 %24\n" // &out.arr[x]
+        "OpStore %40 %39\n"                    // out.arr[x] = n / d + n % d
+        "OpReturn\n"
+        "OpFunctionEnd\n";
+	// clang-format on
+
+	constexpr int32_t n = 1000003;
+	constexpr int32_t even = 7;
+	constexpr int32_t odd = -13;
+	test(
+	    src.str(), [](uint32_t i) { return (i == 0) ? n : (i == 1) ? even : (i == 2) ? odd : i; },
+	    [](uint32_t i) {
+		    int32_t d = ((i & 1) == 0) ? even : odd;
+		    return static_cast<uint32_t>(n / d + n % d);
+	    });
+}
+
+TEST_P(SwiftShaderVulkanBufferToBufferComputeTest, UniformDivisionWithInactiveFirstLane)
+{
+	// #version 450
+	// layout(local_size_x = X, local_size_y = Y, local_size_z = Z) in;
+	// layout(binding = 0, std430) buffer InBuffer
+	// {
+	//     uint Data[];
+	// } In;
+	// layout(binding = 1, std430) buffer OutBuffer
+	// {
+	//     uint Data[];
+	// } Out;
+	// void main()
+	// {
+	//     uint x = gl_GlobalInvocationID.x;
+	//     uint v = 0;
+	//     if ((x & 3) != 0)
+	//     {
+	//         v = In.Data[0] / In.Data[1];
+	//     }
+	//     Out.Data[x] = v;
+	// }
+	std::stringstream src;
+	// clang-format off
+    src <<
+        "OpCapability Shader\n"
+        "OpMemoryModel Logical GLSL450\n"
+        "OpEntryPoint GLCompute %1 \"main\" %2\n"
+        "OpExecutionMode %1 LocalSize " <<
+        GetParam().localSizeX << " " <<
+        GetParam().localSizeY << " " <<
+        GetParam().localSizeZ << "\n" <<
+        "OpDecorate %2 BuiltIn GlobalInvocationId\n"
+        "OpDecorate %3 ArrayStride 4\n"
+        "OpMemberDecorate %4 0 Offset 0\n"
+        "OpDecorate %4 BufferBlock\n"
+        "OpDecorate %5 DescriptorSet 0\n"
+        "OpDecorate %5 Binding 0\n"
+        "OpDecorate %6 DescriptorSet 0\n"
+        "OpDecorate %6 Binding 1\n"
+        "%7 = OpTypeVoid\n"
+        "%8 = OpTypeFunction %7\n"             // void()
+        "%9 = OpTypeInt 32 0\n"                // uint32
+        "%10 = OpTypeBool\n"
+        "%3 = OpTypeRuntimeArray %9\n"         // uint32[]
+        "%4 = OpTypeStruct %3\n"               // struct{ uint32[] }
+        "%11 = OpTypePointer Uniform %4\n"     // struct{ uint32[] }*
+        "%5 = OpVariable %11 Uniform\n"        // struct{ uint32[] }* in
+        "%6 = OpVariable %11 Uniform\n"        // struct{ uint32[] }* out
+        "%12 = OpTypePointer Uniform %9\n"     // uint32*
+        "%13 = OpConstant %9 0\n"              // uint32(0)
+        "%14 = OpConstant %9 1\n"              // uint32(1)
+        "%15 = OpConstant %9 3\n"              // uint32(3)
+        "%16 = OpTypeVector %9 3\n"            // vec3<uint32>
+        "%17 = OpTypePointer Input %16\n"      // vec3<uint32>*
+        "%2 = OpVariable %17 Input\n"          // gl_GlobalInvocationId
+        "%18 = OpTypePointer Input %9\n"       // uint32*
+        "%1 = OpFunction %7 None %8\n"         // -- Function begin --
+        "%19 = OpLabel\n"
+        "%20 = OpAccessChain %18 %2 %13\n"     // &gl_GlobalInvocationId.x
+        "%21 = OpLoad %9 %20\n"                // x
+        "%22 = OpBitwiseAnd %9 %21 %15\n"
+        "%23 = OpINotEqual %10 %22 %13\n"      // (x & 3) != 0
+        "OpSelectionMerge %24 None\n"
+        "OpBranchConditional %23 %25 %24\n"
+        "%25 = OpLabel\n"
+        "%26 = OpAccessChain %12 %5 %13 %13\n" // &in.arr[0]
+        "%27 = OpLoad %9 %26\n"                // in.arr[0]
+        "%28 = OpAccessChain %12 %5 %13 %14\n" // &in.arr[1]
+        "%29 = OpLoad %9 %28\n"                // in.arr[1]
+        "%30 = OpUDiv %9 %27 %29\n"            // in.arr[0] / in.arr[1]
+        "OpBranch %24\n"
+        "%24 = OpLabel\n"
+        "%31 = OpPhi %9 %13 %19 %30 %25\n"     // v
+        "%32 = OpAccessChain %12 %6 %13 %21\n" // &out.arr[x]
+        "OpStore %32 %31\n"                    // out.arr[x] = v
+        "OpReturn\n"
+        "OpFunctionEnd\n";
+	// clang-format on
+
+	test(
+	    src.str(), [](uint32_t i) { return (i == 0) ? 1000003 : (i == 1) ? 7 : i; },
+	    [](uint32_t i) { return ((i & 3) != 0) ? 1000003u / 7u : 0u; });
+}
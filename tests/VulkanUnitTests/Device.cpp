@@ -46,7 +46,8 @@ bool Device::IsValid() const
 }
 
 VkResult Device::CreateComputeDevice(
-    const Driver *driver, VkInstance instance, std::unique_ptr<Device> &out)
+    const Driver *driver, VkInstance instance, std::unique_ptr<Device> &out,
+    const VkPhysicalDeviceFeatures *enabledFeatures)
 {
 	VkResult result;
 
@@ -87,7 +88,7 @@ VkResult Device::CreateComputeDevice(
 			nullptr,                               // ppEnabledLayerNames
 			0,                                     // enabledExtensionCount
 			nullptr,                               // ppEnabledExtensionNames
-			nullptr,                               // pEnabledFeatures
+			enabledFeatures,                       // pEnabledFeatures
 		};
 
 		VkDevice device;
@@ -34,8 +34,10 @@ public:
 	// If a compatible physical device is not found, VK_SUCCESS will still be
 	// returned (as there was no Vulkan error), but calling Device::IsValid()
 	// on this device will return false.
+	// enabledFeatures may be null to enable no features.
 	static VkResult CreateComputeDevice(
-	    const Driver *driver, VkInstance instance, std::unique_ptr<Device> &out);
+	    const Driver *driver, VkInstance instance, std::unique_ptr<Device> &out,
+	    const VkPhysicalDeviceFeatures *enabledFeatures = nullptr);
 
 	// IsValid returns true if the Device is initialized and can be used.
 	bool IsValid() const;
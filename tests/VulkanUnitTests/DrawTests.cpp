@@ -13,10 +13,13 @@
 // limitations under the License.
 
 #include "DrawTester.hpp"
+#include "OffscreenTester.hpp"
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+#include <functional>
+
 class DrawTest : public testing::Test
 {
 };
@@ -74,3 +77,1039 @@ TEST_F(DrawTest, VertexShaderNoPositionOutput)
 	tester.initialize();
 	tester.renderFrame();
 }
+
+class DeferredClearTest : public testing::Test
+{
+protected:
+	static constexpr uint32_t Size = 64;
+	static constexpr vk::Format ColorFormat = vk::Format::eR8G8B8A8Unorm;
+	static constexpr vk::Format DepthFormat = vk::Format::eD32Sfloat;
+
+	// Draws the [x0, x1) x [y0, y1) rectangle, in pixels, at the given depth.
+	struct Rect
+	{
+		uint32_t x0, y0, x1, y1;
+		float depth;
+		Color color;
+
+		bool contains(uint32_t x, uint32_t y) const { return x >= x0 && x < x1 && y >= y0 && y < y1; }
+	};
+
+	void SetUp() override
+	{
+		tester.initialize();
+
+		colorTarget = tester.createRenderTarget(ColorFormat, vk::Extent2D(Size, Size));
+		depthTarget = tester.createRenderTarget(DepthFormat, vk::Extent2D(Size, Size));
+
+		const char *vertexShader = R"(#version 450
+			layout(push_constant) uniform Params
+			{
+				vec4 rect;
+				vec4 color;
+				float depth;
+			} params;
+
+			void main()
+			{
+				const vec2 corners[6] = vec2[](vec2(0, 0), vec2(1, 0), vec2(0, 1),
+				                               vec2(1, 0), vec2(1, 1), vec2(0, 1));
+				gl_Position = vec4(mix(params.rect.xy, params.rect.zw, corners[gl_VertexIndex]), params.depth, 1.0);
+			})";
+
+		const char *fragmentShader = R"(#version 450
+			layout(push_constant) uniform Params
+			{
+				vec4 rect;
+				vec4 color;
+				float depth;
+			} params;
+
+			layout(location = 0) out vec4 outColor;
+
+			void main()
+			{
+				outColor = params.color;
+			})";
+
+		layout = tester.createPipelineLayout();
+		vertexModule = tester.createShaderModule(vertexShader, EShLanguage::EShLangVertex);
+		fragmentModule = tester.createShaderModule(fragmentShader, EShLanguage::EShLangFragment);
+	}
+
+	vk::RenderPass createRenderPass(vk::AttachmentLoadOp loadOp, bool depth)
+	{
+		return tester.createRenderPass(ColorFormat, depth ? DepthFormat : vk::Format::eUndefined, loadOp);
+	}
+
+	vk::Framebuffer createFramebuffer(vk::RenderPass renderPass, bool depth)
+	{
+		std::vector<vk::ImageView> attachments = { colorTarget.view };
+		if(depth)
+		{
+			attachments.push_back(depthTarget.view);
+		}
+
+		return tester.createFramebuffer(renderPass, attachments, vk::Extent2D(Size, Size));
+	}
+
+	vk::Pipeline createPipeline(vk::RenderPass renderPass, bool depth)
+	{
+		OffscreenTester::GraphicsPipelineState state;
+		state.renderPass = renderPass;
+		state.layout = layout;
+		state.vertexShader = vertexModule;
+		state.fragmentShader = fragmentModule;
+		state.depthTest = depth;
+
+		return tester.createGraphicsPipeline(state);
+	}
+
+	void beginRenderPass(vk::CommandBuffer &commandBuffer, vk::RenderPass renderPass, vk::Framebuffer framebuffer, Color clearColor, float clearDepth = 1.0f)
+	{
+		OffscreenTester::beginRenderPass(commandBuffer, renderPass, framebuffer, vk::Extent2D(Size, Size),
+		                                 { clearColor.toClearColor(), vk::ClearDepthStencilValue(clearDepth, 0) });
+	}
+
+	void draw(vk::CommandBuffer &commandBuffer, vk::Pipeline pipeline, const Rect &rect)
+	{
+		struct
+		{
+			float rect[4];
+			float color[4];
+			float depth;
+		} params;
+
+		params.rect[0] = 2.0f * rect.x0 / Size - 1.0f;
+		params.rect[1] = 2.0f * rect.y0 / Size - 1.0f;
+		params.rect[2] = 2.0f * rect.x1 / Size - 1.0f;
+		params.rect[3] = 2.0f * rect.y1 / Size - 1.0f;
+		params.color[0] = rect.color.r / 255.0f;
+		params.color[1] = rect.color.g / 255.0f;
+		params.color[2] = rect.color.b / 255.0f;
+		params.color[3] = rect.color.a / 255.0f;
+		params.depth = rect.depth;
+
+		commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
+		commandBuffer.pushConstants(layout, vk::ShaderStageFlagBits::eAll, 0, sizeof(params), &params);
+		commandBuffer.draw(6, 1, 0, 0);
+	}
+
+	// Checks that every pixel has the color of the last rectangle covering
+	// it, or the clear color if there's none.
+	void expectColor(const std::vector<Color> &texels, Color clearColor, const std::vector<Rect> &rects)
+	{
+		for(uint32_t y = 0; y < Size; y++)
+		{
+			for(uint32_t x = 0; x < Size; x++)
+			{
+				Color expected = clearColor;
+				for(const Rect &rect : rects)
+				{
+					if(rect.contains(x, y))
+					{
+						expected = rect.color;
+					}
+				}
+
+				const Color &actual = texels[y * Size + x];
+				ASSERT_TRUE(actual == expected) << "x " << x << ", y " << y << ": got ("
+				                                << int(actual.r) << ", " << int(actual.g) << ", " << int(actual.b) << ", " << int(actual.a) << ")";
+			}
+		}
+	}
+
+	const Color clearColor = { 51, 102, 153, 255 };
+	const Color red = { 255, 0, 0, 255 };
+	const Color green = { 0, 255, 0, 255 };
+
+	OffscreenTester tester;
+
+	OffscreenTester::RenderTarget colorTarget;
+	OffscreenTester::RenderTarget depthTarget;
+
+	vk::PipelineLayout layout;
+	vk::ShaderModule vertexModule;
+	vk::ShaderModule fragmentModule;
+};
+
+// A load op clear followed by a draw covering part of the attachment must
+// still clear the rows which weren't drawn to.
+TEST_F(DeferredClearTest, LoadOpClearThenPartialDraw)
+{
+	vk::RenderPass renderPass = createRenderPass(vk::AttachmentLoadOp::eClear, false);
+	vk::Framebuffer framebuffer = createFramebuffer(renderPass, false);
+	vk::Pipeline pipeline = createPipeline(renderPass, false);
+
+	std::vector<Rect> rects = {
+		{ 0, 0, 32, 16, 0.5f, red },
+		{ 8, 40, 24, 48, 0.5f, green },
+	};
+
+	tester.submit([&](vk::CommandBuffer &commandBuffer) {
+		beginRenderPass(commandBuffer, renderPass, framebuffer, clearColor);
+		for(const Rect &rect : rects)
+		{
+			draw(commandBuffer, pipeline, rect);
+		}
+		commandBuffer.endRenderPass();
+	});
+
+	expectColor(tester.readTexels<Color>(colorTarget), clearColor, rects);
+}
+
+// A load op clear without any draws must be resolved by the end of the
+// render pass, so a copy of the attachment sees the cleared contents.
+TEST_F(DeferredClearTest, LoadOpClearThenCopy)
+{
+	vk::RenderPass renderPass = createRenderPass(vk::AttachmentLoadOp::eClear, false);
+	vk::Framebuffer framebuffer = createFramebuffer(renderPass, false);
+	vk::Pipeline pipeline = createPipeline(renderPass, false);
+
+	OffscreenTester::RenderTarget copy = tester.createRenderTarget(ColorFormat, vk::Extent2D(Size, Size));
+
+	std::vector<Rect> rects = {
+		{ 16, 16, 48, 24, 0.5f, red },
+	};
+
+	tester.submit([&](vk::CommandBuffer &commandBuffer) {
+		beginRenderPass(commandBuffer, renderPass, framebuffer, clearColor);
+		commandBuffer.endRenderPass();
+
+		// A second pass clearing to another color and drawing to a few rows.
+		beginRenderPass(commandBuffer, renderPass, framebuffer, green);
+		draw(commandBuffer, pipeline, rects[0]);
+		commandBuffer.endRenderPass();
+
+		OffscreenTester::fullBarrier(commandBuffer);
+
+		vk::ImageCopy region;
+		region.srcSubresource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, 1);
+		region.dstSubresource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, 1);
+		region.extent = vk::Extent3D(Size, Size, 1);
+		commandBuffer.copyImage(colorTarget.image, vk::ImageLayout::eGeneral, copy.image, vk::ImageLayout::eGeneral, 1, &region);
+	});
+
+	expectColor(tester.readTexels<Color>(copy), green, rects);
+}
+
+// A full attachment vkCmdClearAttachments() is deferred like a load op clear.
+TEST_F(DeferredClearTest, ClearAttachmentsThenPartialDraw)
+{
+	vk::RenderPass renderPass = createRenderPass(vk::AttachmentLoadOp::eLoad, false);
+	vk::Framebuffer framebuffer = createFramebuffer(renderPass, false);
+	vk::Pipeline pipeline = createPipeline(renderPass, false);
+
+	tester.writeTexels(colorTarget, std::vector<Color>(Size * Size, Color{ 1, 2, 3, 4 }));
+
+	std::vector<Rect> rects = {
+		{ 40, 60, 64, 64, 0.5f, red },
+	};
+
+	tester.submit([&](vk::CommandBuffer &commandBuffer) {
+		beginRenderPass(commandBuffer, renderPass, framebuffer, clearColor);
+
+		vk::ClearAttachment clearAttachment;
+		clearAttachment.aspectMask = vk::ImageAspectFlagBits::eColor;
+		clearAttachment.colorAttachment = 0;
+		clearAttachment.clearValue.color = clearColor.toClearColor();
+		vk::ClearRect clearRect(vk::Rect2D(vk::Offset2D(0, 0), vk::Extent2D(Size, Size)), 0, 1);
+		commandBuffer.clearAttachments(1, &clearAttachment, 1, &clearRect);
+
+		draw(commandBuffer, pipeline, rects[0]);
+		commandBuffer.endRenderPass();
+	});
+
+	expectColor(tester.readTexels<Color>(colorTarget), clearColor, rects);
+}
+
+// Contents of a deferred clear must be resolved by the time a following
+// render pass loads the attachment.
+TEST_F(DeferredClearTest, LoadOpClearThenLoad)
+{
+	vk::RenderPass clearPass = createRenderPass(vk::AttachmentLoadOp::eClear, false);
+	vk::RenderPass loadPass = createRenderPass(vk::AttachmentLoadOp::eLoad, false);
+	vk::Framebuffer framebuffer = createFramebuffer(clearPass, false);
+	vk::Pipeline pipeline = createPipeline(clearPass, false);
+
+	std::vector<Rect> rects = {
+		{ 0, 0, 16, 16, 0.5f, red },
+		{ 48, 48, 64, 64, 0.5f, green },
+	};
+
+	tester.submit([&](vk::CommandBuffer &commandBuffer) {
+		beginRenderPass(commandBuffer, clearPass, framebuffer, clearColor);
+		draw(commandBuffer, pipeline, rects[0]);
+		commandBuffer.endRenderPass();
+
+		beginRenderPass(commandBuffer, loadPass, framebuffer, clearColor);
+		draw(commandBuffer, pipeline, rects[1]);
+		commandBuffer.endRenderPass();
+	});
+
+	expectColor(tester.readTexels<Color>(colorTarget), clearColor, rects);
+}
+
+// Depth tests against a deferred depth clear must see the cleared value.
+TEST_F(DeferredClearTest, DepthClearThenPartialDraw)
+{
+	vk::RenderPass renderPass = createRenderPass(vk::AttachmentLoadOp::eClear, true);
+	vk::Framebuffer framebuffer = createFramebuffer(renderPass, true);
+	vk::Pipeline pipeline = createPipeline(renderPass, true);
+
+	const float clearDepth = 0.5f;
+	Rect front = { 0, 0, 32, 40, 0.25f, red };
+	Rect behind = { 32, 0, 64, 40, 0.75f, green };
+
+	tester.submit([&](vk::CommandBuffer &commandBuffer) {
+		beginRenderPass(commandBuffer, renderPass, framebuffer, clearColor, clearDepth);
+		draw(commandBuffer, pipeline, front);
+		draw(commandBuffer, pipeline, behind);
+		commandBuffer.endRenderPass();
+	});
+
+	expectColor(tester.readTexels<Color>(colorTarget), clearColor, { front });
+
+	std::vector<float> depth = tester.readTexels<float>(depthTarget);
+	for(uint32_t y = 0; y < Size; y++)
+	{
+		for(uint32_t x = 0; x < Size; x++)
+		{
+			float expected = front.contains(x, y) ? front.depth : clearDepth;
+			ASSERT_EQ(depth[y * Size + x], expected) << "x " << x << ", y " << y;
+		}
+	}
+}
+
+// Draws a rectangle covering the top rows of a depth attachment, with a clip
+// distance which is negative on the left half of the attachment.
+class ClipDistanceDepthTest : public testing::Test
+{
+protected:
+	static constexpr uint32_t Size = 64;
+	static constexpr uint32_t ClipX = Size / 2;  // Pixels left of it are clipped
+	static constexpr uint32_t DrawRows = 40;    // Rows covered by the rectangle
+	static constexpr vk::Format ColorFormat = vk::Format::eR8G8B8A8Unorm;
+	static constexpr vk::Format DepthFormat = vk::Format::eD32Sfloat;
+	static constexpr float ClearDepth = 1.0f;
+	static constexpr float DrawDepth = 0.25f;
+
+	void SetUp() override
+	{
+		tester.initialize();
+
+		vk::PhysicalDeviceFeatures features = tester.getPhysicalDevice().getFeatures();
+		if(!features.shaderClipDistance)
+		{
+			GTEST_SKIP() << "shaderClipDistance not supported";
+		}
+
+		colorTarget = tester.createRenderTarget(ColorFormat, vk::Extent2D(Size, Size));
+		depthTarget = tester.createRenderTarget(DepthFormat, vk::Extent2D(Size, Size));
+
+		const char *vertexShader = R"(#version 450
+			void main()
+			{
+				const vec2 corners[6] = vec2[](vec2(0, 0), vec2(1, 0), vec2(0, 1),
+				                               vec2(1, 0), vec2(1, 1), vec2(0, 1));
+				// Covers the top 40 of 64 rows, and is clipped left of the center.
+				vec2 position = mix(vec2(-1.0, -1.0), vec2(1.0, 0.25), corners[gl_VertexIndex]);
+				gl_Position = vec4(position, 0.25, 1.0);
+				gl_ClipDistance[0] = position.x;
+			})";
+
+		layout = tester.createPipelineLayout();
+		vertexModule = tester.createShaderModule(vertexShader, EShLanguage::EShLangVertex);
+	}
+
+	// Draws the rectangle, with the fragment shader if it isn't null, and
+	// returns the resulting depth.
+	std::vector<float> draw(bool hasColorAttachment, vk::ShaderModule fragmentModule, vk::ColorComponentFlags colorWriteMask)
+	{
+		vk::RenderPass renderPass = tester.createRenderPass(hasColorAttachment ? ColorFormat : vk::Format::eUndefined, DepthFormat, vk::AttachmentLoadOp::eClear);
+
+		std::vector<vk::ImageView> attachments;
+		if(hasColorAttachment)
+		{
+			attachments.push_back(colorTarget.view);
+		}
+		attachments.push_back(depthTarget.view);
+		vk::Framebuffer framebuffer = tester.createFramebuffer(renderPass, attachments, vk::Extent2D(Size, Size));
+
+		OffscreenTester::GraphicsPipelineState state;
+		state.renderPass = renderPass;
+		state.layout = layout;
+		state.vertexShader = vertexModule;
+		state.fragmentShader = fragmentModule;
+		state.hasColorAttachment = hasColorAttachment;
+		state.colorWriteMask = colorWriteMask;
+		state.depthTest = true;
+		vk::Pipeline pipeline = tester.createGraphicsPipeline(state);
+
+		tester.submit([&](vk::CommandBuffer &commandBuffer) {
+			std::vector<vk::ClearValue> clearValues;
+			if(hasColorAttachment)
+			{
+				clearValues.push_back(Color{ 0, 0, 0, 0 }.toClearColor());
+			}
+			clearValues.push_back(vk::ClearDepthStencilValue(ClearDepth, 0));
+
+			OffscreenTester::beginRenderPass(commandBuffer, renderPass, framebuffer, vk::Extent2D(Size, Size), clearValues);
+			commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
+			commandBuffer.draw(6, 1, 0, 0);
+			commandBuffer.endRenderPass();
+		});
+
+		return tester.readTexels<float>(depthTarget);
+	}
+
+	static bool isDrawn(uint32_t x, uint32_t y)
+	{
+		return x >= ClipX && y < DrawRows;
+	}
+
+	// Checks that only fragments which weren't clipped wrote depth.
+	void expectDepth(const std::vector<float> &depth)
+	{
+		for(uint32_t y = 0; y < Size; y++)
+		{
+			for(uint32_t x = 0; x < Size; x++)
+			{
+				float expected = isDrawn(x, y) ? DrawDepth : ClearDepth;
+				ASSERT_EQ(depth[y * Size + x], expected) << "x " << x << ", y " << y;
+			}
+		}
+	}
+
+	OffscreenTester tester;
+
+	OffscreenTester::RenderTarget colorTarget;
+	OffscreenTester::RenderTarget depthTarget;
+
+	vk::PipelineLayout layout;
+	vk::ShaderModule vertexModule;
+};
+
+// Draws without a fragment shader use the depth-only pixel routine, which
+// must still discard clipped fragments.
+TEST_F(ClipDistanceDepthTest, DepthOnlyWithoutFragmentShader)
+{
+	expectDepth(draw(false, {}, {}));
+}
+
+// A fragment shader writing only to masked out color components is dropped,
+// which must not drop clipping along with it.
+TEST_F(ClipDistanceDepthTest, DepthOnlyWithRedundantFragmentShader)
+{
+	const char *fragmentShader = R"(#version 450
+		layout(location = 0) out vec4 outColor;
+
+		void main()
+		{
+			outColor = vec4(1.0, 0.0, 0.0, 1.0);
+		})";
+
+	vk::ShaderModule fragmentModule = tester.createShaderModule(fragmentShader, EShLanguage::EShLangFragment);
+	expectDepth(draw(true, fragmentModule, {}));
+}
+
+// A fragment shader without side effects would otherwise have its depth test
+// promoted ahead of shading, which must not happen before clipping.
+TEST_F(ClipDistanceDepthTest, ColorAndDepthWithClipDistance)
+{
+	const char *fragmentShader = R"(#version 450
+		layout(location = 0) out vec4 outColor;
+
+		void main()
+		{
+			outColor = vec4(1.0, 0.0, 0.0, 1.0);
+		})";
+
+	vk::ShaderModule fragmentModule = tester.createShaderModule(fragmentShader, EShLanguage::EShLangFragment);
+	vk::ColorComponentFlags colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
+	expectDepth(draw(true, fragmentModule, colorWriteMask));
+
+	std::vector<Color> color = tester.readTexels<Color>(colorTarget);
+	for(uint32_t y = 0; y < Size; y++)
+	{
+		for(uint32_t x = 0; x < Size; x++)
+		{
+			uint8_t expected = isDrawn(x, y) ? 255 : 0;
+			ASSERT_EQ(color[y * Size + x].r, expected) << "x " << x << ", y " << y;
+		}
+	}
+}
+
+// Renders a rectangle to the views 0, 1 and 3 of four layer attachments, which
+// are cleared by the render pass, inside an occlusion query.
+class MultiviewTest : public testing::Test
+{
+protected:
+	static constexpr uint32_t Size = 32;
+	static constexpr uint32_t Layers = 4;
+	static constexpr uint32_t ViewMask = 0b1011;
+	static constexpr vk::Format ColorFormat = vk::Format::eR8G8B8A8Unorm;
+	static constexpr vk::Format DepthFormat = vk::Format::eD32Sfloat;
+
+	// The rectangle covers [4, 12) x [0, 16) in pixels, offset to the right by
+	// 4 pixels per view index by shaders which read it.
+	static constexpr uint32_t RectX0 = 4;
+	static constexpr uint32_t RectX1 = 12;
+	static constexpr uint32_t RectY1 = 16;
+	static constexpr uint32_t ViewOffset = 4;
+
+	void SetUp() override
+	{
+		tester.initialize();
+
+		vk::PhysicalDeviceFeatures2 features;
+		vk::PhysicalDeviceMultiviewFeatures multiviewFeatures;
+		features.pNext = &multiviewFeatures;
+		tester.getPhysicalDevice().getFeatures2(&features);
+		if(!multiviewFeatures.multiview || !features.features.occlusionQueryPrecise)
+		{
+			GTEST_SKIP() << "multiview or occlusionQueryPrecise not supported";
+		}
+
+		colorTarget = tester.createRenderTarget(ColorFormat, vk::Extent2D(Size, Size), Layers);
+		OffscreenTester::RenderTarget depthTarget = tester.createRenderTarget(DepthFormat, vk::Extent2D(Size, Size), Layers);
+
+		// Layers outside of the view mask must keep their contents.
+		tester.writeTexels(colorTarget, std::vector<Color>(Size * Size * Layers, untouched));
+
+		renderPass = tester.createRenderPass(ColorFormat, DepthFormat, vk::AttachmentLoadOp::eClear, ViewMask);
+		framebuffer = tester.createFramebuffer(renderPass, { colorTarget.view, depthTarget.view }, vk::Extent2D(Size, Size));
+		layout = tester.createPipelineLayout();
+
+		vk::QueryPoolCreateInfo queryPoolInfo;
+		queryPoolInfo.queryType = vk::QueryType::eOcclusion;
+		queryPoolInfo.queryCount = 1;
+		queryPool = tester.getDevice().createQueryPool(queryPoolInfo);
+	}
+
+	void TearDown() override
+	{
+		if(queryPool)
+		{
+			tester.getDevice().destroyQueryPool(queryPool);
+		}
+	}
+
+	vk::Pipeline createPipeline(const char *vertexShader)
+	{
+		const char *fragmentShader = R"(#version 450
+			layout(location = 0) flat in vec4 inColor;
+			layout(location = 0) out vec4 outColor;
+
+			void main()
+			{
+				outColor = inColor;
+			})";
+
+		OffscreenTester::GraphicsPipelineState state;
+		state.renderPass = renderPass;
+		state.layout = layout;
+		state.vertexShader = tester.createShaderModule(vertexShader, EShLanguage::EShLangVertex);
+		state.fragmentShader = tester.createShaderModule(fragmentShader, EShLanguage::EShLangFragment);
+		state.depthTest = true;
+
+		return tester.createGraphicsPipeline(state);
+	}
+
+	// Draws the rectangle and returns the number of samples which passed.
+	uint64_t draw(vk::Pipeline pipeline)
+	{
+		tester.submit([&](vk::CommandBuffer &commandBuffer) {
+			commandBuffer.resetQueryPool(queryPool, 0, 1);
+
+			OffscreenTester::beginRenderPass(commandBuffer, renderPass, framebuffer, vk::Extent2D(Size, Size),
+			                                 { clearColor.toClearColor(), vk::ClearDepthStencilValue(1.0f, 0) });
+			commandBuffer.beginQuery(queryPool, 0, vk::QueryControlFlagBits::ePrecise);
+			commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
+			commandBuffer.draw(6, 1, 0, 0);
+			commandBuffer.endQuery(queryPool, 0);
+			commandBuffer.endRenderPass();
+		});
+
+		uint64_t samples = 0;
+		vk::Result result = tester.getDevice().getQueryPoolResults(queryPool, 0, 1, sizeof(samples), &samples, sizeof(samples), vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWait);
+		EXPECT_EQ(result, vk::Result::eSuccess);
+
+		return samples;
+	}
+
+	// Checks that each view has the rectangle, offset by its view index if
+	// offsetByView is set, in the color returned by viewColor, on the cleared
+	// background, and that the other layer is untouched.
+	void expectViews(bool offsetByView, const std::function<Color(uint32_t view)> &viewColor)
+	{
+		std::vector<Color> texels = tester.readTexels<Color>(colorTarget);
+
+		for(uint32_t layer = 0; layer < Layers; layer++)
+		{
+			const bool rendered = (ViewMask & (1u << layer)) != 0;
+			const uint32_t offset = offsetByView ? layer * ViewOffset : 0;
+
+			for(uint32_t y = 0; y < Size; y++)
+			{
+				for(uint32_t x = 0; x < Size; x++)
+				{
+					const bool inRect = x >= RectX0 + offset && x < RectX1 + offset && y < RectY1;
+					const Color expected = !rendered ? untouched : (inRect ? viewColor(layer) : clearColor);
+
+					const Color &actual = texels[(layer * Size + y) * Size + x];
+					ASSERT_TRUE(actual == expected) << "layer " << layer << ", x " << x << ", y " << y << ": got ("
+					                                << int(actual.r) << ", " << int(actual.g) << ", " << int(actual.b) << ", " << int(actual.a) << ")";
+				}
+			}
+		}
+	}
+
+	static constexpr uint64_t RectSamples = (RectX1 - RectX0) * RectY1;
+	static constexpr uint64_t ViewCount = 3;
+
+	const Color clearColor = { 51, 102, 153, 255 };
+	const Color untouched = { 7, 7, 7, 7 };
+	const Color green = { 0, 255, 0, 255 };
+
+	OffscreenTester tester;
+
+	OffscreenTester::RenderTarget colorTarget;
+	vk::RenderPass renderPass;
+	vk::Framebuffer framebuffer;
+	vk::PipelineLayout layout;
+	vk::QueryPool queryPool;  // Owning handle
+};
+
+// A vertex shader which doesn't read the view index is run once for all views.
+TEST_F(MultiviewTest, ViewIndependentVertexShader)
+{
+	vk::Pipeline pipeline = createPipeline(R"(#version 450
+		layout(location = 0) flat out vec4 outColor;
+
+		void main()
+		{
+			const vec2 corners[6] = vec2[](vec2(0, 0), vec2(1, 0), vec2(0, 1),
+			                               vec2(1, 0), vec2(1, 1), vec2(0, 1));
+			gl_Position = vec4(mix(vec2(-0.75, -1.0), vec2(-0.25, 0.0), corners[gl_VertexIndex]), 0.5, 1.0);
+			outColor = vec4(0.0, 1.0, 0.0, 1.0);
+		})");
+
+	EXPECT_EQ(draw(pipeline), ViewCount * RectSamples);
+	expectViews(false, [&](uint32_t view) { return green; });
+}
+
+// A vertex shader whose position depends on the view index computes the
+// other outputs once, and the position for each view.
+TEST_F(MultiviewTest, ViewDependentPosition)
+{
+	vk::Pipeline pipeline = createPipeline(R"(#version 450
+		#extension GL_EXT_multiview : require
+		layout(location = 0) flat out vec4 outColor;
+
+		void main()
+		{
+			const vec2 corners[6] = vec2[](vec2(0, 0), vec2(1, 0), vec2(0, 1),
+			                               vec2(1, 0), vec2(1, 1), vec2(0, 1));
+			vec2 offset = vec2(0.25 * float(gl_ViewIndex), 0.0);
+			gl_Position = vec4(mix(vec2(-0.75, -1.0), vec2(-0.25, 0.0), corners[gl_VertexIndex]) + offset, 0.5, 1.0);
+			outColor = vec4(0.0, 1.0, 0.0, 1.0);
+		})");
+
+	EXPECT_EQ(draw(pipeline), ViewCount * RectSamples);
+	expectViews(true, [&](uint32_t view) { return green; });
+}
+
+// A vertex shader whose other outputs depend on the view index is run for
+// each view.
+TEST_F(MultiviewTest, ViewDependentOutputs)
+{
+	vk::Pipeline pipeline = createPipeline(R"(#version 450
+		#extension GL_EXT_multiview : require
+		layout(location = 0) flat out vec4 outColor;
+
+		void main()
+		{
+			const vec2 corners[6] = vec2[](vec2(0, 0), vec2(1, 0), vec2(0, 1),
+			                               vec2(1, 0), vec2(1, 1), vec2(0, 1));
+			vec2 offset = vec2(0.25 * float(gl_ViewIndex), 0.0);
+			gl_Position = vec4(mix(vec2(-0.75, -1.0), vec2(-0.25, 0.0), corners[gl_VertexIndex]) + offset, 0.5, 1.0);
+			outColor = vec4(float(gl_ViewIndex) * 64.0 / 255.0, 1.0, 0.0, 1.0);
+		})");
+
+	EXPECT_EQ(draw(pipeline), ViewCount * RectSamples);
+	expectViews(true, [&](uint32_t view) { return Color{ uint8_t(view * 64), 255, 0, 255 }; });
+}
+
+// Draws rows of triangle strips or fans separated by primitive restart indices,
+// and compares them with the same triangles drawn as a list. Each row covers
+// RowHeight rows of pixels, so a missing or misassembled triangle shows up as
+// uncovered pixels, and a wrong winding as back facing ones.
+class PrimitiveRestartTest : public testing::Test
+{
+protected:
+	static constexpr uint32_t Size = 64;
+	static constexpr uint32_t Columns = 16;  // Quads per row
+	static constexpr uint32_t MaxRows = 16;
+	static constexpr uint32_t RowHeight = Size / MaxRows;
+	static constexpr uint16_t RestartIndex = 0xFFFF;
+	static constexpr vk::Format ColorFormat = vk::Format::eR8G8B8A8Unorm;
+
+	void SetUp() override
+	{
+		tester.initialize();
+
+		colorTarget = tester.createRenderTarget(ColorFormat, vk::Extent2D(Size, Size));
+		renderPass = tester.createRenderPass(ColorFormat, vk::Format::eUndefined, vk::AttachmentLoadOp::eClear);
+		framebuffer = tester.createFramebuffer(renderPass, { colorTarget.view }, vk::Extent2D(Size, Size));
+		layout = tester.createPipelineLayout();
+
+		const char *vertexShader = R"(#version 450
+			layout(location = 0) in vec2 inPosition;
+
+			void main()
+			{
+				gl_Position = vec4(inPosition, 0.5, 1.0);
+			})";
+
+		const char *fragmentShader = R"(#version 450
+			layout(location = 0) out vec4 outColor;
+
+			void main()
+			{
+				outColor = gl_FrontFacing ? vec4(0.0, 1.0, 0.0, 1.0) : vec4(1.0, 0.0, 0.0, 1.0);
+			})";
+
+		vertexModule = tester.createShaderModule(vertexShader, EShLanguage::EShLangVertex);
+		fragmentModule = tester.createShaderModule(fragmentShader, EShLanguage::EShLangFragment);
+	}
+
+	// Expands strips or fans separated by restart indices into a triangle list,
+	// with each triangle's vertices in the order the specification defines.
+	static std::vector<uint16_t> toTriangleList(const std::vector<uint16_t> &indices, vk::PrimitiveTopology topology)
+	{
+		std::vector<uint16_t> list;
+		size_t start = 0;
+		while(start < indices.size())
+		{
+			size_t end = start;
+			while(end < indices.size() && indices[end] != RestartIndex)
+			{
+				end++;
+			}
+
+			for(size_t i = 0; i + 2 < end - start; i++)
+			{
+				const uint16_t *v = &indices[start + i];
+				if(topology == vk::PrimitiveTopology::eTriangleStrip)
+				{
+					list.insert(list.end(), { v[0], v[1 + i % 2], v[2 - i % 2] });
+				}
+				else
+				{
+					list.insert(list.end(), { v[1], v[2], indices[start] });
+				}
+			}
+
+			start = end + 1;
+		}
+
+		return list;
+	}
+
+	std::vector<uint32_t> draw(vk::PrimitiveTopology topology, bool primitiveRestart, const std::vector<float> &positions, const std::vector<uint16_t> &indices)
+	{
+		OffscreenTester::GraphicsPipelineState state;
+		state.renderPass = renderPass;
+		state.layout = layout;
+		state.vertexShader = vertexModule;
+		state.fragmentShader = fragmentModule;
+		state.vertexBindings = { vk::VertexInputBindingDescription(0, 2 * sizeof(float), vk::VertexInputRate::eVertex) };
+		state.vertexAttributes = { vk::VertexInputAttributeDescription(0, 0, vk::Format::eR32G32Sfloat, 0) };
+		state.topology = topology;
+		state.primitiveRestart = primitiveRestart;
+		vk::Pipeline pipeline = tester.createGraphicsPipeline(state);
+
+		vk::Buffer vertexBuffer = tester.createBuffer(positions.size() * sizeof(float), vk::BufferUsageFlagBits::eVertexBuffer, positions.data());
+		vk::Buffer indexBuffer = tester.createBuffer(indices.size() * sizeof(uint16_t), vk::BufferUsageFlagBits::eIndexBuffer, indices.data());
+
+		tester.submit([&](vk::CommandBuffer &commandBuffer) {
+			vk::DeviceSize offset = 0;
+			OffscreenTester::beginRenderPass(commandBuffer, renderPass, framebuffer, vk::Extent2D(Size, Size), { Color{ 0, 0, 0, 0 }.toClearColor() });
+			commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
+			commandBuffer.bindVertexBuffers(0, 1, &vertexBuffer, &offset);
+			commandBuffer.bindIndexBuffer(indexBuffer, 0, vk::IndexType::eUint16);
+			commandBuffer.drawIndexed(static_cast<uint32_t>(indices.size()), 1, 0, 0, 0);
+			commandBuffer.endRenderPass();
+		});
+
+		tester.destroyBuffer(vertexBuffer);
+		tester.destroyBuffer(indexBuffer);
+
+		return tester.readTexels<uint32_t>(colorTarget);
+	}
+
+	// Draws the given number of rows, one strip or fan per row, from the top.
+	void test(vk::PrimitiveTopology topology, uint32_t rows)
+	{
+		auto x = [](uint32_t column) { return 2.0f * column / Columns - 1.0f; };
+		auto y = [](uint32_t row) { return 2.0f * row / MaxRows - 1.0f; };
+
+		std::vector<float> positions;
+		std::vector<uint16_t> indices;
+		for(uint32_t row = 0; row < rows; row++)
+		{
+			if(row > 0)
+			{
+				indices.push_back(RestartIndex);
+			}
+
+			uint16_t firstVertex = static_cast<uint16_t>(positions.size() / 2);
+			if(topology == vk::PrimitiveTopology::eTriangleStrip)
+			{
+				// Zigzags between the top and bottom of the row.
+				for(uint32_t column = 0; column <= Columns; column++)
+				{
+					positions.insert(positions.end(), { x(column), y(row), x(column), y(row + 1) });
+				}
+			}
+			else
+			{
+				// The hub is the top left corner, and the rim runs along the
+				// bottom of the row and ends at the top right corner.
+				positions.insert(positions.end(), { x(0), y(row) });
+				for(uint32_t column = 0; column <= Columns; column++)
+				{
+					positions.insert(positions.end(), { x(column), y(row + 1) });
+				}
+				positions.insert(positions.end(), { x(Columns), y(row) });
+			}
+
+			for(uint16_t vertex = firstVertex; vertex < positions.size() / 2; vertex++)
+			{
+				indices.push_back(vertex);
+			}
+		}
+
+		std::vector<uint32_t> restarted = draw(topology, true, positions, indices);
+		std::vector<uint32_t> reference = draw(vk::PrimitiveTopology::eTriangleList, false, positions, toTriangleList(indices, topology));
+
+		const uint32_t green = 0xFF00FF00;  // R8G8B8A8 read as little-endian
+		for(uint32_t py = 0; py < Size; py++)
+		{
+			for(uint32_t px = 0; px < Size; px++)
+			{
+				uint32_t expected = (py < rows * RowHeight) ? green : 0;
+				ASSERT_EQ(reference[py * Size + px], expected) << "x " << px << ", y " << py;
+				ASSERT_EQ(restarted[py * Size + px], expected) << "x " << px << ", y " << py;
+			}
+		}
+	}
+
+	OffscreenTester tester;
+
+	OffscreenTester::RenderTarget colorTarget;
+	vk::RenderPass renderPass;
+	vk::Framebuffer framebuffer;
+	vk::PipelineLayout layout;
+	vk::ShaderModule vertexModule;
+	vk::ShaderModule fragmentModule;
+};
+
+// Three rows take fewer primitives than a batch holds, so every restart is
+// inside the batch. Rows after the first start at odd indices.
+TEST_F(PrimitiveRestartTest, TriangleStripWithinBatch)
+{
+	test(vk::PrimitiveTopology::eTriangleStrip, 3);
+}
+
+// Batches start in the middle of strips which began in a previous batch.
+TEST_F(PrimitiveRestartTest, TriangleStripAcrossBatches)
+{
+	test(vk::PrimitiveTopology::eTriangleStrip, MaxRows);
+}
+
+TEST_F(PrimitiveRestartTest, TriangleFanWithinBatch)
+{
+	test(vk::PrimitiveTopology::eTriangleFan, 3);
+}
+
+// Batches start in the middle of fans whose hub is in a previous batch.
+TEST_F(PrimitiveRestartTest, TriangleFanAcrossBatches)
+{
+	test(vk::PrimitiveTopology::eTriangleFan, MaxRows);
+}
+
+// Draws a grid of triangles with one indirect record each, which get merged into
+// fewer draws, and compares the result with the same records issued as direct
+// draws. The color of each triangle depends on its vertex and instance index.
+class IndirectDrawTest : public testing::Test
+{
+protected:
+	static constexpr uint32_t Size = 64;
+	static constexpr uint32_t GridSize = 16;
+	static constexpr uint32_t RecordCount = GridSize * GridSize;  // Spans several batches
+	static constexpr vk::Format ColorFormat = vk::Format::eR8G8B8A8Unorm;
+
+	void SetUp() override
+	{
+		tester.initialize();
+
+		colorTarget = tester.createRenderTarget(ColorFormat, vk::Extent2D(Size, Size));
+		renderPass = tester.createRenderPass(ColorFormat, vk::Format::eUndefined, vk::AttachmentLoadOp::eClear);
+		framebuffer = tester.createFramebuffer(renderPass, { colorTarget.view }, vk::Extent2D(Size, Size));
+
+		// Records which draw the same triangle are moved to their cell by their instance.
+		const char *vertexShader = R"(#version 450
+			layout(location = 0) in vec2 inPos;
+			layout(location = 0) flat out vec4 outColor;
+
+			void main()
+			{
+				vec2 cell = vec2(gl_InstanceIndex % 16, gl_InstanceIndex / 16);
+				gl_Position = vec4(inPos + cell * (2.0 / 16.0), 0.5, 1.0);
+				outColor = vec4(float(gl_VertexIndex % 256) / 255.0, float(gl_InstanceIndex % 256) / 255.0, 0.0, 1.0);
+			})";
+
+		const char *fragmentShader = R"(#version 450
+			layout(location = 0) flat in vec4 inColor;
+			layout(location = 0) out vec4 outColor;
+
+			void main()
+			{
+				outColor = inColor;
+			})";
+
+		OffscreenTester::GraphicsPipelineState state;
+		state.renderPass = renderPass;
+		state.layout = tester.createPipelineLayout();
+		state.vertexShader = tester.createShaderModule(vertexShader, EShLanguage::EShLangVertex);
+		state.fragmentShader = tester.createShaderModule(fragmentShader, EShLanguage::EShLangFragment);
+		state.vertexBindings = { vk::VertexInputBindingDescription(0, 2 * sizeof(float), vk::VertexInputRate::eVertex) };
+		state.vertexAttributes = { vk::VertexInputAttributeDescription(0, 0, vk::Format::eR32G32Sfloat, 0) };
+		pipeline = tester.createGraphicsPipeline(state);
+
+		// One triangle in the bottom left corner of each cell.
+		const float cellSize = 2.0f / GridSize;
+		std::vector<float> positions;
+		for(uint32_t i = 0; i < RecordCount; i++)
+		{
+			float x = -1.0f + (i % GridSize) * cellSize;
+			float y = -1.0f + (i / GridSize) * cellSize;
+			positions.insert(positions.end(), { x, y, x + cellSize, y, x, y + cellSize });
+		}
+		vertexBuffer = tester.createBuffer(positions.size() * sizeof(float), vk::BufferUsageFlagBits::eVertexBuffer, positions.data());
+	}
+
+	std::vector<uint32_t> render(const std::function<void(vk::CommandBuffer &commandBuffer)> &draw)
+	{
+		tester.submit([&](vk::CommandBuffer &commandBuffer) {
+			vk::DeviceSize offset = 0;
+			OffscreenTester::beginRenderPass(commandBuffer, renderPass, framebuffer, vk::Extent2D(Size, Size), { Color{ 0, 0, 0, 0 }.toClearColor() });
+			commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
+			commandBuffer.bindVertexBuffers(0, 1, &vertexBuffer, &offset);
+			draw(commandBuffer);
+			commandBuffer.endRenderPass();
+		});
+
+		return tester.readTexels<uint32_t>(colorTarget);
+	}
+
+	void testDraw(const std::vector<vk::DrawIndirectCommand> &commands)
+	{
+		vk::Buffer indirectBuffer = tester.createBuffer(commands.size() * sizeof(vk::DrawIndirectCommand), vk::BufferUsageFlagBits::eIndirectBuffer, commands.data());
+
+		std::vector<uint32_t> indirect = render([&](vk::CommandBuffer &commandBuffer) {
+			commandBuffer.drawIndirect(indirectBuffer, 0, static_cast<uint32_t>(commands.size()), sizeof(vk::DrawIndirectCommand));
+		});
+
+		std::vector<uint32_t> direct = render([&](vk::CommandBuffer &commandBuffer) {
+			for(const auto &command : commands)
+			{
+				commandBuffer.draw(command.vertexCount, command.instanceCount, command.firstVertex, command.firstInstance);
+			}
+		});
+
+		expectEqual(indirect, direct);
+	}
+
+	void testDrawIndexed(const std::vector<uint16_t> &indices, const std::vector<vk::DrawIndexedIndirectCommand> &commands)
+	{
+		vk::Buffer indexBuffer = tester.createBuffer(indices.size() * sizeof(uint16_t), vk::BufferUsageFlagBits::eIndexBuffer, indices.data());
+		vk::Buffer indirectBuffer = tester.createBuffer(commands.size() * sizeof(vk::DrawIndexedIndirectCommand), vk::BufferUsageFlagBits::eIndirectBuffer, commands.data());
+
+		std::vector<uint32_t> indirect = render([&](vk::CommandBuffer &commandBuffer) {
+			commandBuffer.bindIndexBuffer(indexBuffer, 0, vk::IndexType::eUint16);
+			commandBuffer.drawIndexedIndirect(indirectBuffer, 0, static_cast<uint32_t>(commands.size()), sizeof(vk::DrawIndexedIndirectCommand));
+		});
+
+		std::vector<uint32_t> direct = render([&](vk::CommandBuffer &commandBuffer) {
+			commandBuffer.bindIndexBuffer(indexBuffer, 0, vk::IndexType::eUint16);
+			for(const auto &command : commands)
+			{
+				commandBuffer.drawIndexed(command.indexCount, command.instanceCount, command.firstIndex, command.vertexOffset, command.firstInstance);
+			}
+		});
+
+		expectEqual(indirect, direct);
+	}
+
+	// Every cell has a triangle, so the images can't match by being empty.
+	static void expectEqual(const std::vector<uint32_t> &indirect, const std::vector<uint32_t> &direct)
+	{
+		uint32_t covered = 0;
+		for(uint32_t i = 0; i < Size * Size; i++)
+		{
+			ASSERT_EQ(indirect[i], direct[i]) << "x " << (i % Size) << ", y " << (i / Size);
+			covered += (direct[i] != 0) ? 1 : 0;
+		}
+		EXPECT_GE(covered, RecordCount);
+	}
+
+	OffscreenTester tester;
+
+	OffscreenTester::RenderTarget colorTarget;
+	vk::RenderPass renderPass;
+	vk::Framebuffer framebuffer;
+	vk::Pipeline pipeline;
+	vk::Buffer vertexBuffer;
+};
+
+// Records with unrelated vertex ranges, drawn in reverse order.
+TEST_F(IndirectDrawTest, FirstVertex)
+{
+	std::vector<vk::DrawIndirectCommand> commands;
+	for(uint32_t i = 0; i < RecordCount; i++)
+	{
+		commands.push_back(vk::DrawIndirectCommand(3, 1, 3 * (RecordCount - 1 - i), 0));
+	}
+
+	testDraw(commands);
+}
+
+// Records of the same triangle, each moved to its cell by its first instance.
+TEST_F(IndirectDrawTest, FirstInstance)
+{
+	std::vector<vk::DrawIndirectCommand> commands;
+	for(uint32_t i = 0; i < RecordCount; i++)
+	{
+		commands.push_back(vk::DrawIndirectCommand(3, 1, 0, i));
+	}
+
+	testDraw(commands);
+}
+
+// Records with contiguous index ranges of the same triangle, each drawing its
+// cell through its vertex offset.
+TEST_F(IndirectDrawTest, VertexOffset)
+{
+	std::vector<uint16_t> indices;
+	std::vector<vk::DrawIndexedIndirectCommand> commands;
+	for(uint32_t i = 0; i < RecordCount; i++)
+	{
+		indices.insert(indices.end(), { 0, 1, 2 });
+		commands.push_back(vk::DrawIndexedIndirectCommand(3, 1, 3 * i, static_cast<int32_t>(3 * i), 0));
+	}
+
+	testDrawIndexed(indices, commands);
+}
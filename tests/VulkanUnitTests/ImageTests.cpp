@@ -0,0 +1,390 @@
+// Copyright 2024 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "OffscreenTester.hpp"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+namespace {
+
+struct MipChainParams
+{
+	uint32_t width;
+	uint32_t height;
+	uint32_t levels;
+	uint32_t layers;
+	vk::Filter filter;
+};
+
+std::ostream &operator<<(std::ostream &os, const MipChainParams &params)
+{
+	return os << params.width << "x" << params.height
+	          << ", levels: " << params.levels
+	          << ", layers: " << params.layers
+	          << ", filter: " << (params.filter == vk::Filter::eLinear ? "linear" : "nearest");
+}
+
+vk::ImageBlit levelBlit(uint32_t srcLevel, uint32_t dstLevel, vk::Extent2D srcExtent, vk::Extent2D dstExtent, uint32_t layers)
+{
+	vk::ImageBlit blit;
+	blit.srcSubresource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, srcLevel, 0, layers);
+	blit.srcOffsets[1] = vk::Offset3D(srcExtent.width, srcExtent.height, 1);
+	blit.dstSubresource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, dstLevel, 0, layers);
+	blit.dstOffsets[1] = vk::Offset3D(dstExtent.width, dstExtent.height, 1);
+	return blit;
+}
+
+struct CompressedFormatParams
+{
+	vk::Format format;
+	const char *name;
+	uint32_t blockBytes;
+	uint32_t colorBlockOffset;  // Offset of the BC1 color block in BC1, BC2 and BC3 blocks
+};
+
+std::ostream &operator<<(std::ostream &os, const CompressedFormatParams &params)
+{
+	return os << params.name;
+}
+
+}  // anonymous namespace
+
+class MipChainTest : public testing::TestWithParam<MipChainParams>
+{
+};
+
+// Generates a mip chain with same-image blits separated by barriers, which
+// are folded into a single pass, and compares each level against a blit of
+// the level above it into a separate image, which goes through the generic
+// blitter.
+TEST_P(MipChainTest, MatchesGenericBlit)
+{
+	const MipChainParams &params = GetParam();
+	const vk::Format format = vk::Format::eR8G8B8A8Unorm;
+	const size_t texelSize = 4;
+
+	OffscreenTester tester;
+	tester.initialize();
+
+	auto levelExtent = [&](uint32_t level) {
+		return vk::Extent2D(std::max(params.width >> level, 1u), std::max(params.height >> level, 1u));
+	};
+
+	vk::ImageCreateInfo imageInfo;
+	imageInfo.imageType = vk::ImageType::e2D;
+	imageInfo.format = format;
+	imageInfo.extent = vk::Extent3D(params.width, params.height, 1);
+	imageInfo.mipLevels = params.levels;
+	imageInfo.arrayLayers = params.layers;
+	imageInfo.samples = vk::SampleCountFlagBits::e1;
+	imageInfo.tiling = vk::ImageTiling::eOptimal;
+	imageInfo.usage = vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst;
+	vk::Image image = tester.createImage(imageInfo);
+
+	std::mt19937 random(params.width * 31 + params.height);
+	std::vector<uint8_t> base(params.width * params.height * params.layers * texelSize);
+	for(auto &value : base)
+	{
+		value = static_cast<uint8_t>(random());
+	}
+
+	tester.writeImage(image, vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, params.layers),
+	                  imageInfo.extent, base.data(), base.size());
+
+	tester.submit([&](vk::CommandBuffer &commandBuffer) {
+		for(uint32_t level = 1; level < params.levels; level++)
+		{
+			vk::ImageMemoryBarrier barrier;
+			barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+			barrier.dstAccessMask = vk::AccessFlagBits::eTransferRead;
+			barrier.oldLayout = vk::ImageLayout::eGeneral;
+			barrier.newLayout = vk::ImageLayout::eGeneral;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = image;
+			barrier.subresourceRange = vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, level - 1, 1, 0, params.layers);
+			commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {}, 0, nullptr, 0, nullptr, 1, &barrier);
+
+			vk::ImageBlit blit = levelBlit(level - 1, level, levelExtent(level - 1), levelExtent(level), params.layers);
+			commandBuffer.blitImage(image, vk::ImageLayout::eGeneral, image, vk::ImageLayout::eGeneral, 1, &blit, params.filter);
+		}
+	});
+
+	// Linear filtering of the fast path rounds differently from the generic
+	// blitter's, by at most one unit.
+	const int tolerance = (params.filter == vk::Filter::eLinear) ? 1 : 0;
+
+	for(uint32_t level = 1; level < params.levels; level++)
+	{
+		vk::Extent2D extent = levelExtent(level);
+
+		vk::ImageCreateInfo referenceInfo = imageInfo;
+		referenceInfo.extent = vk::Extent3D(extent.width, extent.height, 1);
+		referenceInfo.mipLevels = 1;
+		vk::Image reference = tester.createImage(referenceInfo);
+
+		tester.submit([&](vk::CommandBuffer &commandBuffer) {
+			vk::ImageBlit blit = levelBlit(level - 1, 0, levelExtent(level - 1), extent, params.layers);
+			commandBuffer.blitImage(image, vk::ImageLayout::eGeneral, reference, vk::ImageLayout::eGeneral, 1, &blit, params.filter);
+		});
+
+		vk::Extent3D extent3D(extent.width, extent.height, 1);
+		std::vector<uint8_t> expected = tester.readImage(reference, vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, params.layers), extent3D, texelSize);
+		std::vector<uint8_t> actual = tester.readImage(image, vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, level, 0, params.layers), extent3D, texelSize);
+
+		ASSERT_EQ(expected.size(), actual.size());
+		for(size_t i = 0; i < expected.size(); i++)
+		{
+			size_t texel = i / texelSize;
+			uint32_t layer = static_cast<uint32_t>(texel / (extent.width * extent.height));
+			uint32_t x = static_cast<uint32_t>(texel % extent.width);
+			uint32_t y = static_cast<uint32_t>((texel / extent.width) % extent.height);
+
+			ASSERT_LE(std::abs(int(expected[i]) - int(actual[i])), tolerance)
+			    << "level " << level << ", layer " << layer << ", x " << x << ", y " << y << ", component " << (i % texelSize);
+		}
+	}
+}
+
+INSTANTIATE_TEST_SUITE_P(ImageTests, MipChainTest,
+                         testing::Values(
+                             // Even extents at every level take the fast path with linear filtering.
+                             MipChainParams{ 64, 64, 7, 1, vk::Filter::eLinear },
+                             MipChainParams{ 64, 64, 7, 3, vk::Filter::eLinear },
+                             MipChainParams{ 96, 48, 4, 3, vk::Filter::eLinear },
+                             // Odd extents fall back to the generic blitter for the whole chain.
+                             MipChainParams{ 37, 20, 6, 1, vk::Filter::eLinear },
+                             MipChainParams{ 130, 66, 8, 3, vk::Filter::eLinear },
+                             // Nearest filtering is never folded into the fast path.
+                             MipChainParams{ 64, 64, 7, 3, vk::Filter::eNearest },
+                             MipChainParams{ 37, 20, 6, 3, vk::Filter::eNearest }));
+
+class CompressedSamplingTest : public testing::TestWithParam<CompressedFormatParams>
+{
+};
+
+// Samples compressed images, which are decoded block by block by the sampler,
+// and compares the texels against a blit into a float image, which decodes
+// the whole image with the reference BC and ETC decoders. Filtered samples
+// are taken at texel corners, so that their four taps fall in neighbouring
+// blocks, and compared against the average of the reference texels.
+TEST_P(CompressedSamplingTest, MatchesDecoder)
+{
+	const CompressedFormatParams &params = GetParam();
+
+	// Partial blocks at the right and bottom edges.
+	const uint32_t width = 18;
+	const uint32_t height = 10;
+	const uint32_t blockCount = ((width + 3) / 4) * ((height + 3) / 4);
+
+	OffscreenTester tester;
+	tester.initialize();
+
+	vk::FormatFeatureFlags requiredFeatures = vk::FormatFeatureFlagBits::eSampledImage | vk::FormatFeatureFlagBits::eSampledImageFilterLinear | vk::FormatFeatureFlagBits::eBlitSrc;
+	if((tester.getPhysicalDevice().getFormatProperties(params.format).optimalTilingFeatures & requiredFeatures) != requiredFeatures)
+	{
+		GTEST_SKIP() << "Format not supported";
+	}
+
+	std::mt19937 random(static_cast<uint32_t>(params.format));
+	std::vector<uint8_t> blocks(blockCount * params.blockBytes);
+	for(auto &value : blocks)
+	{
+		value = static_cast<uint8_t>(random());
+	}
+
+	// Cycle BC1 color blocks through the four color mode, the three color
+	// mode with black or transparent texels, and equal endpoints.
+	if(params.colorBlockOffset != ~0u)
+	{
+		for(uint32_t i = 0; i < blockCount; i++)
+		{
+			uint8_t *colorBlock = blocks.data() + i * params.blockBytes + params.colorBlockOffset;
+			uint16_t color[2];
+			memcpy(color, colorBlock, sizeof(color));
+
+			switch(i % 3)
+			{
+			case 0:
+				color[0] = std::max(color[0], color[1]) | 1;
+				color[1] = std::min(color[1], static_cast<uint16_t>(color[0] - 1));
+				break;
+			case 1:
+				color[1] = std::max(color[0], color[1]) | 1;
+				color[0] = std::min(color[0], static_cast<uint16_t>(color[1] - 1));
+				break;
+			case 2:
+				color[1] = color[0];
+				break;
+			}
+
+			memcpy(colorBlock, color, sizeof(color));
+		}
+	}
+
+	vk::ImageCreateInfo imageInfo;
+	imageInfo.imageType = vk::ImageType::e2D;
+	imageInfo.format = params.format;
+	imageInfo.extent = vk::Extent3D(width, height, 1);
+	imageInfo.mipLevels = 1;
+	imageInfo.arrayLayers = 1;
+	imageInfo.samples = vk::SampleCountFlagBits::e1;
+	imageInfo.tiling = vk::ImageTiling::eOptimal;
+	imageInfo.usage = vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst;
+	vk::Image image = tester.createImage(imageInfo);
+
+	const vk::ImageSubresourceLayers subresource(vk::ImageAspectFlagBits::eColor, 0, 0, 1);
+	tester.writeImage(image, subresource, imageInfo.extent, blocks.data(), blocks.size());
+
+	// Reference texels.
+	vk::ImageCreateInfo referenceInfo = imageInfo;
+	referenceInfo.format = vk::Format::eR32G32B32A32Sfloat;
+	referenceInfo.usage = vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst;
+	vk::Image reference = tester.createImage(referenceInfo);
+
+	tester.submit([&](vk::CommandBuffer &commandBuffer) {
+		vk::ImageBlit blit;
+		blit.srcSubresource = subresource;
+		blit.srcOffsets[1] = vk::Offset3D(width, height, 1);
+		blit.dstSubresource = subresource;
+		blit.dstOffsets[1] = vk::Offset3D(width, height, 1);
+		commandBuffer.blitImage(image, vk::ImageLayout::eGeneral, reference, vk::ImageLayout::eGeneral, 1, &blit, vk::Filter::eNearest);
+	});
+
+	std::vector<uint8_t> referenceData = tester.readImage(reference, subresource, imageInfo.extent, 4 * sizeof(float));
+	std::vector<float> expected(referenceData.size() / sizeof(float));
+	memcpy(expected.data(), referenceData.data(), referenceData.size());
+
+	// Sampled texels.
+	const char *computeShader = R"(#version 450
+		layout(local_size_x = 4, local_size_y = 4) in;
+		layout(binding = 0) uniform sampler2D nearestTexture;
+		layout(binding = 1) uniform sampler2D linearTexture;
+		layout(binding = 2) buffer Output { vec4 texels[]; };
+
+		void main()
+		{
+			ivec2 size = textureSize(nearestTexture, 0);
+			ivec2 p = ivec2(gl_GlobalInvocationID.xy);
+			if(p.x >= size.x || p.y >= size.y) return;
+
+			int i = p.y * size.x + p.x;
+			texels[i] = texelFetch(nearestTexture, p, 0);
+			texels[size.x * size.y + i] = textureLod(linearTexture, vec2(p + 1) / vec2(size), 0.0);
+		})";
+
+	vk::ImageView imageView = tester.createImageView(image, vk::ImageViewType::e2D, params.format, vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1));
+
+	vk::SamplerCreateInfo samplerInfo;
+	samplerInfo.magFilter = vk::Filter::eNearest;
+	samplerInfo.minFilter = vk::Filter::eNearest;
+	samplerInfo.addressModeU = vk::SamplerAddressMode::eClampToEdge;
+	samplerInfo.addressModeV = vk::SamplerAddressMode::eClampToEdge;
+	samplerInfo.addressModeW = vk::SamplerAddressMode::eClampToEdge;
+	vk::Sampler nearestSampler = tester.createSampler(samplerInfo);
+	samplerInfo.magFilter = vk::Filter::eLinear;
+	samplerInfo.minFilter = vk::Filter::eLinear;
+	vk::Sampler linearSampler = tester.createSampler(samplerInfo);
+
+	vk::DeviceSize outputSize = 2 * width * height * 4 * sizeof(float);
+	vk::Buffer output = tester.createBuffer(outputSize, vk::BufferUsageFlagBits::eStorageBuffer);
+
+	vk::DescriptorSetLayout setLayout = tester.createDescriptorSetLayout({
+	    vk::DescriptorSetLayoutBinding(0, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eCompute),
+	    vk::DescriptorSetLayoutBinding(1, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eCompute),
+	    vk::DescriptorSetLayoutBinding(2, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute),
+	});
+	vk::DescriptorSet descriptorSet = tester.allocateDescriptorSet(setLayout);
+
+	vk::DescriptorImageInfo nearestInfo(nearestSampler, imageView, vk::ImageLayout::eGeneral);
+	vk::DescriptorImageInfo linearInfo(linearSampler, imageView, vk::ImageLayout::eGeneral);
+	vk::DescriptorBufferInfo outputInfo(output, 0, outputSize);
+	std::array<vk::WriteDescriptorSet, 3> writes = {
+		vk::WriteDescriptorSet(descriptorSet, 0, 0, 1, vk::DescriptorType::eCombinedImageSampler, &nearestInfo),
+		vk::WriteDescriptorSet(descriptorSet, 1, 0, 1, vk::DescriptorType::eCombinedImageSampler, &linearInfo),
+		vk::WriteDescriptorSet(descriptorSet, 2, 0, 1, vk::DescriptorType::eStorageBuffer, nullptr, &outputInfo),
+	};
+	tester.getDevice().updateDescriptorSets(static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+	vk::PipelineLayout pipelineLayout = tester.createPipelineLayout(setLayout);
+	vk::Pipeline pipeline = tester.createComputePipeline(pipelineLayout, tester.createShaderModule(computeShader, EShLanguage::EShLangCompute));
+
+	tester.submit([&](vk::CommandBuffer &commandBuffer) {
+		commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline);
+		commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+		commandBuffer.dispatch((width + 3) / 4, (height + 3) / 4, 1);
+		OffscreenTester::fullBarrier(commandBuffer);
+	});
+
+	const float *fetched = static_cast<const float *>(tester.getBufferData(output));
+	const float *filtered = fetched + width * height * 4;
+
+	// Fetched texels hold the same 8 or 11-bit values as the reference. Filtered
+	// samples are interpolated at a lower precision.
+	const float fetchTolerance = 1.0e-4f;
+	const float filterTolerance = 2.0f / 255.0f;
+
+	for(uint32_t y = 0; y < height; y++)
+	{
+		for(uint32_t x = 0; x < width; x++)
+		{
+			for(uint32_t c = 0; c < 4; c++)
+			{
+				uint32_t i = (y * width + x) * 4 + c;
+				ASSERT_NEAR(expected[i], fetched[i], fetchTolerance) << "fetch, x " << x << ", y " << y << ", component " << c;
+
+				uint32_t x1 = std::min(x + 1, width - 1);
+				uint32_t y1 = std::min(y + 1, height - 1);
+				float average = (expected[(y * width + x) * 4 + c] + expected[(y * width + x1) * 4 + c] +
+				                 expected[(y1 * width + x) * 4 + c] + expected[(y1 * width + x1) * 4 + c]) /
+				                4.0f;
+				ASSERT_NEAR(average, filtered[i], filterTolerance) << "filter, x " << x << ", y " << y << ", component " << c;
+			}
+		}
+	}
+}
+
+INSTANTIATE_TEST_SUITE_P(ImageTests, CompressedSamplingTest,
+                         testing::Values(
+                             // BC1 without alpha decodes the three color mode's fourth color as black, with alpha as transparent black.
+                             CompressedFormatParams{ vk::Format::eBc1RgbUnormBlock, "BC1_RGB_UNORM", 8, 0 },
+                             CompressedFormatParams{ vk::Format::eBc1RgbSrgbBlock, "BC1_RGB_SRGB", 8, 0 },
+                             CompressedFormatParams{ vk::Format::eBc1RgbaUnormBlock, "BC1_RGBA_UNORM", 8, 0 },
+                             CompressedFormatParams{ vk::Format::eBc1RgbaSrgbBlock, "BC1_RGBA_SRGB", 8, 0 },
+                             CompressedFormatParams{ vk::Format::eBc2UnormBlock, "BC2_UNORM", 16, 8 },
+                             CompressedFormatParams{ vk::Format::eBc2SrgbBlock, "BC2_SRGB", 16, 8 },
+                             CompressedFormatParams{ vk::Format::eBc3UnormBlock, "BC3_UNORM", 16, 8 },
+                             CompressedFormatParams{ vk::Format::eBc3SrgbBlock, "BC3_SRGB", 16, 8 },
+                             CompressedFormatParams{ vk::Format::eBc4UnormBlock, "BC4_UNORM", 8, ~0u },
+                             CompressedFormatParams{ vk::Format::eBc4SnormBlock, "BC4_SNORM", 8, ~0u },
+                             CompressedFormatParams{ vk::Format::eBc5UnormBlock, "BC5_UNORM", 16, ~0u },
+                             CompressedFormatParams{ vk::Format::eBc5SnormBlock, "BC5_SNORM", 16, ~0u },
+                             // Random ETC2 blocks cover the individual, differential, T, H and planar modes.
+                             CompressedFormatParams{ vk::Format::eEtc2R8G8B8UnormBlock, "ETC2_R8G8B8_UNORM", 8, ~0u },
+                             CompressedFormatParams{ vk::Format::eEtc2R8G8B8SrgbBlock, "ETC2_R8G8B8_SRGB", 8, ~0u },
+                             CompressedFormatParams{ vk::Format::eEtc2R8G8B8A1UnormBlock, "ETC2_R8G8B8A1_UNORM", 8, ~0u },
+                             CompressedFormatParams{ vk::Format::eEtc2R8G8B8A1SrgbBlock, "ETC2_R8G8B8A1_SRGB", 8, ~0u },
+                             CompressedFormatParams{ vk::Format::eEtc2R8G8B8A8UnormBlock, "ETC2_R8G8B8A8_UNORM", 16, ~0u },
+                             CompressedFormatParams{ vk::Format::eEtc2R8G8B8A8SrgbBlock, "ETC2_R8G8B8A8_SRGB", 16, ~0u },
+                             CompressedFormatParams{ vk::Format::eEacR11UnormBlock, "EAC_R11_UNORM", 8, ~0u },
+                             CompressedFormatParams{ vk::Format::eEacR11SnormBlock, "EAC_R11_SNORM", 8, ~0u },
+                             CompressedFormatParams{ vk::Format::eEacR11G11UnormBlock, "EAC_R11G11_UNORM", 16, ~0u },
+                             CompressedFormatParams{ vk::Format::eEacR11G11SnormBlock, "EAC_R11G11_SNORM", 16, ~0u }));
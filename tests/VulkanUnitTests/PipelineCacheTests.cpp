@@ -0,0 +1,228 @@
+// Copyright 2024 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "OffscreenTester.hpp"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Sets an environment variable for the lifetime of the object.
+class ScopedEnvVar
+{
+public:
+	ScopedEnvVar(const char *name, const std::string &value)
+	    : name(name)
+	{
+#if defined(_WIN32)
+		_putenv_s(name, value.c_str());
+#else
+		setenv(name, value.c_str(), 1);
+#endif
+	}
+
+	~ScopedEnvVar()
+	{
+#if defined(_WIN32)
+		_putenv_s(name, "");
+#else
+		unsetenv(name);
+#endif
+	}
+
+private:
+	const char *name;
+};
+
+class PipelineCacheTest : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		// Each test uses a shader no other run has compiled, so that binaries
+		// persisted by previous runs can't turn misses into hits.
+		std::random_device random;
+		nonce = random();
+	}
+
+	std::string computeShader() const
+	{
+		return R"(#version 450
+			layout(local_size_x = 1) in;
+			layout(binding = 0) buffer Output { uint value; } outputBuffer;
+			void main()
+			{
+				outputBuffer.value = )" +
+		       std::to_string(nonce) + R"(u;
+			})";
+	}
+
+	// Creates a compute pipeline for the shader, with the given flags.
+	vk::Pipeline createPipeline(OffscreenTester &tester, vk::PipelineCreateFlags flags = {})
+	{
+		vk::DescriptorSetLayout setLayout = tester.createDescriptorSetLayout({
+		    vk::DescriptorSetLayoutBinding(0, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute),
+		});
+		vk::PipelineLayout layout = tester.createPipelineLayout(setLayout);
+		vk::ShaderModule shader = tester.createShaderModule(computeShader().c_str(), EShLanguage::EShLangCompute);
+
+		return tester.createComputePipeline(layout, shader, flags);
+	}
+
+	// Runs the pipeline and returns the value it wrote.
+	uint32_t run(OffscreenTester &tester, vk::Pipeline pipeline)
+	{
+		vk::DescriptorSetLayout setLayout = tester.createDescriptorSetLayout({
+		    vk::DescriptorSetLayoutBinding(0, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute),
+		});
+		vk::DescriptorSet descriptorSet = tester.allocateDescriptorSet(setLayout);
+		vk::PipelineLayout layout = tester.createPipelineLayout(setLayout);
+
+		vk::Buffer output = tester.createBuffer(sizeof(uint32_t), vk::BufferUsageFlagBits::eStorageBuffer);
+		vk::DescriptorBufferInfo outputInfo(output, 0, sizeof(uint32_t));
+		vk::WriteDescriptorSet write(descriptorSet, 0, 0, 1, vk::DescriptorType::eStorageBuffer, nullptr, &outputInfo);
+		tester.getDevice().updateDescriptorSets(1, &write, 0, nullptr);
+
+		tester.submit([&](vk::CommandBuffer &commandBuffer) {
+			commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline);
+			commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, layout, 0, 1, &descriptorSet, 0, nullptr);
+			commandBuffer.dispatch(1, 1, 1);
+			OffscreenTester::fullBarrier(commandBuffer);
+		});
+
+		return *static_cast<const uint32_t *>(tester.getBufferData(output));
+	}
+
+	static bool supportsCacheControl(OffscreenTester &tester)
+	{
+		vk::PhysicalDeviceFeatures2 features;
+		vk::PhysicalDevicePipelineCreationCacheControlFeatures cacheControlFeatures;
+		features.pNext = &cacheControlFeatures;
+		tester.getPhysicalDevice().getFeatures2(&features);
+
+		return cacheControlFeatures.pipelineCreationCacheControl;
+	}
+
+	static constexpr vk::PipelineCreateFlags failOnCompileRequired = vk::PipelineCreateFlagBits::eFailOnPipelineCompileRequired;
+
+	uint32_t nonce = 0;
+};
+
+}  // anonymous namespace
+
+// A shader which was never optimized requires compilation.
+TEST_F(PipelineCacheTest, MissFailsOnCompileRequired)
+{
+	OffscreenTester tester;
+	tester.initialize();
+	if(!supportsCacheControl(tester))
+	{
+		GTEST_SKIP() << "pipelineCreationCacheControl not supported";
+	}
+
+	EXPECT_FALSE(createPipeline(tester, failOnCompileRequired));
+
+	vk::Pipeline pipeline = createPipeline(tester);
+	ASSERT_TRUE(pipeline);
+	EXPECT_EQ(run(tester, pipeline), nonce);
+}
+
+// Once a shader has been optimized, pipelines using it are created without
+// compiling, even with a different VkPipelineCache or none at all.
+TEST_F(PipelineCacheTest, HitSucceedsOnCompileRequired)
+{
+	OffscreenTester tester;
+	tester.initialize();
+	if(!supportsCacheControl(tester))
+	{
+		GTEST_SKIP() << "pipelineCreationCacheControl not supported";
+	}
+
+	ASSERT_TRUE(createPipeline(tester));
+
+	vk::Pipeline pipeline = createPipeline(tester, failOnCompileRequired);
+	ASSERT_TRUE(pipeline);
+	EXPECT_EQ(run(tester, pipeline), nonce);
+}
+
+// Binaries written to the cache directory are read back by other devices.
+// Invalid files are discarded rather than compiled.
+TEST_F(PipelineCacheTest, PersistenceRoundTrip)
+{
+	fs::path directory = fs::temp_directory_path() / ("swiftshader_spirv_cache_" + std::to_string(nonce));
+	fs::create_directories(directory);
+	ScopedEnvVar spirvCacheDir("SWIFTSHADER_SPIRV_CACHE_DIR", directory.string());
+
+	{
+		OffscreenTester tester;
+		tester.initialize();
+		if(!supportsCacheControl(tester))
+		{
+			fs::remove_all(directory);
+			GTEST_SKIP() << "pipelineCreationCacheControl not supported";
+		}
+
+		EXPECT_FALSE(createPipeline(tester, failOnCompileRequired));
+		ASSERT_TRUE(createPipeline(tester));
+	}
+
+	std::vector<fs::path> files;
+	for(const auto &entry : fs::directory_iterator(directory))
+	{
+		if(entry.path().extension() == ".spv")
+		{
+			files.push_back(entry.path());
+		}
+	}
+	ASSERT_EQ(files.size(), 1u);
+
+	{
+		OffscreenTester tester;
+		tester.initialize();
+
+		vk::Pipeline pipeline = createPipeline(tester, failOnCompileRequired);
+		ASSERT_TRUE(pipeline);
+		EXPECT_EQ(run(tester, pipeline), nonce);
+	}
+
+	// Overwrite the last word of the binary with an invalid instruction.
+	{
+		std::fstream f(files[0], std::ios::binary | std::ios::in | std::ios::out);
+		f.seekp(-static_cast<std::streamoff>(sizeof(uint32_t)), std::ios::end);
+		const uint32_t invalid = 0xFFFFFFFF;
+		f.write(reinterpret_cast<const char *>(&invalid), sizeof(invalid));
+	}
+
+	{
+		OffscreenTester tester;
+		tester.initialize();
+
+		EXPECT_FALSE(createPipeline(tester, failOnCompileRequired));
+
+		vk::Pipeline pipeline = createPipeline(tester);
+		ASSERT_TRUE(pipeline);
+		EXPECT_EQ(run(tester, pipeline), nonce);
+	}
+
+	fs::remove_all(directory);
+}
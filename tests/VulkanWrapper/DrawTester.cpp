@@ -16,8 +16,9 @@
 
 #define ARRAY_SIZE(arr) (sizeof(arr) / sizeof(arr[0]))
 
-DrawTester::DrawTester(Multisample multisample)
+DrawTester::DrawTester(Multisample multisample, DepthTest depthTest)
     : multisample(multisample == Multisample::True)
+    , depthTest(depthTest == DepthTest::True)
 {
 }
 
@@ -144,6 +145,21 @@ vk::RenderPass DrawTester::createRenderPass(vk::Format colorFormat)
 		attachments[0].finalLayout = vk::ImageLayout::ePresentSrcKHR;
 	}
 
+	if(depthTest)
+	{
+		vk::AttachmentDescription depthAttachment;
+		depthAttachment.format = depthFormat;
+		depthAttachment.samples = multisample ? vk::SampleCountFlagBits::e4 : vk::SampleCountFlagBits::e1;
+		depthAttachment.loadOp = vk::AttachmentLoadOp::eClear;
+		depthAttachment.storeOp = vk::AttachmentStoreOp::eDontCare;
+		depthAttachment.stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
+		depthAttachment.stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
+		depthAttachment.initialLayout = vk::ImageLayout::eUndefined;
+		depthAttachment.finalLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
+
+		attachments.push_back(depthAttachment);
+	}
+
 	vk::AttachmentReference attachment0;
 	attachment0.attachment = 0;
 	attachment0.layout = vk::ImageLayout::eColorAttachmentOptimal;
@@ -152,11 +168,16 @@ vk::RenderPass DrawTester::createRenderPass(vk::Format colorFormat)
 	attachment1.attachment = 1;
 	attachment1.layout = vk::ImageLayout::eColorAttachmentOptimal;
 
+	vk::AttachmentReference depthAttachmentReference;
+	depthAttachmentReference.attachment = static_cast<uint32_t>(attachments.size() - 1);
+	depthAttachmentReference.layout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
+
 	vk::SubpassDescription subpassDescription;
 	subpassDescription.pipelineBindPoint = vk::PipelineBindPoint::eGraphics;
 	subpassDescription.colorAttachmentCount = 1;
 	subpassDescription.pResolveAttachments = multisample ? &attachment1 : nullptr;
 	subpassDescription.pColorAttachments = &attachment0;
+	subpassDescription.pDepthStencilAttachment = depthTest ? &depthAttachmentReference : nullptr;
 
 	std::array<vk::SubpassDependency, 2> dependencies;
 
@@ -164,6 +185,10 @@ vk::RenderPass DrawTester::createRenderPass(vk::Format colorFormat)
 	dependencies[0].dstSubpass = 0;
 	dependencies[0].srcStageMask = vk::PipelineStageFlagBits::eBottomOfPipe;
 	dependencies[0].dstStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput;
+	if(depthTest)
+	{
+		dependencies[0].dstStageMask |= vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests;
+	}
 	dependencies[0].srcAccessMask = vk::AccessFlagBits::eMemoryRead;
 	dependencies[0].dstAccessMask = vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite;
 	dependencies[0].dependencyFlags = vk::DependencyFlagBits::eByRegion;
@@ -193,7 +218,7 @@ void DrawTester::createFramebuffers(vk::RenderPass renderPass)
 
 	for(size_t i = 0; i < framebuffers.size(); i++)
 	{
-		framebuffers[i].reset(new Framebuffer(device, physicalDevice, swapchain->getImageView(i), swapchain->colorFormat, renderPass, swapchain->getExtent(), multisample));
+		framebuffers[i].reset(new Framebuffer(device, physicalDevice, swapchain->getImageView(i), swapchain->colorFormat, renderPass, swapchain->getExtent(), multisample, depthTest ? depthFormat : vk::Format::eUndefined));
 	}
 }
 
@@ -257,8 +282,8 @@ vk::Pipeline DrawTester::createGraphicsPipeline(vk::RenderPass renderPass)
 	dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStateEnables.size());
 
 	vk::PipelineDepthStencilStateCreateInfo depthStencilState;
-	depthStencilState.depthTestEnable = VK_FALSE;
-	depthStencilState.depthWriteEnable = VK_FALSE;
+	depthStencilState.depthTestEnable = depthTest ? VK_TRUE : VK_FALSE;
+	depthStencilState.depthWriteEnable = depthTest ? VK_TRUE : VK_FALSE;
 	depthStencilState.depthCompareOp = vk::CompareOp::eLessOrEqual;
 	depthStencilState.depthBoundsTestEnable = VK_FALSE;
 	depthStencilState.back.failOp = vk::StencilOp::eKeep;
@@ -366,8 +391,10 @@ void DrawTester::createCommandBuffers(vk::RenderPass renderPass)
 		vk::CommandBufferBeginInfo commandBufferBeginInfo;
 		commandBuffers[i].begin(commandBufferBeginInfo);
 
-		vk::ClearValue clearValues[1];
+		// Indexed by attachment. The depth attachment follows the color and resolve attachments.
+		vk::ClearValue clearValues[3];
 		clearValues[0].color = vk::ClearColorValue(std::array<float, 4>{ 0.5f, 0.5f, 0.5f, 1.0f });
+		clearValues[multisample ? 2 : 1].depthStencil = vk::ClearDepthStencilValue(1.0f, 0);
 
 		vk::RenderPassBeginInfo renderPassBeginInfo;
 		renderPassBeginInfo.framebuffer = framebuffers[i]->getFramebuffer();
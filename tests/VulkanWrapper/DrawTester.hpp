@@ -31,12 +31,18 @@ enum class Multisample
 	True
 };
 
+enum class DepthTest
+{
+	False,
+	True
+};
+
 class DrawTester : public VulkanTester
 {
 public:
 	using ThisType = DrawTester;
 
-	DrawTester(Multisample multisample = Multisample::False);
+	DrawTester(Multisample multisample = Multisample::False, DepthTest depthTest = DepthTest::False);
 	~DrawTester();
 
 	void initialize();
@@ -134,6 +140,8 @@ private:
 
 	const vk::Extent2D windowSize = { 1280, 720 };
 	const bool multisample;
+	const bool depthTest;
+	const vk::Format depthFormat = vk::Format::eD32Sfloat;
 
 	std::unique_ptr<Window> window;
 	std::unique_ptr<Swapchain> swapchain;
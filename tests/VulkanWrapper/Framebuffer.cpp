@@ -14,7 +14,7 @@
 
 #include "Framebuffer.hpp"
 
-Framebuffer::Framebuffer(vk::Device device, vk::PhysicalDevice physicalDevice, vk::ImageView attachment, vk::Format colorFormat, vk::RenderPass renderPass, vk::Extent2D extent, bool multisample)
+Framebuffer::Framebuffer(vk::Device device, vk::PhysicalDevice physicalDevice, vk::ImageView attachment, vk::Format colorFormat, vk::RenderPass renderPass, vk::Extent2D extent, bool multisample, vk::Format depthFormat)
     : device(device)
 {
 	std::vector<vk::ImageView> attachments(multisample ? 2 : 1);
@@ -32,6 +32,13 @@ Framebuffer::Framebuffer(vk::Device device, vk::PhysicalDevice physicalDevice, v
 		attachments[0] = attachment;
 	}
 
+	if(depthFormat != vk::Format::eUndefined)
+	{
+		depthImage.reset(new Image(device, physicalDevice, extent.width, extent.height, depthFormat, multisample ? vk::SampleCountFlagBits::e4 : vk::SampleCountFlagBits::e1));
+
+		attachments.push_back(depthImage->getImageView());
+	}
+
 	vk::FramebufferCreateInfo framebufferCreateInfo;
 
 	framebufferCreateInfo.renderPass = renderPass;
@@ -46,6 +53,7 @@ Framebuffer::Framebuffer(vk::Device device, vk::PhysicalDevice physicalDevice, v
 
 Framebuffer::~Framebuffer()
 {
+	depthImage.reset();
 	multisampleImage.reset();
 	device.destroyFramebuffer(framebuffer);
 }
@@ -23,7 +23,8 @@
 class Framebuffer
 {
 public:
-	Framebuffer(vk::Device device, vk::PhysicalDevice physicalDevice, vk::ImageView attachment, vk::Format colorFormat, vk::RenderPass renderPass, vk::Extent2D extent, bool multisample);
+	// A depth attachment is added after the color attachments, unless depthFormat is eUndefined.
+	Framebuffer(vk::Device device, vk::PhysicalDevice physicalDevice, vk::ImageView attachment, vk::Format colorFormat, vk::RenderPass renderPass, vk::Extent2D extent, bool multisample, vk::Format depthFormat = vk::Format::eUndefined);
 	~Framebuffer();
 
 	vk::Framebuffer getFramebuffer()
@@ -35,6 +36,7 @@ private:
 	const vk::Device device;
 	vk::Framebuffer framebuffer;  // Owning handle
 	std::unique_ptr<Image> multisampleImage;
+	std::unique_ptr<Image> depthImage;
 };
 
 #endif  // BENCHMARKS_FRAMEBUFFER_HPP_
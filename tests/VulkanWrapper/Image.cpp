@@ -15,15 +15,36 @@
 #include "Image.hpp"
 #include "Util.hpp"
 
+static vk::ImageAspectFlags getAspectMask(vk::Format format)
+{
+	switch(format)
+	{
+	case vk::Format::eD16Unorm:
+	case vk::Format::eX8D24UnormPack32:
+	case vk::Format::eD32Sfloat:
+		return vk::ImageAspectFlagBits::eDepth;
+	case vk::Format::eS8Uint:
+		return vk::ImageAspectFlagBits::eStencil;
+	case vk::Format::eD16UnormS8Uint:
+	case vk::Format::eD24UnormS8Uint:
+	case vk::Format::eD32SfloatS8Uint:
+		return vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil;
+	default:
+		return vk::ImageAspectFlagBits::eColor;
+	}
+}
+
 Image::Image(vk::Device device, vk::PhysicalDevice physicalDevice, uint32_t width, uint32_t height, vk::Format format, vk::SampleCountFlagBits sampleCount /*= vk::SampleCountFlagBits::e1*/)
     : device(device)
 {
+	const vk::ImageAspectFlags aspectMask = getAspectMask(format);
+
 	vk::ImageCreateInfo imageInfo;
 	imageInfo.imageType = vk::ImageType::e2D;
 	imageInfo.format = format;
 	imageInfo.tiling = vk::ImageTiling::eOptimal;
 	imageInfo.initialLayout = vk::ImageLayout::eGeneral;
-	imageInfo.usage = vk::ImageUsageFlagBits::eColorAttachment;
+	imageInfo.usage = (aspectMask == vk::ImageAspectFlagBits::eColor) ? vk::ImageUsageFlagBits::eColorAttachment : vk::ImageUsageFlagBits::eDepthStencilAttachment;
 	imageInfo.samples = sampleCount;
 	imageInfo.extent = vk::Extent3D(width, height, 1);
 	imageInfo.mipLevels = 1;
@@ -45,7 +66,7 @@ Image::Image(vk::Device device, vk::PhysicalDevice physicalDevice, uint32_t widt
 	imageViewInfo.image = image;
 	imageViewInfo.viewType = vk::ImageViewType::e2D;
 	imageViewInfo.format = format;
-	imageViewInfo.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
+	imageViewInfo.subresourceRange.aspectMask = aspectMask;
 	imageViewInfo.subresourceRange.baseMipLevel = 0;
 	imageViewInfo.subresourceRange.levelCount = 1;
 	imageViewInfo.subresourceRange.baseArrayLayer = 0;
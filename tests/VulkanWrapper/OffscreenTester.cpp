@@ -0,0 +1,557 @@
+// Copyright 2024 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "OffscreenTester.hpp"
+
+#include <array>
+#include <cstring>
+
+static vk::ImageAspectFlags getAspectMask(vk::Format format)
+{
+	switch(format)
+	{
+	case vk::Format::eD16Unorm:
+	case vk::Format::eX8D24UnormPack32:
+	case vk::Format::eD32Sfloat:
+		return vk::ImageAspectFlagBits::eDepth;
+	case vk::Format::eS8Uint:
+		return vk::ImageAspectFlagBits::eStencil;
+	case vk::Format::eD16UnormS8Uint:
+	case vk::Format::eD24UnormS8Uint:
+	case vk::Format::eD32SfloatS8Uint:
+		return vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil;
+	default:
+		return vk::ImageAspectFlagBits::eColor;
+	}
+}
+
+OffscreenTester::OffscreenTester() = default;
+
+OffscreenTester::~OffscreenTester()
+{
+	device.waitIdle();
+
+	for(auto &pipeline : pipelines)
+	{
+		device.destroyPipeline(pipeline);
+	}
+	for(auto &framebuffer : framebuffers)
+	{
+		device.destroyFramebuffer(framebuffer);
+	}
+	for(auto &renderPass : renderPasses)
+	{
+		device.destroyRenderPass(renderPass);
+	}
+	for(auto &pipelineLayout : pipelineLayouts)
+	{
+		device.destroyPipelineLayout(pipelineLayout);
+	}
+	for(auto &descriptorSetLayout : descriptorSetLayouts)
+	{
+		device.destroyDescriptorSetLayout(descriptorSetLayout);
+	}
+	for(auto &shaderModule : shaderModules)
+	{
+		device.destroyShaderModule(shaderModule);
+	}
+	for(auto &sampler : samplers)
+	{
+		device.destroySampler(sampler);
+	}
+	for(auto &imageView : imageViews)
+	{
+		device.destroyImageView(imageView);
+	}
+	for(auto &image : images)
+	{
+		device.destroyImage(image);
+	}
+	for(auto &memory : imageMemories)
+	{
+		device.freeMemory(memory);
+	}
+	for(auto &buffer : buffers)
+	{
+		device.destroyBuffer(buffer.first);
+		device.freeMemory(buffer.second.memory);
+	}
+
+	device.destroyDescriptorPool(descriptorPool);
+	device.destroyCommandPool(commandPool);
+}
+
+const void *OffscreenTester::getDeviceCreateInfoNext()
+{
+	vk::PhysicalDeviceFeatures2 supported;
+	vk::PhysicalDeviceMultiviewFeatures supportedMultiview;
+	vk::PhysicalDevicePipelineCreationCacheControlFeatures supportedPipelineCreationCacheControl;
+	supported.pNext = &supportedMultiview;
+	supportedMultiview.pNext = &supportedPipelineCreationCacheControl;
+	physicalDevice.getFeatures2(&supported);
+
+	features.features.shaderClipDistance = supported.features.shaderClipDistance;
+	features.features.multiDrawIndirect = supported.features.multiDrawIndirect;
+	features.features.drawIndirectFirstInstance = supported.features.drawIndirectFirstInstance;
+	features.features.fullDrawIndexUint32 = supported.features.fullDrawIndexUint32;
+	features.features.textureCompressionBC = supported.features.textureCompressionBC;
+	features.features.textureCompressionETC2 = supported.features.textureCompressionETC2;
+	features.features.robustBufferAccess = supported.features.robustBufferAccess;
+	features.features.occlusionQueryPrecise = supported.features.occlusionQueryPrecise;
+	multiviewFeatures.multiview = supportedMultiview.multiview;
+	pipelineCreationCacheControlFeatures.pipelineCreationCacheControl = supportedPipelineCreationCacheControl.pipelineCreationCacheControl;
+
+	features.pNext = &multiviewFeatures;
+	multiviewFeatures.pNext = &pipelineCreationCacheControlFeatures;
+	return &features;
+}
+
+void OffscreenTester::initialize()
+{
+	VulkanTester::initialize();
+
+	vk::CommandPoolCreateInfo commandPoolCreateInfo;
+	commandPoolCreateInfo.queueFamilyIndex = queueFamilyIndex;
+	commandPoolCreateInfo.flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer;
+	commandPool = device.createCommandPool(commandPoolCreateInfo);
+
+	std::array<vk::DescriptorPoolSize, 5> poolSizes;
+	poolSizes[0] = vk::DescriptorPoolSize(vk::DescriptorType::eStorageBuffer, 64);
+	poolSizes[1] = vk::DescriptorPoolSize(vk::DescriptorType::eUniformBuffer, 64);
+	poolSizes[2] = vk::DescriptorPoolSize(vk::DescriptorType::eCombinedImageSampler, 64);
+	poolSizes[3] = vk::DescriptorPoolSize(vk::DescriptorType::eStorageImage, 64);
+	poolSizes[4] = vk::DescriptorPoolSize(vk::DescriptorType::eSampledImage, 64);
+
+	vk::DescriptorPoolCreateInfo poolInfo;
+	poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+	poolInfo.pPoolSizes = poolSizes.data();
+	poolInfo.maxSets = 64;
+	descriptorPool = device.createDescriptorPool(poolInfo);
+}
+
+vk::Buffer OffscreenTester::createBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage, const void *data)
+{
+	vk::BufferCreateInfo bufferInfo;
+	bufferInfo.size = size;
+	bufferInfo.usage = usage;
+	vk::Buffer buffer = device.createBuffer(bufferInfo);
+
+	vk::MemoryRequirements memoryRequirements = device.getBufferMemoryRequirements(buffer);
+	vk::MemoryAllocateInfo allocateInfo;
+	allocateInfo.allocationSize = memoryRequirements.size;
+	allocateInfo.memoryTypeIndex = Util::getMemoryTypeIndex(physicalDevice, memoryRequirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+
+	BufferAllocation allocation;
+	allocation.memory = device.allocateMemory(allocateInfo);
+	device.bindBufferMemory(buffer, allocation.memory, 0);
+	allocation.data = device.mapMemory(allocation.memory, 0, VK_WHOLE_SIZE);
+
+	if(data)
+	{
+		memcpy(allocation.data, data, size);
+	}
+
+	buffers.emplace(static_cast<VkBuffer>(buffer), allocation);
+
+	return buffer;
+}
+
+void *OffscreenTester::getBufferData(vk::Buffer buffer)
+{
+	return buffers.at(static_cast<VkBuffer>(buffer)).data;
+}
+
+void OffscreenTester::destroyBuffer(vk::Buffer buffer)
+{
+	auto it = buffers.find(static_cast<VkBuffer>(buffer));
+	assert(it != buffers.end());
+
+	device.destroyBuffer(buffer);
+	device.freeMemory(it->second.memory);
+	buffers.erase(it);
+}
+
+vk::Image OffscreenTester::createImage(const vk::ImageCreateInfo &imageInfo)
+{
+	vk::Image image = device.createImage(imageInfo);
+	images.push_back(image);
+
+	vk::MemoryRequirements memoryRequirements = device.getImageMemoryRequirements(image);
+	vk::MemoryAllocateInfo allocateInfo;
+	allocateInfo.allocationSize = memoryRequirements.size;
+	allocateInfo.memoryTypeIndex = Util::getMemoryTypeIndex(physicalDevice, memoryRequirements.memoryTypeBits);
+
+	vk::DeviceMemory memory = device.allocateMemory(allocateInfo);
+	imageMemories.push_back(memory);
+	device.bindImageMemory(image, memory, 0);
+
+	vk::ImageAspectFlags aspectMask = getAspectMask(imageInfo.format);
+
+	submit([&](vk::CommandBuffer &commandBuffer) {
+		vk::ImageMemoryBarrier barrier;
+		barrier.srcAccessMask = {};
+		barrier.dstAccessMask = vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite;
+		barrier.oldLayout = vk::ImageLayout::eUndefined;
+		barrier.newLayout = vk::ImageLayout::eGeneral;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange = vk::ImageSubresourceRange(aspectMask, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS);
+
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eAllCommands, {}, 0, nullptr, 0, nullptr, 1, &barrier);
+	});
+
+	return image;
+}
+
+vk::ImageView OffscreenTester::createImageView(vk::Image image, vk::ImageViewType viewType, vk::Format format, const vk::ImageSubresourceRange &range)
+{
+	vk::ImageViewCreateInfo imageViewInfo;
+	imageViewInfo.image = image;
+	imageViewInfo.viewType = viewType;
+	imageViewInfo.format = format;
+	imageViewInfo.subresourceRange = range;
+
+	vk::ImageView imageView = device.createImageView(imageViewInfo);
+	imageViews.push_back(imageView);
+
+	return imageView;
+}
+
+vk::Sampler OffscreenTester::createSampler(const vk::SamplerCreateInfo &samplerInfo)
+{
+	vk::Sampler sampler = device.createSampler(samplerInfo);
+	samplers.push_back(sampler);
+
+	return sampler;
+}
+
+void OffscreenTester::writeImage(vk::Image image, const vk::ImageSubresourceLayers &subresource, vk::Extent3D extent, const void *data, size_t size)
+{
+	vk::Buffer staging = createBuffer(size, vk::BufferUsageFlagBits::eTransferSrc, data);
+
+	submit([&](vk::CommandBuffer &commandBuffer) {
+		vk::BufferImageCopy region;
+		region.imageSubresource = subresource;
+		region.imageExtent = extent;
+
+		fullBarrier(commandBuffer);
+		commandBuffer.copyBufferToImage(staging, image, vk::ImageLayout::eGeneral, 1, &region);
+		fullBarrier(commandBuffer);
+	});
+
+	destroyBuffer(staging);
+}
+
+std::vector<uint8_t> OffscreenTester::readImage(vk::Image image, const vk::ImageSubresourceLayers &subresource, vk::Extent3D extent, size_t texelSize)
+{
+	size_t size = extent.width * extent.height * extent.depth * subresource.layerCount * texelSize;
+	vk::Buffer staging = createBuffer(size, vk::BufferUsageFlagBits::eTransferDst);
+
+	submit([&](vk::CommandBuffer &commandBuffer) {
+		vk::BufferImageCopy region;
+		region.imageSubresource = subresource;
+		region.imageExtent = extent;
+
+		fullBarrier(commandBuffer);
+		commandBuffer.copyImageToBuffer(image, vk::ImageLayout::eGeneral, staging, 1, &region);
+		fullBarrier(commandBuffer);
+	});
+
+	const uint8_t *data = static_cast<const uint8_t *>(getBufferData(staging));
+	std::vector<uint8_t> texels(data, data + size);
+
+	destroyBuffer(staging);
+
+	return texels;
+}
+
+OffscreenTester::RenderTarget OffscreenTester::createRenderTarget(vk::Format format, vk::Extent2D extent, uint32_t layers, vk::ImageUsageFlags usage)
+{
+	vk::ImageAspectFlags aspectMask = getAspectMask(format);
+
+	vk::ImageCreateInfo imageInfo;
+	imageInfo.imageType = vk::ImageType::e2D;
+	imageInfo.format = format;
+	imageInfo.extent = vk::Extent3D(extent.width, extent.height, 1);
+	imageInfo.mipLevels = 1;
+	imageInfo.arrayLayers = layers;
+	imageInfo.samples = vk::SampleCountFlagBits::e1;
+	imageInfo.tiling = vk::ImageTiling::eOptimal;
+	imageInfo.usage = usage | vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst;
+	imageInfo.usage |= (aspectMask & vk::ImageAspectFlagBits::eColor) ? vk::ImageUsageFlagBits::eColorAttachment : vk::ImageUsageFlagBits::eDepthStencilAttachment;
+
+	RenderTarget target;
+	target.image = createImage(imageInfo);
+	target.view = createImageView(target.image, (layers > 1) ? vk::ImageViewType::e2DArray : vk::ImageViewType::e2D, format, vk::ImageSubresourceRange(aspectMask, 0, 1, 0, layers));
+	// Combined depth/stencil formats are read and written through their depth aspect.
+	if(aspectMask & vk::ImageAspectFlagBits::eDepth)
+	{
+		target.aspect = vk::ImageAspectFlagBits::eDepth;
+	}
+	else if(aspectMask & vk::ImageAspectFlagBits::eStencil)
+	{
+		target.aspect = vk::ImageAspectFlagBits::eStencil;
+	}
+	else
+	{
+		target.aspect = vk::ImageAspectFlagBits::eColor;
+	}
+	target.extent = extent;
+	target.layers = layers;
+
+	return target;
+}
+
+vk::ShaderModule OffscreenTester::createShaderModule(const char *glslSource, EShLanguage glslLanguage)
+{
+	auto spirv = Util::compileGLSLtoSPIRV(glslSource, glslLanguage);
+
+	vk::ShaderModuleCreateInfo moduleCreateInfo;
+	moduleCreateInfo.codeSize = spirv.size() * sizeof(uint32_t);
+	moduleCreateInfo.pCode = spirv.data();
+
+	vk::ShaderModule shaderModule = device.createShaderModule(moduleCreateInfo);
+	shaderModules.push_back(shaderModule);
+
+	return shaderModule;
+}
+
+vk::DescriptorSetLayout OffscreenTester::createDescriptorSetLayout(const std::vector<vk::DescriptorSetLayoutBinding> &bindings)
+{
+	vk::DescriptorSetLayoutCreateInfo layoutInfo;
+	layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+	layoutInfo.pBindings = bindings.data();
+
+	vk::DescriptorSetLayout layout = device.createDescriptorSetLayout(layoutInfo);
+	descriptorSetLayouts.push_back(layout);
+
+	return layout;
+}
+
+vk::DescriptorSet OffscreenTester::allocateDescriptorSet(vk::DescriptorSetLayout layout)
+{
+	vk::DescriptorSetAllocateInfo allocInfo;
+	allocInfo.descriptorPool = descriptorPool;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &layout;
+
+	return device.allocateDescriptorSets(allocInfo)[0];
+}
+
+vk::PipelineLayout OffscreenTester::createPipelineLayout(vk::DescriptorSetLayout setLayout)
+{
+	vk::PushConstantRange pushConstantRange(vk::ShaderStageFlagBits::eAll, 0, PushConstantSize);
+
+	vk::PipelineLayoutCreateInfo pipelineLayoutInfo;
+	pipelineLayoutInfo.setLayoutCount = setLayout ? 1 : 0;
+	pipelineLayoutInfo.pSetLayouts = &setLayout;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+	vk::PipelineLayout pipelineLayout = device.createPipelineLayout(pipelineLayoutInfo);
+	pipelineLayouts.push_back(pipelineLayout);
+
+	return pipelineLayout;
+}
+
+vk::RenderPass OffscreenTester::createRenderPass(vk::Format colorFormat, vk::Format depthFormat, vk::AttachmentLoadOp loadOp, uint32_t viewMask)
+{
+	std::vector<vk::AttachmentDescription> attachments;
+
+	vk::AttachmentReference colorReference(VK_ATTACHMENT_UNUSED, vk::ImageLayout::eGeneral);
+	vk::AttachmentReference depthReference(VK_ATTACHMENT_UNUSED, vk::ImageLayout::eGeneral);
+
+	for(vk::Format format : { colorFormat, depthFormat })
+	{
+		if(format == vk::Format::eUndefined)
+		{
+			continue;
+		}
+
+		vk::AttachmentDescription attachment;
+		attachment.format = format;
+		attachment.samples = vk::SampleCountFlagBits::e1;
+		attachment.loadOp = loadOp;
+		attachment.storeOp = vk::AttachmentStoreOp::eStore;
+		attachment.stencilLoadOp = loadOp;
+		attachment.stencilStoreOp = vk::AttachmentStoreOp::eStore;
+		attachment.initialLayout = vk::ImageLayout::eGeneral;
+		attachment.finalLayout = vk::ImageLayout::eGeneral;
+
+		(format == colorFormat ? colorReference : depthReference).attachment = static_cast<uint32_t>(attachments.size());
+		attachments.push_back(attachment);
+	}
+
+	vk::SubpassDescription subpass;
+	subpass.pipelineBindPoint = vk::PipelineBindPoint::eGraphics;
+	subpass.colorAttachmentCount = (colorFormat != vk::Format::eUndefined) ? 1 : 0;
+	subpass.pColorAttachments = &colorReference;
+	subpass.pDepthStencilAttachment = (depthFormat != vk::Format::eUndefined) ? &depthReference : nullptr;
+
+	vk::RenderPassMultiviewCreateInfo multiviewInfo;
+	multiviewInfo.subpassCount = 1;
+	multiviewInfo.pViewMasks = &viewMask;
+
+	vk::RenderPassCreateInfo renderPassInfo;
+	renderPassInfo.pNext = (viewMask != 0) ? &multiviewInfo : nullptr;
+	renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+	renderPassInfo.pAttachments = attachments.data();
+	renderPassInfo.subpassCount = 1;
+	renderPassInfo.pSubpasses = &subpass;
+
+	vk::RenderPass renderPass = device.createRenderPass(renderPassInfo);
+	renderPasses.push_back(renderPass);
+
+	return renderPass;
+}
+
+vk::Framebuffer OffscreenTester::createFramebuffer(vk::RenderPass renderPass, const std::vector<vk::ImageView> &attachments, vk::Extent2D extent, uint32_t layers)
+{
+	vk::FramebufferCreateInfo framebufferInfo;
+	framebufferInfo.renderPass = renderPass;
+	framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+	framebufferInfo.pAttachments = attachments.data();
+	framebufferInfo.width = extent.width;
+	framebufferInfo.height = extent.height;
+	framebufferInfo.layers = layers;
+
+	vk::Framebuffer framebuffer = device.createFramebuffer(framebufferInfo);
+	framebuffers.push_back(framebuffer);
+
+	return framebuffer;
+}
+
+vk::Pipeline OffscreenTester::createGraphicsPipeline(const GraphicsPipelineState &state)
+{
+	std::vector<vk::PipelineShaderStageCreateInfo> shaderStages;
+	shaderStages.push_back(vk::PipelineShaderStageCreateInfo({}, vk::ShaderStageFlagBits::eVertex, state.vertexShader, "main"));
+	if(state.fragmentShader)
+	{
+		shaderStages.push_back(vk::PipelineShaderStageCreateInfo({}, vk::ShaderStageFlagBits::eFragment, state.fragmentShader, "main"));
+	}
+
+	vk::PipelineVertexInputStateCreateInfo vertexInputState;
+	vertexInputState.vertexBindingDescriptionCount = static_cast<uint32_t>(state.vertexBindings.size());
+	vertexInputState.pVertexBindingDescriptions = state.vertexBindings.data();
+	vertexInputState.vertexAttributeDescriptionCount = static_cast<uint32_t>(state.vertexAttributes.size());
+	vertexInputState.pVertexAttributeDescriptions = state.vertexAttributes.data();
+
+	vk::PipelineInputAssemblyStateCreateInfo inputAssemblyState;
+	inputAssemblyState.topology = state.topology;
+	inputAssemblyState.primitiveRestartEnable = state.primitiveRestart ? VK_TRUE : VK_FALSE;
+
+	vk::PipelineViewportStateCreateInfo viewportState;
+	viewportState.viewportCount = 1;
+	viewportState.scissorCount = 1;
+
+	vk::PipelineRasterizationStateCreateInfo rasterizationState;
+	rasterizationState.polygonMode = vk::PolygonMode::eFill;
+	rasterizationState.cullMode = vk::CullModeFlagBits::eNone;
+	rasterizationState.frontFace = vk::FrontFace::eCounterClockwise;
+	rasterizationState.lineWidth = 1.0f;
+
+	vk::PipelineMultisampleStateCreateInfo multisampleState;
+	multisampleState.rasterizationSamples = vk::SampleCountFlagBits::e1;
+
+	vk::PipelineDepthStencilStateCreateInfo depthStencilState;
+	depthStencilState.depthTestEnable = state.depthTest ? VK_TRUE : VK_FALSE;
+	depthStencilState.depthWriteEnable = state.depthTest ? VK_TRUE : VK_FALSE;
+	depthStencilState.depthCompareOp = vk::CompareOp::eLess;
+
+	vk::PipelineColorBlendAttachmentState blendAttachmentState;
+	blendAttachmentState.colorWriteMask = state.colorWriteMask;
+
+	vk::PipelineColorBlendStateCreateInfo colorBlendState;
+	colorBlendState.attachmentCount = state.hasColorAttachment ? 1 : 0;
+	colorBlendState.pAttachments = &blendAttachmentState;
+
+	std::array<vk::DynamicState, 2> dynamicStates = { vk::DynamicState::eViewport, vk::DynamicState::eScissor };
+	vk::PipelineDynamicStateCreateInfo dynamicState;
+	dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+	dynamicState.pDynamicStates = dynamicStates.data();
+
+	vk::GraphicsPipelineCreateInfo pipelineInfo;
+	pipelineInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
+	pipelineInfo.pStages = shaderStages.data();
+	pipelineInfo.pVertexInputState = &vertexInputState;
+	pipelineInfo.pInputAssemblyState = &inputAssemblyState;
+	pipelineInfo.pViewportState = &viewportState;
+	pipelineInfo.pRasterizationState = &rasterizationState;
+	pipelineInfo.pMultisampleState = &multisampleState;
+	pipelineInfo.pDepthStencilState = &depthStencilState;
+	pipelineInfo.pColorBlendState = &colorBlendState;
+	pipelineInfo.pDynamicState = &dynamicState;
+	pipelineInfo.layout = state.layout;
+	pipelineInfo.renderPass = state.renderPass;
+
+	vk::Pipeline pipeline = device.createGraphicsPipeline(nullptr, pipelineInfo).value;
+	pipelines.push_back(pipeline);
+
+	return pipeline;
+}
+
+vk::Pipeline OffscreenTester::createComputePipeline(vk::PipelineLayout layout, vk::ShaderModule shader, vk::PipelineCreateFlags flags)
+{
+	vk::ComputePipelineCreateInfo pipelineInfo;
+	pipelineInfo.flags = flags;
+	pipelineInfo.stage = vk::PipelineShaderStageCreateInfo({}, vk::ShaderStageFlagBits::eCompute, shader, "main");
+	pipelineInfo.layout = layout;
+
+	vk::Pipeline pipeline = device.createComputePipeline(nullptr, pipelineInfo).value;
+	if(pipeline)
+	{
+		pipelines.push_back(pipeline);
+	}
+
+	return pipeline;
+}
+
+void OffscreenTester::submit(const std::function<void(vk::CommandBuffer &commandBuffer)> &record)
+{
+	vk::CommandBuffer commandBuffer = Util::beginSingleTimeCommands(device, commandPool);
+	record(commandBuffer);
+	Util::endSingleTimeCommands(device, commandPool, queue, commandBuffer);
+}
+
+void OffscreenTester::setViewport(vk::CommandBuffer &commandBuffer, vk::Extent2D extent)
+{
+	vk::Viewport viewport(0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f);
+	commandBuffer.setViewport(0, 1, &viewport);
+
+	vk::Rect2D scissor(vk::Offset2D(0, 0), extent);
+	commandBuffer.setScissor(0, 1, &scissor);
+}
+
+void OffscreenTester::beginRenderPass(vk::CommandBuffer &commandBuffer, vk::RenderPass renderPass, vk::Framebuffer framebuffer, vk::Extent2D extent, const std::vector<vk::ClearValue> &clearValues)
+{
+	vk::RenderPassBeginInfo renderPassBeginInfo;
+	renderPassBeginInfo.renderPass = renderPass;
+	renderPassBeginInfo.framebuffer = framebuffer;
+	renderPassBeginInfo.renderArea = vk::Rect2D(vk::Offset2D(0, 0), extent);
+	renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+	renderPassBeginInfo.pClearValues = clearValues.data();
+
+	commandBuffer.beginRenderPass(renderPassBeginInfo, vk::SubpassContents::eInline);
+	setViewport(commandBuffer, extent);
+}
+
+void OffscreenTester::fullBarrier(vk::CommandBuffer &commandBuffer)
+{
+	vk::MemoryBarrier barrier;
+	barrier.srcAccessMask = vk::AccessFlagBits::eMemoryWrite;
+	barrier.dstAccessMask = vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite;
+
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eAllCommands, {}, 1, &barrier, 0, nullptr, 0, nullptr);
+}
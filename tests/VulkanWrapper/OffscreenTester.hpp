@@ -0,0 +1,201 @@
+// Copyright 2024 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OFFSCREEN_TESTER_HPP_
+#define OFFSCREEN_TESTER_HPP_
+
+#include "Util.hpp"
+#include "VulkanTester.hpp"
+
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+// A texel of an R8G8B8A8 image.
+struct Color
+{
+	uint8_t r, g, b, a;
+
+	bool operator==(const Color &other) const { return r == other.r && g == other.g && b == other.b && a == other.a; }
+
+	vk::ClearColorValue toClearColor() const
+	{
+		return vk::ClearColorValue(std::array<float, 4>{ r / 255.0f, g / 255.0f, b / 255.0f, a / 255.0f });
+	}
+};
+
+// OffscreenTester renders into images and reads them back, without a window.
+// All objects it creates are owned by the tester and destroyed along with it.
+// Images are kept in the GENERAL layout, and every submission is waited on,
+// so tests don't need to track layouts or synchronize with the host.
+class OffscreenTester : public VulkanTester
+{
+public:
+	OffscreenTester();
+	~OffscreenTester();
+
+	void initialize();
+
+	/////////////////////////
+	// Resources
+	/////////////////////////
+
+	// Creates a buffer whose memory stays mapped, initialized from data if it isn't null.
+	vk::Buffer createBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage, const void *data = nullptr);
+	void *getBufferData(vk::Buffer buffer);
+	void destroyBuffer(vk::Buffer buffer);
+
+	// Creates an image and transitions it to the GENERAL layout.
+	vk::Image createImage(const vk::ImageCreateInfo &imageInfo);
+	vk::ImageView createImageView(vk::Image image, vk::ImageViewType viewType, vk::Format format, const vk::ImageSubresourceRange &range);
+	vk::Sampler createSampler(const vk::SamplerCreateInfo &samplerInfo);
+
+	// Copies tightly packed data into the given region of an image.
+	void writeImage(vk::Image image, const vk::ImageSubresourceLayers &subresource, vk::Extent3D extent, const void *data, size_t size);
+
+	// Reads back the given region of an image, tightly packed with texelSize bytes per texel.
+	std::vector<uint8_t> readImage(vk::Image image, const vk::ImageSubresourceLayers &subresource, vk::Extent3D extent, size_t texelSize);
+
+	// A single level 2D image and a view of all of its layers.
+	struct RenderTarget
+	{
+		vk::Image image;
+		vk::ImageView view;
+		vk::ImageAspectFlagBits aspect;  // Aspect read and written by readTexels() and writeTexels()
+		vk::Extent2D extent;
+		uint32_t layers;
+	};
+
+	// Creates a render target usable as a color or depth/stencil attachment,
+	// depending on its format, and as a transfer source and destination, in
+	// addition to the given usage.
+	RenderTarget createRenderTarget(vk::Format format, vk::Extent2D extent, uint32_t layers = 1, vk::ImageUsageFlags usage = {});
+
+	// Reads back or writes all layers of a render target, tightly packed.
+	template<typename T>
+	std::vector<T> readTexels(const RenderTarget &target);
+	template<typename T>
+	void writeTexels(const RenderTarget &target, const std::vector<T> &texels);
+
+	/////////////////////////
+	// Pipelines
+	/////////////////////////
+
+	vk::ShaderModule createShaderModule(const char *glslSource, EShLanguage glslLanguage);
+
+	// Creates a descriptor set layout and allocates a set with it.
+	vk::DescriptorSetLayout createDescriptorSetLayout(const std::vector<vk::DescriptorSetLayoutBinding> &bindings);
+	vk::DescriptorSet allocateDescriptorSet(vk::DescriptorSetLayout layout);
+
+	// Pipeline layouts have a push constant range of PushConstantSize bytes for all stages.
+	static constexpr uint32_t PushConstantSize = 128;
+	vk::PipelineLayout createPipelineLayout(vk::DescriptorSetLayout setLayout = {});
+
+	// Creates a single subpass render pass with a color and an optional depth
+	// attachment, either of which may be eUndefined to omit it. Attachments
+	// are loaded with loadOp and always stored. A non-zero viewMask enables
+	// multiview.
+	vk::RenderPass createRenderPass(vk::Format colorFormat, vk::Format depthFormat, vk::AttachmentLoadOp loadOp = vk::AttachmentLoadOp::eLoad, uint32_t viewMask = 0);
+	vk::Framebuffer createFramebuffer(vk::RenderPass renderPass, const std::vector<vk::ImageView> &attachments, vk::Extent2D extent, uint32_t layers = 1);
+
+	struct GraphicsPipelineState
+	{
+		vk::RenderPass renderPass;
+		vk::PipelineLayout layout;
+		vk::ShaderModule vertexShader;
+		vk::ShaderModule fragmentShader;  // Optional
+		std::vector<vk::VertexInputBindingDescription> vertexBindings;
+		std::vector<vk::VertexInputAttributeDescription> vertexAttributes;
+		vk::PrimitiveTopology topology = vk::PrimitiveTopology::eTriangleList;
+		bool primitiveRestart = false;
+		bool hasColorAttachment = true;
+		vk::ColorComponentFlags colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
+		bool depthTest = false;  // Tests with LESS and writes depth
+	};
+
+	// Viewport and scissor are dynamic state.
+	vk::Pipeline createGraphicsPipeline(const GraphicsPipelineState &state);
+
+	// Returns a null handle if flags include eFailOnPipelineCompileRequired
+	// and the pipeline couldn't be created without compiling.
+	vk::Pipeline createComputePipeline(vk::PipelineLayout layout, vk::ShaderModule shader, vk::PipelineCreateFlags flags = {});
+
+	/////////////////////////
+	// Commands
+	/////////////////////////
+
+	// Records commands, submits them and waits for them to complete.
+	void submit(const std::function<void(vk::CommandBuffer &commandBuffer)> &record);
+
+	// Sets the viewport and scissor to cover the extent.
+	static void setViewport(vk::CommandBuffer &commandBuffer, vk::Extent2D extent);
+
+	// Begins an inline render pass over the extent, and sets the viewport and scissor to cover it.
+	static void beginRenderPass(vk::CommandBuffer &commandBuffer, vk::RenderPass renderPass, vk::Framebuffer framebuffer, vk::Extent2D extent, const std::vector<vk::ClearValue> &clearValues = {});
+
+	// Makes all prior writes visible to all subsequent accesses.
+	static void fullBarrier(vk::CommandBuffer &commandBuffer);
+
+protected:
+	const void *getDeviceCreateInfoNext() override;
+
+private:
+	// Features enabled when supported.
+	vk::PhysicalDeviceFeatures2 features;
+	vk::PhysicalDeviceMultiviewFeatures multiviewFeatures;
+	vk::PhysicalDevicePipelineCreationCacheControlFeatures pipelineCreationCacheControlFeatures;
+
+	vk::CommandPool commandPool;        // Owning handle
+	vk::DescriptorPool descriptorPool;  // Owning handle
+
+	struct BufferAllocation
+	{
+		vk::DeviceMemory memory;  // Owning handle
+		void *data;
+	};
+	std::unordered_map<VkBuffer, BufferAllocation> buffers;  // Owning handles
+
+	// Owning handles
+	std::vector<vk::DeviceMemory> imageMemories;
+	std::vector<vk::Image> images;
+	std::vector<vk::ImageView> imageViews;
+	std::vector<vk::Sampler> samplers;
+	std::vector<vk::ShaderModule> shaderModules;
+	std::vector<vk::DescriptorSetLayout> descriptorSetLayouts;
+	std::vector<vk::PipelineLayout> pipelineLayouts;
+	std::vector<vk::RenderPass> renderPasses;
+	std::vector<vk::Framebuffer> framebuffers;
+	std::vector<vk::Pipeline> pipelines;
+};
+
+template<typename T>
+std::vector<T> OffscreenTester::readTexels(const RenderTarget &target)
+{
+	std::vector<uint8_t> data = readImage(target.image, vk::ImageSubresourceLayers(target.aspect, 0, 0, target.layers), vk::Extent3D(target.extent.width, target.extent.height, 1), sizeof(T));
+	std::vector<T> texels(data.size() / sizeof(T));
+	memcpy(texels.data(), data.data(), data.size());
+	return texels;
+}
+
+template<typename T>
+void OffscreenTester::writeTexels(const RenderTarget &target, const std::vector<T> &texels)
+{
+	assert(texels.size() == target.extent.width * target.extent.height * target.layers);
+	writeImage(target.image, vk::ImageSubresourceLayers(target.aspect, 0, 0, target.layers), vk::Extent3D(target.extent.width, target.extent.height, 1), texels.data(), texels.size() * sizeof(T));
+}
+
+#endif  // OFFSCREEN_TESTER_HPP_
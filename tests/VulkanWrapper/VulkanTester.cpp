@@ -263,7 +263,11 @@ void VulkanTester::initialize()
 	PFN_vkGetInstanceProcAddr vkGetInstanceProcAddr = dl->getProcAddress<PFN_vkGetInstanceProcAddr>("vkGetInstanceProcAddr");
 	VULKAN_HPP_DEFAULT_DISPATCHER.init(vkGetInstanceProcAddr);
 
+	vk::ApplicationInfo applicationInfo;
+	applicationInfo.apiVersion = VK_API_VERSION_1_1;
+
 	vk::InstanceCreateInfo instanceCreateInfo;
+	instanceCreateInfo.pApplicationInfo = &applicationInfo;
 	std::vector<const char *> extensionNames
 	{
 		VK_KHR_SURFACE_EXTENSION_NAME,
@@ -347,6 +351,7 @@ void VulkanTester::initialize()
 	};
 
 	vk::DeviceCreateInfo deviceCreateInfo;
+	deviceCreateInfo.pNext = getDeviceCreateInfoNext();
 	deviceCreateInfo.queueCreateInfoCount = 1;
 	deviceCreateInfo.pQueueCreateInfos = &queueCreateInfo;
 	deviceCreateInfo.ppEnabledExtensionNames = deviceExtensions.data();
@@ -34,6 +34,12 @@ public:
 	vk::Queue &getQueue() { return queue; }
 	uint32_t getQueueFamilyIndex() const { return queueFamilyIndex; }
 
+protected:
+	// Called from initialize() before the device is created. Returns the
+	// pNext chain of the device create info, which testers can use to enable
+	// optional features.
+	virtual const void *getDeviceCreateInfoNext() { return nullptr; }
+
 private:
 	std::unique_ptr<vk::detail::DynamicLoader> loadDriver();
 